@@ -217,6 +217,30 @@ def parse_wave_data(file_path, start_time_set, end_time_set, quality_threshold,
     return times, heights, qualities
 
 
+def parse_wave_data_native(file_paths, start_time_set, end_time_set, quality_threshold, iqr_scale, window_size,
+                           tool="../host_tools/build/wave_analyze"):
+    """
+    Same as parse_wave_data() followed by detect_outliers(), using the native
+    host_tools/wave_analyze (see host_tools/README.md). Much faster on
+    multi-day files; accepts a list of data files.
+    """
+    import subprocess
+    import tempfile
+
+    if isinstance(file_paths, str):
+        file_paths = [file_paths]
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "series.npy")
+        subprocess.run([tool, "-o", out, "--start", str(start_time_set), "--end", str(end_time_set),
+                        "--min-strength", str(quality_threshold), "--iqr", str(iqr_scale),
+                        "--window", str(window_size)] + list(file_paths), check=True)
+        data = np.load(out)
+
+    # Logger times are wall clock; keep them naive like parse_wave_data()
+    times = np.array([datetime.utcfromtimestamp(t) for t in data[:, 0]])
+    return times, data[:, 1], data[:, 2]
+
+
 def detect_outliers(heights, times, window_size=13, iqr_multiplier=2.0):
     """
     Detect outliers using both IQR method and rolling median comparison.
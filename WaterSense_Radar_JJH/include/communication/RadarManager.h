@@ -1,8 +1,10 @@
 // include/communication/GPSManager.h
 #pragma once
 
-#include <HardwareSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "storage/SDCardManager.h"
+#include "communication/RadarProtocol.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 
@@ -20,12 +22,10 @@
 #define RADAR_CMD_STOP_CONFIRM 0x78
 #define RADAR_CMD_CONFIG_STRING 0x24
 #define RADAR_CMD_DEBUG_MSG 0x21
+#define RADAR_CMD_PROFILE_MSG 0x50 // text like RADAR_CMD_DEBUG_MSG, one STM32 profile zone (RADAR_MODE_PROFILE)
+#define RADAR_CMD_ENERGY_MSG 0x45  // text like RADAR_CMD_DEBUG_MSG, STM32 energy estimate of a received config
 #define RADAR_NULL 0x00
 
-// Header bytes
-#define RADAR_HEADER_BYTE1 0x4F
-#define RADAR_HEADER_BYTE2 0x3A
-
 class RadarManager
 {
 public:
@@ -37,6 +37,7 @@ public:
 
   bool initialize(uint8_t rxPin, uint8_t txPin, uint32_t baudRate = 921600);
   void radarTask();
+  bool serviceUart(TickType_t ticks);
 
   bool sendConfig(const ConfigSettings &config);
   bool stopDataCollection();
@@ -45,6 +46,9 @@ public:
   bool isMeasuring() const { return m_measurementInProgress; }
   float getSamplePeriod() const { return m_samplePeriod; }
   bool isSamplingPeriodOver() const { return m_samplePeriodOver; }
+  uint32_t getDroppedFrames() const { return m_droppedFrames; }
+  uint32_t getFrameErrors() const { return m_frameErrors; }
+  uint32_t getRxOverflows() const { return m_rxOverflows; }
 
 private:
   RadarManager() : m_isActive(false),
@@ -53,6 +57,12 @@ private:
                    m_testStartTime(0),
                    m_rxPin(0),
                    m_txPin(0),
+                   m_baudRate(921600),
+                   m_uartQueue(nullptr),
+                   m_rxHead(0),
+                   m_rxTail(0),
+                   m_rxOverflows(0),
+                   m_lastRxTime(0),
                    m_measurementInProgress(false),
                    m_samplePeriod(0.0f),
                    m_timingInProgress(false),
@@ -60,7 +70,16 @@ private:
                    m_sampleCount(0),
                    m_discardCount(0),
                    m_sampleCountMax(1),
-                   m_samplePeriodOver(false) {}
+                   m_samplePeriodOver(false),
+                   m_updateRate(0.0f),
+                   m_warmupPeriodCount(0),
+                   m_warmupLastStamp(0),
+                   m_warmupLastSequence(0),
+                   m_haveWarmupStamp(false),
+                   m_lastSequence(0),
+                   m_haveSequence(false),
+                   m_droppedFrames(0),
+                   m_frameErrors(0) {}
   ~RadarManager() = default;
 
   RadarManager(const RadarManager &) = delete;
@@ -68,14 +87,42 @@ private:
 
   bool sendCommand(uint8_t cmd);
   bool sendCommandWithData(uint8_t cmd, const uint8_t *data, size_t len);
-  bool processRadarData();
+  void processRadarData();
+  bool dispatchMessage(uint8_t cmd, const uint8_t *msg, size_t len);
   void handleDistanceData(const uint8_t *data, size_t len);
+  void handleDistanceFrame(const RadarDistanceFrame &frame);
+  void handleConfigFrame(const RadarDistanceFrame &frame);
+  void handleAggregateFrame(const RadarAggregateFrame &frame);
+  void handleRateFrame(const RadarRateFrame &frame);
+  void handleWindowFrame(const RadarWindowFrame &frame);
+  void trackRateWarmup(const RadarDistanceFrame &frame);
+  void reportRateWarmup();
+  void outputDistanceLine(const char *dataStr, const BinaryLogSample &values, uint32_t ageMs);
+  void updateSampleTiming();
+  bool handleDistancePacket(const uint8_t *frame, size_t frameLen);
+  bool handleAggregatePacket(const uint8_t *frame, size_t frameLen);
+  bool handleRatePacket(const uint8_t *frame, size_t frameLen);
+  bool handleWindowPacket(const uint8_t *frame, size_t frameLen);
+  void trackSequence(uint8_t sequence);
+  void formatConfigString(const ConfigSettings &config, char *buffer, size_t size);
   void logStatus(const char *format, ...);
   bool performStopSequence(uint32_t delay_ms, uint32_t timeout_ms);
   float calculateUpdateRate(uint8_t count, uint32_t elapsed_ms);
   bool validateConfigEcho(const uint8_t *received, size_t len);
 
-  HardwareSerial m_serial{2}; // UART2
+  // UART receive path
+  bool startUart();
+  void stopUart();
+  bool waitForUartEvent(TickType_t ticks);
+  bool readBytes(uint8_t *buffer, size_t len, uint32_t timeout_ms);
+  size_t readUntilNull(uint8_t *buffer, size_t size, uint32_t timeout_ms);
+  size_t rxAvailable() const { return m_rxHead - m_rxTail; }
+  uint8_t rxPeek(size_t offset) const { return m_rxRing[(m_rxTail + offset) & (RX_RING_SIZE - 1)]; }
+  void rxConsume(size_t len) { m_rxTail += len; }
+  const uint8_t *rxContiguous(size_t len);
+  size_t rxFindNull(size_t offset);
+  size_t resyncToHeader();
+
   bool m_isActive;
   bool m_isTesting;
   bool m_noiseBlocking;
@@ -84,7 +131,14 @@ private:
   ConfigSettings m_currentConfig;
   uint8_t m_rxPin;  // Added RX pin storage
   uint8_t m_txPin;  // Added TX pin storage
+  uint32_t m_baudRate;        // UART baud rate, kept for restarting the driver
+  QueueHandle_t m_uartQueue;  // UART driver event queue
+  uint32_t m_rxHead;          // Receive ring write count (free running)
+  uint32_t m_rxTail;          // Receive ring read count (free running)
+  uint32_t m_rxOverflows;     // UART FIFO/driver/ring overflows
+  uint32_t m_lastRxTime;      // millis() of the last UART event
   uint32_t m_lastPrintTime = 0;
+  TimestampFormatter m_timestampFormatter; // caches the date part of data timestamps
   bool m_measurementInProgress;
   float m_samplePeriod;       // Time for one sample in milliseconds
   bool m_timingInProgress;    // Are we currently timing samples?
@@ -93,11 +147,29 @@ private:
   uint32_t m_discardCount;    // How many samples to discard
   uint32_t m_sampleCountMax;  // Sample count goal
   bool m_samplePeriodOver;
+  float m_updateRate;         // Current STM32 update rate [Hz], changed by rate frames
+  float m_warmupPeriods[RADAR_RATE_WARMUP_MEASUREMENTS]; // Periods between timed frames [ms]
+  uint8_t m_warmupPeriodCount;
+  uint32_t m_warmupLastStamp;    // STM32 time of the last timed frame
+  uint8_t m_warmupLastSequence;  // Sequence number of the last timed frame
+  bool m_haveWarmupStamp;
+  uint8_t m_lastSequence;     // Sequence number of last binary frame
+  bool m_haveSequence;        // Has a binary frame been received since start?
+  uint32_t m_droppedFrames;   // Frames lost, from sequence number gaps
+  uint32_t m_frameErrors;     // Frames rejected for bad length/CRC
 
-      static constexpr size_t MAX_DATA_SIZE = 256;
+  static constexpr size_t MAX_DATA_SIZE = 256;
+  static constexpr size_t CONFIG_STRING_SIZE = 96; // formatConfigString() with every optional field
   static constexpr uint32_t CONFIG_TIMEOUT_MS = 2500;
   static constexpr uint32_t DEFAULT_TIMEOUT_MS = 1000;
   static constexpr uint32_t STOP_TIMEOUT_MS = 3000;
   static constexpr uint8_t MAX_BT_PRINTS_PER_SEC = 11;  // Adjust this value as needed
   static constexpr uint32_t MIN_PRINT_INTERVAL_MS = 1000 / MAX_BT_PRINTS_PER_SEC;
+  static constexpr uart_port_t RADAR_UART = UART_NUM_2;
+  static constexpr size_t RX_RING_SIZE = 1024;            // Must be a power of 2
+  static constexpr int UART_DRIVER_RX_SIZE = 2048;        // IDF driver's internal RX buffer
+  static constexpr int UART_EVENT_QUEUE_SIZE = 20;
+
+  uint8_t m_rxRing[RX_RING_SIZE];       // Receive ring, messages are parsed in place
+  uint8_t m_rxScratch[MAX_DATA_SIZE];   // Copy of messages that wrap around the ring
 };
\ No newline at end of file
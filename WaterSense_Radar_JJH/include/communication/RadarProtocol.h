@@ -0,0 +1,134 @@
+// include/communication/RadarProtocol.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Header bytes, start every message in both directions
+#define RADAR_HEADER_BYTE1 0x4F
+#define RADAR_HEADER_BYTE2 0x3A
+
+// Binary frame command codes
+#define RADAR_CMD_DATA_FRAME 0x44
+#define RADAR_CMD_AGGREGATE_FRAME 0x41
+#define RADAR_CMD_RATE_FRAME 0x52
+#define RADAR_CMD_TIMED_DATA_FRAME 0x64
+#define RADAR_CMD_CONFIG_DATA_FRAME 0x63
+#define RADAR_CMD_WINDOW_FRAME 0x57
+#define RADAR_CMD_FILTERED_DATA_FRAME 0x66
+
+// Binary frame layout (multi-byte fields are little-endian):
+// [HEADER1][HEADER2][CMD][VERSION][LENGTH][SEQ][PAYLOAD...][CRC16 LO][CRC16 HI]
+// CRC-16/CCITT-FALSE covers CMD through the end of the payload.
+#define RADAR_FRAME_VERSION 0x01
+#define RADAR_FRAME_PREFIX_SIZE 6
+#define RADAR_FRAME_CRC_SIZE 2
+#define RADAR_FRAME_MAX_PAYLOAD 64
+
+// Distance payload: per target uint16 distance [mm] + int16 strength [0.01 dB]
+#define RADAR_FRAME_DISTANCE_SIZE 4
+#define RADAR_FRAME_MAX_DISTANCES 5
+
+// Timed distance payload: uint32 measurement time [ms since STM32 boot], then the distance payload
+#define RADAR_FRAME_TIMESTAMP_SIZE 4
+
+// Filtered distance payload: uint32 age of the measurement when sent [ms], then the distance
+// payload. The STM32 outlier filter (filter_window) sends each measurement half a window late,
+// the age lets the ESP32 timestamp it when it was measured
+#define RADAR_FRAME_AGE_SIZE 4
+
+// Timed frames the STM32 sends at the start of a collection when testing_update_rate is set
+// with RADAR_MODE_RATE_WARMUP, the ESP32 reports the period and its jitter from them
+#define RADAR_RATE_WARMUP_MEASUREMENTS 32
+
+// Config distance payload: uint8 config index, then the distance payload. Results of the
+// secondary configuration (ConfigSettings::secondary_*), sent unfiltered every
+// secondary_interval measurements next to the primary's data or aggregate frames
+#define RADAR_FRAME_CONFIG_INDEX_SIZE 1
+#define RADAR_SECONDARY_CONFIG_INDEX 1
+
+// Aggregate payload, one per aggregation period instead of every measurement:
+// uint16 median/min/max distance [mm], int16 mean strength [0.01 dB],
+// uint16 samples/outliers/empty measurements, uint32 period [ms]
+#define RADAR_FRAME_AGGREGATE_SIZE 18
+
+// Rate payload, sent when the STM32 changes its update rate (RADAR_MODE_ADAPTIVE_RATE):
+// uint32 measurement period [ms], uint16 distance spread [mm] that caused the change
+#define RADAR_FRAME_RATE_SIZE 6
+
+// Window payload, sent when the STM32 moves its measured range (RADAR_MODE_TRACKING):
+// uint16 start/end [mm], uint8 1 while sweeping the search range for a lost surface
+#define RADAR_FRAME_WINDOW_SIZE 5
+
+// Mode flags (ConfigSettings::mode_flags), sent to the STM32 as the last config field
+#define RADAR_MODE_BINARY_FRAMES 0x01
+#define RADAR_MODE_BINARY_LOG 0x02    // ESP32 only: write .bin data files (storage/BinaryLog.h)
+#define RADAR_MODE_ADAPTIVE_RATE 0x04 // STM32 varies the update rate with the water surface, needs binary frames
+#define RADAR_MODE_RATE_WARMUP 0x08   // testing_update_rate measures inside collection, needs binary frames
+#define RADAR_MODE_TRACKING 0x10      // STM32 range window follows the surface, searches the secondary range
+                                      // when it is lost, needs binary frames
+#define RADAR_MODE_BANDS 0x20         // STM32 measures the secondary range around a fine primary band in one frame
+#define RADAR_MODE_PROFILE 0x40       // STM32 sends where its awake time goes as RADAR_CMD_PROFILE_MSG lines
+#define RADAR_MODE_HIBERNATE 0x80     // STM32 sensor hibernates between measurements, band mode skips the prepare
+#define RADAR_MODE_DEFAULT (RADAR_MODE_BINARY_FRAMES | RADAR_MODE_RATE_WARMUP)
+
+struct RadarDistanceFrame
+{
+  uint8_t sequence;
+  uint8_t numDistances;
+  float distances[RADAR_FRAME_MAX_DISTANCES]; // meters
+  float strengths[RADAR_FRAME_MAX_DISTANCES]; // dB
+  bool timed;           // RADAR_CMD_TIMED_DATA_FRAME
+  uint32_t timestampMs; // STM32 time of the measurement, timed frames only
+  uint8_t configIndex;  // RADAR_CMD_CONFIG_DATA_FRAME, 0 (primary) for the others
+  uint32_t ageMs;       // RADAR_CMD_FILTERED_DATA_FRAME, time since the measurement, 0 for the others
+};
+
+// Strongest target over one aggregation period, outliers excluded
+struct RadarAggregateFrame
+{
+  uint8_t sequence;
+  float median;       // meters, 0 if samples is 0
+  float min;          // meters
+  float max;          // meters
+  float meanStrength; // dB
+  uint16_t samples;   // measurements that passed the outlier filter
+  uint16_t outliers;  // measurements rejected by the outlier filter
+  uint16_t empty;     // measurements without distances
+  uint32_t periodMs;
+};
+
+// New measurement period; update_rate from the config is the fastest rate
+struct RadarRateFrame
+{
+  uint8_t sequence;
+  uint32_t periodMs;
+  float spread; // meters, spread of recent distances that caused the change
+};
+
+// New measured range; start_m..end_m from the config only sets its width
+struct RadarWindowFrame
+{
+  uint8_t sequence;
+  float start;    // meters
+  float end;      // meters
+  bool searching; // sweeping the secondary range
+};
+
+namespace RadarProtocol
+{
+  uint16_t crc16(const uint8_t *data, size_t len);
+
+  // Size of a complete frame given its first RADAR_FRAME_PREFIX_SIZE bytes, 0 if invalid
+  size_t frameSize(const uint8_t *prefix);
+
+  // Decodes RADAR_CMD_DATA_FRAME, RADAR_CMD_TIMED_DATA_FRAME, RADAR_CMD_CONFIG_DATA_FRAME and
+  // RADAR_CMD_FILTERED_DATA_FRAME
+  bool decodeDistanceFrame(const uint8_t *frame, size_t len, RadarDistanceFrame *out);
+
+  bool decodeAggregateFrame(const uint8_t *frame, size_t len, RadarAggregateFrame *out);
+
+  bool decodeRateFrame(const uint8_t *frame, size_t len, RadarRateFrame *out);
+
+  bool decodeWindowFrame(const uint8_t *frame, size_t len, RadarWindowFrame *out);
+}
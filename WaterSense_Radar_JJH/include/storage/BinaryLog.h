@@ -0,0 +1,111 @@
+// include/storage/BinaryLog.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "communication/RadarProtocol.h"
+
+// Binary data file format (RADAR_MODE_BINARY_LOG). Shared with the host decoder
+// in host_tools/, so this module must not depend on Arduino headers.
+//
+// A .bin data file starts with the same human-readable text header as a .txt
+// data file (ending in "---\n"), followed by blocks. Each SD flush writes one
+// block. All multi-byte fields are little-endian.
+//
+// Block header (BINLOG_BLOCK_HEADER_SIZE bytes):
+//   0  magic "WSBL"          28 f32 start_m
+//   4  u8  version           32 f32 end_m
+//   5  u8  header size       36 f32 update_rate
+//   6  u16 record count      40 f32 threshold_sensitivity
+//   8  u32 payload size      44 f32 signal_quality
+//   12 u16 payload CRC16     48 f32 true_update_rate
+//   14 u16 year              52 u8  max_step_length
+//   16 u8  month, day,       53 u8  max_profile
+//          hour, minute,     54 u8  reflector_shape
+//          second, (pad)     55 u8  mode_flags
+//   22 u16 millisecond
+//   24 u32 millis() when the block was started (diagnostic only)
+//
+// Records follow the header back to back:
+//   [TAG][DELTA varint][body]
+//   TAG 0..5           sample with TAG targets, body is TAG x (u16 mm, i16 0.01 dB)
+//   TAG BINLOG_TAG_TEXT text line, body is u8 length + characters (no newline)
+// DELTA is milliseconds since the previous record in the block (the first
+// record is relative to the block's base time), as an unsigned LEB128 varint.
+#define BINLOG_MAGIC0 'W'
+#define BINLOG_MAGIC1 'S'
+#define BINLOG_MAGIC2 'B'
+#define BINLOG_MAGIC3 'L'
+#define BINLOG_VERSION 0x01
+#define BINLOG_BLOCK_HEADER_SIZE 56
+#define BINLOG_TAG_TEXT 0x80
+#define BINLOG_MAX_DISTANCES RADAR_FRAME_MAX_DISTANCES
+#define BINLOG_MAX_VARINT_SIZE 5
+#define BINLOG_MAX_TEXT_LENGTH 255
+#define BINLOG_MAX_RECORD_SIZE (1 + BINLOG_MAX_VARINT_SIZE + 1 + BINLOG_MAX_TEXT_LENGTH)
+
+// One radar measurement in fixed point
+struct BinaryLogSample
+{
+  uint8_t count;                               // 0 means no distances found
+  uint16_t distances_mm[BINLOG_MAX_DISTANCES]; // millimeters
+  int16_t strengths_cdb[BINLOG_MAX_DISTANCES]; // 0.01 dB
+};
+
+struct BinaryLogBlockInfo
+{
+  uint16_t recordCount;
+  uint32_t payloadSize;
+  uint16_t payloadCrc;
+
+  // Wall-clock time of the block's base, from TimeManager
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  uint16_t millisecond;
+  uint32_t baseMillis; // diagnostic only
+
+  // Config snapshot
+  float start_m;
+  float end_m;
+  float update_rate;
+  float threshold_sensitivity;
+  float signal_quality;
+  float true_update_rate;
+  uint8_t max_step_length;
+  uint8_t max_profile;
+  uint8_t reflector_shape;
+  uint8_t mode_flags;
+};
+
+struct BinaryLogRecord
+{
+  uint32_t deltaMs;
+  bool isText;
+  BinaryLogSample sample; // valid if !isText
+  const char *text;       // valid if isText, not null-terminated
+  uint8_t textLength;
+};
+
+namespace BinaryLog
+{
+  void writeBlockHeader(uint8_t *out, const BinaryLogBlockInfo &info);
+
+  // Returns false if the bytes aren't a supported block header
+  bool readBlockHeader(const uint8_t *in, size_t len, BinaryLogBlockInfo *info);
+
+  size_t writeVarint(uint8_t *out, uint32_t value);
+
+  // Returns bytes consumed, 0 if truncated or too long
+  size_t readVarint(const uint8_t *in, size_t len, uint32_t *value);
+
+  // Return bytes written, at most BINLOG_MAX_RECORD_SIZE
+  size_t encodeSample(uint8_t *out, uint32_t deltaMs, const BinaryLogSample &sample);
+  size_t encodeText(uint8_t *out, uint32_t deltaMs, const char *text, size_t len);
+
+  // Returns bytes consumed, 0 if the record is malformed or truncated
+  size_t decodeRecord(const uint8_t *in, size_t len, BinaryLogRecord *out);
+}
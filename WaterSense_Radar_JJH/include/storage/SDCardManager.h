@@ -7,6 +7,11 @@
 #include <queue>
 #include <mutex>
 #include <atomic>
+#include "communication/RadarProtocol.h"
+#include "storage/SpscRing.h"
+#include "storage/SDFileWriter.h"
+#include "storage/BinaryLog.h"
+#include "storage/TimeManager.h"
 
 typedef struct
 {
@@ -24,6 +29,14 @@ typedef struct
   char latitude[32];
   char longitude[32];
   char elevation[16];
+  uint8_t mode_flags; // RADAR_MODE_* bits, see RadarProtocol.h
+  uint8_t filter_window; // STM32 outlier filter length in measurements, 0 = off
+  uint16_t aggregate_s;  // STM32 sends one aggregate per period [s] instead of every measurement, 0 = off
+  float secondary_start_m; // second STM32 configuration, e.g. a wide range to find the surface again
+  float secondary_end_m;
+  uint8_t secondary_max_step_length;
+  uint8_t secondary_max_profile;
+  uint16_t secondary_interval; // primary measurements per secondary measurement, 0 = off
 } ConfigSettings;
 
 class SDCardManager
@@ -38,8 +51,11 @@ public:
 
   bool initialize(uint8_t chipSelectPin, RTC_PCF8523 &rtc);
   void sdTask();
+  void sdTaskStep();
 
   void queueData(const char *format, ...);
+  void queueAuxData(const char *format, ...);
+  void queueSample(uint64_t epochMs, const BinaryLogSample &values, uint8_t stream = 0);
   void queueDebug(const char *format, ...);
   void updateConfig(const ConfigSettings &config);
   ConfigSettings getConfig();
@@ -48,23 +64,32 @@ public:
   void flushDebugBuffer();
   void flushDataBuffer();
 
-  bool hasActiveOperations() const { return m_operationInProgress.load(); }
+  bool hasActiveOperations() const { return m_operationInProgress.load() > 0; }
+  void requestSync() { m_syncRequested.store(true); } // safe from ISRs, e.g. on power-fail warning
+  void setSyncInterval(uint32_t intervalMs) { m_syncIntervalMs = intervalMs; }
+  const SDFileWriter::Stats &getDataWriterStats() const { return m_dataWriter.getStats(); }
+  const SDFileWriter::Stats &getDebugWriterStats() const { return m_debugWriter.getStats(); }
+  const SDFileWriter::Stats &getStreamWriterStats() const { return m_streamWriter.getStats(); }
+  uint32_t getDroppedDataLines() const { return m_droppedDataLines.load(); }
+  uint32_t getDroppedDebugLines() const { return m_droppedDebugLines.load(); }
 
 private:
+  struct DataRecord;
+
   class OperationGuard
   {
   public:
-    OperationGuard(std::atomic<bool> &flag) : m_flag(flag)
+    OperationGuard(std::atomic<int> &count) : m_count(count)
     {
-      m_flag.store(true);
+      m_count++;
     }
     ~OperationGuard()
     {
-      m_flag.store(false);
+      m_count--;
     }
 
   private:
-    std::atomic<bool> &m_flag;
+    std::atomic<int> &m_count;
   };
 
   explicit SDCardManager(size_t dataBufferLines)
@@ -72,11 +97,20 @@ private:
         m_pRTC(nullptr),
         m_debugBufferPos(0),
         m_dataBufferPos(0),
+        m_dataBufferLines(0),
         m_lastFlushTime(0),
         m_linesSaved(0),
         m_maxDataBufferLines(dataBufferLines),
+        m_lastSyncTime(0),
+        m_syncIntervalMs(DEFAULT_SYNC_INTERVAL_MS),
         m_currentDebugPath(nullptr),
         m_currentDataPath(nullptr),
+        m_binaryDataFile(false),
+        m_streamIndex(0),
+        m_block{},
+        m_blockLastEpochMs(0),
+        m_reportedDataDrops(0),
+        m_reportedDebugDrops(0),
         m_needNewDataFile(false),
         m_needConfigSave(false)
   {
@@ -104,7 +138,16 @@ private:
   void appendDebug(const char *format, ...);
 
   bool startNewDataFile(char **dataFilePath);
-  void appendData(const char *format, ...);
+  void appendData(const char *line, size_t len);
+  void appendRecord(const DataRecord &record);
+  void appendBinaryRecord(const DataRecord &record);
+  bool startStreamFile(uint8_t stream);
+  void appendStreamRecord(const DataRecord &record);
+  int formatSampleLine(const DataRecord &record, char *line, size_t size);
+  void drainDataQueues();
+  void reportDroppedLines();
+  void syncFiles();
+  void logWriterStats(const char *name, const SDFileWriter &writer);
 
   bool readConfig(ConfigSettings *config);
   bool saveConfig(const ConfigSettings *config);
@@ -128,7 +171,15 @@ private:
         40,        // text_width
         "Not Set", // latitude
         "Not Set", // longitude
-        "Not Set"  // elevation
+        "Not Set", // elevation
+        RADAR_MODE_DEFAULT, // mode_flags
+        0,         // filter_window
+        0,         // aggregate_s
+        0.10f,     // secondary_start_m
+        5.00f,     // secondary_end_m
+        8,         // secondary_max_step_length
+        5,         // secondary_max_profile
+        0          // secondary_interval
     };
     return config;
   }
@@ -137,12 +188,20 @@ private:
   bool m_isInitialized;         // is the SD card initialized?
   RTC_PCF8523 *m_pRTC;          // pointer to RTC object
   size_t m_debugBufferPos;      // tracks debug buffer cursor position
-  size_t m_dataBufferPos;       // tracks data buffer cursor position
+  size_t m_dataBufferPos;       // tracks data buffer cursor position (bytes)
+  size_t m_dataBufferLines;     // number of lines currently in data buffer
   uint32_t m_lastFlushTime;     // last time that data was appended
   uint32_t m_linesSaved;        // track number of data lines saved
   size_t m_maxDataBufferLines;  // gets set in constructor, max # of data lines before append is forced
+  uint32_t m_lastSyncTime;      // last time open files were committed to the card
+  uint32_t m_syncIntervalMs;    // how often open files are committed
   char *m_currentDebugPath;     // track current debug file path
   char *m_currentDataPath;      // track current data file path
+  bool m_binaryDataFile;        // is the current data file in BinaryLog format?
+  uint8_t m_streamIndex;        // config index of the open stream file
+  BinaryLogBlockInfo m_block;   // base time of the block being built in m_dataBuffer
+  uint64_t m_blockLastEpochMs;  // time of the last record in the block
+  TimestampFormatter m_timestampFormatter; // for samples written to .txt files
 
   // parameters
   static constexpr size_t DEBUG_BUFFER_SIZE = 4096; // max length for debug lines
@@ -150,17 +209,48 @@ private:
   char m_debugBuffer[DEBUG_BUFFER_SIZE];            // buffer for 
   char m_dataBuffer[MAX_LINE_LENGTH * 100];         // default max 100 lines
   static constexpr uint32_t FLUSH_INTERVAL = 5000;  // 5 seconds
+  static constexpr uint32_t DEFAULT_SYNC_INTERVAL_MS = 5000;
   static constexpr uint32_t MAX_LINES_PER_FILE = 1000000UL;
   static constexpr const char *CONFIG_FILE_PATH = "/radar_config.txt";
 
-  // Queues for data
-  std::queue<std::string> m_dataQueue;
+  // One queued data line or radar sample, written in place by the producer
+  enum DataRecordType : uint8_t
+  {
+    DATA_RECORD_TEXT,
+    DATA_RECORD_SAMPLE
+  };
+
+  struct DataRecord
+  {
+    DataRecordType type;
+    uint8_t stream;   // 0 for the data file, else the config index of a stream file
+    uint16_t length;  // text length, DATA_RECORD_TEXT only
+    uint64_t epochMs; // TimeManager::getEpochMs() when queued / measured
+    union
+    {
+      char text[MAX_LINE_LENGTH];
+      BinaryLogSample sample;
+    };
+  };
+
+  // Queues for data. The radar task is the only producer for m_dataRing; other
+  // tasks use m_auxDataRing, which serializes its producers with a mutex.
+  static constexpr size_t DATA_RING_SIZE = 64;     // power of 2, ~6 s at 10 Hz
+  static constexpr size_t AUX_DATA_RING_SIZE = 8;  // power of 2
+  SpscRing<DataRecord, DATA_RING_SIZE> m_dataRing;
+  SpscRing<DataRecord, AUX_DATA_RING_SIZE> m_auxDataRing;
   std::queue<std::string> m_debugQueue;
 
   // Mutexes for thread safety
-  std::mutex m_dataQueueMutex;
+  std::mutex m_auxDataMutex;
   std::mutex m_debugQueueMutex;
 
+  // Lines dropped because a queue was full, reported to the debug log by sdTask
+  std::atomic<uint32_t> m_droppedDataLines{0};
+  std::atomic<uint32_t> m_droppedDebugLines{0};
+  uint32_t m_reportedDataDrops;
+  uint32_t m_reportedDebugDrops;
+
   // Control flags
   volatile bool m_needNewDataFile;
   volatile bool m_needConfigSave;
@@ -169,7 +259,13 @@ private:
   ConfigSettings m_currentConfig;
   std::mutex m_configMutex;
 
-  std::atomic<bool> m_operationInProgress{false}; // Track if any operation is running
+  // Files stay open between flushes, see SDFileWriter
+  SDFileWriter m_dataWriter;
+  SDFileWriter m_debugWriter;
+  SDFileWriter m_streamWriter; // secondary configuration measurements, next to the data file
+  std::atomic<bool> m_syncRequested{false};
+
+  std::atomic<int> m_operationInProgress{0}; // Number of SD operations running (guards nest)
 
-  static constexpr size_t MAX_QUEUE_SIZE = 100; // Adjust based on needs
+  static constexpr size_t MAX_QUEUE_SIZE = 100; // Max queued debug messages
 };
\ No newline at end of file
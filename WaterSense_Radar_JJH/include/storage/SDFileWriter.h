@@ -0,0 +1,59 @@
+// include/storage/SDFileWriter.h
+#pragma once
+
+#include <SD.h>
+
+/**
+ * @brief Append-only writer that keeps one SD file open between flushes
+ *
+ * Opening and closing a FAT file costs a directory lookup and a cluster-chain
+ * walk every time, so SDCardManager keeps one writer per log file instead.
+ * Writes are issued in whole SECTOR_SIZE chunks aligned to the file offset;
+ * the unaligned tail is held in a one-sector staging buffer until more data
+ * arrives or sync() is called. sync() writes the tail and commits the file
+ * size to the directory entry, so data is only guaranteed on the card after
+ * a sync.
+ *
+ * Not thread safe, only sdTask uses it.
+ */
+class SDFileWriter
+{
+public:
+  struct Stats
+  {
+    uint32_t bytesWritten;  // bytes passed to the card
+    uint32_t writeCalls;    // File::write() calls
+    uint32_t opens;         // files opened
+    uint32_t syncs;         // sync() calls that flushed the file
+    uint32_t lastSyncUs;    // duration of the last sync
+    uint32_t maxSyncUs;     // longest sync
+    uint64_t totalSyncUs;   // sum of all sync durations
+    uint32_t errors;        // failed or short writes
+  };
+
+  static constexpr size_t SECTOR_SIZE = 512;
+
+  SDFileWriter() : m_fileSize(0), m_pending(0), m_dirty(false), m_stats{} {}
+
+  bool open(const char *path);
+  bool write(const uint8_t *data, size_t len);
+  bool sync();
+  void close();
+
+  bool isOpen() const { return (bool)m_file; }
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  // prevent copying
+  SDFileWriter(const SDFileWriter &) = delete;
+  SDFileWriter &operator=(const SDFileWriter &) = delete;
+
+  bool writeToFile(const uint8_t *data, size_t len);
+
+  File m_file;
+  uint32_t m_fileSize;             // bytes in the file, including staged bytes
+  size_t m_pending;                // bytes in m_staging
+  bool m_dirty;                    // written since last sync?
+  uint8_t m_staging[SECTOR_SIZE];  // unaligned tail waiting for a full sector
+  Stats m_stats;
+};
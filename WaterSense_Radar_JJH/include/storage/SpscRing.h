@@ -0,0 +1,70 @@
+// include/storage/SpscRing.h
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @brief Fixed-capacity single-producer/single-consumer ring of records
+ *
+ * Lock-free and allocation-free. Exactly one task may call reserve()/commit()
+ * and exactly one (other) task may call front()/pop(). Records are written and
+ * read in place, so no copies are made beyond what the caller writes.
+ *
+ * N must be a power of 2. Head and tail are free-running counters, so all N
+ * slots are usable.
+ */
+template <typename T, size_t N>
+class SpscRing
+{
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of 2");
+
+public:
+  SpscRing() : m_head(0), m_tail(0) {}
+
+  // Producer side: returns the next free slot, or nullptr if the ring is full
+  T *reserve()
+  {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= N)
+    {
+      return nullptr;
+    }
+    return &m_slots[head & (N - 1)];
+  }
+
+  // Producer side: publishes the slot returned by reserve()
+  void commit()
+  {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Consumer side: returns the oldest record, or nullptr if the ring is empty
+  T *front()
+  {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+    return &m_slots[tail & (N - 1)];
+  }
+
+  // Consumer side: releases the record returned by front()
+  void pop()
+  {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  size_t size() const
+  {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+private:
+  T m_slots[N];
+  std::atomic<size_t> m_head; // written by producer only
+  std::atomic<size_t> m_tail; // written by consumer only
+};
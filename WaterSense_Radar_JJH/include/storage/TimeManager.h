@@ -3,6 +3,7 @@
 
 #include "RTClib.h"
 #include <mutex>
+#include <atomic>
 #include <string>
 
 struct DateTimeMS
@@ -16,6 +17,31 @@ struct DateTimeMS
   uint16_t millisecond;
 };
 
+/**
+ * @brief Incremental "[yy/mm/dd hh:mm:ss.mmm]" formatter
+ *
+ * Caches the "[yy/mm/dd hh:mm:" prefix and only renders the seconds and
+ * milliseconds digits while the minute stays the same, so the calendar math
+ * and snprintf run once a minute. Not thread safe: each task that formats
+ * timestamps at a high rate keeps its own instance.
+ */
+class TimestampFormatter
+{
+public:
+  static constexpr size_t TIMESTAMP_LENGTH = 24; // "[yy/mm/dd hh:mm:ss.mmm]" including terminator
+
+  TimestampFormatter() : m_cachedMinute(UINT64_MAX) { m_prefix[0] = '\0'; }
+
+  // Returns characters written (excluding terminator), 0 if size is too small
+  size_t format(uint64_t epochMs, char *buffer, size_t size);
+
+private:
+  static constexpr size_t PREFIX_LENGTH = 16; // "[yy/mm/dd hh:mm:"
+
+  uint64_t m_cachedMinute;         // epochMs / 60000 of m_prefix
+  char m_prefix[PREFIX_LENGTH + 1];
+};
+
 class TimeManager
 {
 public:
@@ -30,6 +56,11 @@ public:
 
   void getFormattedTimestamp(char *buffer, size_t size); // For data logging
   DateTimeMS getCurrentTimeMS();                         // For direct timestamp access if needed
+  uint64_t getEpochMs() const;                           // Milliseconds since 1970-01-01 (RTC time), lock-free
+
+  static uint64_t toEpochMs(const DateTimeMS &time);
+  static DateTimeMS toDateTime(uint64_t epochMs);
+
   void resetInitialTime();
   void setDateTime(uint16_t year, uint8_t month, uint8_t day,
                    uint8_t hour, uint8_t minute, uint8_t second);
@@ -62,10 +93,9 @@ public:
 private:
   TimeManager() : m_isInitialized(false), 
                   m_pRTC(nullptr),
-                  m_initTime{0}, 
-                  m_initMillis(0), 
-                  m_overflowCount(0),
-                  m_lastUpdateTime(0),
+                  m_baseEpochMs(0),
+                  m_baseUptimeMs(0),
+                  m_timeSeq(0),
                   m_processingStartTime(0),
                   m_processingEndTime(0),
                   m_processingActive(false),
@@ -76,27 +106,21 @@ private:
   TimeManager(const TimeManager &) = delete;
   TimeManager &operator=(const TimeManager &) = delete;
 
-  void updateCurrentTime();
-  uint8_t daysInMonth(uint8_t month, uint16_t year) const;
-  bool isLeapYear(uint16_t year) const;
-  void checkMillisOverflow();
+  void syncWithRTC();
+  static uint64_t uptimeMs();
   void logStatus(const char *format, ...);
   void performLightSleep(); 
 
   bool m_isInitialized;           // is time manager set up?
   RTC_PCF8523 *m_pRTC;            // pointer to RTC object
-  DateTimeMS m_initTime;          // RTC time at startup
-  uint32_t m_initMillis;          // initial millis() at startup
-  uint32_t m_overflowCount;       // how many times has millis() overflowed? (51 days)
-  uint32_t m_lastUpdateTime;      // when was the time updated last? 
-  DateTimeMS m_currentTime;       // what is the time right now?
+  uint64_t m_baseEpochMs;         // RTC time at last sync, ms since 1970
+  uint64_t m_baseUptimeMs;        // uptimeMs() at last sync
+  std::atomic<uint32_t> m_timeSeq; // seqlock for the two above, odd while being written
   uint32_t m_processingStartTime; // When processing starts
   uint32_t m_processingEndTime;   // When processing ends
   bool m_processingActive;        // Is timing active?
   float m_targetSamplePeriod;     // Period we're aiming for
   bool m_deepSleepEnabled;        // Should we deep sleep?
 
-  mutable std::mutex m_timeMutex;   
-
-  static constexpr uint32_t MILLIS_OVERFLOW = 0xFFFFFFFF;
+  std::mutex m_timeMutex;          // serializes writers (RTC syncs), readers don't lock
 };
\ No newline at end of file
@@ -461,5 +461,5 @@ void GPSManager::logGPS(const char *format, ...)
   logStatus(messageBuffer);
 
   // Log to data file without prefix
-  SDCardManager::getInstance().queueData("%s", messageBuffer);
+  SDCardManager::getInstance().queueAuxData("%s", messageBuffer);
 }
@@ -4,6 +4,7 @@
 #include "storage/SDCardManager.h"
 #include "storage/TimeManager.h"
 #include <Arduino.h>
+#include <algorithm>
 #include <stdarg.h>
 
 
@@ -14,8 +15,8 @@
  * @param baudRate UART baud rate, defaults to 921600
  * @return true for successful initialization, false if error occurred
  *
- * Initializes UART communication with STM32, loads initial configuration from SD card,
- * and clears any stale data in the serial buffer. Configuration parameters include
+ * Installs the UART driver for the STM32 link, loads initial configuration from SD card,
+ * and clears any stale data in the receive buffers. Configuration parameters include
  * measurement range, update rate, signal quality settings, and other radar parameters.
  */
 bool RadarManager::initialize(uint8_t rxPin, uint8_t txPin, uint32_t baudRate)
@@ -23,7 +24,13 @@ bool RadarManager::initialize(uint8_t rxPin, uint8_t txPin, uint32_t baudRate)
   m_rxPin = rxPin;
   m_txPin = txPin;
 
-  m_serial.begin(baudRate, SERIAL_8E1, rxPin, txPin);
+  m_baudRate = baudRate;
+
+  if (!startUart())
+  {
+    logStatus("Failed to start radar UART");
+    return false;
+  }
   m_isActive = false;
   m_isTesting = false;
   m_noiseBlocking = false;
@@ -44,13 +51,22 @@ bool RadarManager::initialize(uint8_t rxPin, uint8_t txPin, uint32_t baudRate)
   logStatus("Threshold sensitivity: %.2f", m_currentConfig.threshold_sensitivity);
   logStatus("Testing update rate: %d", m_currentConfig.testing_update_rate);
   logStatus("True update rate: %.1f Hz", m_currentConfig.true_update_rate);
-
-  // Clear any stale data
-  while (m_serial.available())
+  logStatus("Mode flags: 0x%02X", m_currentConfig.mode_flags);
+  logStatus("Outlier filter: %d", m_currentConfig.filter_window);
+  logStatus("Aggregate period: %d s", m_currentConfig.aggregate_s);
+  if (m_currentConfig.secondary_interval != 0)
   {
-    m_serial.read();
+    logStatus("Secondary: %.2f-%.2f m, step %d, profile %d, every %d measurements",
+              m_currentConfig.secondary_start_m, m_currentConfig.secondary_end_m,
+              m_currentConfig.secondary_max_step_length, m_currentConfig.secondary_max_profile,
+              m_currentConfig.secondary_interval);
   }
 
+  // Clear any stale data
+  uart_flush_input(RADAR_UART);
+  xQueueReset(m_uartQueue);
+  m_rxHead = m_rxTail = 0;
+
   logStatus("\nRadar initialized\n");
   return true;
 }
@@ -60,8 +76,9 @@ bool RadarManager::initialize(uint8_t rxPin, uint8_t txPin, uint32_t baudRate)
  * @brief Main task for Radar Manager
  * @return none
  *
- * RadarTask continuously monitors serial data from STM32 and processes incoming
- * messages. Handles various commands including:
+ * RadarTask blocks on the UART driver's event queue, moves received bytes into
+ * the receive ring in bulk and processes every complete message. Handles
+ * various commands including:
  * - New distance measurements
  * - Configuration requests
  * - Start/stop data collection
@@ -69,20 +86,42 @@ bool RadarManager::initialize(uint8_t rxPin, uint8_t txPin, uint32_t baudRate)
  * - Debug messages
  *
  * All operations use a custom protocol with header bytes and command codes for
- * reliable communication between ESP32 and STM32.
+ * reliable communication between ESP32 and STM32. A partial message that isn't
+ * completed within DEFAULT_TIMEOUT_MS is discarded.
  */
 void RadarManager::radarTask()
 {
-  while (true)  // Add infinite loop
+  while (true)
   {
-    if (m_serial.available())
-    {
-      processRadarData();
-    }
+    serviceUart(pdMS_TO_TICKS(DEFAULT_TIMEOUT_MS));
+  }
+}
+
+
+/**
+ * @brief Runs one iteration of radarTask
+ * @param ticks Maximum time to wait for a UART event
+ * @return true if a UART event was handled, false on timeout
+ *
+ * Split out of radarTask so the host replay harness (test/replay) can drive the
+ * receive path one step at a time. A partial message is discarded once no
+ * bytes have arrived for DEFAULT_TIMEOUT_MS, independent of ticks.
+ */
+bool RadarManager::serviceUart(TickType_t ticks)
+{
+  if (waitForUartEvent(ticks))
+  {
+    m_lastRxTime = millis();
+    processRadarData();
+    return true;
+  }
 
-    // Prevent task starvation
-    vTaskDelay(pdMS_TO_TICKS(5));  // Small delay between checks
+  if (rxAvailable() > 0 && (millis() - m_lastRxTime) >= DEFAULT_TIMEOUT_MS)
+  {
+    logStatus("Timeout waiting for rest of message, discarding %d bytes", (int)rxAvailable());
+    m_rxTail = m_rxHead;
   }
+  return false;
 }
 
 
@@ -100,19 +139,8 @@ bool RadarManager::sendConfig(const ConfigSettings &config)
   m_currentConfig = config;
 
   // Format config string
-  char configStr[64];
-  snprintf(configStr, sizeof(configStr),
-           "%05.2f,%05.2f,%04.1f,%02d,%d,%04.1f,%d,%04.2f,%d,%04.1f",
-           config.start_m,
-           config.end_m,
-           config.update_rate,
-           config.max_step_length,
-           config.max_profile,
-           config.signal_quality,
-           config.reflector_shape,
-           config.threshold_sensitivity,
-           config.testing_update_rate,
-           config.true_update_rate);
+  char configStr[CONFIG_STRING_SIZE];
+  formatConfigString(config, configStr, sizeof(configStr));
 
   logStatus("Sending config to STM...");
 
@@ -124,53 +152,45 @@ bool RadarManager::sendConfig(const ConfigSettings &config)
 
   // Wait for echo and validation
   uint32_t startTime = millis();
-  while ((millis() - startTime) < CONFIG_TIMEOUT_MS)
+  uint8_t response[MAX_DATA_SIZE];
+  size_t len = readUntilNull(response, sizeof(response), CONFIG_TIMEOUT_MS);
+
+  if (len > 0)
   {
-    if (m_serial.available() >= 4)
+    logStatus("Received from STM32: %s", response);
+
+    // First validate the echo
+    if (!validateConfigEcho(response, len))
     {
-      uint8_t response[MAX_DATA_SIZE];
-      size_t len = m_serial.readBytesUntil(RADAR_NULL, response, sizeof(response));
+      logStatus("Config echo validation failed");
+      return false;
+    }
 
-      if (len > 0)
+    // Then wait for success/fail response
+    while ((millis() - startTime) < CONFIG_TIMEOUT_MS)
+    {
+      uint8_t header[4];
+      if (!readBytes(header, 4, CONFIG_TIMEOUT_MS - (millis() - startTime)))
       {
-        logStatus("Received from STM32: %s", response);
+        break;
+      }
 
-        // First validate the echo
-        if (!validateConfigEcho(response, len))
+      if (header[0] == RADAR_HEADER_BYTE1 &&
+          header[1] == RADAR_HEADER_BYTE2 &&
+          header[3] == RADAR_NULL)
+      {
+        if (header[2] == RADAR_CMD_CONFIG_GOOD)
         {
-          logStatus("Config echo validation failed");
-          return false;
+          logStatus("Configuration accepted by STM32");
+          return true;
         }
-
-        // Then wait for success/fail response
-        while ((millis() - startTime) < CONFIG_TIMEOUT_MS)
+        else if (header[2] == RADAR_CMD_CONFIG_BAD)
         {
-          if (m_serial.available() >= 4)
-          {
-            uint8_t header[4];
-            m_serial.readBytes(header, 4);
-
-            if (header[0] == RADAR_HEADER_BYTE1 &&
-                header[1] == RADAR_HEADER_BYTE2 &&
-                header[3] == RADAR_NULL)
-            {
-              if (header[2] == RADAR_CMD_CONFIG_GOOD)
-              {
-                logStatus("Configuration accepted by STM32");
-                return true;
-              }
-              else if (header[2] == RADAR_CMD_CONFIG_BAD)
-              {
-                logStatus("Configuration rejected by STM32");
-                return false;
-              }
-            }
-          }
-          delay(1);
+          logStatus("Configuration rejected by STM32");
+          return false;
         }
       }
     }
-    delay(1);
   }
 
   logStatus("Config timeout waiting for STM32 response");
@@ -187,12 +207,18 @@ bool RadarManager::sendConfig(const ConfigSettings &config)
  * 2. Restores UART and waits for stop acknowledgment
  * 3. Sends stop confirmation back to STM32
  *
- * Delay is calculated based on current update rate to ensure clean stop.
+ * Delay is calculated from the slowest update rate that can be active, as the
+ * STM32 only checks the TX line once per wakeup.
  */
 bool RadarManager::stopDataCollection()
 {
-  // Calculate delay based on update rate
-  uint32_t delay_ms = (uint32_t)(3000.0f / m_currentConfig.update_rate) + 1000;
+  // The adaptive rate can slow the STM32 below the configured rate, announced with rate frames
+  float rate = m_currentConfig.update_rate;
+  if (m_updateRate > 0.0f && m_updateRate < rate)
+  {
+    rate = m_updateRate;
+  }
+  uint32_t delay_ms = (uint32_t)(3000.0f / rate) + 1000;
 
   if (!performStopSequence(delay_ms, STOP_TIMEOUT_MS))
   {
@@ -200,6 +226,7 @@ bool RadarManager::stopDataCollection()
   }
 
   m_isActive = false;
+  SDCardManager::getInstance().requestSync();
   logStatus("Stopped radar data collection");
   return true;
 }
@@ -217,7 +244,7 @@ bool RadarManager::stopDataCollection()
 bool RadarManager::sendCommand(uint8_t cmd)
 {
   uint8_t buf[4] = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2, cmd, RADAR_NULL};
-  if (m_serial.write(buf, 4) != 4)
+  if (uart_write_bytes(RADAR_UART, (const char *)buf, 4) != 4)
   {
     logStatus("Failed to send command: 0x%02X", cmd);
     return false;
@@ -252,7 +279,7 @@ bool RadarManager::sendCommandWithData(uint8_t cmd, const uint8_t *data, size_t
   memcpy(&buf[3], data, len);
   buf[len + 3] = RADAR_NULL; // Put null terminator after the data
 
-  if (m_serial.write(buf, len + 4) != (len + 4))
+  if (uart_write_bytes(RADAR_UART, (const char *)buf, len + 4) != (int)(len + 4))
   {
     logStatus("Failed to send command with data: 0x%02X", cmd);
     return false;
@@ -263,142 +290,181 @@ bool RadarManager::sendCommandWithData(uint8_t cmd, const uint8_t *data, size_t
 
 
 /**
- * @brief Processes incoming data from STM32
- * @return true if valid message processed, false if error/invalid
- *
- * Handles all incoming messages from STM32 including:
- * - New distance measurements (RADAR_CMD_NEW_DATA)
- * - Configuration requests (RADAR_CMD_REQUEST_CONFIG)
- * - Start/stop commands (RADAR_CMD_START_DATA, RADAR_CMD_STOP_REQUEST)
- * - Update rate test messages (RADAR_CMD_START_TEST, RADAR_CMD_END_TEST)
- * - Noise control (RADAR_CMD_NOISE_ON, RADAR_CMD_NOISE_OFF)
- * - Debug messages (RADAR_CMD_DEBUG_MSG)
+ * @brief Processes all complete messages waiting in the receive ring
+ * @return none
  *
- * All messages must start with correct header bytes and end with null terminator.
- * Invalid messages are logged and discarded.
+ * Splits the receive ring into messages without copying: binary frames carry
+ * their own length, END_TEST has one raw count byte, and all other messages
+ * end with a null terminator. Each complete message is passed to
+ * dispatchMessage() by pointer. Bytes that don't start with the header are
+ * skipped up to the next header byte. Incomplete messages stay in the ring
+ * until more bytes arrive.
  */
-bool RadarManager::processRadarData()
+void RadarManager::processRadarData()
 {
-  if (m_serial.available() < 3)
-  {
-    return false;
-  }
-
-  uint8_t header[3];
-  m_serial.readBytes(header, 3);
-  uint8_t nullByte;
-  // if (!m_noiseBlocking)
-  // {
-  //   Serial.printf("Header received: %02X %02X %02X\n", header[0], header[1], header[2]);
-  // }
-  // Serial.printf("Header received: %02X %02X %02X\n", header[0], header[1], header[2]);
-
-  if (header[0] != RADAR_HEADER_BYTE1 || header[1] != RADAR_HEADER_BYTE2)
+  while (rxAvailable() >= 3)
   {
-    if (!m_noiseBlocking)
+    if (rxPeek(0) != RADAR_HEADER_BYTE1 || rxPeek(1) != RADAR_HEADER_BYTE2)
     {
-      logStatus("Invalid header received");
-    }
-    // Clear any stale data
-    while (m_serial.available())
-    {
-      m_serial.read();
+      size_t skipped = resyncToHeader();
+      if (!m_noiseBlocking)
+      {
+        logStatus("Invalid header received, skipped %d bytes", (int)skipped);
+      }
+      continue;
     }
-    return false;
-  }
 
-  switch (header[2])
-  {
+    uint8_t cmd = rxPeek(2);
+    size_t msgLen = 0;
 
-  case RADAR_CMD_NEW_DATA:
-  {
-    // Handle timing if active
-    if (m_discardCount > 0)
+    if (cmd == RADAR_CMD_DATA_FRAME || cmd == RADAR_CMD_TIMED_DATA_FRAME ||
+        cmd == RADAR_CMD_CONFIG_DATA_FRAME || cmd == RADAR_CMD_AGGREGATE_FRAME ||
+        cmd == RADAR_CMD_RATE_FRAME || cmd == RADAR_CMD_WINDOW_FRAME ||
+        cmd == RADAR_CMD_FILTERED_DATA_FRAME)
     {
-      m_discardCount--;
-    }
+      if (rxAvailable() < RADAR_FRAME_PREFIX_SIZE)
+      {
+        return;
+      }
 
-    if (!m_timingInProgress && m_discardCount <= 0 && m_sampleCount == 0)
-    {
-      // Start timing
-      m_timingInProgress = true;
-      m_timingStartTick = millis();
-      m_sampleCountMax = (uint32_t)(15*m_currentConfig.update_rate) > 15 ? 
-                         (uint32_t)(15*m_currentConfig.update_rate) : 15;
-      m_sampleCount = 0;
+      uint8_t prefix[RADAR_FRAME_PREFIX_SIZE];
+      for (size_t i = 0; i < RADAR_FRAME_PREFIX_SIZE; i++)
+      {
+        prefix[i] = rxPeek(i);
+      }
+
+      msgLen = RadarProtocol::frameSize(prefix);
+      if (msgLen == 0)
+      {
+        m_frameErrors++;
+        logStatus("Invalid frame 0x%02X (version 0x%02X, length %d)", cmd, prefix[3], prefix[4]);
+        rxConsume(2);
+        continue;
+      }
+      if (rxAvailable() < msgLen)
+      {
+        return;
+      }
     }
-    else if (m_timingInProgress)
+    else if (cmd == RADAR_CMD_END_TEST)
     {
-      m_sampleCount++;
-
-      // Check if we have enough samples
-      if (m_sampleCount >= m_sampleCountMax)
+      // [HEADER1][HEADER2][CMD][COUNT][NULL], count is a raw byte and may be 0
+      msgLen = 5;
+      if (rxAvailable() < msgLen)
       {
-        uint32_t totalTime = millis() - m_timingStartTick;
-        m_samplePeriod = (float)totalTime / m_sampleCount;
-        m_timingInProgress = false;
-        m_samplePeriodOver = true;
-
-        logStatus("Measured sample period: %.2f ms", m_samplePeriod);
-        // Inform TimeManager of the sample period
-        TimeManager::getInstance().setSamplePeriod(m_samplePeriod);
+        return;
       }
     }
-
-    uint8_t data[MAX_DATA_SIZE];
-    size_t len = 0;
-    uint32_t startTime = millis();
-
-    while ((millis() - startTime) < DEFAULT_TIMEOUT_MS && len < MAX_DATA_SIZE)
+    else
     {
-      if (m_serial.available())
+      msgLen = rxFindNull(3);
+      if (msgLen == 0 && rxAvailable() < MAX_DATA_SIZE)
       {
-        data[len] = m_serial.read();
-        if (data[len] == RADAR_NULL)
-        {
-          handleDistanceData(data, len);
-          return true;
-        }
-        len++;
+        return;
+      }
+      if (msgLen == 0 || msgLen > MAX_DATA_SIZE)
+      {
+        logStatus("Buffer overflow reading message 0x%02X", cmd);
+        rxConsume(3);
+        continue;
       }
     }
-    logStatus("Timeout or buffer overflow reading distance data");
-    break;
+
+    // The message is consumed before dispatching so handshakes started from
+    // dispatchMessage() (e.g. sendConfig) read the bytes that follow it.
+    // Those handshakes only read a few bytes, so the message memory isn't
+    // overwritten while it's in use.
+    const uint8_t *msg = rxContiguous(msgLen);
+    rxConsume(msgLen);
+    dispatchMessage(cmd, msg, msgLen);
   }
+}
 
-  case RADAR_CMD_REQUEST_CONFIG:
+
+/**
+ * @brief Handles one complete message from STM32
+ * @param cmd Command byte of the message
+ * @param msg Pointer to the complete message, starting at the header bytes
+ * @param len Length of the message including header and terminator/CRC
+ * @return true if valid message processed, false if error/invalid
+ *
+ * Handles all incoming messages from STM32 including:
+ * - New distance measurements (RADAR_CMD_NEW_DATA text, RADAR_CMD_DATA_FRAME and
+ *   RADAR_CMD_TIMED_DATA_FRAME binary)
+ * - Measurements that passed the STM32 outlier filter (RADAR_CMD_FILTERED_DATA_FRAME)
+ * - Secondary configuration measurements (RADAR_CMD_CONFIG_DATA_FRAME)
+ * - Aggregated measurements (RADAR_CMD_AGGREGATE_FRAME)
+ * - Update rate changes (RADAR_CMD_RATE_FRAME)
+ * - Range window moves (RADAR_CMD_WINDOW_FRAME)
+ * - Configuration requests (RADAR_CMD_REQUEST_CONFIG)
+ * - Start/stop commands (RADAR_CMD_START_DATA, RADAR_CMD_STOP_REQUEST)
+ * - Update rate test messages (RADAR_CMD_START_TEST, RADAR_CMD_END_TEST)
+ * - Noise control (RADAR_CMD_NOISE_ON, RADAR_CMD_NOISE_OFF)
+ * - Debug messages (RADAR_CMD_DEBUG_MSG)
+ * - Cycle counter profile zones (RADAR_CMD_PROFILE_MSG)
+ * - Energy estimates of a received configuration (RADAR_CMD_ENERGY_MSG)
+ *
+ * Invalid messages are logged and discarded.
+ */
+bool RadarManager::dispatchMessage(uint8_t cmd, const uint8_t *msg, size_t len)
+{
+  // Commands without data are exactly [HEADER1][HEADER2][CMD][NULL]
+  bool bareCommand = (len == 4);
+
+  switch (cmd)
   {
-    // Read the null terminator separately
-    if (!m_serial.available())
-    {
-      return false;
-    }
-    nullByte = m_serial.read();
 
-    if (nullByte == RADAR_NULL)
+  case RADAR_CMD_NEW_DATA:
+    updateSampleTiming();
+    handleDistanceData(msg + 3, len - 4);
+    return true;
+
+  case RADAR_CMD_DATA_FRAME:
+  case RADAR_CMD_TIMED_DATA_FRAME:
+  case RADAR_CMD_FILTERED_DATA_FRAME:
+    updateSampleTiming();
+    return handleDistancePacket(msg, len);
+
+  case RADAR_CMD_CONFIG_DATA_FRAME:
+    // Measured in the same wakeup as a primary frame, so not a sample period of its own
+    return handleDistancePacket(msg, len);
+
+  case RADAR_CMD_AGGREGATE_FRAME:
+    updateSampleTiming();
+    return handleAggregatePacket(msg, len);
+
+  case RADAR_CMD_RATE_FRAME:
+    return handleRatePacket(msg, len);
+
+  case RADAR_CMD_WINDOW_FRAME:
+    return handleWindowPacket(msg, len);
+
+  case RADAR_CMD_REQUEST_CONFIG:
+    if (bareCommand)
     {
       logStatus("Config requested by STM32");
       return sendConfig(m_currentConfig);
     }
     break;
-  }
 
   case RADAR_CMD_START_DATA:
-    if (!m_serial.available())
-    {
-      return false;
-    }
-    nullByte = m_serial.read();
-
-    if (nullByte == RADAR_NULL)
+    if (bareCommand)
     {
       logStatus("Starting data collection");
       SDCardManager::getInstance().requestNewDataFile();
       m_isActive = true;
 
+      // Reset binary frame tracking
+      m_haveSequence = false;
+      m_droppedFrames = 0;
+      m_frameErrors = 0;
+      m_warmupPeriodCount = 0;
+      m_haveWarmupStamp = false;
+
       // Start timing sequence
-      m_discardCount = (uint32_t) (5*m_currentConfig.update_rate) > 5 ?
-                       (uint32_t) (5*m_currentConfig.update_rate) : 5; // Discard 5*samplerate samples
+      m_updateRate = m_currentConfig.update_rate;
+      m_discardCount = (uint32_t) (5*m_updateRate) > 5 ?
+                       (uint32_t) (5*m_updateRate) : 5; // Discard 5*samplerate samples
       m_sampleCount = 0;
       m_timingInProgress = false; // Will start after discarding
       m_samplePeriodOver = false;
@@ -407,62 +473,26 @@ bool RadarManager::processRadarData()
     break;
 
   case RADAR_CMD_START_TEST:
-  {
-    if (!m_serial.available())
-    {
-      return false;
-    }
-    nullByte = m_serial.read();
-
-    if (nullByte == RADAR_NULL)
+    if (bareCommand)
     {
       m_testStartTime = millis();
       logStatus("Update rate test started");
       return true;
     }
     break;
-  }
+
   case RADAR_CMD_END_TEST:
   {
-    uint32_t startTime = millis();
-    char numStr[4] = {0}; // Buffer for up to 3 digits plus null
-    size_t pos = 0;
-
-    // Read digits until non-digit or timeout
-    while (pos < 3 && (millis() - startTime) < DEFAULT_TIMEOUT_MS)
-    {
-      if (m_serial.available())
-      {
-        char c = m_serial.read();
-        if (!isdigit(c))
-        {
-          break;
-        }
-        numStr[pos++] = c;
-      }
-    }
-
-    if (pos > 0)
-    {
-      uint8_t count = atoi(numStr);
-      uint32_t elapsed = millis() - m_testStartTime;
-      float actualRate = calculateUpdateRate(count, elapsed);
-      m_isTesting = false;
-      logStatus("Update rate test complete: %d samples, %.1f Hz", count, actualRate);
-      return true;
-    }
-    break;
+    uint8_t count = msg[3];
+    uint32_t elapsed = millis() - m_testStartTime;
+    float actualRate = calculateUpdateRate(count, elapsed);
+    m_isTesting = false;
+    logStatus("Update rate test complete: %d samples, %.1f Hz", count, actualRate);
+    return true;
   }
 
   case RADAR_CMD_STOP_REQUEST:
-  {
-    if (!m_serial.available())
-    {
-      return false;
-    }
-    nullByte = m_serial.read();
-
-    if (nullByte == RADAR_NULL)
+    if (bareCommand)
     {
       logStatus("Received stop request from STM32, sending confirmation");
 
@@ -470,6 +500,7 @@ bool RadarManager::processRadarData()
       if (sendCommand(RADAR_CMD_STOP_CONFIRM))
       {
         m_isActive = false;
+        SDCardManager::getInstance().requestSync();
         return true;
       }
       else
@@ -479,19 +510,11 @@ bool RadarManager::processRadarData()
       }
     }
     break;
-  }
 
   case RADAR_CMD_NOISE_ON:
-    if (!m_serial.available())
-    {
-      return false;
-    }
-    nullByte = m_serial.read();
-
-    if (nullByte == RADAR_NULL)
+    if (bareCommand)
     {
       m_noiseBlocking = true;
-      // Serial.printf("noise_on: %lu\n", millis());
       // Processing is done, stop timer
       if (isSamplingPeriodOver() && !BluetoothManager::getInstance().isEnabled())
       {
@@ -502,17 +525,10 @@ bool RadarManager::processRadarData()
     break;
 
   case RADAR_CMD_NOISE_OFF:
-    if (!m_serial.available())
-    {
-      return false;
-    }
-    nullByte = m_serial.read();
-
-    if (nullByte == RADAR_NULL)
+    if (bareCommand)
     {
       m_noiseBlocking = false;
       m_measurementInProgress = true;
-      // Serial.printf("noise_off: %lu\n", millis());
       // Start timing the processing
       if (isSamplingPeriodOver() && !BluetoothManager::getInstance().isEnabled())
       {
@@ -523,42 +539,25 @@ bool RadarManager::processRadarData()
     break;
 
   case RADAR_CMD_DEBUG_MSG:
-  {
-    // Buffer for debug message including null terminator
-    uint8_t data[MAX_DATA_SIZE];
-    size_t len = 0;
-    uint32_t startTime = millis();
+    // Message is null terminated in place
+    logStatus("STM32 Debug: %s", (const char *)(msg + 3));
+    return true;
 
-    // Read until null terminator or timeout
-    while ((millis() - startTime) < DEFAULT_TIMEOUT_MS && len < MAX_DATA_SIZE - 1)
-    {
-      if (m_serial.available())
-      {
-        data[len] = m_serial.read();
-        if (data[len] == RADAR_NULL) // Found null terminator
-        {
-          // Explicitly null terminate the string
-          data[len] = '\0';
-          // Log the debug message from STM32
-          logStatus("STM32 Debug: %s", data);
-          return true;
-        }
-        len++;
-      }
-    }
-    logStatus("Timeout or buffer overflow reading debug message");
-    break;
-  }
+  case RADAR_CMD_PROFILE_MSG:
+    // "<zone> n=<count> min=<us> mean=<us> max=<us> us hist=<counts>", logged for offline analysis
+    logStatus("STM32 Profile: %s", (const char *)(msg + 3));
+    return true;
+
+  case RADAR_CMD_ENERGY_MSG:
+    // Sent before the sensor starts, so an operator can still change a config that drains the battery early
+    logStatus("STM32 Energy: %s", (const char *)(msg + 3));
+    BluetoothManager::getInstance().sendMessageSTM32("Energy estimate: %s", (const char *)(msg + 3));
+    return true;
 
   default:
     if (!m_noiseBlocking)
     {
-      logStatus("Unknown command received: 0x%02X", header[2]);
-    }
-    // Clear any stale data
-    while (m_serial.available())
-    {
-      m_serial.read();
+      logStatus("Unknown command received: 0x%02X", cmd);
     }
     break;
   }
@@ -568,158 +567,635 @@ bool RadarManager::processRadarData()
 
 
 /**
- * @brief Processes and logs distance measurement data
- * @param data Pointer to raw distance data
- * @param len Length of data
+ * @brief Updates sample period measurement for each received sample
  * @return none
  *
- * Formats distance data with timestamp and handles:
- * - Empty measurements ("no_dists")
- * - Valid distance measurements
- *
- * Data is logged to:
- * - SD card (always)
- * - Serial monitor (rate limited)
- * - Bluetooth (rate limited)
- *
- * Rate limiting prevents overwhelming serial/BT connections while ensuring
- * all data is saved to SD card.
+ * Discards the first samples after START_DATA, then times m_sampleCountMax
+ * samples and passes the measured period to TimeManager for sleep scheduling.
  */
-void RadarManager::handleDistanceData(const uint8_t *data, size_t len)
+void RadarManager::updateSampleTiming()
 {
-  // Get timestamp
-  char timestamp[32];
-  TimeManager::getInstance().getFormattedTimestamp(timestamp, sizeof(timestamp));
-
-  // Make a null-terminated copy of the data
-  char dataStr[MAX_DATA_SIZE];
-  memcpy(dataStr, data, len);
-  dataStr[len] = '\0';
-
-  if (len == 0 || dataStr[0] == '\0')
+  // Handle timing if active
+  if (m_discardCount > 0)
   {
-    // For empty data, print "no_dists" with timestamp to Serial and BT only
-    char noDistStr[64];
-    snprintf(noDistStr, sizeof(noDistStr), "%s no_dists", timestamp);
+    m_discardCount--;
+  }
 
-    SDCardManager::getInstance().queueData("%s", noDistStr);
+  if (!m_timingInProgress && m_discardCount <= 0 && m_sampleCount == 0)
+  {
+    // Start timing
+    m_timingInProgress = true;
+    m_timingStartTick = millis();
+    m_sampleCountMax = (uint32_t)(15*m_updateRate) > 15 ?
+                       (uint32_t)(15*m_updateRate) : 15;
+    m_sampleCount = 0;
+  }
+  else if (m_timingInProgress)
+  {
+    m_sampleCount++;
 
-    // Check if enough time has passed to print again
-    uint32_t currentTime = millis();
-    if ((currentTime - m_lastPrintTime) >= MIN_PRINT_INTERVAL_MS)
+    // Check if we have enough samples
+    if (m_sampleCount >= m_sampleCountMax)
     {
-      Serial.println(noDistStr);
-      BluetoothManager::getInstance().sendWithWrapping("", noDistStr, false);
-      m_lastPrintTime = currentTime;
+      uint32_t totalTime = millis() - m_timingStartTick;
+      m_samplePeriod = (float)totalTime / m_sampleCount;
+      m_timingInProgress = false;
+      m_samplePeriodOver = true;
+
+      logStatus("Measured sample period: %.2f ms", m_samplePeriod);
+      // Inform TimeManager of the sample period
+      TimeManager::getInstance().setSamplePeriod(m_samplePeriod);
     }
-
-    m_measurementInProgress = false;
-    return;
   }
+}
 
-  // For valid data, include timestamp and save to all outputs
-  char fullStr[MAX_DATA_SIZE + 32]; // Add space for timestamp
-  snprintf(fullStr, sizeof(fullStr), "%s %s", timestamp, dataStr);
 
-  // Always log the data
-  SDCardManager::getInstance().queueData("%s", fullStr);
+/**
+ * @brief Decodes a complete binary distance frame
+ * @param frame Pointer to the frame, starting at the header bytes
+ * @param frameLen Length of the frame including CRC
+ * @return true if a valid frame was received, false if CRC mismatch
+ *
+ * Sequence gaps are counted as dropped frames; CRC failures are counted
+ * as frame errors and the frame is discarded. The first untimed frame after
+ * the rate warm-up reports it. Frames of the secondary configuration go to
+ * their own stream.
+ */
+bool RadarManager::handleDistancePacket(const uint8_t *frame, size_t frameLen)
+{
+  RadarDistanceFrame decoded;
+  if (!RadarProtocol::decodeDistanceFrame(frame, frameLen, &decoded))
+  {
+    m_frameErrors++;
+    logStatus("Distance frame CRC mismatch (%lu errors)", (unsigned long)m_frameErrors);
+    return false;
+  }
 
-  // Check if enough time has passed to print again
-  uint32_t currentTime = millis();
-  if ((currentTime - m_lastPrintTime) >= MIN_PRINT_INTERVAL_MS)
+  trackSequence(decoded.sequence);
+  if (decoded.configIndex != 0)
   {
-    Serial.println(fullStr);
-    BluetoothManager::getInstance().sendWithWrapping("", fullStr, false);
-    m_lastPrintTime = currentTime;
+    handleConfigFrame(decoded);
+    return true;
   }
 
-  m_measurementInProgress = false;
+  if (decoded.timed)
+  {
+    trackRateWarmup(decoded);
+  }
+  else
+  {
+    reportRateWarmup();
+  }
+  handleDistanceFrame(decoded);
+  return true;
 }
 
 
 /**
- * @brief Logs status messages to debug log
- * @param format Printf-style format string
- * @param ... Variable arguments for format string
- * @return none
+ * @brief Decodes a complete binary aggregate frame
+ * @param frame Pointer to the frame, starting at the header bytes
+ * @param frameLen Length of the frame including CRC
+ * @return true if a valid frame was received, false if CRC mismatch
  *
- * Adds "Radar:" prefix to all messages.
- * Messages are printed to Serial and queued for SD card logging.
+ * Aggregate frames share the sequence counter with distance frames.
  */
-void RadarManager::logStatus(const char *format, ...)
+bool RadarManager::handleAggregatePacket(const uint8_t *frame, size_t frameLen)
 {
-  char messageBuffer[256];
-  va_list args;
-  va_start(args, format);
-  vsnprintf(messageBuffer, sizeof(messageBuffer), format, args);
-  va_end(args);
-
-  // Print to Serial for debugging
-  Serial.println(messageBuffer);
+  RadarAggregateFrame decoded;
+  if (!RadarProtocol::decodeAggregateFrame(frame, frameLen, &decoded))
+  {
+    m_frameErrors++;
+    logStatus("Aggregate frame CRC mismatch (%lu errors)", (unsigned long)m_frameErrors);
+    return false;
+  }
 
-  // Queue for SD card logging
-  SDCardManager::getInstance().queueDebug("Radar: %s", messageBuffer);
+  trackSequence(decoded.sequence);
+  reportRateWarmup();
+  handleAggregateFrame(decoded);
+  return true;
 }
 
 
 /**
- * @brief Executes radar stop sequence
- * @param delay_ms Delay time in milliseconds between steps
- * @param timeout_ms Maximum time to wait for acknowledgment
- * @return true if stop sequence completed successfully, false if timeout/error
+ * @brief Decodes a complete binary rate frame
+ * @param frame Pointer to the frame, starting at the header bytes
+ * @param frameLen Length of the frame including CRC
+ * @return true if a valid frame was received, false if CRC mismatch
  *
- * Performs coordinated shutdown:
- * 1. Disable UART
- * 2. Set TX pin low for specified delay
- * 3. Restore UART
- * 4. Wait for stop acknowledgment
- * 5. Send confirmation
- *
- * Delay is calculated based on update rate to ensure clean stop.
- * Times out if no acknowledgment received within timeout period.
+ * Rate frames share the sequence counter with distance frames.
  */
-bool RadarManager::performStopSequence(uint32_t delay_ms, uint32_t timeout_ms)
+bool RadarManager::handleRatePacket(const uint8_t *frame, size_t frameLen)
 {
-  // Log to both status and Bluetooth
+  RadarRateFrame decoded;
+  if (!RadarProtocol::decodeRateFrame(frame, frameLen, &decoded))
+  {
+    m_frameErrors++;
+    logStatus("Rate frame CRC mismatch (%lu errors)", (unsigned long)m_frameErrors);
+    return false;
+  }
+
+  trackSequence(decoded.sequence);
+  handleRateFrame(decoded);
+  return true;
+}
+
+
+/**
+ * @brief Decodes a complete binary window frame
+ * @param frame Pointer to the frame, starting at the header bytes
+ * @param frameLen Length of the frame including CRC
+ * @return true if a valid frame was received, false if CRC mismatch
+ *
+ * Window frames share the sequence counter with distance frames.
+ */
+bool RadarManager::handleWindowPacket(const uint8_t *frame, size_t frameLen)
+{
+  RadarWindowFrame decoded;
+  if (!RadarProtocol::decodeWindowFrame(frame, frameLen, &decoded))
+  {
+    m_frameErrors++;
+    logStatus("Window frame CRC mismatch (%lu errors)", (unsigned long)m_frameErrors);
+    return false;
+  }
+
+  trackSequence(decoded.sequence);
+  handleWindowFrame(decoded);
+  return true;
+}
+
+
+/**
+ * @brief Collects the periods between timed frames of the rate warm-up
+ * @param frame Decoded timed distance frame
+ * @return none
+ *
+ * Periods come from the STM32 timestamps, so UART and ESP32 scheduling
+ * delays don't add jitter. A period is only taken between frames with
+ * consecutive sequence numbers, a dropped frame would double it.
+ */
+void RadarManager::trackRateWarmup(const RadarDistanceFrame &frame)
+{
+  if (m_haveWarmupStamp && frame.sequence == (uint8_t)(m_warmupLastSequence + 1) &&
+      m_warmupPeriodCount < RADAR_RATE_WARMUP_MEASUREMENTS)
+  {
+    m_warmupPeriods[m_warmupPeriodCount++] = (float)(frame.timestampMs - m_warmupLastStamp);
+  }
+
+  m_warmupLastStamp = frame.timestampMs;
+  m_warmupLastSequence = frame.sequence;
+  m_haveWarmupStamp = true;
+
+  if (m_warmupPeriodCount == RADAR_RATE_WARMUP_MEASUREMENTS - 1)
+  {
+    reportRateWarmup();
+  }
+}
+
+
+/**
+ * @brief Reports the update rate and period jitter measured in the warm-up
+ * @return none
+ *
+ * Replaces the separate update rate test (RADAR_CMD_START_TEST/END_TEST):
+ * the mean period goes to TimeManager for sleep scheduling straight away,
+ * and the percentiles are logged and noted on a "#" line in the data file.
+ * Does nothing if there is no warm-up to report.
+ */
+void RadarManager::reportRateWarmup()
+{
+  uint8_t count = m_warmupPeriodCount;
+  m_warmupPeriodCount = 0;
+  m_haveWarmupStamp = false;
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  float sorted[RADAR_RATE_WARMUP_MEASUREMENTS];
+  float sum = 0.0f;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    sorted[i] = m_warmupPeriods[i];
+    sum += sorted[i];
+  }
+  std::sort(sorted, sorted + count);
+
+  // Linear interpolation between the nearest ranks, like numpy.percentile
+  auto percentile = [&](float p)
+  {
+    float position = p * (count - 1);
+    uint8_t lo = (uint8_t)position;
+    uint8_t hi = (lo + 1 < count) ? lo + 1 : lo;
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (position - lo);
+  };
+
+  float mean = sum / count;
+  float p50 = percentile(0.50f);
+  float p90 = percentile(0.90f);
+  float p99 = percentile(0.99f);
+  float max = sorted[count - 1];
+  float rate = (mean > 0.0f) ? 1000.0f / mean : 0.0f;
+
+  logStatus("Update rate warm-up: %d periods, %.2f Hz, period p50 %.1f p90 %.1f p99 %.1f max %.1f ms",
+            count, rate, p50, p90, p99, max);
+  SDCardManager::getInstance().queueData("# rate_test periods=%d rate=%.2fHz p50=%.1fms p90=%.1fms p99=%.1fms max=%.1fms",
+                                         count, rate, p50, p90, p99, max);
+
+  if (mean > 0.0f)
+  {
+    m_samplePeriod = mean;
+    m_samplePeriodOver = true;
+    TimeManager::getInstance().setSamplePeriod(m_samplePeriod);
+  }
+}
+
+
+/**
+ * @brief Counts sequence number gaps as dropped frames
+ * @param sequence Sequence number of a valid binary frame
+ * @return none
+ */
+void RadarManager::trackSequence(uint8_t sequence)
+{
+  if (m_haveSequence)
+  {
+    uint8_t gap = (uint8_t)(sequence - m_lastSequence - 1);
+    if (gap > 0)
+    {
+      m_droppedFrames += gap;
+      logStatus("Dropped %d frame(s) (%lu total)", gap, (unsigned long)m_droppedFrames);
+    }
+  }
+  m_lastSequence = sequence;
+  m_haveSequence = true;
+}
+
+
+/**
+ * @brief Processes and logs text distance measurement data
+ * @param data Pointer to raw distance data
+ * @param len Length of data
+ * @return none
+ *
+ * Used for the text protocol (RADAR_CMD_NEW_DATA), where the STM32 sends
+ * "distance,strength;" pairs. Empty data means no distances were found.
+ */
+void RadarManager::handleDistanceData(const uint8_t *data, size_t len)
+{
+  // Make a null-terminated copy of the data
+  char dataStr[MAX_DATA_SIZE];
+  memcpy(dataStr, data, len);
+  dataStr[len] = '\0';
+
+  // Binary logging stores the numbers, so parse the "d,s;" pairs back out
+  BinaryLogSample values = {};
+  if (m_currentConfig.mode_flags & RADAR_MODE_BINARY_LOG)
+  {
+    const char *p = dataStr;
+    while (values.count < BINLOG_MAX_DISTANCES && *p != '\0')
+    {
+      char *end;
+      float distance = strtof(p, &end);
+      if (end == p || *end != ',')
+        break;
+      p = end + 1;
+      float strength = strtof(p, &end);
+      if (end == p)
+        break;
+      values.distances_mm[values.count] = (uint16_t)lroundf(distance * 1000.0f);
+      values.strengths_cdb[values.count] = (int16_t)lroundf(strength * 100.0f);
+      values.count++;
+      p = (*end == ';') ? end + 1 : end;
+    }
+  }
+
+  outputDistanceLine(dataStr, values, 0);
+}
+
+
+/**
+ * @brief Processes and logs a decoded binary distance frame
+ * @param frame Decoded distance frame
+ * @return none
+ *
+ * Renders the frame in the same "distance,strength;" text used by the text
+ * protocol so data files look identical regardless of the link format.
+ * Filtered frames are timestamped when they were measured, not received.
+ */
+void RadarManager::handleDistanceFrame(const RadarDistanceFrame &frame)
+{
+  char dataStr[MAX_DATA_SIZE];
+  size_t pos = 0;
+  dataStr[0] = '\0';
+  BinaryLogSample values = {};
+
+  for (uint8_t i = 0; i < frame.numDistances && pos < sizeof(dataStr); i++)
+  {
+    pos += snprintf(dataStr + pos, sizeof(dataStr) - pos, "%.3f,%.2f;",
+                    frame.distances[i], frame.strengths[i]);
+    values.distances_mm[i] = (uint16_t)lroundf(frame.distances[i] * 1000.0f);
+    values.strengths_cdb[i] = (int16_t)lroundf(frame.strengths[i] * 100.0f);
+    values.count++;
+  }
+
+  outputDistanceLine(dataStr, values, frame.ageMs);
+}
+
+
+/**
+ * @brief Stores a measurement of a secondary configuration
+ * @param frame Decoded config distance frame
+ * @return none
+ *
+ * Secondary measurements are written to the stream file of their
+ * configuration next to the data file, not printed, so the primary data file
+ * and the Serial/BT output only ever hold one range.
+ */
+void RadarManager::handleConfigFrame(const RadarDistanceFrame &frame)
+{
+  BinaryLogSample values = {};
+
+  for (uint8_t i = 0; i < frame.numDistances && i < BINLOG_MAX_DISTANCES; i++)
+  {
+    values.distances_mm[i] = (uint16_t)lroundf(frame.distances[i] * 1000.0f);
+    values.strengths_cdb[i] = (int16_t)lroundf(frame.strengths[i] * 100.0f);
+    values.count++;
+  }
+
+  SDCardManager::getInstance().queueSample(TimeManager::getInstance().getEpochMs(), values, frame.configIndex);
+}
+
+
+/**
+ * @brief Processes and logs a decoded aggregate frame
+ * @param frame Decoded aggregate frame
+ * @return none
+ *
+ * The median is output like a single-target measurement, so data files stay
+ * readable by sd_plotter.py and wave_analyze. The spread follows on a "#"
+ * line, which those readers skip.
+ */
+void RadarManager::handleAggregateFrame(const RadarAggregateFrame &frame)
+{
+  char dataStr[MAX_DATA_SIZE];
+  dataStr[0] = '\0';
+  BinaryLogSample values = {};
+
+  if (frame.samples > 0)
+  {
+    snprintf(dataStr, sizeof(dataStr), "%.3f,%.2f;", frame.median, frame.meanStrength);
+    values.distances_mm[0] = (uint16_t)lroundf(frame.median * 1000.0f);
+    values.strengths_cdb[0] = (int16_t)lroundf(frame.meanStrength * 100.0f);
+    values.count = 1;
+  }
+
+  outputDistanceLine(dataStr, values, 0);
+
+  SDCardManager::getInstance().queueData("# aggregate min=%.3f max=%.3f samples=%u outliers=%u empty=%u period=%.1fs",
+                                         frame.min, frame.max, frame.samples, frame.outliers, frame.empty,
+                                         frame.periodMs / 1000.0f);
+}
+
+
+/**
+ * @brief Follows an update rate change of the STM32
+ * @param frame Decoded rate frame
+ * @return none
+ *
+ * The STM32 sleeps for the announced period from the measurement before the
+ * frame on, so TimeManager gets it straight away instead of after the next
+ * timing window, which at the slowest rate would take minutes. The realised
+ * period is then measured again at the new rate, skipping the measurement
+ * that may still have been on the old period. The change is noted on a "#"
+ * line so data files show where the sample spacing changes.
+ */
+void RadarManager::handleRateFrame(const RadarRateFrame &frame)
+{
+  m_updateRate = 1000.0f / frame.periodMs;
+  m_samplePeriod = (float)frame.periodMs;
+  m_samplePeriodOver = true;
+  TimeManager::getInstance().setSamplePeriod(m_samplePeriod);
+
+  m_discardCount = 1;
+  m_sampleCount = 0;
+  m_timingInProgress = false;
+
+  logStatus("Update rate changed to %.2f Hz (spread %.3f m)", m_updateRate, frame.spread);
+  SDCardManager::getInstance().queueData("# rate period=%.1fs spread=%.3f", frame.periodMs / 1000.0f, frame.spread);
+}
+
+
+/**
+ * @brief Follows a move of the STM32's measured range
+ * @param frame Decoded window frame
+ * @return none
+ *
+ * The STM32 recalibrates the detector for the new range before its next
+ * measurement, which makes that period longer, so it is left out of the
+ * sample period like after a rate change. The move is noted on a "#" line so
+ * data files show which range each measurement came from.
+ */
+void RadarManager::handleWindowFrame(const RadarWindowFrame &frame)
+{
+  m_discardCount = 1;
+  m_sampleCount = 0;
+  m_timingInProgress = false;
+
+  logStatus("Range window moved to %.2f-%.2f m%s", frame.start, frame.end, frame.searching ? " (searching)" : "");
+  SDCardManager::getInstance().queueData("# window start=%.3f end=%.3f%s", frame.start, frame.end,
+                                         frame.searching ? " search" : "");
+}
+
+
+/**
+ * @brief Timestamps and outputs one measurement
+ * @param dataStr Null-terminated distance text, empty if no distances found
+ * @param values Same measurement in fixed point, used for binary logging
+ * @param ageMs Time since the measurement, it is timestamped that much earlier
+ * @return none
+ *
+ * Handles both empty measurements ("no_dists") and valid distance measurements.
+ * Data is logged to:
+ * - SD card (always), as text or as a BinaryLog sample if RADAR_MODE_BINARY_LOG is set
+ * - Serial monitor (rate limited)
+ * - Bluetooth (rate limited)
+ *
+ * Rate limiting prevents overwhelming serial/BT connections while ensuring
+ * all data is saved to SD card. In binary mode the text timestamp is only
+ * formatted for measurements that get printed.
+ */
+void RadarManager::outputDistanceLine(const char *dataStr, const BinaryLogSample &values, uint32_t ageMs)
+{
+  bool binaryLog = (m_currentConfig.mode_flags & RADAR_MODE_BINARY_LOG) != 0;
+  uint32_t currentTime = millis();
+  bool printNow = (currentTime - m_lastPrintTime) >= MIN_PRINT_INTERVAL_MS;
+
+  uint64_t epochMs = TimeManager::getInstance().getEpochMs();
+  if (ageMs < epochMs)
+  {
+    epochMs -= ageMs;
+  }
+
+  if (binaryLog)
+  {
+    SDCardManager::getInstance().queueSample(epochMs, values);
+    if (!printNow)
+    {
+      m_measurementInProgress = false;
+      return;
+    }
+  }
+
+  // Get timestamp, only the seconds digits are re-rendered between samples
+  char timestamp[TimestampFormatter::TIMESTAMP_LENGTH];
+  m_timestampFormatter.format(epochMs, timestamp, sizeof(timestamp));
+
+  if (dataStr[0] == '\0')
+  {
+    // For empty data, print "no_dists" with timestamp to Serial and BT only
+    char noDistStr[64];
+    snprintf(noDistStr, sizeof(noDistStr), "%s no_dists", timestamp);
+
+    if (!binaryLog)
+    {
+      SDCardManager::getInstance().queueData("%s", noDistStr);
+    }
+
+    // Check if enough time has passed to print again
+    if (printNow)
+    {
+      Serial.println(noDistStr);
+      BluetoothManager::getInstance().sendWithWrapping("", noDistStr, false);
+      m_lastPrintTime = currentTime;
+    }
+
+    m_measurementInProgress = false;
+    return;
+  }
+
+  // For valid data, include timestamp and save to all outputs
+  char fullStr[MAX_DATA_SIZE + 32]; // Add space for timestamp
+  snprintf(fullStr, sizeof(fullStr), "%s %s", timestamp, dataStr);
+
+  // Always log the data
+  if (!binaryLog)
+  {
+    SDCardManager::getInstance().queueData("%s", fullStr);
+  }
+
+  // Check if enough time has passed to print again
+  if (printNow)
+  {
+    Serial.println(fullStr);
+    BluetoothManager::getInstance().sendWithWrapping("", fullStr, false);
+    m_lastPrintTime = currentTime;
+  }
+
+  m_measurementInProgress = false;
+}
+
+
+/**
+ * @brief Logs status messages to debug log
+ * @param format Printf-style format string
+ * @param ... Variable arguments for format string
+ * @return none
+ *
+ * Adds "Radar:" prefix to all messages.
+ * Messages are printed to Serial and queued for SD card logging.
+ */
+void RadarManager::logStatus(const char *format, ...)
+{
+  char messageBuffer[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(messageBuffer, sizeof(messageBuffer), format, args);
+  va_end(args);
+
+  // Print to Serial for debugging
+  Serial.println(messageBuffer);
+
+  // Queue for SD card logging
+  SDCardManager::getInstance().queueDebug("Radar: %s", messageBuffer);
+}
+
+
+/**
+ * @brief Executes radar stop sequence
+ * @param delay_ms Delay time in milliseconds between steps
+ * @param timeout_ms Maximum time to wait for acknowledgment
+ * @return true if stop sequence completed successfully, false if timeout/error
+ *
+ * Performs coordinated shutdown:
+ * 1. Delete UART driver
+ * 2. Set TX pin low for specified delay
+ * 3. Reinstall UART driver
+ * 4. Wait for stop acknowledgment, logging the filtered measurements and
+ *    aggregate the STM32 sends ahead of it
+ * 5. Send confirmation
+ *
+ * Delay is calculated based on update rate to ensure clean stop.
+ * Times out if no acknowledgment received within timeout period.
+ */
+bool RadarManager::performStopSequence(uint32_t delay_ms, uint32_t timeout_ms)
+{
+  // Log to both status and Bluetooth
   logStatus("Stopping radar... (%.1f second delay)", delay_ms / 1000.0f);
   BluetoothManager::getInstance().sendMessageESP32("Stopping radar... (%.1f second delay)", delay_ms / 1000.0f);
 
   // Disable UART
-  uart_driver_delete(UART_NUM_2);
+  stopUart();
 
   // Configure TX pin as output and set LOW
   gpio_set_direction((gpio_num_t)m_txPin, GPIO_MODE_OUTPUT);
   gpio_set_level((gpio_num_t)m_txPin, 0);
 
-  // Wait for calculated delay
-  uint32_t startTime = millis();
-  while ((millis() - startTime) < delay_ms)
-    ;
+  // Hold TX low for the calculated delay, letting other tasks run meanwhile
+  vTaskDelay(pdMS_TO_TICKS(delay_ms));
 
   // Restart UART
-  m_serial.begin(921600, SERIAL_8E1, m_rxPin, m_txPin);
+  if (!startUart())
+  {
+    logStatus("Failed to restart radar UART");
+    return false;
+  }
 
   // Wait for stop acknowledgment
-  startTime = millis();
+  uint32_t startTime = millis();
 
   while ((millis() - startTime) < timeout_ms)
   {
-    if (m_serial.available() >= 4)
+    uint8_t response[RADAR_FRAME_PREFIX_SIZE + RADAR_FRAME_MAX_PAYLOAD + RADAR_FRAME_CRC_SIZE];
+    if (!readBytes(response, 4, timeout_ms - (millis() - startTime)))
     {
-      uint8_t response[4];
-      m_serial.readBytes(response, 4);
+      break;
+    }
 
-      if (response[0] == RADAR_HEADER_BYTE1 &&
-          response[1] == RADAR_HEADER_BYTE2 &&
-          response[2] == RADAR_CMD_STOP_REQUEST &&
-          response[3] == RADAR_NULL)
-      {
+    if (response[0] == RADAR_HEADER_BYTE1 &&
+        response[1] == RADAR_HEADER_BYTE2 &&
+        response[2] == RADAR_CMD_STOP_REQUEST &&
+        response[3] == RADAR_NULL)
+    {
 
-        // Send confirmation
-        return sendCommand(RADAR_CMD_STOP_CONFIRM);
+      // Send confirmation
+      return sendCommand(RADAR_CMD_STOP_CONFIRM);
+    }
+
+    // The STM32 sends what is left in its outlier filter and aggregate ahead of the request
+    if (response[0] == RADAR_HEADER_BYTE1 &&
+        response[1] == RADAR_HEADER_BYTE2 &&
+        (response[2] == RADAR_CMD_FILTERED_DATA_FRAME || response[2] == RADAR_CMD_AGGREGATE_FRAME) &&
+        readBytes(response + 4, RADAR_FRAME_PREFIX_SIZE - 4, timeout_ms - (millis() - startTime)))
+    {
+      size_t frameLen = RadarProtocol::frameSize(response);
+      if (frameLen != 0 &&
+          readBytes(response + RADAR_FRAME_PREFIX_SIZE, frameLen - RADAR_FRAME_PREFIX_SIZE,
+                    timeout_ms - (millis() - startTime)))
+      {
+        dispatchMessage(response[2], response, frameLen);
       }
     }
-    delay(1);
   }
 
   logStatus("Stop sequence timeout");
@@ -781,19 +1257,8 @@ bool RadarManager::validateConfigEcho(const uint8_t *received, size_t len)
   }
 
   // Format the expected config string
-  char expectedStr[64];
-  snprintf(expectedStr, sizeof(expectedStr),
-           "%05.2f,%05.2f,%04.1f,%02d,%d,%04.1f,%d,%04.2f,%d,%04.1f",
-           m_currentConfig.start_m,
-           m_currentConfig.end_m,
-           m_currentConfig.update_rate,
-           m_currentConfig.max_step_length,
-           m_currentConfig.max_profile,
-           m_currentConfig.signal_quality,
-           m_currentConfig.reflector_shape,
-           m_currentConfig.threshold_sensitivity,
-           m_currentConfig.testing_update_rate,
-           m_currentConfig.true_update_rate);
+  char expectedStr[CONFIG_STRING_SIZE];
+  formatConfigString(m_currentConfig, expectedStr, sizeof(expectedStr));
 
   // Compare the config strings (skip doubled header + cmd bytes)
   if (len < (strlen(expectedStr) + 5))
@@ -814,3 +1279,322 @@ bool RadarManager::validateConfigEcho(const uint8_t *received, size_t len)
   logStatus("Config echo validated successfully");
   return true;
 }
+
+
+/**
+ * @brief Formats configuration settings as the STM32 config string
+ * @param config Configuration settings to format
+ * @param buffer Buffer to store formatted string
+ * @param size Size of buffer
+ * @return none
+ *
+ * Format: start_m,end_m,update_rate,max_step_length,max_profile,signal_quality,
+ * reflector_shape,threshold_sensitivity,testing_update_rate,true_update_rate,mode_flags
+ * e.g. "00.40,01.20,05.0,02,5,35.0,1,0.50,0,05.1,01" (mode_flags in hex)
+ *
+ * filter_window and aggregate_s are appended (",13,0010") only if either is
+ * set, so STM32 firmware that predates them keeps getting a string it accepts.
+ * The secondary configuration follows them (",00.20,06.00,08,5,0020") only if
+ * secondary_interval is set, RADAR_MODE_TRACKING searches its range or
+ * RADAR_MODE_BANDS measures it around the primary.
+ */
+void RadarManager::formatConfigString(const ConfigSettings &config, char *buffer, size_t size)
+{
+  snprintf(buffer, size,
+           "%05.2f,%05.2f,%04.1f,%02d,%d,%04.1f,%d,%04.2f,%d,%04.1f,%02X",
+           config.start_m,
+           config.end_m,
+           config.update_rate,
+           config.max_step_length,
+           config.max_profile,
+           config.signal_quality,
+           config.reflector_shape,
+           config.threshold_sensitivity,
+           config.testing_update_rate,
+           config.true_update_rate,
+           config.mode_flags);
+
+  bool secondary = config.secondary_interval != 0 || (config.mode_flags & (RADAR_MODE_TRACKING | RADAR_MODE_BANDS));
+
+  if (config.filter_window != 0 || config.aggregate_s != 0 || secondary)
+  {
+    size_t len = strlen(buffer);
+    snprintf(buffer + len, size - len, ",%02d,%04d", config.filter_window, config.aggregate_s);
+  }
+
+  if (secondary)
+  {
+    size_t len = strlen(buffer);
+    snprintf(buffer + len, size - len, ",%05.2f,%05.2f,%02d,%d,%04d",
+             config.secondary_start_m,
+             config.secondary_end_m,
+             config.secondary_max_step_length,
+             config.secondary_max_profile,
+             config.secondary_interval);
+  }
+}
+
+
+/**
+ * @brief Installs the UART driver for the STM32 link
+ * @return true if driver installed, false if error
+ *
+ * Uses the ESP-IDF UART driver with an event queue (8E1, m_baudRate). The
+ * driver posts a UART_DATA event when its RX FIFO fills or the line goes idle,
+ * so radarTask only wakes when there are bytes to process.
+ */
+bool RadarManager::startUart()
+{
+  uart_config_t uartConfig = {};
+  uartConfig.baud_rate = (int)m_baudRate;
+  uartConfig.data_bits = UART_DATA_8_BITS;
+  uartConfig.parity = UART_PARITY_EVEN;
+  uartConfig.stop_bits = UART_STOP_BITS_1;
+  uartConfig.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+  if (uart_param_config(RADAR_UART, &uartConfig) != ESP_OK ||
+      uart_set_pin(RADAR_UART, m_txPin, m_rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK ||
+      uart_driver_install(RADAR_UART, UART_DRIVER_RX_SIZE, 0, UART_EVENT_QUEUE_SIZE, &m_uartQueue, 0) != ESP_OK)
+  {
+    return false;
+  }
+
+  m_rxHead = m_rxTail = 0;
+  return true;
+}
+
+
+/**
+ * @brief Removes the UART driver for the STM32 link
+ * @return none
+ *
+ * Drops anything left in the receive ring; the event queue is deleted with the driver.
+ */
+void RadarManager::stopUart()
+{
+  uart_driver_delete(RADAR_UART);
+  m_uartQueue = nullptr;
+  m_rxHead = m_rxTail = 0;
+}
+
+
+/**
+ * @brief Waits for one UART driver event and handles it
+ * @param ticks Maximum time to wait
+ * @return true if an event was received, false on timeout
+ *
+ * UART_DATA events move all received bytes into the receive ring with at most
+ * two uart_read_bytes() calls (one per contiguous region of the ring). On
+ * FIFO/driver buffer overflow the input is flushed and any partial message is
+ * dropped, since its remaining bytes are gone.
+ */
+bool RadarManager::waitForUartEvent(TickType_t ticks)
+{
+  uart_event_t event;
+  if (m_uartQueue == nullptr || xQueueReceive(m_uartQueue, &event, ticks) != pdTRUE)
+  {
+    return false;
+  }
+
+  switch (event.type)
+  {
+  case UART_DATA:
+  {
+    size_t count = event.size;
+    while (count > 0)
+    {
+      size_t used = rxAvailable();
+      if (used == RX_RING_SIZE)
+      {
+        m_rxOverflows++;
+        logStatus("Receive ring full, dropping %d bytes", (int)used);
+        m_rxTail = m_rxHead;
+        used = 0;
+      }
+
+      size_t headIdx = m_rxHead & (RX_RING_SIZE - 1);
+      size_t chunk = RX_RING_SIZE - headIdx;
+      if (chunk > RX_RING_SIZE - used)
+      {
+        chunk = RX_RING_SIZE - used;
+      }
+      if (chunk > count)
+      {
+        chunk = count;
+      }
+
+      int received = uart_read_bytes(RADAR_UART, m_rxRing + headIdx, chunk, 0);
+      if (received <= 0)
+      {
+        break;
+      }
+      m_rxHead += received;
+      count -= received;
+    }
+    break;
+  }
+
+  case UART_FIFO_OVF:
+  case UART_BUFFER_FULL:
+    m_rxOverflows++;
+    logStatus("UART overflow (%lu total), flushing input", (unsigned long)m_rxOverflows);
+    uart_flush_input(RADAR_UART);
+    xQueueReset(m_uartQueue);
+    m_rxTail = m_rxHead;
+    break;
+
+  default:
+    // Parity/frame errors show up as invalid headers or CRC errors
+    break;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Gets pointer to the next len bytes of the receive ring
+ * @param len Number of bytes needed (must be <= rxAvailable())
+ * @return Pointer to len contiguous bytes
+ *
+ * Returns a pointer into the ring itself unless the bytes wrap around the end
+ * of the ring, in which case they are copied into m_rxScratch.
+ */
+const uint8_t *RadarManager::rxContiguous(size_t len)
+{
+  size_t tailIdx = m_rxTail & (RX_RING_SIZE - 1);
+  if (tailIdx + len <= RX_RING_SIZE)
+  {
+    return m_rxRing + tailIdx;
+  }
+
+  size_t first = RX_RING_SIZE - tailIdx;
+  memcpy(m_rxScratch, m_rxRing + tailIdx, first);
+  memcpy(m_rxScratch + first, m_rxRing, len - first);
+  return m_rxScratch;
+}
+
+
+/**
+ * @brief Finds the null terminator of the message at the start of the ring
+ * @param offset Index to start searching from
+ * @return Message length including the terminator, 0 if not received yet
+ */
+size_t RadarManager::rxFindNull(size_t offset)
+{
+  size_t available = rxAvailable();
+  if (offset >= available)
+  {
+    return 0;
+  }
+
+  // Search the (at most two) contiguous regions with memchr
+  size_t tailIdx = (m_rxTail + offset) & (RX_RING_SIZE - 1);
+  size_t first = RX_RING_SIZE - tailIdx;
+  size_t remaining = available - offset;
+  if (first > remaining)
+  {
+    first = remaining;
+  }
+
+  const uint8_t *found = (const uint8_t *)memchr(m_rxRing + tailIdx, RADAR_NULL, first);
+  if (found)
+  {
+    return offset + (found - (m_rxRing + tailIdx)) + 1;
+  }
+
+  if (remaining > first)
+  {
+    found = (const uint8_t *)memchr(m_rxRing, RADAR_NULL, remaining - first);
+    if (found)
+    {
+      return offset + first + (found - m_rxRing) + 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/**
+ * @brief Skips bytes until the next possible header
+ * @return Number of bytes skipped
+ *
+ * Always skips at least one byte so a bad header can't stall the parser.
+ */
+size_t RadarManager::resyncToHeader()
+{
+  size_t skipped = 1;
+  rxConsume(1);
+
+  while (rxAvailable() > 0 && rxPeek(0) != RADAR_HEADER_BYTE1)
+  {
+    rxConsume(1);
+    skipped++;
+  }
+
+  return skipped;
+}
+
+
+/**
+ * @brief Reads an exact number of bytes from the STM32
+ * @param buffer Buffer to store bytes
+ * @param len Number of bytes to read
+ * @param timeout_ms Maximum time to wait
+ * @return true if all bytes were read, false on timeout
+ *
+ * Used by the synchronous handshakes (config, stop sequence). Pumps UART
+ * events itself, so it must only be called from radarTask.
+ */
+bool RadarManager::readBytes(uint8_t *buffer, size_t len, uint32_t timeout_ms)
+{
+  uint32_t startTime = millis();
+
+  while (rxAvailable() < len)
+  {
+    uint32_t elapsed = millis() - startTime;
+    if (elapsed >= timeout_ms)
+    {
+      return false;
+    }
+    waitForUartEvent(pdMS_TO_TICKS(timeout_ms - elapsed));
+  }
+
+  memcpy(buffer, rxContiguous(len), len);
+  rxConsume(len);
+  return true;
+}
+
+
+/**
+ * @brief Reads bytes from the STM32 up to and including a null terminator
+ * @param buffer Buffer to store bytes, always null terminated
+ * @param size Size of buffer
+ * @param timeout_ms Maximum time to wait
+ * @return Number of bytes before the terminator, 0 on timeout
+ *
+ * Used by the synchronous handshakes (config, stop sequence). Pumps UART
+ * events itself, so it must only be called from radarTask.
+ */
+size_t RadarManager::readUntilNull(uint8_t *buffer, size_t size, uint32_t timeout_ms)
+{
+  uint32_t startTime = millis();
+  size_t msgLen;
+
+  while ((msgLen = rxFindNull(0)) == 0)
+  {
+    uint32_t elapsed = millis() - startTime;
+    if (elapsed >= timeout_ms || rxAvailable() >= size)
+    {
+      return 0;
+    }
+    waitForUartEvent(pdMS_TO_TICKS(timeout_ms - elapsed));
+  }
+
+  size_t copyLen = msgLen < size ? msgLen : size;
+  memcpy(buffer, rxContiguous(copyLen), copyLen);
+  buffer[copyLen - 1] = '\0';
+  rxConsume(msgLen);
+  return copyLen - 1;
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+// src/communication/RadarProtocol.cpp
+#include "communication/RadarProtocol.h"
+
+
+/**
+ * @brief Computes CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ * @param data Pointer to bytes to checksum
+ * @param len Number of bytes
+ * @return 16-bit CRC
+ *
+ * Must match crc16_ccitt() in jjh_v2.c on the STM32.
+ */
+uint16_t RadarProtocol::crc16(const uint8_t *data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+
+/**
+ * @brief Calculates total frame size from the frame prefix
+ * @param prefix Pointer to the first RADAR_FRAME_PREFIX_SIZE bytes of a frame
+ * @return Total frame size in bytes including header and CRC, 0 if prefix is invalid
+ *
+ * Rejects unknown versions and payloads longer than RADAR_FRAME_MAX_PAYLOAD so a
+ * corrupted length byte can't make the receiver wait for bytes that never come.
+ */
+size_t RadarProtocol::frameSize(const uint8_t *prefix)
+{
+  if (prefix[0] != RADAR_HEADER_BYTE1 ||
+      prefix[1] != RADAR_HEADER_BYTE2 ||
+      prefix[3] != RADAR_FRAME_VERSION ||
+      prefix[4] > RADAR_FRAME_MAX_PAYLOAD)
+  {
+    return 0;
+  }
+
+  return RADAR_FRAME_PREFIX_SIZE + prefix[4] + RADAR_FRAME_CRC_SIZE;
+}
+
+
+namespace
+{
+  /**
+   * @brief Checks command, length and CRC of a complete frame
+   * @param frame Pointer to frame, starting at the header bytes
+   * @param len Length of frame in bytes
+   * @param cmd Expected command byte
+   * @return true if the frame can be decoded
+   */
+  bool checkFrame(const uint8_t *frame, size_t len, uint8_t cmd)
+  {
+    if (len < RADAR_FRAME_PREFIX_SIZE + RADAR_FRAME_CRC_SIZE ||
+        frame[2] != cmd ||
+        RadarProtocol::frameSize(frame) != len)
+    {
+      return false;
+    }
+
+    uint16_t expected = (uint16_t)frame[len - 2] | ((uint16_t)frame[len - 1] << 8);
+    return RadarProtocol::crc16(frame + 2, len - 2 - RADAR_FRAME_CRC_SIZE) == expected;
+  }
+
+  uint16_t readU16(const uint8_t *p)
+  {
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+  }
+}
+
+
+/**
+ * @brief Decodes a complete distance frame
+ * @param frame Pointer to frame, starting at the header bytes
+ * @param len Length of frame in bytes
+ * @param out Decoded distances/strengths
+ * @return true if frame is well formed and CRC matches, false otherwise
+ *
+ * Converts fixed-point fields back to meters and dB. An empty payload is a valid
+ * frame with no detected distances. Timed frames carry the STM32 measurement
+ * time in front of the distances, config frames the index of the configuration,
+ * filtered frames the age of the measurement.
+ */
+bool RadarProtocol::decodeDistanceFrame(const uint8_t *frame, size_t len, RadarDistanceFrame *out)
+{
+  uint8_t cmd = len > 2 ? frame[2] : 0;
+  bool timed = cmd == RADAR_CMD_TIMED_DATA_FRAME;
+  bool tagged = cmd == RADAR_CMD_CONFIG_DATA_FRAME;
+  bool filtered = cmd == RADAR_CMD_FILTERED_DATA_FRAME;
+  if (!checkFrame(frame, len, (timed || tagged || filtered) ? cmd : RADAR_CMD_DATA_FRAME))
+  {
+    return false;
+  }
+
+  const uint8_t *payload = frame + RADAR_FRAME_PREFIX_SIZE;
+  uint8_t payloadLen = frame[4];
+  out->timed = timed;
+  out->timestampMs = 0;
+  out->configIndex = 0;
+  out->ageMs = 0;
+  if (tagged)
+  {
+    if (payloadLen < RADAR_FRAME_CONFIG_INDEX_SIZE)
+    {
+      return false;
+    }
+    out->configIndex = payload[0];
+    payload += RADAR_FRAME_CONFIG_INDEX_SIZE;
+    payloadLen -= RADAR_FRAME_CONFIG_INDEX_SIZE;
+  }
+  if (timed)
+  {
+    if (payloadLen < RADAR_FRAME_TIMESTAMP_SIZE)
+    {
+      return false;
+    }
+    out->timestampMs = (uint32_t)readU16(payload) | ((uint32_t)readU16(payload + 2) << 16);
+    payload += RADAR_FRAME_TIMESTAMP_SIZE;
+    payloadLen -= RADAR_FRAME_TIMESTAMP_SIZE;
+  }
+  if (filtered)
+  {
+    if (payloadLen < RADAR_FRAME_AGE_SIZE)
+    {
+      return false;
+    }
+    out->ageMs = (uint32_t)readU16(payload) | ((uint32_t)readU16(payload + 2) << 16);
+    payload += RADAR_FRAME_AGE_SIZE;
+    payloadLen -= RADAR_FRAME_AGE_SIZE;
+  }
+
+  if (payloadLen % RADAR_FRAME_DISTANCE_SIZE != 0 ||
+      payloadLen / RADAR_FRAME_DISTANCE_SIZE > RADAR_FRAME_MAX_DISTANCES)
+  {
+    return false;
+  }
+
+  out->sequence = frame[5];
+  out->numDistances = payloadLen / RADAR_FRAME_DISTANCE_SIZE;
+
+  for (uint8_t i = 0; i < out->numDistances; i++)
+  {
+    const uint8_t *p = payload + i * RADAR_FRAME_DISTANCE_SIZE;
+    out->distances[i] = readU16(p) / 1000.0f;
+    out->strengths[i] = (int16_t)readU16(p + 2) / 100.0f;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Decodes a complete aggregate frame
+ * @param frame Pointer to frame, starting at the header bytes
+ * @param len Length of frame in bytes
+ * @param out Decoded aggregate
+ * @return true if frame is well formed and CRC matches, false otherwise
+ *
+ * Sent by the STM32 instead of distance frames when an aggregation period is
+ * configured (ConfigSettings::aggregate_s).
+ */
+bool RadarProtocol::decodeAggregateFrame(const uint8_t *frame, size_t len, RadarAggregateFrame *out)
+{
+  if (!checkFrame(frame, len, RADAR_CMD_AGGREGATE_FRAME) ||
+      frame[4] != RADAR_FRAME_AGGREGATE_SIZE)
+  {
+    return false;
+  }
+
+  const uint8_t *p = frame + RADAR_FRAME_PREFIX_SIZE;
+  out->sequence = frame[5];
+  out->median = readU16(p) / 1000.0f;
+  out->min = readU16(p + 2) / 1000.0f;
+  out->max = readU16(p + 4) / 1000.0f;
+  out->meanStrength = (int16_t)readU16(p + 6) / 100.0f;
+  out->samples = readU16(p + 8);
+  out->outliers = readU16(p + 10);
+  out->empty = readU16(p + 12);
+  out->periodMs = (uint32_t)readU16(p + 14) | ((uint32_t)readU16(p + 16) << 16);
+
+  return true;
+}
+
+
+/**
+ * @brief Decodes a complete rate frame
+ * @param frame Pointer to frame, starting at the header bytes
+ * @param len Length of frame in bytes
+ * @param out Decoded rate change
+ * @return true if frame is well formed and CRC matches, false otherwise
+ *
+ * Sent by the STM32 when RADAR_MODE_ADAPTIVE_RATE changes the update rate,
+ * before it sleeps for the new period.
+ */
+bool RadarProtocol::decodeRateFrame(const uint8_t *frame, size_t len, RadarRateFrame *out)
+{
+  if (!checkFrame(frame, len, RADAR_CMD_RATE_FRAME) ||
+      frame[4] != RADAR_FRAME_RATE_SIZE)
+  {
+    return false;
+  }
+
+  const uint8_t *p = frame + RADAR_FRAME_PREFIX_SIZE;
+  out->sequence = frame[5];
+  out->periodMs = (uint32_t)readU16(p) | ((uint32_t)readU16(p + 2) << 16);
+  out->spread = readU16(p + 4) / 1000.0f;
+
+  return out->periodMs > 0;
+}
+
+
+/**
+ * @brief Decodes a complete window frame
+ * @param frame Pointer to frame, starting at the header bytes
+ * @param len Length of frame in bytes
+ * @param out Decoded range window
+ * @return true if frame is well formed and CRC matches, false otherwise
+ *
+ * Sent by the STM32 when RADAR_MODE_TRACKING moves the measured range, after
+ * the measurement that made it move.
+ */
+bool RadarProtocol::decodeWindowFrame(const uint8_t *frame, size_t len, RadarWindowFrame *out)
+{
+  if (!checkFrame(frame, len, RADAR_CMD_WINDOW_FRAME) ||
+      frame[4] != RADAR_FRAME_WINDOW_SIZE)
+  {
+    return false;
+  }
+
+  const uint8_t *p = frame + RADAR_FRAME_PREFIX_SIZE;
+  out->sequence = frame[5];
+  out->start = readU16(p) / 1000.0f;
+  out->end = readU16(p + 2) / 1000.0f;
+  out->searching = p[4] != 0;
+
+  return out->end > out->start;
+}
@@ -18,8 +18,12 @@
 #define CHIP_SELECT_PIN 33
 #define RADAR_RX_PIN 16
 #define RADAR_TX_PIN 17
+#define POWER_FAIL_PIN -1 // Active-low power-fail warning input, -1 if not wired
 
 // Function declarations
+#if POWER_FAIL_PIN >= 0
+void IRAM_ATTR onPowerFail();
+#endif
 
 // Global file path pointers
 char *debugFilePath = nullptr;
@@ -67,6 +71,12 @@ void setup()
   // Save the modified configuration
   SDCardManager::getInstance().updateConfig(currentConfig);
 
+#if POWER_FAIL_PIN >= 0
+  // Commit open SD files as soon as the supply starts to drop
+  pinMode(POWER_FAIL_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(POWER_FAIL_PIN), onPowerFail, FALLING);
+#endif
+
   BluetoothManager::getInstance().initialize(DEVICE_NAME, LED_PIN);
 
   GPSManager::getInstance().initialize(GPS_RX_PIN, GPS_TX_PIN, GPS_POWER_PIN, rtc);
@@ -192,4 +202,14 @@ void loop()
 
   // Regular task processing
   vTaskDelay(pdMS_TO_TICKS(1000));
-}
\ No newline at end of file
+}
+
+#if POWER_FAIL_PIN >= 0
+/**
+ * @brief Power-fail warning interrupt, asks sdTask to sync open files
+ */
+void IRAM_ATTR onPowerFail()
+{
+  SDCardManager::getInstance().requestSync();
+}
+#endif
@@ -0,0 +1,270 @@
+// src/storage/BinaryLog.cpp
+#include "storage/BinaryLog.h"
+#include <string.h>
+
+static void putU16(uint8_t *out, uint16_t value)
+{
+  out[0] = (uint8_t)(value & 0xFF);
+  out[1] = (uint8_t)(value >> 8);
+}
+
+static void putU32(uint8_t *out, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    out[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static void putF32(uint8_t *out, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putU32(out, bits);
+}
+
+static uint16_t getU16(const uint8_t *in)
+{
+  return (uint16_t)in[0] | ((uint16_t)in[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t *in)
+{
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+         ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static float getF32(const uint8_t *in)
+{
+  uint32_t bits = getU32(in);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+
+/**
+ * @brief Serializes a block header
+ * @param out Destination, at least BINLOG_BLOCK_HEADER_SIZE bytes
+ * @param info Header fields
+ * @return none
+ */
+void BinaryLog::writeBlockHeader(uint8_t *out, const BinaryLogBlockInfo &info)
+{
+  out[0] = BINLOG_MAGIC0;
+  out[1] = BINLOG_MAGIC1;
+  out[2] = BINLOG_MAGIC2;
+  out[3] = BINLOG_MAGIC3;
+  out[4] = BINLOG_VERSION;
+  out[5] = BINLOG_BLOCK_HEADER_SIZE;
+  putU16(out + 6, info.recordCount);
+  putU32(out + 8, info.payloadSize);
+  putU16(out + 12, info.payloadCrc);
+  putU16(out + 14, info.year);
+  out[16] = info.month;
+  out[17] = info.day;
+  out[18] = info.hour;
+  out[19] = info.minute;
+  out[20] = info.second;
+  out[21] = 0;
+  putU16(out + 22, info.millisecond);
+  putU32(out + 24, info.baseMillis);
+  putF32(out + 28, info.start_m);
+  putF32(out + 32, info.end_m);
+  putF32(out + 36, info.update_rate);
+  putF32(out + 40, info.threshold_sensitivity);
+  putF32(out + 44, info.signal_quality);
+  putF32(out + 48, info.true_update_rate);
+  out[52] = info.max_step_length;
+  out[53] = info.max_profile;
+  out[54] = info.reflector_shape;
+  out[55] = info.mode_flags;
+}
+
+
+/**
+ * @brief Parses a block header
+ * @param in Pointer to the start of the block
+ * @param len Bytes available at in
+ * @param info Parsed header fields
+ * @return true if the magic, version and header size are valid
+ *
+ * Doesn't check the payload CRC, since the payload may not be loaded yet.
+ */
+bool BinaryLog::readBlockHeader(const uint8_t *in, size_t len, BinaryLogBlockInfo *info)
+{
+  if (len < BINLOG_BLOCK_HEADER_SIZE ||
+      in[0] != BINLOG_MAGIC0 || in[1] != BINLOG_MAGIC1 ||
+      in[2] != BINLOG_MAGIC2 || in[3] != BINLOG_MAGIC3 ||
+      in[4] != BINLOG_VERSION || in[5] != BINLOG_BLOCK_HEADER_SIZE)
+  {
+    return false;
+  }
+
+  info->recordCount = getU16(in + 6);
+  info->payloadSize = getU32(in + 8);
+  info->payloadCrc = getU16(in + 12);
+  info->year = getU16(in + 14);
+  info->month = in[16];
+  info->day = in[17];
+  info->hour = in[18];
+  info->minute = in[19];
+  info->second = in[20];
+  info->millisecond = getU16(in + 22);
+  info->baseMillis = getU32(in + 24);
+  info->start_m = getF32(in + 28);
+  info->end_m = getF32(in + 32);
+  info->update_rate = getF32(in + 36);
+  info->threshold_sensitivity = getF32(in + 40);
+  info->signal_quality = getF32(in + 44);
+  info->true_update_rate = getF32(in + 48);
+  info->max_step_length = in[52];
+  info->max_profile = in[53];
+  info->reflector_shape = in[54];
+  info->mode_flags = in[55];
+  return true;
+}
+
+
+/**
+ * @brief Writes an unsigned LEB128 varint
+ * @param out Destination, at least BINLOG_MAX_VARINT_SIZE bytes
+ * @param value Value to encode
+ * @return Bytes written (1 for values below 128)
+ */
+size_t BinaryLog::writeVarint(uint8_t *out, uint32_t value)
+{
+  size_t pos = 0;
+  while (value >= 0x80)
+  {
+    out[pos++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[pos++] = (uint8_t)value;
+  return pos;
+}
+
+
+/**
+ * @brief Reads an unsigned LEB128 varint
+ * @param in Source bytes
+ * @param len Bytes available at in
+ * @param value Decoded value
+ * @return Bytes consumed, 0 if truncated or longer than BINLOG_MAX_VARINT_SIZE
+ */
+size_t BinaryLog::readVarint(const uint8_t *in, size_t len, uint32_t *value)
+{
+  uint32_t result = 0;
+  for (size_t i = 0; i < len && i < BINLOG_MAX_VARINT_SIZE; i++)
+  {
+    result |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+    if ((in[i] & 0x80) == 0)
+    {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+
+/**
+ * @brief Encodes one sample record
+ * @param out Destination, at least BINLOG_MAX_RECORD_SIZE bytes
+ * @param deltaMs Milliseconds since the previous record
+ * @param sample Sample to encode, count is clamped to BINLOG_MAX_DISTANCES
+ * @return Bytes written
+ */
+size_t BinaryLog::encodeSample(uint8_t *out, uint32_t deltaMs, const BinaryLogSample &sample)
+{
+  uint8_t count = sample.count > BINLOG_MAX_DISTANCES ? BINLOG_MAX_DISTANCES : sample.count;
+  size_t pos = 0;
+
+  out[pos++] = count;
+  pos += writeVarint(out + pos, deltaMs);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    putU16(out + pos, sample.distances_mm[i]);
+    putU16(out + pos + 2, (uint16_t)sample.strengths_cdb[i]);
+    pos += 4;
+  }
+  return pos;
+}
+
+
+/**
+ * @brief Encodes one text record
+ * @param out Destination, at least BINLOG_MAX_RECORD_SIZE bytes
+ * @param deltaMs Milliseconds since the previous record
+ * @param text Characters to store, no terminator needed
+ * @param len Length of text, truncated to BINLOG_MAX_TEXT_LENGTH
+ * @return Bytes written
+ */
+size_t BinaryLog::encodeText(uint8_t *out, uint32_t deltaMs, const char *text, size_t len)
+{
+  if (len > BINLOG_MAX_TEXT_LENGTH)
+  {
+    len = BINLOG_MAX_TEXT_LENGTH;
+  }
+
+  size_t pos = 0;
+  out[pos++] = BINLOG_TAG_TEXT;
+  pos += writeVarint(out + pos, deltaMs);
+  out[pos++] = (uint8_t)len;
+  memcpy(out + pos, text, len);
+  return pos + len;
+}
+
+
+/**
+ * @brief Decodes one record
+ * @param in Start of the record
+ * @param len Bytes available at in
+ * @param out Decoded record, text points into in
+ * @return Bytes consumed, 0 if the record is malformed or truncated
+ */
+size_t BinaryLog::decodeRecord(const uint8_t *in, size_t len, BinaryLogRecord *out)
+{
+  if (len < 2)
+  {
+    return 0;
+  }
+
+  uint8_t tag = in[0];
+  size_t pos = 1;
+  size_t used = readVarint(in + pos, len - pos, &out->deltaMs);
+  if (used == 0)
+  {
+    return 0;
+  }
+  pos += used;
+
+  if (tag == BINLOG_TAG_TEXT)
+  {
+    if (pos >= len || pos + 1 + in[pos] > len)
+    {
+      return 0;
+    }
+    out->isText = true;
+    out->textLength = in[pos];
+    out->text = (const char *)(in + pos + 1);
+    return pos + 1 + out->textLength;
+  }
+
+  if (tag > BINLOG_MAX_DISTANCES || pos + tag * 4u > len)
+  {
+    return 0;
+  }
+
+  out->isText = false;
+  out->text = nullptr;
+  out->textLength = 0;
+  out->sample.count = tag;
+  for (uint8_t i = 0; i < tag; i++)
+  {
+    out->sample.distances_mm[i] = getU16(in + pos);
+    out->sample.strengths_cdb[i] = (int16_t)getU16(in + pos + 2);
+    pos += 4;
+  }
+  return pos;
+}
@@ -88,8 +88,10 @@ bool SDCardManager::initialize(uint8_t chipSelectPin, RTC_PCF8523 &rtc)
  * - Processes queued data and debug messages
  * - Saves configuration changes
  * - Flushes buffers periodically
+ * - Syncs the open data and debug files to the card
  *
- * All operations use appropriate mutex locks for thread safety
+ * This task is the only consumer of the data rings and the only task that
+ * touches the SD card, so producers never block on SD I/O.
  */
 void SDCardManager::sdTask()
 {
@@ -101,56 +103,69 @@ void SDCardManager::sdTask()
 
   while (true)
   {
-    // Handle new data file creation if needed
-    if (m_needNewDataFile)
-    {
-      if (startNewDataFile(nullptr))
-      {
-        m_needNewDataFile = false;
-      }
-    }
+    sdTaskStep();
+
+    // Prevent task starvation
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+}
 
-    // Process data queue
+
+/**
+ * @brief Runs one iteration of sdTask
+ * @return none
+ *
+ * Split out of sdTask so the host replay harness (test/replay) can interleave
+ * it with the radar task deterministically. Must only be called from one task.
+ */
+void SDCardManager::sdTaskStep()
+{
+  // Handle new data file creation if needed
+  if (m_needNewDataFile)
+  {
+    if (startNewDataFile(nullptr))
     {
-      std::lock_guard<std::mutex> lock(m_dataQueueMutex);
-      while (!m_dataQueue.empty())
-      {
-        appendData(m_dataQueue.front().c_str());
-        m_dataQueue.pop();
-      }
+      m_needNewDataFile = false;
     }
+  }
+
+  // Process data queues
+  drainDataQueues();
 
-    // Process debug queue
+  // Process debug queue
+  {
+    std::lock_guard<std::mutex> lock(m_debugQueueMutex);
+    while (!m_debugQueue.empty())
     {
-      std::lock_guard<std::mutex> lock(m_debugQueueMutex);
-      while (!m_debugQueue.empty())
-      {
-        appendDebug(m_debugQueue.front().c_str());
-        m_debugQueue.pop();
-      }
+      appendDebug(m_debugQueue.front().c_str());
+      m_debugQueue.pop();
     }
+  }
 
-    // Save config if needed
-    if (m_needConfigSave)
+  // Save config if needed
+  if (m_needConfigSave)
+  {
     {
+      std::lock_guard<std::mutex> lock(m_configMutex);
+      if (saveConfig(&m_currentConfig))
       {
-        std::lock_guard<std::mutex> lock(m_configMutex);
-        if (saveConfig(&m_currentConfig))
-        {
-          m_needConfigSave = false;
-        }
+        m_needConfigSave = false;
       }
     }
+  }
 
-    // Ensure buffers are flushed periodically
-    if (millis() - m_lastFlushTime > FLUSH_INTERVAL)
-    {
-      flushDebugBuffer();
-      flushDataBuffer();
-    }
+  // Ensure buffers are flushed periodically
+  if (millis() - m_lastFlushTime > FLUSH_INTERVAL)
+  {
+    reportDroppedLines();
+    flushDebugBuffer();
+    flushDataBuffer();
+  }
 
-    // Prevent task starvation
-    vTaskDelay(pdMS_TO_TICKS(20));
+  // Commit open files on the sync interval or when asked (stop, power fail)
+  if (m_syncRequested.exchange(false) || millis() - m_lastSyncTime > m_syncIntervalMs)
+  {
+    syncFiles();
   }
 }
 
@@ -160,27 +175,100 @@ void SDCardManager::sdTask()
  * @param format Treat this function like a wrapper for printf
  * @return none
  *
- * Thread-safe function to queue data messages. Messages are buffered and
- * written in batches to improve SD card performance.
+ * Formats the message directly into the next free slot of the data ring.
+ * Lock-free and allocation-free, but only one task (the radar task) may call
+ * it; other tasks must use queueAuxData(). If the ring is full the line is
+ * dropped and counted rather than blocking on SD I/O.
  */
 void SDCardManager::queueData(const char *format, ...)
 {
-  OperationGuard guard(m_operationInProgress);
-  char buffer[MAX_LINE_LENGTH];
+  DataRecord *record = m_dataRing.reserve();
+  if (!record)
+  {
+    m_droppedDataLines++;
+    return;
+  }
+
+  record->type = DATA_RECORD_TEXT;
+  record->stream = 0;
+  record->epochMs = TimeManager::getInstance().getEpochMs();
+
   va_list args;
   va_start(args, format);
-  vsnprintf(buffer, sizeof(buffer), format, args);
+  int written = vsnprintf(record->text, sizeof(record->text), format, args);
   va_end(args);
 
-  std::lock_guard<std::mutex> lock(m_dataQueueMutex);
-  if (m_dataQueue.size() >= MAX_QUEUE_SIZE)
+  if (written < 0)
   {
-    flushDataBuffer();
+    return;
   }
-  else
+  record->length = (written < (int)sizeof(record->text)) ? written : sizeof(record->text) - 1;
+  m_dataRing.commit();
+}
+
+
+/**
+ * @brief Queues data message from a task other than the radar task
+ * @param format Treat this function like a wrapper for printf
+ * @return none
+ *
+ * Same as queueData(), but producers are serialized with a mutex so any
+ * number of low-rate tasks (e.g. GPS) can share the auxiliary ring.
+ */
+void SDCardManager::queueAuxData(const char *format, ...)
+{
+  std::lock_guard<std::mutex> lock(m_auxDataMutex);
+  DataRecord *record = m_auxDataRing.reserve();
+  if (!record)
+  {
+    m_droppedDataLines++;
+    return;
+  }
+
+  record->type = DATA_RECORD_TEXT;
+  record->stream = 0;
+  record->epochMs = TimeManager::getInstance().getEpochMs();
+
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(record->text, sizeof(record->text), format, args);
+  va_end(args);
+
+  if (written < 0)
   {
-    m_dataQueue.push(std::string(buffer));
+    return;
   }
+  record->length = (written < (int)sizeof(record->text)) ? written : sizeof(record->text) - 1;
+  m_auxDataRing.commit();
+}
+
+
+/**
+ * @brief Queues one radar sample for writing to SD card
+ * @param epochMs Time of the sample from TimeManager::getEpochMs()
+ * @param values Distances and strengths in fixed point
+ * @param stream 0 for the data file, else the config index of a stream file
+ * @return none
+ *
+ * Used when RADAR_MODE_BINARY_LOG is set, and for secondary configuration
+ * measurements. Same single-producer rules as queueData(). The sample is
+ * stored numerically and encoded by sdTask, as a BinaryLog record in .bin
+ * files or as a text line in .txt files.
+ */
+void SDCardManager::queueSample(uint64_t epochMs, const BinaryLogSample &values, uint8_t stream)
+{
+  DataRecord *record = m_dataRing.reserve();
+  if (!record)
+  {
+    m_droppedDataLines++;
+    return;
+  }
+
+  record->type = DATA_RECORD_SAMPLE;
+  record->stream = stream;
+  record->epochMs = epochMs;
+  record->sample = values;
+  m_dataRing.commit();
 }
 
 
@@ -190,11 +278,11 @@ void SDCardManager::queueData(const char *format, ...)
  * @return none
  *
  * Thread-safe function to queue debug messages. Messages are buffered and
- * written in batches to improve SD card performance.
+ * written in batches to improve SD card performance. If MAX_QUEUE_SIZE
+ * messages are already waiting the message is dropped and counted.
  */
 void SDCardManager::queueDebug(const char *format, ...)
 {
-  OperationGuard guard(m_operationInProgress);
   char buffer[MAX_LINE_LENGTH];
   va_list args;
   va_start(args, format);
@@ -204,7 +292,7 @@ void SDCardManager::queueDebug(const char *format, ...)
   std::lock_guard<std::mutex> lock(m_debugQueueMutex);
   if (m_debugQueue.size() >= MAX_QUEUE_SIZE)
   {
-    flushDebugBuffer();
+    m_droppedDebugLines++;
   }
   else
   {
@@ -223,7 +311,6 @@ void SDCardManager::queueDebug(const char *format, ...)
  */
 void SDCardManager::updateConfig(const ConfigSettings &config)
 {
-  OperationGuard guard(m_operationInProgress);
   std::lock_guard<std::mutex> lock(m_configMutex);
   m_currentConfig = config;
   m_needConfigSave = true;
@@ -238,7 +325,6 @@ void SDCardManager::updateConfig(const ConfigSettings &config)
  */
 ConfigSettings SDCardManager::getConfig()
 {
-  OperationGuard guard(m_operationInProgress);
   std::lock_guard<std::mutex> lock(m_configMutex);
   return m_currentConfig;
 }
@@ -343,13 +429,11 @@ bool SDCardManager::startNewDebugFile(char **debugFilePath)
     return false;
   }
 
-  File file = SD.open(filename, FILE_WRITE);
-  if (!file)
+  if (!m_debugWriter.open(filename))
   {
     logStatus("Failed to create new debug file");
     return false;
   }
-  file.close();
 
   // Update the external pointer if provided
   if (debugFilePath)
@@ -417,7 +501,8 @@ void SDCardManager::appendDebug(const char *format, ...)
  * @brief Flushes debug buffer to SD card
  * @return none
  *
- * Forces writing of buffered debug messages to SD card
+ * Passes buffered debug messages to the open debug file. They reach the
+ * card in whole sectors, or at the next syncFiles().
  * Called automatically when buffer is full or by timer
  */
 void SDCardManager::flushDebugBuffer()
@@ -431,8 +516,7 @@ void SDCardManager::flushDebugBuffer()
     startNewDebugFile(nullptr);
   }
 
-  m_debugBuffer[m_debugBufferPos] = '\0';
-  appendToFile(m_currentDebugPath, m_debugBuffer);
+  m_debugWriter.write((const uint8_t *)m_debugBuffer, m_debugBufferPos);
   m_debugBufferPos = 0;
   m_lastFlushTime = millis();
 }
@@ -443,7 +527,8 @@ void SDCardManager::flushDebugBuffer()
  * @param dataFilePath Optional pointer to store new file path
  * @return true if file created successfully, false if error
  *
- * Creates data file with name format: DD-MM-YY_HH-MM-SS_data.txt
+ * Creates data file with name format: DD-MM-YY_HH-MM-SS_data.txt, or
+ * DD-MM-YY_HH-MM-SS_data.bin if RADAR_MODE_BINARY_LOG is set
  * Updates both internal path and optional external pointer
  * Resets initial time when creating new file
  */
@@ -453,12 +538,20 @@ bool SDCardManager::startNewDataFile(char **dataFilePath)
   if (!m_isInitialized || !m_pRTC)
     return false;
 
+  // Buffered data belongs to the old file and its format
+  if (m_currentDataPath && m_dataBufferPos > 0)
+  {
+    flushDataBuffer();
+  }
+
   static char filename[64];
   DateTime now = m_pRTC->now();
+  bool binary = (m_currentConfig.mode_flags & RADAR_MODE_BINARY_LOG) != 0;
 
-  snprintf(filename, sizeof(filename), "/DATA/%02d-%02d-%02d_%02d-%02d-%02d_data.txt",
+  snprintf(filename, sizeof(filename), "/DATA/%02d-%02d-%02d_%02d-%02d-%02d_data.%s",
            now.year() % 100, now.month(), now.day(),
-           now.hour(), now.minute(), now.second());
+           now.hour(), now.minute(), now.second(),
+           binary ? "bin" : "txt");
 
   TimeManager::getInstance().resetInitialTime();
 
@@ -468,8 +561,20 @@ bool SDCardManager::startNewDataFile(char **dataFilePath)
     return false;
   }
 
-  File file = SD.open(filename, FILE_WRITE);
-  if (!file)
+  // Close the previous file before the new one is opened, the stream file
+  // follows the data file it belongs to
+  if (m_dataWriter.isOpen())
+  {
+    m_dataWriter.close();
+    logWriterStats("Data", m_dataWriter);
+  }
+  if (m_streamWriter.isOpen())
+  {
+    m_streamWriter.close();
+    logWriterStats("Stream", m_streamWriter);
+  }
+
+  if (!m_dataWriter.open(filename))
   {
     logStatus("Failed to create new data file");
     return false;
@@ -513,11 +618,50 @@ bool SDCardManager::startNewDataFile(char **dataFilePath)
                   m_currentConfig.true_update_rate);
   pos += snprintf(header + pos, sizeof(header) - pos, "Text width: %d characters\n",
                   m_currentConfig.text_width);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Mode flags: 0x%02X\n",
+                  m_currentConfig.mode_flags);
+  if (m_currentConfig.filter_window != 0)
+  {
+    pos += snprintf(header + pos, sizeof(header) - pos, "Outlier filter: %d measurements\n",
+                    m_currentConfig.filter_window);
+  }
+  if (m_currentConfig.aggregate_s != 0)
+  {
+    pos += snprintf(header + pos, sizeof(header) - pos,
+                    "Aggregate period: %d s (one median per period, spread on the following # line)\n",
+                    m_currentConfig.aggregate_s);
+  }
+  // Band mode covers the secondary range in every frame, so the STM32 doesn't measure it separately
+  if (m_currentConfig.secondary_interval != 0 && !(m_currentConfig.mode_flags & RADAR_MODE_BANDS))
+  {
+    pos += snprintf(header + pos, sizeof(header) - pos,
+                    "Secondary configuration: %.2f-%.2f m every %d measurements, in the _c1.txt file\n",
+                    m_currentConfig.secondary_start_m, m_currentConfig.secondary_end_m,
+                    m_currentConfig.secondary_interval);
+  }
+  if (m_currentConfig.mode_flags & RADAR_MODE_TRACKING)
+  {
+    pos += snprintf(header + pos, sizeof(header) - pos,
+                    "Tracking: range window follows the surface within %.2f-%.2f m, moves on # window lines\n",
+                    m_currentConfig.secondary_start_m, m_currentConfig.secondary_end_m);
+  }
+  if (m_currentConfig.mode_flags & RADAR_MODE_BANDS)
+  {
+    pos += snprintf(header + pos, sizeof(header) - pos,
+                    "Bands: coarse %.2f-%.2f m at step %d, profile %d around the primary (strengths in dB above threshold)\n",
+                    m_currentConfig.secondary_start_m, m_currentConfig.secondary_end_m,
+                    m_currentConfig.secondary_max_step_length, m_currentConfig.secondary_max_profile);
+  }
+  if (binary)
+  {
+    pos += snprintf(header + pos, sizeof(header) - pos,
+                    "Data format: binary v%d, decode with host_tools/radar_log_decode\n",
+                    BINLOG_VERSION);
+  }
   pos += snprintf(header + pos, sizeof(header) - pos, "---\n"); // Add separator line
 
   // Write header to file
-  file.write((uint8_t *)header, strlen(header));
-  file.close();
+  m_dataWriter.write((const uint8_t *)header, strlen(header));
 
   // Update the external pointer if provided
   if (dataFilePath)
@@ -535,6 +679,7 @@ bool SDCardManager::startNewDataFile(char **dataFilePath)
     free(m_currentDataPath);
   }
   m_currentDataPath = strdup(filename);
+  m_binaryDataFile = binary;
 
   logStatus("New data file created: %s", filename);
 
@@ -544,43 +689,301 @@ bool SDCardManager::startNewDataFile(char **dataFilePath)
 
 
 /**
- * @brief Appends data message to current data file
- * @param format Treat this function like a wrapper for printf
+ * @brief Appends data line to the data buffer
+ * @param line Formatted line, without newline
+ * @param len Length of line in bytes
  * @return none
  *
- * Messages are buffered and written in batches. New file is created
- * automatically when MAX_LINES_PER_FILE is reached
+ * Lines are packed back to back in the buffer and written in batches. The
+ * buffer is flushed after m_maxDataBufferLines lines or when the next line
+ * might not fit. New file is created automatically when MAX_LINES_PER_FILE
+ * is reached
  */
-void SDCardManager::appendData(const char *format, ...)
+void SDCardManager::appendData(const char *line, size_t len)
 {
   OperationGuard guard(m_operationInProgress);
   if (!m_isInitialized)
     return;
 
-  va_list args;
-  va_start(args, format);
+  if (m_dataBufferPos + len + 2 > sizeof(m_dataBuffer))
+  {
+    flushDataBuffer();
+  }
 
-  // Calculate position in buffer for new line
-  size_t bufferOffset = m_dataBufferPos * MAX_LINE_LENGTH;
-  size_t remaining = sizeof(m_dataBuffer) - bufferOffset - 1;
+  memcpy(m_dataBuffer + m_dataBufferPos, line, len);
+  m_dataBufferPos += len;
+  m_dataBuffer[m_dataBufferPos++] = '\n';
+  m_dataBuffer[m_dataBufferPos] = '\0';
+  m_dataBufferLines++;
 
-  // Format the message
-  int written = vsnprintf(m_dataBuffer + bufferOffset, remaining, format, args);
+  // Check if buffer is full
+  if (m_dataBufferLines >= m_maxDataBufferLines ||
+      m_dataBufferPos + MAX_LINE_LENGTH + 2 > sizeof(m_dataBuffer))
+  {
+    flushDataBuffer();
+  }
+}
 
-  va_end(args);
 
-  if (written > 0 && written < remaining)
+/**
+ * @brief Appends a queued record in the current data file's format
+ * @param record Text line or sample from a data ring
+ * @return none
+ *
+ * Samples going to a .txt file are rendered as "[timestamp] d,s;" lines, the
+ * same as RadarManager writes in text mode, so the file format only depends
+ * on the mode flags at the time the file was created.
+ */
+void SDCardManager::appendRecord(const DataRecord &record)
+{
+  // The buffer format follows the file, so make sure there is one
+  if (!m_currentDataPath && !startNewDataFile(nullptr))
+  {
+    m_droppedDataLines++;
+    return;
+  }
+
+  if (record.stream != 0)
   {
-    // Add newline
-    m_dataBuffer[bufferOffset + written] = '\n';
-    m_dataBuffer[bufferOffset + written + 1] = '\0'; // Null terminate this line
-    m_dataBufferPos++;
+    appendStreamRecord(record);
+    return;
+  }
 
-    // Check if buffer is full
-    if (m_dataBufferPos >= m_maxDataBufferLines)
-    {
-      flushDataBuffer();
-    }
+  if (m_binaryDataFile)
+  {
+    appendBinaryRecord(record);
+    return;
+  }
+
+  if (record.type == DATA_RECORD_TEXT)
+  {
+    appendData(record.text, record.length);
+    return;
+  }
+
+  char line[MAX_LINE_LENGTH];
+  appendData(line, formatSampleLine(record, line, sizeof(line)));
+}
+
+
+/**
+ * @brief Renders a sample record as a text data line
+ * @param record Sample record
+ * @param line Output buffer, without newline
+ * @param size Size of line, at least MAX_LINE_LENGTH
+ * @return Length of the line
+ */
+int SDCardManager::formatSampleLine(const DataRecord &record, char *line, size_t size)
+{
+  int pos = m_timestampFormatter.format(record.epochMs, line, size);
+  line[pos++] = ' ';
+
+  if (record.sample.count == 0)
+  {
+    pos += snprintf(line + pos, size - pos, "no_dists");
+  }
+  for (uint8_t i = 0; i < record.sample.count && i < BINLOG_MAX_DISTANCES; i++)
+  {
+    pos += snprintf(line + pos, size - pos, "%.3f,%.2f;",
+                    record.sample.distances_mm[i] / 1000.0f,
+                    record.sample.strengths_cdb[i] / 100.0f);
+  }
+  return pos;
+}
+
+
+/**
+ * @brief Opens the stream file of a configuration next to the data file
+ * @param stream Config index of the stream
+ * @return true if the file is open, false if error
+ *
+ * Creates DD-MM-YY_HH-MM-SS_data_c<index>.txt with the name of the current
+ * data file and a header describing the configuration. Stream files are
+ * always text, they only get a measurement every secondary_interval samples.
+ */
+bool SDCardManager::startStreamFile(uint8_t stream)
+{
+  OperationGuard guard(m_operationInProgress);
+  if (!m_isInitialized || !m_currentDataPath)
+    return false;
+
+  if (m_streamWriter.isOpen())
+  {
+    m_streamWriter.close();
+    logWriterStats("Stream", m_streamWriter);
+  }
+
+  char filename[64];
+  const char *ext = strrchr(m_currentDataPath, '.');
+  int baseLen = ext ? (int)(ext - m_currentDataPath) : (int)strlen(m_currentDataPath);
+  snprintf(filename, sizeof(filename), "%.*s_c%u.txt", baseLen, m_currentDataPath, stream);
+
+  if (!m_streamWriter.open(filename))
+  {
+    logStatus("Failed to create stream file %s", filename);
+    return false;
+  }
+
+  char header[512];
+  int pos = 0;
+  pos += snprintf(header + pos, sizeof(header) - pos, "Stream File: %s\n", filename);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Data File: %s\n", m_currentDataPath);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Configuration: %u\n", stream);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Start of range: %.2f m\n",
+                  m_currentConfig.secondary_start_m);
+  pos += snprintf(header + pos, sizeof(header) - pos, "End of range: %.2f m\n",
+                  m_currentConfig.secondary_end_m);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Maximum step length: %d (%.1f mm)\n",
+                  m_currentConfig.secondary_max_step_length,
+                  (float)m_currentConfig.secondary_max_step_length * 2.5f);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Maximum profile: %d\n",
+                  m_currentConfig.secondary_max_profile);
+  pos += snprintf(header + pos, sizeof(header) - pos, "Interval: every %d measurements\n",
+                  m_currentConfig.secondary_interval);
+  pos += snprintf(header + pos, sizeof(header) - pos, "---\n");
+  m_streamWriter.write((const uint8_t *)header, pos);
+
+  m_streamIndex = stream;
+  logStatus("New stream file created: %s", filename);
+  return true;
+}
+
+
+/**
+ * @brief Writes a secondary configuration sample to its stream file
+ * @param record Sample record with a non-zero stream
+ * @return none
+ *
+ * Stream samples are rare, so they go straight to the writer, which holds
+ * them until a sector is full or the next syncFiles().
+ */
+void SDCardManager::appendStreamRecord(const DataRecord &record)
+{
+  if ((!m_streamWriter.isOpen() || m_streamIndex != record.stream) && !startStreamFile(record.stream))
+  {
+    m_droppedDataLines++;
+    return;
+  }
+
+  char line[MAX_LINE_LENGTH];
+  int len = (record.type == DATA_RECORD_SAMPLE) ? formatSampleLine(record, line, sizeof(line) - 1)
+                                                : snprintf(line, sizeof(line) - 1, "%.*s", record.length, record.text);
+  line[len++] = '\n';
+  m_streamWriter.write((const uint8_t *)line, len);
+}
+
+
+/**
+ * @brief Encodes a queued record into the current BinaryLog block
+ * @param record Text line or sample from a data ring
+ * @return none
+ *
+ * The first record of a block reserves room for the block header, which is
+ * filled in by flushDataBuffer(). The block's base time is the time of its
+ * first record.
+ */
+void SDCardManager::appendBinaryRecord(const DataRecord &record)
+{
+  OperationGuard guard(m_operationInProgress);
+  if (!m_isInitialized)
+    return;
+
+  if (m_dataBufferPos + BINLOG_MAX_RECORD_SIZE > sizeof(m_dataBuffer))
+  {
+    flushDataBuffer();
+  }
+
+  if (m_dataBufferPos == 0)
+  {
+    DateTimeMS base = TimeManager::toDateTime(record.epochMs);
+    m_block = BinaryLogBlockInfo{};
+    m_block.year = base.year;
+    m_block.month = base.month;
+    m_block.day = base.day;
+    m_block.hour = base.hour;
+    m_block.minute = base.minute;
+    m_block.second = base.second;
+    m_block.millisecond = base.millisecond;
+    m_block.baseMillis = millis();
+    m_blockLastEpochMs = record.epochMs;
+    m_dataBufferPos = BINLOG_BLOCK_HEADER_SIZE;
+  }
+
+  // Text lines from other tasks can be queued slightly out of order, clamp to 0
+  uint32_t delta = 0;
+  if (record.epochMs > m_blockLastEpochMs)
+  {
+    delta = (uint32_t)(record.epochMs - m_blockLastEpochMs);
+    m_blockLastEpochMs = record.epochMs;
+  }
+
+  uint8_t *out = (uint8_t *)m_dataBuffer + m_dataBufferPos;
+  if (record.type == DATA_RECORD_SAMPLE)
+  {
+    m_dataBufferPos += BinaryLog::encodeSample(out, delta, record.sample);
+  }
+  else
+  {
+    m_dataBufferPos += BinaryLog::encodeText(out, delta, record.text, record.length);
+  }
+  m_dataBufferLines++;
+
+  if (m_dataBufferLines >= m_maxDataBufferLines ||
+      m_dataBufferPos + BINLOG_MAX_RECORD_SIZE > sizeof(m_dataBuffer))
+  {
+    flushDataBuffer();
+  }
+}
+
+
+/**
+ * @brief Moves all queued data lines into the data buffer
+ * @return none
+ *
+ * Consumer side of both data rings. Auxiliary lines (GPS) are low rate, so
+ * they are drained first and the radar ring second.
+ */
+void SDCardManager::drainDataQueues()
+{
+  DataRecord *record;
+  while ((record = m_auxDataRing.front()) != nullptr)
+  {
+    appendRecord(*record);
+    m_auxDataRing.pop();
+  }
+  while ((record = m_dataRing.front()) != nullptr)
+  {
+    appendRecord(*record);
+    m_dataRing.pop();
+  }
+}
+
+
+/**
+ * @brief Logs how many lines were dropped since the last report
+ * @return none
+ *
+ * Producers only increment counters when a queue is full; the report is
+ * written from sdTask so it never adds to a full queue. It goes straight
+ * into the debug buffer rather than through logStatus(), which drops lines
+ * until the first debug file has been opened.
+ */
+void SDCardManager::reportDroppedLines()
+{
+  uint32_t dataDrops = m_droppedDataLines.load();
+  uint32_t debugDrops = m_droppedDebugLines.load();
+
+  if (dataDrops != m_reportedDataDrops)
+  {
+    appendDebug("SDCard: Data queue full, dropped %u lines (%u total)",
+                dataDrops - m_reportedDataDrops, dataDrops);
+    m_reportedDataDrops = dataDrops;
+  }
+  if (debugDrops != m_reportedDebugDrops)
+  {
+    appendDebug("SDCard: Debug queue full, dropped %u lines (%u total)",
+                debugDrops - m_reportedDebugDrops, debugDrops);
+    m_reportedDebugDrops = debugDrops;
   }
 }
 
@@ -589,7 +992,8 @@ void SDCardManager::appendData(const char *format, ...)
  * @brief Flushes data buffer to SD card
  * @return none
  *
- * Forces writing of buffered data messages to SD card
+ * Passes buffered data to the open data file. It reaches the card in whole
+ * sectors, or at the next syncFiles().
  * Called automatically when buffer is full or by timer
  */
 void SDCardManager::flushDataBuffer()
@@ -598,18 +1002,41 @@ void SDCardManager::flushDataBuffer()
   if (!m_isInitialized || m_dataBufferPos == 0)
     return;
 
-  if (!m_currentDataPath)
+  if (!m_currentDataPath && !startNewDataFile(nullptr))
   {
-    startNewDataFile(nullptr);
+    logStatus("No data file, dropped %d buffered lines", (int)m_dataBufferLines);
+    m_dataBuffer[0] = '\0';
+    m_dataBufferPos = 0;
+    m_dataBufferLines = 0;
+    return;
   }
 
-  // Already null-terminated by appendData
-  appendToFile(m_currentDataPath, m_dataBuffer);
+  if (m_binaryDataFile)
+  {
+    // Fill in the header reserved by appendBinaryRecord()
+    uint8_t *block = (uint8_t *)m_dataBuffer;
+    m_block.recordCount = m_dataBufferLines;
+    m_block.payloadSize = m_dataBufferPos - BINLOG_BLOCK_HEADER_SIZE;
+    m_block.payloadCrc = RadarProtocol::crc16(block + BINLOG_BLOCK_HEADER_SIZE, m_block.payloadSize);
+    m_block.start_m = m_currentConfig.start_m;
+    m_block.end_m = m_currentConfig.end_m;
+    m_block.update_rate = m_currentConfig.update_rate;
+    m_block.threshold_sensitivity = m_currentConfig.threshold_sensitivity;
+    m_block.signal_quality = m_currentConfig.signal_quality;
+    m_block.true_update_rate = m_currentConfig.true_update_rate;
+    m_block.max_step_length = m_currentConfig.max_step_length;
+    m_block.max_profile = m_currentConfig.max_profile;
+    m_block.reflector_shape = m_currentConfig.reflector_shape;
+    m_block.mode_flags = m_currentConfig.mode_flags;
+    BinaryLog::writeBlockHeader(block, m_block);
+  }
+  m_dataWriter.write((const uint8_t *)m_dataBuffer, m_dataBufferPos);
 
   // Clear buffer
-  m_linesSaved += m_dataBufferPos;
+  m_linesSaved += m_dataBufferLines;
   m_dataBuffer[0] = '\0';
   m_dataBufferPos = 0;
+  m_dataBufferLines = 0;
   m_lastFlushTime = millis();
 
   // Check if we need to start a new file
@@ -620,6 +1047,44 @@ void SDCardManager::flushDataBuffer()
 }
 
 
+/**
+ * @brief Commits buffered data and debug messages to the card
+ * @return none
+ *
+ * Moves the RAM buffers into the open files and syncs both. Runs on the sync
+ * interval and whenever requestSync() is called, e.g. when data collection
+ * stops or a power-fail warning fires.
+ */
+void SDCardManager::syncFiles()
+{
+  OperationGuard guard(m_operationInProgress);
+  drainDataQueues();
+  flushDataBuffer();
+  flushDebugBuffer();
+  m_dataWriter.sync();
+  m_streamWriter.sync();
+  m_debugWriter.sync();
+  m_lastSyncTime = millis();
+}
+
+
+/**
+ * @brief Logs write metrics of a file writer
+ * @param name Name of the file type for the log line
+ * @param writer Writer to report on
+ * @return none
+ */
+void SDCardManager::logWriterStats(const char *name, const SDFileWriter &writer)
+{
+  const SDFileWriter::Stats &stats = writer.getStats();
+  logStatus("%s writer: %u bytes in %u writes, %u opens, %u syncs (last %u us, max %u us, avg %u us), %u errors",
+            name, stats.bytesWritten, stats.writeCalls, stats.opens, stats.syncs,
+            stats.lastSyncUs, stats.maxSyncUs,
+            stats.syncs ? (uint32_t)(stats.totalSyncUs / stats.syncs) : 0,
+            stats.errors);
+}
+
+
 /**
  * @brief Reads configuration from SD card
  * @param config Pointer to store loaded configuration
@@ -642,7 +1107,7 @@ bool SDCardManager::readConfig(ConfigSettings *config)
     return saveConfig(config);
   }
 
-  char buf[192]; // Increased buffer for GPS coordinates
+  char buf[224]; // Increased buffer for GPS coordinates
   size_t len = file.readBytesUntil('\n', buf, sizeof(buf) - 1);
   file.close();
 
@@ -656,7 +1121,15 @@ bool SDCardManager::readConfig(ConfigSettings *config)
   buf[len] = '\0';
 
   char lat_buf[32], lon_buf[32], elev_buf[16];
-  int parsed = sscanf(buf, "%f,%f,%f,%hhu,%hhu,%f,%hhu,%f,%hhu,%f,%hhu,%[^,],%[^,],%s",
+  config->mode_flags = RADAR_MODE_DEFAULT;
+  config->filter_window = 0;
+  config->aggregate_s = 0;
+  config->secondary_start_m = 0.10f;
+  config->secondary_end_m = 5.00f;
+  config->secondary_max_step_length = 8;
+  config->secondary_max_profile = 5;
+  config->secondary_interval = 0;
+  int parsed = sscanf(buf, "%f,%f,%f,%hhu,%hhu,%f,%hhu,%f,%hhu,%f,%hhu,%31[^,],%31[^,],%15[^,\r\n],%hhx,%hhu,%hu,%f,%f,%hhu,%hhu,%hu",
                       &config->start_m,
                       &config->end_m,
                       &config->update_rate,
@@ -670,9 +1143,19 @@ bool SDCardManager::readConfig(ConfigSettings *config)
                       &config->text_width,
                       lat_buf,
                       lon_buf,
-                      elev_buf);
-
-  if (parsed != 14)
+                      elev_buf,
+                      &config->mode_flags,
+                      &config->filter_window,
+                      &config->aggregate_s,
+                      &config->secondary_start_m,
+                      &config->secondary_end_m,
+                      &config->secondary_max_step_length,
+                      &config->secondary_max_profile,
+                      &config->secondary_interval);
+
+  // Config files written before mode_flags existed have 14 fields, before
+  // filter_window and aggregate_s 15, before the secondary configuration 17
+  if (parsed != 14 && parsed != 15 && parsed != 17 && parsed != 22)
   {
     logStatus("Error: Failed to parse config file");
     deleteFile(CONFIG_FILE_PATH);
@@ -713,9 +1196,9 @@ bool SDCardManager::saveConfig(const ConfigSettings *config)
     deleteFile(CONFIG_FILE_PATH);
   }
 
-  char config_string[192]; // Increased size for GPS
+  char config_string[224]; // Increased size for GPS
   snprintf(config_string, sizeof(config_string),
-           "%05.2f,%05.2f,%04.1f,%02d,%d,%04.1f,%d,%04.2f,%d,%04.1f,%d,%s,%s,%s\n",
+           "%05.2f,%05.2f,%04.1f,%02d,%d,%04.1f,%d,%04.2f,%d,%04.1f,%d,%s,%s,%s,%02X,%d,%d,%05.2f,%05.2f,%02d,%d,%d\n",
            config->start_m,
            config->end_m,
            config->update_rate,
@@ -729,7 +1212,15 @@ bool SDCardManager::saveConfig(const ConfigSettings *config)
            config->text_width,
            config->latitude,
            config->longitude,
-           config->elevation);
+           config->elevation,
+           config->mode_flags,
+           config->filter_window,
+           config->aggregate_s,
+           config->secondary_start_m,
+           config->secondary_end_m,
+           config->secondary_max_step_length,
+           config->secondary_max_profile,
+           config->secondary_interval);
 
   // Write new config
   return appendToFile(CONFIG_FILE_PATH, config_string);
@@ -758,7 +1249,20 @@ bool SDCardManager::verifyConfig(const ConfigSettings *config)
       config->threshold_sensitivity < 0.0f || config->threshold_sensitivity > 1.0f ||
       config->testing_update_rate > 1 ||
       config->true_update_rate < 0.0f || config->true_update_rate > 10.5f ||
-      config->text_width > 140)
+      config->text_width > 140 ||
+      (config->filter_window != 0 && (config->filter_window < 3 || config->filter_window > 31)) ||
+      config->aggregate_s > 3600)
+  {
+    return false;
+  }
+
+  // The secondary range is only checked when it's used, like the STM32 does
+  if ((config->secondary_interval != 0 || (config->mode_flags & (RADAR_MODE_TRACKING | RADAR_MODE_BANDS))) &&
+      (config->secondary_start_m < 0.1f || config->secondary_end_m > 20.0f ||
+       config->secondary_start_m >= config->secondary_end_m ||
+       config->secondary_max_step_length < 1 || config->secondary_max_step_length > 99 ||
+       config->secondary_max_profile < 1 || config->secondary_max_profile > 5 ||
+       config->secondary_interval > 9999))
   {
     return false;
   }
@@ -0,0 +1,149 @@
+// src/storage/SDFileWriter.cpp
+#include "storage/SDFileWriter.h"
+#include <Arduino.h>
+
+
+/**
+ * @brief Opens a file for appending, closing any file already open
+ * @param path File path to open, created if it doesn't exist
+ * @return true if file opened, false if error
+ */
+bool SDFileWriter::open(const char *path)
+{
+  close();
+
+  m_file = SD.open(path, FILE_APPEND);
+  if (!m_file)
+  {
+    m_stats.errors++;
+    return false;
+  }
+
+  m_fileSize = m_file.size();
+  m_pending = 0;
+  m_dirty = false;
+  m_stats.opens++;
+  return true;
+}
+
+
+/**
+ * @brief Appends bytes to the file
+ * @param data Bytes to append
+ * @param len Number of bytes
+ * @return true if all card writes succeeded, false if any failed
+ *
+ * Only whole sectors are written to the card: the staging buffer is topped up
+ * to the next sector boundary first, then whole sectors are written straight
+ * from data and the remainder is staged.
+ */
+bool SDFileWriter::write(const uint8_t *data, size_t len)
+{
+  if (!m_file)
+    return false;
+
+  bool ok = true;
+  while (len > 0)
+  {
+    // Bytes from the end of what's on the card up to the next sector boundary
+    uint32_t onCard = m_fileSize - m_pending;
+    size_t toBoundary = SECTOR_SIZE - (onCard % SECTOR_SIZE);
+
+    if (m_pending == 0 && toBoundary == SECTOR_SIZE && len >= SECTOR_SIZE)
+    {
+      size_t direct = len - (len % SECTOR_SIZE);
+      ok &= writeToFile(data, direct);
+      m_fileSize += direct;
+      data += direct;
+      len -= direct;
+      continue;
+    }
+
+    size_t n = toBoundary - m_pending;
+    if (n > len)
+      n = len;
+    memcpy(m_staging + m_pending, data, n);
+    m_pending += n;
+    m_fileSize += n;
+    data += n;
+    len -= n;
+
+    if (m_pending == toBoundary)
+    {
+      ok &= writeToFile(m_staging, m_pending);
+      m_pending = 0;
+    }
+  }
+
+  m_dirty = true;
+  return ok;
+}
+
+
+/**
+ * @brief Writes staged bytes and commits the file to the card
+ * @return true if successful, false if a write failed
+ *
+ * Call periodically and before power may be lost. Sync duration is recorded
+ * in the stats.
+ */
+bool SDFileWriter::sync()
+{
+  if (!m_file || !m_dirty)
+    return true;
+
+  uint32_t start = micros();
+  bool ok = true;
+
+  if (m_pending > 0)
+  {
+    ok = writeToFile(m_staging, m_pending);
+    m_pending = 0;
+  }
+  m_file.flush();
+  m_dirty = false;
+
+  uint32_t elapsed = micros() - start;
+  m_stats.syncs++;
+  m_stats.lastSyncUs = elapsed;
+  m_stats.totalSyncUs += elapsed;
+  if (elapsed > m_stats.maxSyncUs)
+    m_stats.maxSyncUs = elapsed;
+
+  return ok;
+}
+
+
+/**
+ * @brief Syncs and closes the file
+ * @return none
+ */
+void SDFileWriter::close()
+{
+  if (!m_file)
+    return;
+
+  sync();
+  m_file.close();
+}
+
+
+/**
+ * @brief Writes bytes to the open file and updates stats
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return true if all bytes were written
+ */
+bool SDFileWriter::writeToFile(const uint8_t *data, size_t len)
+{
+  size_t written = m_file.write(data, len);
+  m_stats.writeCalls++;
+  m_stats.bytesWritten += written;
+
+  if (written != len)
+  {
+    m_stats.errors++;
+    return false;
+  }
+  return true;
+}
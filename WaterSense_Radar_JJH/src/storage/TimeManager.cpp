@@ -3,6 +3,7 @@
 #include "storage/SDCardManager.h"
 #include "communication/BluetoothManager.h"
 #include <Arduino.h>
+#include <esp_timer.h>
 #include <stdarg.h>
 
 
@@ -35,19 +36,7 @@ bool TimeManager::initialize(RTC_PCF8523 &rtc)
   m_pRTC->start();
 
   // Set initial time
-  DateTime now = m_pRTC->now();
-  m_initTime.year = now.year();
-  m_initTime.month = now.month();
-  m_initTime.day = now.day();
-  m_initTime.hour = now.hour();
-  m_initTime.minute = now.minute();
-  m_initTime.second = now.second();
-  m_initTime.millisecond = millis() % 1000;
-  m_initMillis = millis();
-
-  m_currentTime = m_initTime;
-  m_lastUpdateTime = m_initMillis;
-  m_overflowCount = 0;
+  syncWithRTC();
 
   m_isInitialized = true;
 
@@ -63,26 +52,18 @@ bool TimeManager::initialize(RTC_PCF8523 &rtc)
  * @param size Size of buffer (must be >= 25 bytes)
  * @return none
  *
- * Formats current time as [DD/MM/YY HH:MM:SS.mmm]
- * Buffer must be at least 25 bytes to hold full timestamp
+ * Formats current time as [YY/MM/DD HH:MM:SS.mmm]
+ * Buffer must be at least 25 bytes to hold full timestamp. Tasks that log
+ * every sample should keep their own TimestampFormatter and use getEpochMs()
+ * instead, so the date prefix is cached between calls.
  */
 void TimeManager::getFormattedTimestamp(char *buffer, size_t size)
 {
-  if (!buffer || size < 25)
-  { // Minimum size for timestamp
-    if (buffer && size > 0)
-    {
-      buffer[0] = '\0';
-    }
-    return;
+  TimestampFormatter formatter;
+  if (formatter.format(getEpochMs(), buffer, size) == 0 && buffer && size > 0)
+  {
+    buffer[0] = '\0';
   }
-
-  DateTimeMS current = getCurrentTimeMS();
-
-  snprintf(buffer, size, "[%02d/%02d/%02d %02d:%02d:%02d.%03d]",
-           current.year % 100, current.month, current.day,
-           current.hour, current.minute, current.second,
-           current.millisecond);
 }
 
 
@@ -90,8 +71,7 @@ void TimeManager::getFormattedTimestamp(char *buffer, size_t size)
  * @brief Gets current time with millisecond precision
  * @return DateTimeMS struct with current time
  *
- * Returns current time combining RTC time with internal millisecond counter.
- * Updates internal time if update interval exceeded.
+ * Returns current time combining RTC time with the system uptime counter.
  */
 DateTimeMS TimeManager::getCurrentTimeMS()
 {
@@ -100,11 +80,31 @@ DateTimeMS TimeManager::getCurrentTimeMS()
     return DateTimeMS{0};
   }
 
-  std::lock_guard<std::mutex> lock(m_timeMutex);
+  return toDateTime(getEpochMs());
+}
 
-  updateCurrentTime();
 
-  return m_currentTime;
+/**
+ * @brief Gets current time as milliseconds since 1970-01-01
+ * @return RTC time of the last sync plus uptime elapsed since then
+ *
+ * Lock-free: the sync point is read under a seqlock, so callers on any task
+ * or core never block, even while an RTC sync is in progress.
+ */
+uint64_t TimeManager::getEpochMs() const
+{
+  uint32_t seq;
+  uint64_t baseEpoch, baseUptime;
+
+  do
+  {
+    seq = m_timeSeq.load(std::memory_order_acquire);
+    baseEpoch = m_baseEpochMs;
+    baseUptime = m_baseUptimeMs;
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != m_timeSeq.load(std::memory_order_relaxed));
+
+  return baseEpoch + (uptimeMs() - baseUptime);
 }
 
 
@@ -119,25 +119,7 @@ void TimeManager::resetInitialTime()
 {
   std::lock_guard<std::mutex> lock(m_timeMutex);
 
-  // Get current RTC time
-  DateTime now = m_pRTC->now();
-
-  // Update initial time
-  m_initTime.year = now.year();
-  m_initTime.month = now.month();
-  m_initTime.day = now.day();
-  m_initTime.hour = now.hour();
-  m_initTime.minute = now.minute();
-  m_initTime.second = now.second();
-  m_initTime.millisecond = millis() % 1000;
-
-  // Reset other counters
-  m_initMillis = millis();
-  m_overflowCount = 0;
-  m_lastUpdateTime = m_initMillis;
-
-  // Force an immediate update of current time
-  updateCurrentTime();
+  syncWithRTC();
 }
 
 
@@ -165,169 +147,144 @@ void TimeManager::setDateTime(uint16_t year, uint8_t month, uint8_t day,
   m_pRTC->adjust(DateTime(year, month, day, hour, minute, second));
 
   // Reset our timing variables to match
-  DateTime now = m_pRTC->now();
-  m_initTime.year = now.year();
-  m_initTime.month = now.month();
-  m_initTime.day = now.day();
-  m_initTime.hour = now.hour();
-  m_initTime.minute = now.minute();
-  m_initTime.second = now.second();
-  m_initTime.millisecond = millis() % 1000;
-  m_initMillis = millis();
-  m_overflowCount = 0;
-
-  // Force immediate update of current time
-  updateCurrentTime();
+  syncWithRTC();
 }
 
 
 /**
- * @brief Updates internal current time
+ * @brief Re-reads the RTC and moves the sync point to now
  * @return none
  *
- * Calculates current time based on initial time and elapsed milliseconds.
- * Handles millisecond counter overflow and date rollovers.
+ * Caller must hold m_timeMutex (or be initializing). The RTC only has whole
+ * seconds, so like before the sub-second part is taken from the uptime
+ * counter. Readers in getEpochMs() retry while the sequence number is odd.
  */
-void TimeManager::updateCurrentTime()
+void TimeManager::syncWithRTC()
 {
-  checkMillisOverflow();
-
-  uint32_t currentMillis = millis();
-  uint64_t elapsedMS;
-
-  if (currentMillis >= m_initMillis)
-  {
-    elapsedMS = currentMillis - m_initMillis;
-  }
-  else
-  {
-    elapsedMS = (MILLIS_OVERFLOW - m_initMillis) + currentMillis + 1UL;
-  }
-  elapsedMS += (uint64_t)MILLIS_OVERFLOW * m_overflowCount;
-
-  // Start with initial time
-  m_currentTime = m_initTime;
-
-  // Add milliseconds and handle rollovers
-  m_currentTime.millisecond = (elapsedMS % 1000);
-  uint64_t totalSeconds = elapsedMS / 1000;
-
-  // Add seconds and handle rollovers
-  m_currentTime.second += totalSeconds % 60;
-  uint64_t totalMinutes = totalSeconds / 60;
-  if (m_currentTime.second >= 60)
-  {
-    m_currentTime.second -= 60;
-    totalMinutes++;
-  }
-
-  // Add minutes and handle rollovers
-  m_currentTime.minute += totalMinutes % 60;
-  uint64_t totalHours = totalMinutes / 60;
-  if (m_currentTime.minute >= 60)
-  {
-    m_currentTime.minute -= 60;
-    totalHours++;
-  }
-
-  // Add hours and handle rollovers
-  m_currentTime.hour += totalHours % 24;
-  uint64_t totalDays = totalHours / 24;
-  if (m_currentTime.hour >= 24)
-  {
-    m_currentTime.hour -= 24;
-    totalDays++;
-  }
+  DateTime now = m_pRTC->now();
+  uint64_t uptime = uptimeMs();
+
+  DateTimeMS rtcTime;
+  rtcTime.year = now.year();
+  rtcTime.month = now.month();
+  rtcTime.day = now.day();
+  rtcTime.hour = now.hour();
+  rtcTime.minute = now.minute();
+  rtcTime.second = now.second();
+  rtcTime.millisecond = uptime % 1000;
+
+  m_timeSeq.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  m_baseEpochMs = toEpochMs(rtcTime);
+  m_baseUptimeMs = uptime;
+  m_timeSeq.fetch_add(1, std::memory_order_release);
+}
 
-  // Add remaining days, handling month and year transitions
-  while (totalDays > 0)
-  {
-    uint8_t daysThisMonth = daysInMonth(m_currentTime.month, m_currentTime.year);
-    if (m_currentTime.day + totalDays > daysThisMonth)
-    {
-      totalDays -= (daysThisMonth - m_currentTime.day + 1);
-      m_currentTime.day = 1;
-      if (++m_currentTime.month > 12)
-      {
-        m_currentTime.month = 1;
-        m_currentTime.year++;
-      }
-    }
-    else
-    {
-      m_currentTime.day += totalDays;
-      break;
-    }
-  }
 
-  m_lastUpdateTime = currentMillis;
+/**
+ * @brief Milliseconds since boot as a 64-bit counter
+ * @return Uptime in milliseconds
+ *
+ * esp_timer keeps counting through light sleep and doesn't wrap after 49
+ * days like millis(), so no overflow handling is needed.
+ */
+uint64_t TimeManager::uptimeMs()
+{
+  return (uint64_t)esp_timer_get_time() / 1000ULL;
 }
 
 
 /**
- * @brief Checks for millisecond counter overflow
- * @return none
+ * @brief Converts a calendar time to milliseconds since 1970-01-01
+ * @param time Calendar time, year is four digits
+ * @return Milliseconds since the epoch
  *
- * Updates overflow counter and re-syncs with RTC when overflow occurs.
- * Prevents time drift over long periods.
+ * Uses the days-from-civil algorithm, no month tables or leap year loops.
  */
-void TimeManager::checkMillisOverflow()
+uint64_t TimeManager::toEpochMs(const DateTimeMS &time)
 {
-  uint32_t currentMillis = millis();
-  if (currentMillis < m_lastUpdateTime)
-  {
-    m_overflowCount++;
-
-    // Re-sync with RTC on overflow to prevent drift
-    if (m_pRTC)
-    {
-      DateTime now = m_pRTC->now();
-      m_initTime.year = now.year();
-      m_initTime.month = now.month();
-      m_initTime.day = now.day();
-      m_initTime.hour = now.hour();
-      m_initTime.minute = now.minute();
-      m_initTime.second = now.second();
-      m_initTime.millisecond = currentMillis % 1000;
-      m_initMillis = currentMillis;
-      m_overflowCount = 0;
-    }
-  }
+  int32_t y = time.year - (time.month <= 2);
+  int32_t era = y / 400;
+  uint32_t yoe = (uint32_t)(y - era * 400);
+  uint32_t doy = (153 * (time.month + (time.month > 2 ? -3 : 9)) + 2) / 5 + time.day - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  uint64_t days = (uint64_t)(era * 146097 + (int32_t)doe - 719468);
+
+  uint64_t seconds = days * 86400ULL + time.hour * 3600UL + time.minute * 60UL + time.second;
+  return seconds * 1000ULL + time.millisecond;
 }
 
 
 /**
- * @brief Gets number of days in specified month
- * @param month Month (1-12)
- * @param year Four-digit year
- * @return Number of days in month, accounting for leap years
+ * @brief Converts milliseconds since 1970-01-01 to a calendar time
+ * @param epochMs Milliseconds since the epoch
+ * @return Calendar time with millisecond precision
  */
-uint8_t TimeManager::daysInMonth(uint8_t month, uint16_t year) const
+DateTimeMS TimeManager::toDateTime(uint64_t epochMs)
 {
-  static const uint8_t daysPerMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  DateTimeMS result;
+  uint64_t seconds = epochMs / 1000ULL;
+  uint32_t secondOfDay = seconds % 86400ULL;
+  int32_t days = (int32_t)(seconds / 86400ULL) + 719468;
+
+  int32_t era = days / 146097;
+  uint32_t doe = (uint32_t)(days - era * 146097);
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+
+  result.day = doy - (153 * mp + 2) / 5 + 1;
+  result.month = mp < 10 ? mp + 3 : mp - 9;
+  result.year = yoe + era * 400 + (result.month <= 2);
+  result.hour = secondOfDay / 3600;
+  result.minute = (secondOfDay / 60) % 60;
+  result.second = secondOfDay % 60;
+  result.millisecond = epochMs % 1000ULL;
+  return result;
+}
 
-  if (month == 0 || month > 12)
+
+/**
+ * @brief Formats a timestamp as [YY/MM/DD HH:MM:SS.mmm]
+ * @param epochMs Milliseconds since 1970-01-01
+ * @param buffer Buffer to store formatted timestamp
+ * @param size Size of buffer (must be >= TIMESTAMP_LENGTH)
+ * @return Characters written excluding terminator, 0 if buffer too small
+ *
+ * The prefix up to the minutes is rebuilt only when the minute changes;
+ * otherwise only the last 7 characters are rendered.
+ */
+size_t TimestampFormatter::format(uint64_t epochMs, char *buffer, size_t size)
+{
+  if (!buffer || size < TIMESTAMP_LENGTH)
   {
     return 0;
   }
 
-  if (month == 2 && isLeapYear(year))
+  uint64_t minute = epochMs / 60000ULL;
+  if (minute != m_cachedMinute)
   {
-    return 29;
+    DateTimeMS t = TimeManager::toDateTime(epochMs);
+    snprintf(m_prefix, sizeof(m_prefix), "[%02d/%02d/%02d %02d:%02d:",
+             t.year % 100, t.month, t.day, t.hour, t.minute);
+    m_cachedMinute = minute;
   }
 
-  return daysPerMonth[month - 1];
-}
-
-
-/**
- * @brief Checks if specified year is a leap year
- * @param year Four-digit year to check
- * @return true if leap year, false otherwise
- */
-bool TimeManager::isLeapYear(uint16_t year) const
-{
-  return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+  uint32_t msOfMinute = epochMs % 60000ULL;
+  uint32_t second = msOfMinute / 1000;
+  uint32_t ms = msOfMinute % 1000;
+
+  memcpy(buffer, m_prefix, PREFIX_LENGTH);
+  char *p = buffer + PREFIX_LENGTH;
+  *p++ = '0' + second / 10;
+  *p++ = '0' + second % 10;
+  *p++ = '.';
+  *p++ = '0' + ms / 100;
+  *p++ = '0' + (ms / 10) % 10;
+  *p++ = '0' + ms % 10;
+  *p++ = ']';
+  *p = '\0';
+  return TIMESTAMP_LENGTH - 1;
 }
 
 
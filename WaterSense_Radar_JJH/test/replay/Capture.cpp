@@ -0,0 +1,471 @@
+// test/replay/Capture.cpp
+#include "Capture.h"
+#include "communication/RadarManager.h"
+#include "communication/RadarProtocol.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  struct CommandName
+  {
+    const char *name;
+    uint8_t cmd;
+  };
+
+  const CommandName COMMANDS[] = {
+      {"REQUEST_CONFIG", RADAR_CMD_REQUEST_CONFIG},
+      {"CONFIG_GOOD", RADAR_CMD_CONFIG_GOOD},
+      {"CONFIG_BAD", RADAR_CMD_CONFIG_BAD},
+      {"START_DATA", RADAR_CMD_START_DATA},
+      {"NEW_DATA", RADAR_CMD_NEW_DATA},
+      {"START_TEST", RADAR_CMD_START_TEST},
+      {"END_TEST", RADAR_CMD_END_TEST},
+      {"NOISE_ON", RADAR_CMD_NOISE_ON},
+      {"NOISE_OFF", RADAR_CMD_NOISE_OFF},
+      {"STOP_REQUEST", RADAR_CMD_STOP_REQUEST},
+      {"STOP_CONFIRM", RADAR_CMD_STOP_CONFIRM},
+      {"CONFIG_STRING", RADAR_CMD_CONFIG_STRING},
+      {"DEBUG_MSG", RADAR_CMD_DEBUG_MSG},
+      {"PROFILE_MSG", RADAR_CMD_PROFILE_MSG},
+      {"ENERGY_MSG", RADAR_CMD_ENERGY_MSG},
+  };
+
+  bool parseHex(const std::string &text, std::vector<uint8_t> *out)
+  {
+    std::string digits;
+    for (char c : text)
+    {
+      if (isxdigit((unsigned char)c))
+        digits.push_back(c);
+      else if (!isspace((unsigned char)c))
+        return false;
+    }
+    if (digits.empty() || digits.size() % 2 != 0)
+      return false;
+
+    for (size_t i = 0; i < digits.size(); i += 2)
+      out->push_back((uint8_t)strtoul(digits.substr(i, 2).c_str(), nullptr, 16));
+    return true;
+  }
+
+  bool parseUnixtime(const std::string &date, const std::string &time, uint32_t *out)
+  {
+    int y, mo, d, h, mi, s;
+    if (sscanf(date.c_str(), "%d-%d-%d", &y, &mo, &d) != 3 ||
+        sscanf(time.c_str(), "%d:%d:%d", &h, &mi, &s) != 3)
+    {
+      return false;
+    }
+
+    // days_from_civil
+    y -= mo <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+    *out = (uint32_t)(days * 86400 + h * 3600 + mi * 60 + s);
+    return true;
+  }
+
+  std::string restOfLine(std::istringstream &in)
+  {
+    std::string rest;
+    std::getline(in, rest);
+    size_t start = rest.find_first_not_of(" \t");
+    return start == std::string::npos ? "" : rest.substr(start);
+  }
+}
+
+
+namespace CaptureFile
+{
+  bool commandByName(const std::string &name, uint8_t *cmd)
+  {
+    for (const CommandName &c : COMMANDS)
+    {
+      if (name == c.name)
+      {
+        *cmd = c.cmd;
+        return true;
+      }
+    }
+    return false;
+  }
+
+
+  std::vector<uint8_t> encodeMessage(uint8_t cmd, const std::string &text)
+  {
+    std::vector<uint8_t> msg;
+    msg.reserve(text.size() + 4);
+    msg.push_back(RADAR_HEADER_BYTE1);
+    msg.push_back(RADAR_HEADER_BYTE2);
+    msg.push_back(cmd);
+    msg.insert(msg.end(), text.begin(), text.end());
+    msg.push_back(RADAR_NULL);
+    return msg;
+  }
+
+
+  std::vector<uint8_t> encodeDistanceFrame(uint8_t sequence, const std::vector<float> &distances,
+                                           const std::vector<float> &strengths,
+                                           const uint32_t *timestampMs, uint8_t configIndex, const uint32_t *ageMs)
+  {
+    size_t count = distances.size() < RADAR_FRAME_MAX_DISTANCES ? distances.size() : RADAR_FRAME_MAX_DISTANCES;
+    size_t length = count * RADAR_FRAME_DISTANCE_SIZE + (timestampMs ? RADAR_FRAME_TIMESTAMP_SIZE : 0) +
+                    (configIndex ? RADAR_FRAME_CONFIG_INDEX_SIZE : 0) + (ageMs ? RADAR_FRAME_AGE_SIZE : 0);
+    uint8_t cmd = timestampMs ? RADAR_CMD_TIMED_DATA_FRAME
+                              : (configIndex ? RADAR_CMD_CONFIG_DATA_FRAME
+                                             : (ageMs ? RADAR_CMD_FILTERED_DATA_FRAME : RADAR_CMD_DATA_FRAME));
+    std::vector<uint8_t> frame = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2, cmd,
+                                  RADAR_FRAME_VERSION, (uint8_t)length, sequence};
+
+    if (timestampMs)
+    {
+      for (int shift = 0; shift < 32; shift += 8)
+        frame.push_back((uint8_t)(*timestampMs >> shift));
+    }
+    else if (configIndex)
+    {
+      frame.push_back(configIndex);
+    }
+    else if (ageMs)
+    {
+      for (int shift = 0; shift < 32; shift += 8)
+        frame.push_back((uint8_t)(*ageMs >> shift));
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+      long mm = lroundf(distances[i] * 1000.0f);
+      long cdb = lroundf(strengths[i] * 100.0f);
+      uint16_t d = (uint16_t)(mm < 0 ? 0 : (mm > 0xFFFF ? 0xFFFF : mm));
+      int16_t s = (int16_t)(cdb < INT16_MIN ? INT16_MIN : (cdb > INT16_MAX ? INT16_MAX : cdb));
+      frame.push_back((uint8_t)(d & 0xFF));
+      frame.push_back((uint8_t)(d >> 8));
+      frame.push_back((uint8_t)((uint16_t)s & 0xFF));
+      frame.push_back((uint8_t)((uint16_t)s >> 8));
+    }
+
+    uint16_t crc = RadarProtocol::crc16(frame.data() + 2, frame.size() - 2);
+    frame.push_back((uint8_t)(crc & 0xFF));
+    frame.push_back((uint8_t)(crc >> 8));
+    return frame;
+  }
+
+
+  std::vector<uint8_t> encodeAggregateFrame(uint8_t sequence, const RadarAggregateFrame &aggregate)
+  {
+    std::vector<uint8_t> frame = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2, RADAR_CMD_AGGREGATE_FRAME,
+                                  RADAR_FRAME_VERSION, RADAR_FRAME_AGGREGATE_SIZE, sequence};
+    auto put16 = [&](uint16_t value)
+    {
+      frame.push_back((uint8_t)(value & 0xFF));
+      frame.push_back((uint8_t)(value >> 8));
+    };
+
+    put16((uint16_t)lroundf(aggregate.median * 1000.0f));
+    put16((uint16_t)lroundf(aggregate.min * 1000.0f));
+    put16((uint16_t)lroundf(aggregate.max * 1000.0f));
+    put16((uint16_t)(int16_t)lroundf(aggregate.meanStrength * 100.0f));
+    put16(aggregate.samples);
+    put16(aggregate.outliers);
+    put16(aggregate.empty);
+    put16((uint16_t)(aggregate.periodMs & 0xFFFF));
+    put16((uint16_t)(aggregate.periodMs >> 16));
+
+    uint16_t crc = RadarProtocol::crc16(frame.data() + 2, frame.size() - 2);
+    frame.push_back((uint8_t)(crc & 0xFF));
+    frame.push_back((uint8_t)(crc >> 8));
+    return frame;
+  }
+
+
+  std::vector<uint8_t> encodeRateFrame(uint8_t sequence, const RadarRateFrame &rate)
+  {
+    std::vector<uint8_t> frame = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2, RADAR_CMD_RATE_FRAME,
+                                  RADAR_FRAME_VERSION, RADAR_FRAME_RATE_SIZE, sequence};
+    auto put16 = [&](uint16_t value)
+    {
+      frame.push_back((uint8_t)(value & 0xFF));
+      frame.push_back((uint8_t)(value >> 8));
+    };
+
+    put16((uint16_t)(rate.periodMs & 0xFFFF));
+    put16((uint16_t)(rate.periodMs >> 16));
+    put16((uint16_t)lroundf(rate.spread * 1000.0f));
+
+    uint16_t crc = RadarProtocol::crc16(frame.data() + 2, frame.size() - 2);
+    frame.push_back((uint8_t)(crc & 0xFF));
+    frame.push_back((uint8_t)(crc >> 8));
+    return frame;
+  }
+
+
+  std::vector<uint8_t> encodeWindowFrame(uint8_t sequence, const RadarWindowFrame &window)
+  {
+    std::vector<uint8_t> frame = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2, RADAR_CMD_WINDOW_FRAME,
+                                  RADAR_FRAME_VERSION, RADAR_FRAME_WINDOW_SIZE, sequence};
+    auto put16 = [&](uint16_t value)
+    {
+      frame.push_back((uint8_t)(value & 0xFF));
+      frame.push_back((uint8_t)(value >> 8));
+    };
+
+    put16((uint16_t)lroundf(window.start * 1000.0f));
+    put16((uint16_t)lroundf(window.end * 1000.0f));
+    frame.push_back(window.searching ? 1 : 0);
+
+    uint16_t crc = RadarProtocol::crc16(frame.data() + 2, frame.size() - 2);
+    frame.push_back((uint8_t)(crc & 0xFF));
+    frame.push_back((uint8_t)(crc >> 8));
+    return frame;
+  }
+
+
+  bool load(const char *path, Capture *out, std::string *error)
+  {
+    std::ifstream file(path);
+    if (!file)
+    {
+      *error = std::string(path) + ": can't open";
+      return false;
+    }
+
+    std::string text;
+    int lineNo = 0;
+    double lastMs = 0.0;
+
+    auto fail = [&](const std::string &message)
+    {
+      *error = std::string(path) + ":" + std::to_string(lineNo) + ": " + message;
+      return false;
+    };
+
+    while (std::getline(file, text))
+    {
+      lineNo++;
+      if (!text.empty() && text.back() == '\r')
+        text.pop_back();
+
+      std::istringstream in(text);
+      std::string first;
+      if (!(in >> first) || first[0] == '#')
+        continue;
+
+      if (first == "rtc")
+      {
+        std::string date, time;
+        if (!(in >> date >> time) || !parseUnixtime(date, time, &out->rtcUnixtime))
+          return fail("expected rtc YYYY-MM-DD HH:MM:SS");
+        continue;
+      }
+      if (first == "config")
+      {
+        std::string field, value;
+        if (!(in >> field >> value))
+          return fail("expected config <field> <value>");
+        out->config.push_back({field, value});
+        continue;
+      }
+      if (first == "expect")
+      {
+        CaptureExpect expect;
+        expect.line = lineNo;
+        if (!(in >> expect.name))
+          return fail("expected expect <name> <value>");
+        expect.value = restOfLine(in);
+        out->expects.push_back(expect);
+        continue;
+      }
+
+      // Timed line
+      bool relative = first[0] == '+';
+      char *end;
+      double ms = strtod(first.c_str() + (relative ? 1 : 0), &end);
+      if (*end != '\0' || ms < 0)
+        return fail("unknown line \"" + first + "\"");
+      if (relative)
+        ms += lastMs;
+      if (ms < lastMs)
+        return fail("time goes backwards");
+      lastMs = ms;
+
+      CaptureEvent event;
+      event.type = CaptureEvent::RX;
+      event.timeUs = (uint64_t)llround(ms * 1000.0);
+      event.line = lineNo;
+
+      std::string verb;
+      in >> verb;
+      if (verb == "rx")
+      {
+        if (!parseHex(restOfLine(in), &event.bytes))
+          return fail("bad hex bytes");
+      }
+      else if (verb == "msg")
+      {
+        std::string name;
+        uint8_t cmd;
+        if (!(in >> name) || !commandByName(name, &cmd))
+          return fail("unknown command \"" + name + "\"");
+
+        std::string body = restOfLine(in);
+        if (cmd == RADAR_CMD_END_TEST)
+        {
+          // Sample count is one raw byte, not text
+          event.bytes = encodeMessage(cmd, std::string(1, (char)(uint8_t)atoi(body.c_str())));
+        }
+        else
+        {
+          event.bytes = encodeMessage(cmd, body);
+        }
+      }
+      else if (verb == "frame")
+      {
+        int sequence;
+        if (!(in >> sequence))
+          return fail("expected frame <seq> [@<stamp_ms> | c<config> | ~<age_ms>] [<d_m> <s_db>]...");
+
+        std::vector<float> distances, strengths;
+        bool badCrc = false;
+        bool timed = false;
+        uint32_t timestampMs = 0;
+        unsigned long configIndex = 0;
+        bool filtered = false;
+        uint32_t ageMs = 0;
+        std::string token;
+        while (in >> token)
+        {
+          if (token == "badcrc")
+          {
+            badCrc = true;
+            continue;
+          }
+          if (token[0] == '@')
+          {
+            timed = true;
+            timestampMs = (uint32_t)strtoul(token.c_str() + 1, nullptr, 10);
+            continue;
+          }
+          if (token[0] == '~')
+          {
+            filtered = true;
+            ageMs = (uint32_t)strtoul(token.c_str() + 1, nullptr, 10);
+            continue;
+          }
+          if (token[0] == 'c')
+          {
+            configIndex = strtoul(token.c_str() + 1, nullptr, 10);
+            if (configIndex == 0 || configIndex > 0xFF)
+              return fail("frame config index must be 1-255");
+            continue;
+          }
+          std::string strength;
+          if (!(in >> strength))
+            return fail("frame needs distance/strength pairs");
+          distances.push_back(strtof(token.c_str(), nullptr));
+          strengths.push_back(strtof(strength.c_str(), nullptr));
+        }
+
+        if ((timed ? 1 : 0) + (configIndex ? 1 : 0) + (filtered ? 1 : 0) > 1)
+          return fail("a frame is either timed, filtered or of a secondary configuration");
+        event.bytes = encodeDistanceFrame((uint8_t)sequence, distances, strengths, timed ? &timestampMs : nullptr,
+                                          (uint8_t)configIndex, filtered ? &ageMs : nullptr);
+        if (badCrc)
+          event.bytes.back() ^= 0xFF;
+      }
+      else if (verb == "aggregate")
+      {
+        int sequence;
+        unsigned samples, outliers, empty, periodMs;
+        RadarAggregateFrame aggregate = {};
+        if (!(in >> sequence >> aggregate.median >> aggregate.min >> aggregate.max >> aggregate.meanStrength >>
+              samples >> outliers >> empty >> periodMs))
+          return fail("expected aggregate <seq> <median_m> <min_m> <max_m> <s_db> <samples> <outliers> <empty> <period_ms>");
+
+        aggregate.samples = (uint16_t)samples;
+        aggregate.outliers = (uint16_t)outliers;
+        aggregate.empty = (uint16_t)empty;
+        aggregate.periodMs = periodMs;
+        event.bytes = encodeAggregateFrame((uint8_t)sequence, aggregate);
+      }
+      else if (verb == "rate")
+      {
+        int sequence;
+        unsigned periodMs;
+        RadarRateFrame rate = {};
+        if (!(in >> sequence >> periodMs >> rate.spread))
+          return fail("expected rate <seq> <period_ms> <spread_m>");
+
+        rate.periodMs = periodMs;
+        event.bytes = encodeRateFrame((uint8_t)sequence, rate);
+      }
+      else if (verb == "window")
+      {
+        int sequence;
+        RadarWindowFrame window = {};
+        if (!(in >> sequence >> window.start >> window.end))
+          return fail("expected window <seq> <start_m> <end_m> [search]");
+
+        std::string flag;
+        if (in >> flag)
+        {
+          if (flag != "search")
+            return fail("expected window <seq> <start_m> <end_m> [search]");
+          window.searching = true;
+        }
+        event.bytes = encodeWindowFrame((uint8_t)sequence, window);
+      }
+      else if (verb == "burst")
+      {
+        int count, sequence;
+        if (!(in >> count >> sequence) || count <= 0)
+          return fail("expected burst <n> <seq> [<d_m> <s_db>]...");
+
+        std::vector<float> distances, strengths;
+        float distance, strength;
+        while (in >> distance >> strength)
+        {
+          distances.push_back(distance);
+          strengths.push_back(strength);
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+          std::vector<uint8_t> frame = encodeDistanceFrame((uint8_t)(sequence + i), distances, strengths);
+          event.bytes.insert(event.bytes.end(), frame.begin(), frame.end());
+        }
+      }
+      else if (verb == "fill")
+      {
+        int count;
+        std::string hex;
+        if (!(in >> count >> hex) || count <= 0 || !parseHex(hex, &event.bytes) || event.bytes.size() != 1)
+          return fail("expected fill <n> <hex byte>");
+        event.bytes.assign((size_t)count, event.bytes[0]);
+      }
+      else if (verb == "echo-config")
+      {
+        event.type = CaptureEvent::CONFIG_ECHO;
+      }
+      else if (verb == "stop")
+      {
+        event.type = CaptureEvent::STOP;
+      }
+      else
+      {
+        return fail("unknown verb \"" + verb + "\"");
+      }
+
+      out->events.push_back(event);
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,85 @@
+// test/replay/Capture.h
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "communication/RadarProtocol.h"
+
+// Replay capture (.cap): a recorded or scripted STM32 session as text, one
+// item per line. Blank lines and lines starting with '#' are ignored.
+//
+//   rtc <YYYY-MM-DD> <HH:MM:SS>     RTC time at boot (default 2024-01-01 00:00:00)
+//   config <field> <value>          ConfigSettings field set before RadarManager starts,
+//                                   e.g. "config mode_flags 03", "config update_rate 10"
+//   <time> rx <hex bytes>           raw bytes from the STM32, e.g. "4F 3A 42 00" or "4F3A4200"
+//   <time> msg <NAME> [text]        [H1][H2][CMD][text][NULL]; NAME is a RADAR_CMD_* suffix
+//                                   (NOISE_ON, NEW_DATA, ...). For END_TEST the text is the
+//                                   sample count, sent as one raw byte.
+//   <time> frame <seq> [@<stamp_ms> | c<config> | ~<age_ms>] [<d_m> <s_db>]... [badcrc]
+//                                   RADAR_CMD_DATA_FRAME, RADAR_CMD_TIMED_DATA_FRAME with
+//                                   an STM32 timestamp, RADAR_CMD_CONFIG_DATA_FRAME of a
+//                                   secondary configuration or RADAR_CMD_FILTERED_DATA_FRAME
+//                                   measured age_ms earlier; "badcrc" corrupts the CRC
+//   <time> aggregate <seq> <median_m> <min_m> <max_m> <s_db> <samples> <outliers> <empty> <period_ms>
+//                                   RADAR_CMD_AGGREGATE_FRAME
+//   <time> rate <seq> <period_ms> <spread_m>
+//                                   RADAR_CMD_RATE_FRAME
+//   <time> window <seq> <start_m> <end_m> [search]
+//                                   RADAR_CMD_WINDOW_FRAME
+//   <time> burst <n> <seq> [<d_m> <s_db>]...
+//                                   n frames with consecutive sequence numbers in one chunk
+//   <time> fill <n> <hex byte>      n copies of one byte in one chunk (line noise)
+//   <time> echo-config              STM32 echo of the last config string the ESP32 sent
+//   <time> stop                     ESP32 starts its stop sequence (stopDataCollection)
+//   expect <name> <value>           checked after the replay, see radar_replay --help
+//
+// <time> is milliseconds since boot, or "+<ms>" relative to the previous timed
+// line. Bytes scheduled while the ESP32's UART driver is removed (during the
+// stop sequence) are lost, like on the wire.
+struct CaptureEvent
+{
+  enum Type
+  {
+    RX,
+    CONFIG_ECHO,
+    STOP
+  };
+
+  Type type;
+  uint64_t timeUs;
+  std::vector<uint8_t> bytes; // RX only
+  int line;
+};
+
+struct CaptureExpect
+{
+  std::string name;
+  std::string value;
+  int line;
+};
+
+struct Capture
+{
+  uint32_t rtcUnixtime = 1704067200; // 2024-01-01 00:00:00
+  std::vector<std::pair<std::string, std::string>> config;
+  std::vector<CaptureEvent> events; // in time order
+  std::vector<CaptureExpect> expects;
+};
+
+namespace CaptureFile
+{
+  // Returns false and sets error ("file:line: message") if the file can't be parsed
+  bool load(const char *path, Capture *out, std::string *error);
+
+  // Messages as the STM32 firmware sends them
+  bool commandByName(const std::string &name, uint8_t *cmd);
+  std::vector<uint8_t> encodeMessage(uint8_t cmd, const std::string &text);
+  std::vector<uint8_t> encodeDistanceFrame(uint8_t sequence, const std::vector<float> &distances,
+                                           const std::vector<float> &strengths,
+                                           const uint32_t *timestampMs = nullptr, uint8_t configIndex = 0,
+                                           const uint32_t *ageMs = nullptr);
+  std::vector<uint8_t> encodeAggregateFrame(uint8_t sequence, const RadarAggregateFrame &aggregate);
+  std::vector<uint8_t> encodeRateFrame(uint8_t sequence, const RadarRateFrame &rate);
+  std::vector<uint8_t> encodeWindowFrame(uint8_t sequence, const RadarWindowFrame &window);
+}
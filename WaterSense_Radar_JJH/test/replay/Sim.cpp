@@ -0,0 +1,540 @@
+// test/replay/Sim.cpp
+//
+// Simulated clock, UART driver, SD card and RTC behind the host stubs.
+
+#include "Sim.h"
+
+#include <Arduino.h>
+#include <SD.h>
+#include <RTClib.h>
+#include <esp_timer.h>
+#include "driver/uart.h"
+#include "driver/gpio.h"
+
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  // IDF posts a UART_DATA event every time the RX FIFO reaches its full
+  // threshold (120 bytes by default) or the line goes idle
+  constexpr size_t UART_EVENT_MAX_BYTES = 120;
+
+  struct RxChunk
+  {
+    uint64_t timeUs;
+    std::vector<uint8_t> bytes;
+    bool configEcho;
+  };
+
+  struct GenericQueue
+  {
+    uint32_t length;
+    uint32_t itemSize;
+    std::deque<std::vector<uint8_t>> items;
+  };
+
+  uint64_t s_nowUs = 0;
+  uint64_t s_sleepTimerUs = 0;
+  double s_speed = 0.0;
+  uint64_t s_paceSimUs = 0;
+  std::chrono::steady_clock::time_point s_paceWall;
+  bool s_verbose = false;
+  std::string s_sdRoot = "replay_sd";
+
+  // UART driver
+  std::deque<RxChunk> s_schedule;
+  bool s_uartInstalled = false;
+  size_t s_rxBufferSize = 0;
+  size_t s_eventQueueSize = 0;
+  std::deque<uint8_t> s_rxBuffer;
+  std::deque<uart_event_t> s_uartEvents;
+  int s_uartQueueTag; // address used as the event queue handle
+  std::vector<uint8_t> s_tx;
+  Sim::UartStats s_uartStats = {};
+
+  void postUartEvent(uart_event_type_t type, size_t size)
+  {
+    if (s_uartEvents.size() >= s_eventQueueSize)
+    {
+      s_uartStats.eventsLost++;
+      return;
+    }
+    uart_event_t event = {};
+    event.type = type;
+    event.size = size;
+    s_uartEvents.push_back(event);
+  }
+
+  /**
+   * @brief Builds the STM32's echo of the last config string sent
+   *
+   * The STM32 sends back what it received through its own send routine, which
+   * adds another header: [H1][H2][H1][H2][CMD_CONFIG_STRING]...[NULL]
+   */
+  std::vector<uint8_t> configEchoBytes()
+  {
+    std::vector<uint8_t> echo;
+    for (size_t i = s_tx.size(); i >= 3; i--)
+    {
+      size_t start = i - 3;
+      if (s_tx[start] == 0x4F && s_tx[start + 1] == 0x3A && s_tx[start + 2] == 0x24)
+      {
+        echo.push_back(0x4F);
+        echo.push_back(0x3A);
+        for (size_t j = start; j < s_tx.size(); j++)
+        {
+          echo.push_back(s_tx[j]);
+          if (s_tx[j] == 0)
+            break;
+        }
+        break;
+      }
+    }
+    return echo;
+  }
+
+  void deliver(RxChunk &chunk)
+  {
+    if (chunk.configEcho)
+      chunk.bytes = configEchoBytes();
+
+    s_uartStats.chunks++;
+    if (!s_uartInstalled)
+    {
+      s_uartStats.bytesLost += chunk.bytes.size();
+      return;
+    }
+
+    size_t space = s_rxBufferSize - s_rxBuffer.size();
+    size_t accepted = chunk.bytes.size() < space ? chunk.bytes.size() : space;
+    s_rxBuffer.insert(s_rxBuffer.end(), chunk.bytes.begin(), chunk.bytes.begin() + accepted);
+    s_uartStats.bytesReceived += accepted;
+
+    for (size_t posted = 0; posted < accepted; posted += UART_EVENT_MAX_BYTES)
+    {
+      size_t n = accepted - posted;
+      postUartEvent(UART_DATA, n < UART_EVENT_MAX_BYTES ? n : UART_EVENT_MAX_BYTES);
+    }
+
+    if (accepted < chunk.bytes.size())
+    {
+      s_uartStats.bytesLost += chunk.bytes.size() - accepted;
+      postUartEvent(UART_BUFFER_FULL, 0);
+    }
+  }
+
+  std::string sdPath(const char *path)
+  {
+    return s_sdRoot + path;
+  }
+
+  // Howard Hinnant's days_from_civil / civil_from_days
+  int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+  {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+  }
+}
+
+
+namespace Sim
+{
+  void reset()
+  {
+    s_nowUs = 0;
+    s_paceSimUs = 0;
+    s_paceWall = std::chrono::steady_clock::now();
+    s_schedule.clear();
+    s_uartInstalled = false;
+    s_rxBuffer.clear();
+    s_uartEvents.clear();
+    s_tx.clear();
+    s_uartStats = {};
+  }
+
+  uint64_t nowUs()
+  {
+    return s_nowUs;
+  }
+
+  /**
+   * @brief Moves the clock forward, delivering scheduled bytes on the way
+   * @param timeUs Time to advance to, ignored if in the past
+   */
+  void advanceTo(uint64_t timeUs)
+  {
+    while (!s_schedule.empty() && s_schedule.front().timeUs <= timeUs)
+    {
+      if (s_schedule.front().timeUs > s_nowUs)
+        s_nowUs = s_schedule.front().timeUs;
+      deliver(s_schedule.front());
+      s_schedule.pop_front();
+    }
+
+    if (timeUs > s_nowUs)
+      s_nowUs = timeUs;
+
+    if (s_speed > 0.0)
+    {
+      auto wallTarget = s_paceWall + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                         std::chrono::duration<double, std::micro>((s_nowUs - s_paceSimUs) / s_speed));
+      std::this_thread::sleep_until(wallTarget);
+    }
+  }
+
+  void advanceBy(uint64_t us)
+  {
+    advanceTo(s_nowUs + us);
+  }
+
+  void setSpeed(double speed)
+  {
+    s_speed = speed;
+    s_paceSimUs = s_nowUs;
+    s_paceWall = std::chrono::steady_clock::now();
+  }
+
+  void scheduleRx(uint64_t timeUs, const std::vector<uint8_t> &bytes)
+  {
+    s_schedule.push_back({timeUs, bytes, false});
+  }
+
+  void scheduleConfigEcho(uint64_t timeUs)
+  {
+    s_schedule.push_back({timeUs, {}, true});
+  }
+
+  uint64_t nextRxUs()
+  {
+    return s_schedule.empty() ? NEVER : s_schedule.front().timeUs;
+  }
+
+  const std::vector<uint8_t> &txBytes()
+  {
+    return s_tx;
+  }
+
+  const UartStats &uartStats()
+  {
+    return s_uartStats;
+  }
+
+  void setSdRoot(const std::string &path)
+  {
+    s_sdRoot = path;
+  }
+
+  const std::string &sdRoot()
+  {
+    return s_sdRoot;
+  }
+
+  void setVerbose(bool verbose)
+  {
+    s_verbose = verbose;
+  }
+}
+
+
+// ---------------- Arduino core ----------------
+
+Print Serial;
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  if (s_verbose)
+    fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+uint32_t millis() { return (uint32_t)(s_nowUs / 1000); }
+uint32_t micros() { return (uint32_t)s_nowUs; }
+void delay(uint32_t ms) { Sim::advanceBy((uint64_t)ms * 1000); }
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+
+int64_t esp_timer_get_time() { return (int64_t)s_nowUs; }
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+  s_sleepTimerUs = time_in_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_uart_wakeup(int) { return ESP_OK; }
+
+// Light sleep ends on the wakeup timer or when UART bytes arrive
+esp_err_t esp_light_sleep_start()
+{
+  uint64_t wake = s_nowUs + s_sleepTimerUs;
+  uint64_t next = Sim::nextRxUs();
+  Sim::advanceTo(next < wake ? next : wake);
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t, gpio_mode_t) { return ESP_OK; }
+esp_err_t gpio_set_level(gpio_num_t, uint32_t) { return ESP_OK; }
+
+
+// ---------------- FreeRTOS ----------------
+
+void vTaskDelay(TickType_t ticks)
+{
+  Sim::advanceBy((uint64_t)ticks * 1000);
+}
+
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t itemSize)
+{
+  return new GenericQueue{length, itemSize, {}};
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t)
+{
+  GenericQueue *q = (GenericQueue *)queue;
+  if (q == nullptr || q->items.size() >= q->length)
+    return pdFALSE;
+  const uint8_t *bytes = (const uint8_t *)item;
+  q->items.emplace_back(bytes, bytes + q->itemSize);
+  return pdTRUE;
+}
+
+/**
+ * UART event queue: returns a pending event, otherwise advances the clock to
+ * the next scheduled chunk or the timeout, whichever comes first.
+ */
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+  if (queue == &s_uartQueueTag)
+  {
+    uint64_t deadline = (ticks == portMAX_DELAY) ? Sim::NEVER : s_nowUs + (uint64_t)ticks * 1000;
+    while (true)
+    {
+      if (!s_uartEvents.empty())
+      {
+        *(uart_event_t *)item = s_uartEvents.front();
+        s_uartEvents.pop_front();
+        return pdTRUE;
+      }
+
+      uint64_t next = Sim::nextRxUs();
+      if (next == Sim::NEVER || next > deadline)
+      {
+        if (deadline != Sim::NEVER)
+          Sim::advanceTo(deadline);
+        return pdFALSE;
+      }
+      Sim::advanceTo(next);
+    }
+  }
+
+  GenericQueue *q = (GenericQueue *)queue;
+  if (q == nullptr || q->items.empty())
+  {
+    Sim::advanceBy((uint64_t)(ticks == portMAX_DELAY ? 0 : ticks) * 1000);
+    return pdFALSE;
+  }
+  memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+  if (queue == &s_uartQueueTag)
+    s_uartEvents.clear();
+  else if (queue)
+    ((GenericQueue *)queue)->items.clear();
+  return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+  if (queue != &s_uartQueueTag)
+    delete (GenericQueue *)queue;
+}
+
+
+// ---------------- UART driver ----------------
+
+esp_err_t uart_param_config(uart_port_t, const uart_config_t *) { return ESP_OK; }
+esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return ESP_OK; }
+esp_err_t uart_set_wakeup_threshold(uart_port_t, int) { return ESP_OK; }
+
+esp_err_t uart_driver_install(uart_port_t, int rx_buffer_size, int, int queue_size,
+                              QueueHandle_t *uart_queue, int)
+{
+  if (s_uartInstalled)
+    return ESP_FAIL;
+
+  s_uartInstalled = true;
+  s_rxBufferSize = (size_t)rx_buffer_size;
+  s_eventQueueSize = (size_t)queue_size;
+  if (uart_queue)
+    *uart_queue = &s_uartQueueTag;
+  return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t)
+{
+  s_uartInstalled = false;
+  s_rxBuffer.clear();
+  s_uartEvents.clear();
+  return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t)
+{
+  s_rxBuffer.clear();
+  return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t, void *buf, uint32_t length, TickType_t)
+{
+  uint8_t *out = (uint8_t *)buf;
+  uint32_t n = 0;
+  while (n < length && !s_rxBuffer.empty())
+  {
+    out[n++] = s_rxBuffer.front();
+    s_rxBuffer.pop_front();
+  }
+  return (int)n;
+}
+
+int uart_write_bytes(uart_port_t, const void *src, size_t size)
+{
+  if (!s_uartInstalled)
+    return -1;
+
+  const uint8_t *bytes = (const uint8_t *)src;
+  s_tx.insert(s_tx.end(), bytes, bytes + size);
+  s_uartStats.bytesSent += size;
+  return (int)size;
+}
+
+
+// ---------------- SD card ----------------
+
+SDFS SD;
+
+bool SDFS::begin(uint8_t)
+{
+  ::mkdir(s_sdRoot.c_str(), 0755);
+  struct stat st;
+  return stat(s_sdRoot.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool SDFS::exists(const char *path)
+{
+  struct stat st;
+  return stat(sdPath(path).c_str(), &st) == 0;
+}
+
+bool SDFS::mkdir(const char *path)
+{
+  return ::mkdir(sdPath(path).c_str(), 0755) == 0;
+}
+
+bool SDFS::remove(const char *path)
+{
+  return ::remove(sdPath(path).c_str()) == 0;
+}
+
+File SDFS::open(const char *path, const char *mode)
+{
+  return File(fopen(sdPath(path).c_str(), mode));
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+  return m_f ? fwrite(buffer, 1, size, m_f) : 0;
+}
+
+size_t File::size()
+{
+  if (!m_f)
+    return 0;
+  fflush(m_f);
+  struct stat st;
+  return fstat(fileno(m_f), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+int File::available()
+{
+  if (!m_f)
+    return 0;
+  long pos = ftell(m_f);
+  return pos < 0 ? 0 : (int)(size() - (size_t)pos);
+}
+
+size_t File::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t n = 0;
+  int c;
+  while (m_f && n < length && (c = fgetc(m_f)) != EOF && c != terminator)
+    buffer[n++] = (char)c;
+  return n;
+}
+
+
+// ---------------- RTC ----------------
+
+DateTime::DateTime(uint32_t unixtime)
+{
+  int64_t days = unixtime / 86400;
+  uint32_t rem = unixtime % 86400;
+
+  // civil_from_days
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned doe = (unsigned)(days - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+
+  m_year = (uint16_t)((int64_t)yoe + era * 400 + (m <= 2));
+  m_month = (uint8_t)m;
+  m_day = (uint8_t)d;
+  m_hour = (uint8_t)(rem / 3600);
+  m_minute = (uint8_t)(rem / 60 % 60);
+  m_second = (uint8_t)(rem % 60);
+}
+
+// Same formats as __DATE__ ("Oct 17 2026") and __TIME__ ("13:38:25")
+DateTime::DateTime(const char *date, const char *time) : DateTime()
+{
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  const char *found = strstr(months, std::string(date, 3).c_str());
+  m_month = found ? (uint8_t)((found - months) / 3 + 1) : 1;
+  m_day = (uint8_t)atoi(date + 4);
+  m_year = (uint16_t)atoi(date + 7);
+  m_hour = (uint8_t)atoi(time);
+  m_minute = (uint8_t)atoi(time + 3);
+  m_second = (uint8_t)atoi(time + 6);
+}
+
+uint32_t DateTime::unixtime() const
+{
+  return (uint32_t)(daysFromCivil(m_year, m_month, m_day) * 86400 +
+                    m_hour * 3600 + m_minute * 60 + m_second);
+}
+
+void RTC_PCF8523::adjust(const DateTime &dt)
+{
+  m_setUnixtime = dt.unixtime();
+  m_setUs = s_nowUs;
+}
+
+DateTime RTC_PCF8523::now()
+{
+  return DateTime((uint32_t)(m_setUnixtime + (s_nowUs - m_setUs) / 1000000));
+}
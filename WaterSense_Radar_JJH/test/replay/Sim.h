@@ -0,0 +1,57 @@
+// test/replay/Sim.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Simulated environment behind the host stubs (stubs/).
+//
+// The harness is single threaded: radarTask and sdTask are run one step at a
+// time (RadarManager::serviceUart, SDCardManager::sdTaskStep) and the clock
+// only moves when firmware code waits, i.e. in xQueueReceive() on the UART
+// event queue, vTaskDelay() and delay(). Scheduled STM32 bytes are delivered
+// to the UART driver when the clock reaches their timestamp, so a replay is
+// deterministic regardless of host speed. With a speed set, every clock
+// advance is also paced against the wall clock.
+namespace Sim
+{
+  static constexpr uint64_t NEVER = UINT64_MAX;
+
+  struct UartStats
+  {
+    uint64_t chunks;        // scheduled chunks delivered or lost
+    uint64_t bytesReceived; // bytes accepted into the driver's RX buffer
+    uint64_t bytesLost;     // bytes that arrived with no driver or a full buffer
+    uint64_t eventsLost;    // events dropped because the event queue was full
+    uint64_t bytesSent;     // bytes written by the ESP32
+  };
+
+  void reset();
+
+  // Clock, in microseconds since boot
+  uint64_t nowUs();
+  void advanceTo(uint64_t timeUs);
+  void advanceBy(uint64_t us);
+
+  // Simulated seconds per wall-clock second, 0 runs as fast as possible
+  void setSpeed(double speed);
+
+  // STM32 -> ESP32 bytes. Chunks must be scheduled in time order.
+  void scheduleRx(uint64_t timeUs, const std::vector<uint8_t> &bytes);
+  void scheduleConfigEcho(uint64_t timeUs); // echoes the last config string sent
+  uint64_t nextRxUs();                      // NEVER when nothing is scheduled
+
+  // ESP32 -> STM32 bytes
+  const std::vector<uint8_t> &txBytes();
+
+  const UartStats &uartStats();
+
+  // Host directory that stands in for the SD card
+  void setSdRoot(const std::string &path);
+  const std::string &sdRoot();
+
+  // Print Serial/Bluetooth output to stdout
+  void setVerbose(bool verbose);
+}
@@ -0,0 +1,292 @@
+// test/replay/make_capture.cpp
+//
+// Turns a data file from the logger's SD card (/DATA/*.txt) back into the
+// STM32 session that produced it: config handshake, START_DATA, one
+// measurement per logged line at its logged time with the NOISE_ON/NOISE_OFF
+// bracket the STM32 sends around its sleep, then an ESP32 stop sequence.
+// The result is a capture for radar_replay, with expect lines for the number
+// of records the replay should log.
+//
+// Reads both the current line format ("[YY/MM/DD HH:MM:SS.mmm] d,s;d,s;" or
+// "... no_dists") and the older single-target format ("... 4.058 m, 21.97").
+// Lines that don't parse (e.g. two samples run together on a torn write) are
+// skipped and counted in a comment.
+
+#include "communication/RadarProtocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct Sample
+  {
+    int64_t timeMs;        // since midnight of the first sample's day
+    std::string timestamp; // as logged, "[YY/MM/DD HH:MM:SS.mmm]"
+    std::vector<float> distances;
+    std::vector<float> strengths;
+  };
+
+  struct Options
+  {
+    const char *input = nullptr;
+    const char *output = nullptr;
+    bool text = false;
+    bool binaryLog = false;
+    size_t limit = 0;
+  };
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "Usage: %s [options] <data.txt>\n"
+            "  -o <file.cap>   output capture (default: stdout)\n"
+            "  --text          send NEW_DATA text messages instead of binary frames\n"
+            "  --binary-log    also set RADAR_MODE_BINARY_LOG (.bin data files)\n"
+            "  --limit <n>     only the first n samples\n",
+            argv0);
+  }
+
+  bool parseArgs(int argc, char **argv, Options *opt)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        opt->output = argv[++i];
+      else if (strcmp(argv[i], "--text") == 0)
+        opt->text = true;
+      else if (strcmp(argv[i], "--binary-log") == 0)
+        opt->binaryLog = true;
+      else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc)
+        opt->limit = strtoul(argv[++i], nullptr, 10);
+      else if (argv[i][0] == '-' || opt->input)
+        return false;
+      else
+        opt->input = argv[i];
+    }
+    return opt->input != nullptr;
+  }
+
+  // "[YY/MM/DD HH:MM:SS.mmm]", returns ms since midnight of day 0 and the date
+  bool parseTimestamp(const char *line, int date[3], int64_t *ms, const char **rest)
+  {
+    int y, mo, d, h, mi, s, milli, used = 0;
+    if (sscanf(line, "[%d/%d/%d %d:%d:%d.%d]%n", &y, &mo, &d, &h, &mi, &s, &milli, &used) != 7 || used == 0)
+      return false;
+
+    date[0] = 2000 + y;
+    date[1] = mo;
+    date[2] = d;
+    *ms = ((int64_t)h * 3600 + mi * 60 + s) * 1000 + milli;
+    *rest = line + used;
+    return true;
+  }
+
+  bool parseValues(const char *text, Sample *sample)
+  {
+    while (*text == ' ')
+      text++;
+
+    if (strcmp(text, "no_dists") == 0)
+      return true;
+
+    // Older firmware: "4.058 m, 21.97"
+    float distance, strength;
+    int used = 0;
+    if (sscanf(text, "%f m, %f%n", &distance, &strength, &used) == 2 && text[used] == '\0')
+    {
+      sample->distances.push_back(distance);
+      sample->strengths.push_back(strength);
+      return true;
+    }
+
+    // Current firmware: "d,s;d,s;"
+    const char *p = text;
+    while (*p != '\0')
+    {
+      if (sscanf(p, "%f,%f;%n", &distance, &strength, &used) != 2 || used == 0)
+        return false;
+      sample->distances.push_back(distance);
+      sample->strengths.push_back(strength);
+      p += used;
+    }
+    return !sample->distances.empty() && sample->distances.size() <= RADAR_FRAME_MAX_DISTANCES;
+  }
+
+  void writeSample(FILE *out, const Options &opt, const Sample &sample, unsigned sequence)
+  {
+    if (opt.text)
+    {
+      fprintf(out, "%lld msg NEW_DATA ", (long long)sample.timeMs);
+      for (size_t i = 0; i < sample.distances.size(); i++)
+        fprintf(out, "%.3f,%.2f;", sample.distances[i], sample.strengths[i]);
+      fprintf(out, "\n");
+    }
+    else
+    {
+      fprintf(out, "%lld frame %u", (long long)sample.timeMs, sequence & 0xFF);
+      for (size_t i = 0; i < sample.distances.size(); i++)
+        fprintf(out, " %.3f %.2f", sample.distances[i], sample.strengths[i]);
+      fprintf(out, "\n");
+    }
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  Options opt;
+  if (!parseArgs(argc, argv, &opt))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::ifstream in(opt.input);
+  if (!in)
+  {
+    fprintf(stderr, "Can't open %s\n", opt.input);
+    return 1;
+  }
+
+  // Header lines end at "---"; the update rate sets the stop sequence timing
+  std::string line;
+  float updateRate = 0.0f;
+  bool inHeader = true;
+  int date[3] = {0, 0, 0};
+  int64_t firstMs = -1;
+  int64_t lastMs = 0;
+  size_t skipped = 0;
+  std::vector<Sample> samples;
+
+  while (std::getline(in, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    if (inHeader)
+    {
+      sscanf(line.c_str(), "Update rate: %f", &updateRate);
+      if (line == "---")
+        inHeader = false;
+      continue;
+    }
+
+    Sample sample;
+    int lineDate[3];
+    int64_t ms;
+    const char *rest;
+    if (!parseTimestamp(line.c_str(), lineDate, &ms, &rest) || !parseValues(rest, &sample))
+    {
+      skipped++;
+      continue;
+    }
+
+    if (firstMs < 0)
+    {
+      memcpy(date, lineDate, sizeof(date));
+      firstMs = ms;
+    }
+    else if (memcmp(date, lineDate, sizeof(date)) != 0)
+    {
+      ms += 86400000; // a recording may run past midnight, not past two
+    }
+    if (ms < lastMs)
+    {
+      skipped++;
+      continue;
+    }
+    lastMs = ms;
+
+    sample.timeMs = ms;
+    sample.timestamp.assign(line.c_str(), rest - line.c_str());
+    samples.push_back(sample);
+    if (opt.limit && samples.size() >= opt.limit)
+      break;
+  }
+
+  if (samples.empty())
+  {
+    fprintf(stderr, "No samples in %s\n", opt.input);
+    return 1;
+  }
+  if (updateRate <= 0.0f)
+    updateRate = 10.0f;
+
+  FILE *out = opt.output ? fopen(opt.output, "w") : stdout;
+  if (!out)
+  {
+    fprintf(stderr, "Can't create %s\n", opt.output);
+    return 1;
+  }
+
+  // The session starts 5 s before the first sample: config handshake, the
+  // STM32's 3 s calibration delay, then START_DATA. Times are relative to boot.
+  int64_t startMs = samples.front().timeMs - 5000;
+  int64_t bootSeconds = startMs / 1000;
+  for (Sample &sample : samples)
+    sample.timeMs -= bootSeconds * 1000;
+
+  uint8_t modeFlags = (opt.text ? 0 : RADAR_MODE_BINARY_FRAMES) | (opt.binaryLog ? RADAR_MODE_BINARY_LOG : 0);
+  fprintf(out, "# Generated by make_capture from %s\n", opt.input);
+  fprintf(out, "# %zu samples, %zu lines skipped\n", samples.size(), skipped);
+  fprintf(out, "rtc %04d-%02d-%02d %02lld:%02lld:%02lld\n", date[0], date[1], date[2],
+          (long long)(bootSeconds / 3600 % 24), (long long)(bootSeconds / 60 % 60), (long long)(bootSeconds % 60));
+  fprintf(out, "config update_rate %.1f\n", updateRate);
+  fprintf(out, "config mode_flags %02X\n\n", modeFlags);
+
+  int64_t t = startMs - bootSeconds * 1000;
+  fprintf(out, "%lld msg REQUEST_CONFIG\n", (long long)t);
+  fprintf(out, "+20 echo-config\n");
+  fprintf(out, "+5 msg CONFIG_GOOD\n");
+  fprintf(out, "+3000 msg START_DATA\n");
+
+  // Each measurement is followed by NOISE_ON while the STM32 sleeps and
+  // NOISE_OFF when it wakes up for the next one
+  unsigned sequence = 0;
+  for (size_t i = 0; i < samples.size(); i++)
+  {
+    writeSample(out, opt, samples[i], sequence++);
+    fprintf(out, "+1 msg NOISE_ON\n");
+    int64_t next = (i + 1 < samples.size()) ? samples[i + 1].timeMs : samples[i].timeMs + (int64_t)(1000.0f / updateRate);
+    if (next - 10 > samples[i].timeMs + 1)
+      fprintf(out, "%lld msg NOISE_OFF\n", (long long)(next - 10));
+  }
+
+  // ESP32 stop: TX is held low for 3 s / update rate + 1 s, the STM32 sees it
+  // after its current measurement and repeats STOP_REQUEST once a second
+  int64_t stopMs = samples.back().timeMs + 500;
+  int64_t lowMs = (int64_t)(3000.0f / updateRate) + 1000;
+  fprintf(out, "\n%lld stop\n", (long long)stopMs);
+  for (int64_t r = stopMs + 1000; r <= stopMs + lowMs + 2000; r += 1000)
+    fprintf(out, "%lld msg STOP_REQUEST\n", (long long)r);
+
+  fprintf(out, "\nexpect data_files 1\n");
+  fprintf(out, "expect data_records %zu\n", samples.size());
+  fprintf(out, "expect dropped_data_lines 0\n");
+  fprintf(out, "expect dropped_frames 0\n");
+  fprintf(out, "expect frame_errors 0\n");
+  fprintf(out, "expect rx_overflows 0\n");
+  fprintf(out, "expect stops 1\n");
+  fprintf(out, "expect active 0\n");
+  fprintf(out, "expect tx 4F 3A 78 00\n");
+  fprintf(out, "expect debug Configuration accepted by STM32\n");
+
+  // The replay must log the last sample with the same time and values
+  if (!opt.binaryLog)
+  {
+    const Sample &last = samples.back();
+    fprintf(out, "expect data %s %s", last.timestamp.c_str(), last.distances.empty() ? "no_dists" : "");
+    for (size_t i = 0; i < last.distances.size(); i++)
+      fprintf(out, "%.3f,%.2f;", last.distances[i], last.strengths[i]);
+    fprintf(out, "\n");
+  }
+
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
@@ -0,0 +1,540 @@
+// test/replay/radar_replay.cpp
+//
+// Replays an STM32 capture (see Capture.h) into the ESP32 firmware's
+// RadarManager, SDCardManager and TimeManager built for the host, then checks
+// the capture's "expect" lines against what ended up on the simulated SD card.
+// Also reports ingest throughput and per-step latency of the radar and SD
+// tasks, for comparing builds before flashing field units.
+
+#include "Capture.h"
+#include "Sim.h"
+#include "communication/RadarManager.h"
+#include "storage/SDCardManager.h"
+#include "storage/TimeManager.h"
+#include "storage/BinaryLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <math.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace
+{
+  constexpr uint8_t SD_CHIP_SELECT_PIN = 33;
+  constexpr uint8_t RADAR_RX_PIN = 16;
+  constexpr uint8_t RADAR_TX_PIN = 17;
+  constexpr uint64_t SD_TASK_PERIOD_US = 20000; // sdTask's vTaskDelay
+  constexpr uint64_t SETTLE_US = 6000000;       // run on past the last event so timeouts and
+                                                // sdTask's 5 s flush/drop report happen
+  constexpr uint64_t REPEAT_GAP_US = 5000000;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Options
+  {
+    const char *capture = nullptr;
+    std::string sdRoot = "replay_sd";
+    double speed = 0.0;
+    int repeat = 1;
+    bool verbose = false;
+    bool check = true;
+  };
+
+  struct StepTimes
+  {
+    std::vector<uint32_t> ns;
+
+    void add(Clock::time_point start)
+    {
+      ns.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+
+    uint32_t percentile(double p)
+    {
+      if (ns.empty())
+        return 0;
+      size_t k = (size_t)(p * (ns.size() - 1) + 0.5);
+      std::nth_element(ns.begin(), ns.begin() + k, ns.end());
+      return ns[k];
+    }
+  };
+
+  struct SdContents
+  {
+    size_t dataFiles = 0;
+    size_t dataRecords = 0; // text lines after the header, or BinaryLog records
+    size_t badBlocks = 0;
+    size_t streamFiles = 0;
+    size_t streamRecords = 0;
+    std::string dataText;   // all .txt data and .bin text records
+    std::string streamText; // secondary configuration stream files
+    std::string debugText;
+  };
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "Usage: %s [options] <capture.cap>\n"
+            "  --sd-root <dir>  simulated SD card directory (default: replay_sd); its DATA,\n"
+            "                   DEBUG_LOGS and radar_config.txt are cleared first\n"
+            "  --speed <x>      pace the replay at x times real time (default: 0, unpaced)\n"
+            "  --realtime       same as --speed 1\n"
+            "  --repeat <n>     replay the capture n times back to back, expect lines are\n"
+            "                   only checked for n = 1\n"
+            "  --no-check       ignore expect lines\n"
+            "  --verbose        print Serial output\n"
+            "\n"
+            "Expect lines (value is N, >=N or <=N unless noted):\n"
+            "  data_files, data_records, stream_files, stream_records (secondary configuration\n"
+            "  files), bad_blocks, dropped_frames, frame_errors,\n"
+            "  rx_overflows, rx_lost_bytes, dropped_data_lines, dropped_debug_lines,\n"
+            "  writer_errors, stops (successful ESP32 stop sequences), active (0/1),\n"
+            "  sample_period (period used for sleep scheduling, rounded to ms)\n"
+            "  data <text>      a data file contains text\n"
+            "  stream <text>    a stream file contains text\n"
+            "  debug <text>     a debug log contains text\n"
+            "  no_debug <text>  no debug log contains text\n"
+            "  tx <hex>         the ESP32 sent these bytes\n",
+            argv0);
+  }
+
+  bool parseArgs(int argc, char **argv, Options *opt)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (arg == "--sd-root" && i + 1 < argc)
+        opt->sdRoot = argv[++i];
+      else if (arg == "--speed" && i + 1 < argc)
+        opt->speed = atof(argv[++i]);
+      else if (arg == "--realtime")
+        opt->speed = 1.0;
+      else if (arg == "--repeat" && i + 1 < argc)
+        opt->repeat = atoi(argv[++i]);
+      else if (arg == "--no-check")
+        opt->check = false;
+      else if (arg == "--verbose")
+        opt->verbose = true;
+      else if (arg[0] == '-' || opt->capture)
+        return false;
+      else
+        opt->capture = argv[i];
+    }
+    return opt->capture != nullptr && opt->repeat > 0 && opt->speed >= 0.0;
+  }
+
+  std::vector<std::string> listFiles(const std::string &dir)
+  {
+    std::vector<std::string> files;
+    DIR *d = opendir(dir.c_str());
+    if (!d)
+      return files;
+    while (dirent *entry = readdir(d))
+    {
+      std::string path = dir + "/" + entry->d_name;
+      struct stat st;
+      if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        files.push_back(path);
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  // Only the firmware's own files are removed, never the directory itself
+  bool prepareSdRoot(const std::string &root)
+  {
+    ::mkdir(root.c_str(), 0755);
+    for (const char *dir : {"/DATA", "/DEBUG_LOGS"})
+    {
+      for (const std::string &file : listFiles(root + dir))
+        ::remove(file.c_str());
+    }
+    ::remove((root + "/radar_config.txt").c_str());
+
+    struct stat st;
+    return stat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  }
+
+  std::string readFile(const std::string &path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  }
+
+  void countBinaryRecords(const std::string &data, size_t start, SdContents *sd)
+  {
+    size_t pos = start;
+    while (pos + BINLOG_BLOCK_HEADER_SIZE <= data.size())
+    {
+      const uint8_t *bytes = (const uint8_t *)data.data();
+      BinaryLogBlockInfo info;
+      if (!BinaryLog::readBlockHeader(bytes + pos, data.size() - pos, &info) ||
+          info.payloadSize > data.size() - pos - BINLOG_BLOCK_HEADER_SIZE ||
+          RadarProtocol::crc16(bytes + pos + BINLOG_BLOCK_HEADER_SIZE, info.payloadSize) != info.payloadCrc)
+      {
+        sd->badBlocks++;
+        return;
+      }
+
+      const uint8_t *payload = bytes + pos + BINLOG_BLOCK_HEADER_SIZE;
+      size_t off = 0;
+      while (off < info.payloadSize)
+      {
+        BinaryLogRecord rec;
+        size_t used = BinaryLog::decodeRecord(payload + off, info.payloadSize - off, &rec);
+        if (used == 0)
+        {
+          sd->badBlocks++;
+          break;
+        }
+        if (rec.isText)
+          sd->dataText.append(rec.text, rec.textLength).push_back('\n');
+        sd->dataRecords++;
+        off += used;
+      }
+      pos += BINLOG_BLOCK_HEADER_SIZE + info.payloadSize;
+    }
+  }
+
+  SdContents readSdContents(const std::string &root)
+  {
+    SdContents sd;
+    for (const std::string &path : listFiles(root + "/DATA"))
+    {
+      std::string data = readFile(path);
+      size_t header = data.find("---\n");
+      if (header == std::string::npos)
+        continue;
+
+      size_t body = header + 4;
+      if (path.find("_data_c") != std::string::npos)
+      {
+        sd.streamFiles++;
+        sd.streamRecords += std::count(data.begin() + body, data.end(), '\n');
+        sd.streamText.append(data, body, std::string::npos);
+        continue;
+      }
+
+      sd.dataFiles++;
+      if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0)
+      {
+        countBinaryRecords(data, body, &sd);
+        continue;
+      }
+
+      sd.dataRecords += std::count(data.begin() + body, data.end(), '\n');
+      sd.dataText.append(data, body, std::string::npos);
+    }
+
+    for (const std::string &path : listFiles(root + "/DEBUG_LOGS"))
+      sd.debugText += readFile(path);
+
+    return sd;
+  }
+
+  bool applyConfig(const Capture &capture, ConfigSettings *config, std::string *error)
+  {
+    for (const auto &item : capture.config)
+    {
+      const std::string &field = item.first;
+      const char *value = item.second.c_str();
+
+      if (field == "start_m")
+        config->start_m = atof(value);
+      else if (field == "end_m")
+        config->end_m = atof(value);
+      else if (field == "update_rate")
+        config->update_rate = atof(value);
+      else if (field == "max_step_length")
+        config->max_step_length = (uint8_t)atoi(value);
+      else if (field == "max_profile")
+        config->max_profile = (uint8_t)atoi(value);
+      else if (field == "signal_quality")
+        config->signal_quality = atof(value);
+      else if (field == "reflector_shape")
+        config->reflector_shape = (uint8_t)atoi(value);
+      else if (field == "threshold_sensitivity")
+        config->threshold_sensitivity = atof(value);
+      else if (field == "testing_update_rate")
+        config->testing_update_rate = (uint8_t)atoi(value);
+      else if (field == "true_update_rate")
+        config->true_update_rate = atof(value);
+      else if (field == "mode_flags")
+        config->mode_flags = (uint8_t)strtoul(value, nullptr, 16);
+      else if (field == "filter_window")
+        config->filter_window = (uint8_t)atoi(value);
+      else if (field == "aggregate_s")
+        config->aggregate_s = (uint16_t)atoi(value);
+      else if (field == "secondary_start_m")
+        config->secondary_start_m = atof(value);
+      else if (field == "secondary_end_m")
+        config->secondary_end_m = atof(value);
+      else if (field == "secondary_max_step_length")
+        config->secondary_max_step_length = (uint8_t)atoi(value);
+      else if (field == "secondary_max_profile")
+        config->secondary_max_profile = (uint8_t)atoi(value);
+      else if (field == "secondary_interval")
+        config->secondary_interval = (uint16_t)atoi(value);
+      else
+      {
+        *error = "unknown config field \"" + field + "\"";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool compareCount(const std::string &expected, uint64_t actual)
+  {
+    if (expected.compare(0, 2, ">=") == 0)
+      return actual >= strtoull(expected.c_str() + 2, nullptr, 10);
+    if (expected.compare(0, 2, "<=") == 0)
+      return actual <= strtoull(expected.c_str() + 2, nullptr, 10);
+    return actual == strtoull(expected.c_str(), nullptr, 10);
+  }
+
+  bool containsHex(const std::vector<uint8_t> &haystack, const std::string &hex)
+  {
+    std::string digits;
+    for (char c : hex)
+    {
+      if (isxdigit((unsigned char)c))
+        digits.push_back(c);
+    }
+    std::vector<uint8_t> needle;
+    for (size_t i = 0; i + 1 < digits.size(); i += 2)
+      needle.push_back((uint8_t)strtoul(digits.substr(i, 2).c_str(), nullptr, 16));
+
+    return !needle.empty() &&
+           std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end()) != haystack.end();
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  Options opt;
+  if (!parseArgs(argc, argv, &opt))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  Capture capture;
+  std::string error;
+  if (!CaptureFile::load(opt.capture, &capture, &error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 2;
+  }
+
+  if (!prepareSdRoot(opt.sdRoot))
+  {
+    fprintf(stderr, "Can't use %s as the SD card\n", opt.sdRoot.c_str());
+    return 2;
+  }
+
+  Sim::reset();
+  Sim::setSdRoot(opt.sdRoot);
+  Sim::setVerbose(opt.verbose);
+
+  // Boot like setup() in main.cpp
+  static RTC_PCF8523 rtc;
+  rtc.adjust(DateTime(capture.rtcUnixtime));
+
+  TimeManager &timeManager = TimeManager::getInstance();
+  SDCardManager &sd = SDCardManager::getInstance();
+  RadarManager &radar = RadarManager::getInstance();
+
+  if (!timeManager.initialize(rtc) || !sd.initialize(SD_CHIP_SELECT_PIN, rtc))
+  {
+    fprintf(stderr, "Manager initialization failed\n");
+    return 1;
+  }
+
+  ConfigSettings config = sd.getConfig();
+  if (!applyConfig(capture, &config, &error))
+  {
+    fprintf(stderr, "%s: %s\n", opt.capture, error.c_str());
+    return 2;
+  }
+  sd.updateConfig(config);
+
+  if (!radar.initialize(RADAR_RX_PIN, RADAR_TX_PIN))
+  {
+    fprintf(stderr, "Radar initialization failed\n");
+    return 1;
+  }
+
+  // Schedule the capture, relative to the end of boot
+  uint64_t bootUs = Sim::nowUs();
+  uint64_t captureSpanUs = capture.events.empty() ? 0 : capture.events.back().timeUs;
+  std::vector<uint64_t> stops;
+  for (int r = 0; r < opt.repeat; r++)
+  {
+    uint64_t offset = bootUs + r * (captureSpanUs + REPEAT_GAP_US);
+    for (const CaptureEvent &event : capture.events)
+    {
+      if (event.type == CaptureEvent::RX)
+        Sim::scheduleRx(offset + event.timeUs, event.bytes);
+      else if (event.type == CaptureEvent::CONFIG_ECHO)
+        Sim::scheduleConfigEcho(offset + event.timeUs);
+      else
+        stops.push_back(offset + event.timeUs);
+    }
+  }
+  uint64_t endUs = bootUs + (opt.repeat - 1) * (captureSpanUs + REPEAT_GAP_US) + captureSpanUs + SETTLE_US;
+
+  // Run radarTask and sdTask in turns, sdTask every SD_TASK_PERIOD_US
+  StepTimes radarSteps, sdSteps;
+  size_t nextStop = 0;
+  uint32_t stopsOk = 0;
+  uint64_t nextSdUs = Sim::nowUs();
+  Sim::setSpeed(opt.speed);
+  Clock::time_point wallStart = Clock::now();
+
+  while (Sim::nowUs() < endUs || Sim::nextRxUs() != Sim::NEVER || nextStop < stops.size())
+  {
+    if (nextStop < stops.size() && stops[nextStop] <= Sim::nowUs())
+    {
+      nextStop++;
+      if (radar.stopDataCollection())
+        stopsOk++;
+      continue;
+    }
+
+    if (Sim::nowUs() >= nextSdUs)
+    {
+      Clock::time_point start = Clock::now();
+      sd.sdTaskStep();
+      sdSteps.add(start);
+      nextSdUs = Sim::nowUs() + SD_TASK_PERIOD_US;
+    }
+
+    uint64_t wakeUs = nextSdUs;
+    if (nextStop < stops.size() && stops[nextStop] < wakeUs)
+      wakeUs = stops[nextStop];
+    TickType_t ticks = (TickType_t)((wakeUs - Sim::nowUs() + 999) / 1000);
+
+    Clock::time_point start = Clock::now();
+    if (radar.serviceUart(ticks > 0 ? ticks : 1))
+      radarSteps.add(start);
+  }
+
+  // Let sdTask write everything out, as on a stop request
+  sd.sdTaskStep();
+  sd.flushDataBuffer();
+  sd.flushDebugBuffer();
+  sd.requestSync();
+  sd.sdTaskStep();
+
+  double wallS = std::chrono::duration<double>(Clock::now() - wallStart).count();
+  double simS = (Sim::nowUs() - bootUs) / 1e6;
+  const Sim::UartStats &uart = Sim::uartStats();
+  const SDFileWriter::Stats &dataWriter = sd.getDataWriterStats();
+  const SDFileWriter::Stats &debugWriter = sd.getDebugWriterStats();
+  SdContents contents = readSdContents(opt.sdRoot);
+
+  printf("%s: %.1f s simulated in %.3f s (%.0fx)\n", opt.capture, simS, wallS, wallS > 0 ? simS / wallS : 0.0);
+  printf("  uart:   %llu bytes in %llu chunks, %llu lost, %llu events lost, %llu bytes sent\n",
+         (unsigned long long)uart.bytesReceived, (unsigned long long)uart.chunks,
+         (unsigned long long)uart.bytesLost, (unsigned long long)uart.eventsLost,
+         (unsigned long long)uart.bytesSent);
+  printf("  radar:  %lu dropped frames, %lu frame errors, %lu rx overflows\n",
+         (unsigned long)radar.getDroppedFrames(), (unsigned long)radar.getFrameErrors(),
+         (unsigned long)radar.getRxOverflows());
+  printf("  sd:     %zu data files, %zu records, %lu dropped data lines, %lu dropped debug lines\n",
+         contents.dataFiles, contents.dataRecords, (unsigned long)sd.getDroppedDataLines(),
+         (unsigned long)sd.getDroppedDebugLines());
+  printf("  writer: data %lu bytes/%lu writes/%lu syncs, debug %lu bytes/%lu writes/%lu syncs\n",
+         (unsigned long)dataWriter.bytesWritten, (unsigned long)dataWriter.writeCalls,
+         (unsigned long)dataWriter.syncs, (unsigned long)debugWriter.bytesWritten,
+         (unsigned long)debugWriter.writeCalls, (unsigned long)debugWriter.syncs);
+  if (wallS > 0)
+  {
+    printf("  ingest: %.0f bytes/s, %.0f records/s%s\n", uart.bytesReceived / wallS,
+           contents.dataRecords / wallS, opt.speed > 0 ? " (paced)" : "");
+  }
+  printf("  radar step: %zu events, p50 %.1f us, p99 %.1f us, max %.1f us\n", radarSteps.ns.size(),
+         radarSteps.percentile(0.50) / 1000.0, radarSteps.percentile(0.99) / 1000.0,
+         radarSteps.percentile(1.0) / 1000.0);
+  printf("  sd step:    %zu runs, p50 %.1f us, p99 %.1f us, max %.1f us\n", sdSteps.ns.size(),
+         sdSteps.percentile(0.50) / 1000.0, sdSteps.percentile(0.99) / 1000.0,
+         sdSteps.percentile(1.0) / 1000.0);
+
+  if (!opt.check || opt.repeat != 1)
+    return 0;
+
+  int failures = 0;
+  for (const CaptureExpect &expect : capture.expects)
+  {
+    bool ok;
+    std::string actual;
+    auto count = [&](uint64_t value)
+    {
+      actual = std::to_string(value);
+      return compareCount(expect.value, value);
+    };
+
+    if (expect.name == "data_files")
+      ok = count(contents.dataFiles);
+    else if (expect.name == "data_records")
+      ok = count(contents.dataRecords);
+    else if (expect.name == "stream_files")
+      ok = count(contents.streamFiles);
+    else if (expect.name == "stream_records")
+      ok = count(contents.streamRecords);
+    else if (expect.name == "bad_blocks")
+      ok = count(contents.badBlocks);
+    else if (expect.name == "dropped_frames")
+      ok = count(radar.getDroppedFrames());
+    else if (expect.name == "frame_errors")
+      ok = count(radar.getFrameErrors());
+    else if (expect.name == "rx_overflows")
+      ok = count(radar.getRxOverflows());
+    else if (expect.name == "rx_lost_bytes")
+      ok = count(uart.bytesLost);
+    else if (expect.name == "dropped_data_lines")
+      ok = count(sd.getDroppedDataLines());
+    else if (expect.name == "dropped_debug_lines")
+      ok = count(sd.getDroppedDebugLines());
+    else if (expect.name == "writer_errors")
+      ok = count(dataWriter.errors + debugWriter.errors + sd.getStreamWriterStats().errors);
+    else if (expect.name == "stops")
+      ok = count(stopsOk);
+    else if (expect.name == "active")
+      ok = count(radar.isActive() ? 1 : 0);
+    else if (expect.name == "sample_period")
+      ok = count((uint64_t)lroundf(radar.getSamplePeriod()));
+    else if (expect.name == "data")
+      ok = contents.dataText.find(expect.value) != std::string::npos;
+    else if (expect.name == "stream")
+      ok = contents.streamText.find(expect.value) != std::string::npos;
+    else if (expect.name == "debug")
+      ok = contents.debugText.find(expect.value) != std::string::npos;
+    else if (expect.name == "no_debug")
+      ok = contents.debugText.find(expect.value) == std::string::npos;
+    else if (expect.name == "tx")
+      ok = containsHex(Sim::txBytes(), expect.value);
+    else
+    {
+      fprintf(stderr, "%s:%d: unknown expect \"%s\"\n", opt.capture, expect.line, expect.name.c_str());
+      failures++;
+      continue;
+    }
+
+    if (!ok)
+    {
+      failures++;
+      fprintf(stderr, "%s:%d: FAILED expect %s %s%s%s\n", opt.capture, expect.line, expect.name.c_str(),
+              expect.value.c_str(), actual.empty() ? "" : ", got ", actual.c_str());
+    }
+  }
+
+  printf("  %zu expectations, %d failed\n", capture.expects.size(), failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+// test/replay/stubs/Arduino.h
+#pragma once
+
+// Host stand-in for the parts of the Arduino-ESP32 core the managers use.
+// Time comes from the replay simulator's clock (see Sim.h), so millis() only
+// moves when the simulation advances.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_sleep.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LED_BUILTIN 13
+#define IRAM_ATTR
+#define F(x) (x)
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+// Text sink for Serial and BluetoothSerial, discarded unless the harness is verbose
+class Print
+{
+public:
+  virtual ~Print() = default;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t println(const char *s = "") { return print(s) + print("\n"); }
+  size_t printf(const char *format, ...)
+  {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return len > 0 ? print(buffer) : 0;
+  }
+  void begin(unsigned long) {}
+  void flush() {}
+};
+
+extern Print Serial;
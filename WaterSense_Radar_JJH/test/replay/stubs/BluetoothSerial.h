@@ -0,0 +1,17 @@
+// test/replay/stubs/BluetoothSerial.h
+#pragma once
+
+// Host stand-in for the ESP32 Bluetooth serial port. Never connected.
+
+#include <Arduino.h>
+
+class BluetoothSerial : public Print
+{
+public:
+  bool begin(const char *) { return true; }
+  bool hasClient() { return false; }
+  int available() { return 0; }
+  int read() { return -1; }
+  size_t readBytesUntil(char, char *, size_t) { return 0; }
+  void end() {}
+};
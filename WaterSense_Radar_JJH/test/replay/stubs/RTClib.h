@@ -0,0 +1,56 @@
+// test/replay/stubs/RTClib.h
+#pragma once
+
+// Host stand-in for Adafruit RTClib. RTC_PCF8523 counts whole seconds from
+// the time it was adjusted to, driven by the simulator clock.
+
+#include <Arduino.h>
+
+class TimeSpan
+{
+public:
+  TimeSpan(int32_t seconds = 0) : m_seconds(seconds) {}
+  int32_t totalseconds() const { return m_seconds; }
+
+private:
+  int32_t m_seconds;
+};
+
+class DateTime
+{
+public:
+  DateTime(uint32_t unixtime);
+  DateTime(const char *date, const char *time);
+  DateTime(uint16_t year = 2000, uint8_t month = 1, uint8_t day = 1,
+           uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0)
+      : m_year(year), m_month(month), m_day(day), m_hour(hour), m_minute(minute), m_second(second) {}
+
+  uint16_t year() const { return m_year; }
+  uint8_t month() const { return m_month; }
+  uint8_t day() const { return m_day; }
+  uint8_t hour() const { return m_hour; }
+  uint8_t minute() const { return m_minute; }
+  uint8_t second() const { return m_second; }
+  uint32_t unixtime() const;
+
+  DateTime operator+(const TimeSpan &span) const { return DateTime(unixtime() + span.totalseconds()); }
+
+private:
+  uint16_t m_year;
+  uint8_t m_month, m_day, m_hour, m_minute, m_second;
+};
+
+class RTC_PCF8523
+{
+public:
+  bool begin() { return true; }
+  bool initialized() { return true; }
+  bool lostPower() { return false; }
+  void start() {}
+  void adjust(const DateTime &dt);
+  DateTime now();
+
+private:
+  uint32_t m_setUnixtime = 946684800; // 2000-01-01
+  uint64_t m_setUs = 0;               // simulator time when adjusted
+};
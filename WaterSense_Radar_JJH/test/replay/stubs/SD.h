@@ -0,0 +1,57 @@
+// test/replay/stubs/SD.h
+#pragma once
+
+// Host stand-in for the ESP32 SD library. Paths are mapped into a directory
+// on the host (Sim::setSdRoot), files are plain stdio streams.
+
+#include <Arduino.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum
+{
+  CARD_NONE,
+  CARD_MMC,
+  CARD_SD,
+  CARD_SDHC
+};
+
+class File
+{
+public:
+  File(FILE *f = nullptr) : m_f(f) {}
+
+  operator bool() const { return m_f != nullptr; }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t println(const char *s = "") { return print(s) + print("\n"); }
+  size_t write(const uint8_t *buffer, size_t size);
+  size_t read(uint8_t *buffer, size_t size) { return m_f ? fread(buffer, 1, size, m_f) : 0; }
+  int available();
+  size_t readBytesUntil(char terminator, char *buffer, size_t length);
+  void flush() { if (m_f) fflush(m_f); }
+  size_t size();
+  void close()
+  {
+    if (m_f)
+      fclose(m_f);
+    m_f = nullptr;
+  }
+
+private:
+  FILE *m_f;
+};
+
+class SDFS
+{
+public:
+  bool begin(uint8_t chipSelectPin);
+  bool exists(const char *path);
+  bool mkdir(const char *path);
+  bool remove(const char *path);
+  File open(const char *path, const char *mode = FILE_READ);
+  uint8_t cardType() { return CARD_SDHC; }
+};
+
+extern SDFS SD;
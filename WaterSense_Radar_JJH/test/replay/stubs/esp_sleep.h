@@ -0,0 +1,10 @@
+// test/replay/stubs/esp_sleep.h
+#pragma once
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_uart_wakeup(int uart_num);
+esp_err_t esp_light_sleep_start();
@@ -0,0 +1,7 @@
+// test/replay/stubs/esp_timer.h
+#pragma once
+
+#include <stdint.h>
+
+// Microseconds since boot, from the simulator clock
+int64_t esp_timer_get_time();
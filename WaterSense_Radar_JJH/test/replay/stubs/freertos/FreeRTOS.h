@@ -0,0 +1,16 @@
+// test/replay/stubs/freertos/FreeRTOS.h
+#pragma once
+
+#include <stdint.h>
+
+// One tick per millisecond, like the ESP32 Arduino core's CONFIG_FREERTOS_HZ=1000
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *QueueHandle_t;
+typedef void *TaskHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
@@ -0,0 +1,12 @@
+// test/replay/stubs/freertos/queue.h
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// Fixed-size item queues. The UART driver's event queue is the simulator's;
+// other queues (Bluetooth) are plain FIFOs that never block.
+QueueHandle_t xQueueCreate(uint32_t length, uint32_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueueReset(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
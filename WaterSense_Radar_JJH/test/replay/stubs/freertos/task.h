@@ -0,0 +1,7 @@
+// test/replay/stubs/freertos/task.h
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// Advances the simulator clock; the harness is single threaded
+void vTaskDelay(TickType_t ticks);
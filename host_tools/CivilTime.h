@@ -0,0 +1,58 @@
+// host_tools/CivilTime.h
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Logger timestamps are the RTC's wall clock. The host tools convert them to
+// milliseconds since 1970-01-01 as if the RTC was set to UTC, without going
+// through timegm() and the local time zone.
+namespace CivilTime
+{
+  /**
+   * @brief Days since 1970-01-01 for a proleptic Gregorian date
+   *
+   * Howard Hinnant's days_from_civil.
+   */
+  inline int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+  {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+  }
+
+  inline int64_t epochMs(int64_t y, unsigned mo, unsigned d, unsigned h, unsigned mi, unsigned s, unsigned ms)
+  {
+    int64_t seconds = daysFromCivil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s;
+    return seconds * 1000 + ms;
+  }
+
+  /**
+   * @brief Formats epoch milliseconds as "YYYY-MM-DD HH:MM:SS.mmm"
+   */
+  inline void formatIso(int64_t epochMs, char *out, size_t size)
+  {
+    int64_t ms = epochMs % 1000;
+    int64_t secs = epochMs / 1000;
+    int64_t days = secs / 86400;
+    int64_t rem = secs % 86400;
+
+    // civil_from_days
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = (unsigned)(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t y = (int64_t)yoe + era * 400 + (m <= 2);
+
+    snprintf(out, size, "%04lld-%02u-%02u %02lld:%02lld:%02lld.%03lld",
+             (long long)y, m, d, (long long)(rem / 3600), (long long)(rem / 60 % 60),
+             (long long)(rem % 60), (long long)ms);
+  }
+}
@@ -0,0 +1,42 @@
+// host_tools/Npy.h
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace Npy
+{
+  /**
+   * @brief Writes a row-major float64 [rows, columns] array as a NumPy .npy file
+   * @return false if the file can't be written
+   */
+  inline bool write(const char *path, const std::vector<double> &values, int columns)
+  {
+    FILE *f = fopen(path, "wb");
+    if (!f)
+      return false;
+
+    char dict[128];
+    int len = snprintf(dict, sizeof(dict),
+                       "{'descr': '<f8', 'fortran_order': False, 'shape': (%zu, %d), }",
+                       values.size() / columns, columns);
+
+    // magic + version + header length + dict, padded with spaces to a multiple of 64
+    std::string header(dict, len);
+    size_t total = 10 + header.size() + 1;
+    header.append((64 - total % 64) % 64, ' ');
+    header.push_back('\n');
+
+    const unsigned char preamble[8] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0};
+    uint16_t headerLen = (uint16_t)header.size();
+    unsigned char lenBytes[2] = {(unsigned char)(headerLen & 0xFF), (unsigned char)(headerLen >> 8)};
+
+    bool ok = fwrite(preamble, 1, sizeof(preamble), f) == sizeof(preamble) &&
+              fwrite(lenBytes, 1, 2, f) == 2 &&
+              fwrite(header.data(), 1, header.size(), f) == header.size() &&
+              fwrite(values.data(), sizeof(double), values.size(), f) == values.size();
+    return fclose(f) == 0 && ok;
+  }
+}
@@ -0,0 +1,183 @@
+// host_tools/OrderStatistics.h
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+/**
+ * @brief Multiset of doubles with O(log n) insert, erase and k-th smallest
+ *
+ * A treap with subtree sizes in a node pool, for rolling medians and
+ * quantiles over a sliding window: every step is one insert and one erase
+ * instead of re-sorting the window. Elements are keyed by (value, id) so
+ * equal values can be erased individually; the caller picks unique ids
+ * (e.g. sample indices).
+ */
+class OrderStatisticTree
+{
+public:
+  OrderStatisticTree() { m_nodes.push_back(Node()); } // node 0 is the null leaf
+
+  size_t size() const { return m_nodes[m_root].size; }
+
+  void insert(double value, uint32_t id)
+  {
+    uint32_t node = allocate(value, id);
+    uint32_t left, right;
+    split(m_root, value, id, &left, &right);
+    m_root = merge(merge(left, node), right);
+  }
+
+  // Returns false if (value, id) isn't in the tree
+  bool erase(double value, uint32_t id)
+  {
+    uint32_t *link = &m_root;
+    while (*link)
+    {
+      Node &n = m_nodes[*link];
+      if (n.value == value && n.id == id)
+      {
+        uint32_t removed = *link;
+        *link = merge(n.left, n.right);
+        m_nodes[removed].left = m_free;
+        m_free = removed;
+        // Fix the sizes on the path from the root
+        for (uint32_t p = m_root; p && p != *link;)
+        {
+          Node &q = m_nodes[p];
+          q.size--;
+          p = less(value, id, q) ? q.left : q.right;
+        }
+        return true;
+      }
+      link = less(value, id, n) ? &n.left : &n.right;
+    }
+    return false;
+  }
+
+  // k-th smallest value, 0-based, k < size()
+  double kth(size_t k) const
+  {
+    uint32_t node = m_root;
+    while (true)
+    {
+      const Node &n = m_nodes[node];
+      size_t leftSize = m_nodes[n.left].size;
+      if (k < leftSize)
+        node = n.left;
+      else if (k == leftSize)
+        return n.value;
+      else
+      {
+        k -= leftSize + 1;
+        node = n.right;
+      }
+    }
+  }
+
+  // Quantile q in [0, 1] with linear interpolation between order statistics,
+  // the same as numpy.percentile(values, 100 * q)
+  double quantile(double q) const
+  {
+    double pos = q * (size() - 1);
+    size_t lo = (size_t)floor(pos);
+    double a = kth(lo);
+    double frac = pos - lo;
+    if (frac == 0.0)
+      return a;
+    double b = kth(lo + 1);
+    return a + (b - a) * frac;
+  }
+
+private:
+  struct Node
+  {
+    double value = 0.0;
+    uint32_t id = 0;
+    uint32_t priority = 0;
+    uint32_t left = 0;
+    uint32_t right = 0;
+    uint32_t size = 0;
+  };
+
+  static bool less(double value, uint32_t id, const Node &n)
+  {
+    return value < n.value || (value == n.value && id < n.id);
+  }
+
+  uint32_t allocate(double value, uint32_t id)
+  {
+    // xorshift32 priorities keep the treap balanced in expectation
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+
+    uint32_t index;
+    if (m_free)
+    {
+      index = m_free;
+      m_free = m_nodes[index].left;
+    }
+    else
+    {
+      index = (uint32_t)m_nodes.size();
+      m_nodes.push_back(Node());
+    }
+    Node &n = m_nodes[index];
+    n.value = value;
+    n.id = id;
+    n.priority = m_seed;
+    n.left = n.right = 0;
+    n.size = 1;
+    return index;
+  }
+
+  void update(uint32_t node)
+  {
+    Node &n = m_nodes[node];
+    n.size = 1 + m_nodes[n.left].size + m_nodes[n.right].size;
+  }
+
+  // Splits into keys < (value, id) and keys >= (value, id)
+  void split(uint32_t node, double value, uint32_t id, uint32_t *left, uint32_t *right)
+  {
+    if (!node)
+    {
+      *left = *right = 0;
+      return;
+    }
+    Node &n = m_nodes[node];
+    if (less(value, id, n) || (n.value == value && n.id == id))
+    {
+      split(n.left, value, id, left, &m_nodes[node].left);
+      *right = node;
+    }
+    else
+    {
+      split(n.right, value, id, &m_nodes[node].right, right);
+      *left = node;
+    }
+    update(node);
+  }
+
+  uint32_t merge(uint32_t a, uint32_t b)
+  {
+    if (!a || !b)
+      return a ? a : b;
+    if (m_nodes[a].priority > m_nodes[b].priority)
+    {
+      m_nodes[a].right = merge(m_nodes[a].right, b);
+      update(a);
+      return a;
+    }
+    m_nodes[b].left = merge(a, m_nodes[b].left);
+    update(b);
+    return b;
+  }
+
+  std::vector<Node> m_nodes;
+  uint32_t m_root = 0;
+  uint32_t m_free = 0;
+  uint32_t m_seed = 2463534242u;
+};
@@ -0,0 +1,306 @@
+// host_tools/Spectrum.cpp
+#include "Spectrum.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+  constexpr int EXTIRPOLATION_ORDER = 4; // MACC in Numerical Recipes' fasper()
+
+  size_t nextPowerOfTwo(size_t n)
+  {
+    size_t p = 1;
+    while (p < n)
+      p <<= 1;
+    return p;
+  }
+
+  void meanAndVariance(const std::vector<double> &y, double *mean, double *variance)
+  {
+    double sum = 0.0;
+    for (double v : y)
+      sum += v;
+    *mean = sum / y.size();
+
+    double sq = 0.0;
+    for (double v : y)
+      sq += (v - *mean) * (v - *mean);
+    *variance = y.size() > 1 ? sq / (y.size() - 1) : 0.0;
+  }
+
+  /**
+   * @brief Adds value to grid at fractional position x, spread over the
+   * EXTIRPOLATION_ORDER nearest points with Lagrange weights
+   *
+   * Numerical Recipes' spread(), 0-based.
+   */
+  void spread(double value, double *grid, long n, double x)
+  {
+    const long m = EXTIRPOLATION_ORDER;
+    static const long FACTORIAL[] = {1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880};
+
+    long ix = (long)x;
+    if (x == (double)ix)
+    {
+      grid[ix] += value;
+      return;
+    }
+
+    long ilo = std::min(std::max((long)(x - 0.5 * m + 2.0) - 1, 0L), n - m);
+    long ihi = ilo + m - 1;
+    long nden = FACTORIAL[m - 1];
+    double fac = x - ilo;
+    for (long j = ilo + 1; j <= ihi; j++)
+      fac *= x - j;
+    grid[ihi] += value * fac / (nden * (x - ihi));
+    for (long j = ihi - 1; j >= ilo; j--)
+    {
+      nden = (nden / (j + 1 - ilo)) * (j - ihi);
+      grid[j] += value * fac / (nden * (x - j));
+    }
+  }
+
+  SpectrumPoint makePoint(double frequency, double cterm, double sterm, size_t n)
+  {
+    SpectrumPoint p;
+    p.frequency_hz = frequency;
+    p.power = 0.5 * (cterm + sterm);
+    p.amplitude_m = sqrt(4.0 * p.power / n);
+    return p;
+  }
+}
+
+
+namespace Spectrum
+{
+  void fft(std::vector<std::complex<double>> *data, bool inverse)
+  {
+    std::vector<std::complex<double>> &a = *data;
+    size_t n = a.size();
+
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+      size_t bit = n >> 1;
+      for (; j & bit; bit >>= 1)
+        j ^= bit;
+      j ^= bit;
+      if (i < j)
+        std::swap(a[i], a[j]);
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+      double angle = 2.0 * M_PI / len * (inverse ? 1.0 : -1.0);
+      // Twiddles for this stage computed once, not per butterfly group
+      std::vector<std::complex<double>> twiddle(len / 2);
+      for (size_t k = 0; k < len / 2; k++)
+        twiddle[k] = std::polar(1.0, angle * k);
+
+      for (size_t i = 0; i < n; i += len)
+      {
+        for (size_t k = 0; k < len / 2; k++)
+        {
+          std::complex<double> u = a[i + k];
+          std::complex<double> v = a[i + k + len / 2] * twiddle[k];
+          a[i + k] = u + v;
+          a[i + k + len / 2] = u - v;
+        }
+      }
+    }
+  }
+
+  std::vector<SpectrumPoint> lombScargleFast(const std::vector<double> &t, const std::vector<double> &y,
+                                             double oversample, double maxFrequency)
+  {
+    std::vector<SpectrumPoint> out;
+    size_t n = t.size();
+    if (n < 2 || t.back() <= t.front())
+      return out;
+
+    double mean, variance;
+    meanAndVariance(y, &mean, &variance);
+
+    double span = t.back() - t.front();
+    double df = 1.0 / (span * oversample);
+    size_t nout = (size_t)(maxFrequency / df);
+    if (nout == 0)
+      return out;
+
+    // Grid with room for the 2f sums, oversampled by the extirpolation order
+    size_t ndim = 2 * nextPowerOfTwo(std::max<size_t>(64, 2 * nout * EXTIRPOLATION_ORDER));
+    std::vector<double> wk1(ndim, 0.0), wk2(ndim, 0.0);
+    double fac = ndim / (span * oversample);
+    for (size_t j = 0; j < n; j++)
+    {
+      double ck = fmod((t[j] - t.front()) * fac, (double)ndim);
+      double ckk = fmod(2.0 * ck, (double)ndim);
+      spread(y[j] - mean, wk1.data(), (long)ndim, ck);
+      spread(1.0, wk2.data(), (long)ndim, ckk);
+    }
+
+    // Both real grids in one complex FFT, separated by conjugate symmetry
+    std::vector<std::complex<double>> z(ndim);
+    for (size_t j = 0; j < ndim; j++)
+      z[j] = std::complex<double>(wk1[j], wk2[j]);
+    fft(&z);
+
+    out.reserve(nout);
+    for (size_t j = 1; j <= nout && j < ndim / 2; j++)
+    {
+      std::complex<double> zk = z[j];
+      std::complex<double> zc = std::conj(z[ndim - j]);
+      std::complex<double> w1 = 0.5 * (zk + zc);
+      std::complex<double> w2 = std::complex<double>(0.0, -0.5) * (zk - zc);
+
+      double hypo = std::abs(w2);
+      double hc2wt = hypo > 0.0 ? 0.5 * w2.real() / hypo : 0.5;
+      double hs2wt = hypo > 0.0 ? 0.5 * w2.imag() / hypo : 0.0;
+      double cwt = sqrt(0.5 + hc2wt);
+      double swt = copysign(sqrt(std::max(0.0, 0.5 - hc2wt)), hs2wt);
+      double den = 0.5 * n + hc2wt * w2.real() + hs2wt * w2.imag();
+      double cnum = cwt * w1.real() + swt * w1.imag();
+      double snum = cwt * w1.imag() - swt * w1.real();
+      double cterm = den > 0.0 ? cnum * cnum / den : 0.0;
+      double sterm = n - den > 0.0 ? snum * snum / (n - den) : 0.0;
+      out.push_back(makePoint(j * df, cterm, sterm, n));
+    }
+    return out;
+  }
+
+  std::vector<SpectrumPoint> lombScargleDirect(const std::vector<double> &t, const std::vector<double> &y,
+                                               const std::vector<double> &frequencies)
+  {
+    std::vector<SpectrumPoint> out;
+    size_t n = t.size();
+    if (n < 2)
+      return out;
+
+    double mean, variance;
+    meanAndVariance(y, &mean, &variance);
+
+    out.reserve(frequencies.size());
+    for (double f : frequencies)
+    {
+      double w = 2.0 * M_PI * f;
+      double s2 = 0.0, c2 = 0.0;
+      for (size_t j = 0; j < n; j++)
+      {
+        double a = 2.0 * w * (t[j] - t.front());
+        s2 += sin(a);
+        c2 += cos(a);
+      }
+      double tau = atan2(s2, c2) / (2.0 * w);
+
+      double yc = 0.0, ys = 0.0, cc = 0.0, ss = 0.0;
+      for (size_t j = 0; j < n; j++)
+      {
+        double a = w * (t[j] - t.front() - tau);
+        double c = cos(a), s = sin(a);
+        double v = y[j] - mean;
+        yc += v * c;
+        ys += v * s;
+        cc += c * c;
+        ss += s * s;
+      }
+      out.push_back(makePoint(f, cc > 0.0 ? yc * yc / cc : 0.0, ss > 0.0 ? ys * ys / ss : 0.0, n));
+    }
+    return out;
+  }
+
+  std::vector<SpectrumPoint> welch(const std::vector<double> &t, const std::vector<double> &y,
+                                   double segmentSeconds)
+  {
+    std::vector<SpectrumPoint> out;
+    size_t n = t.size();
+    if (n < 4)
+      return out;
+
+    // Median sample interval sets the uniform grid
+    std::vector<double> dts(n - 1);
+    for (size_t i = 1; i < n; i++)
+      dts[i - 1] = t[i] - t[i - 1];
+    std::nth_element(dts.begin(), dts.begin() + dts.size() / 2, dts.end());
+    double dt = dts[dts.size() / 2];
+    if (dt <= 0.0)
+      return out;
+
+    double mean, variance;
+    meanAndVariance(y, &mean, &variance);
+
+    size_t total = (size_t)((t.back() - t.front()) / dt) + 1;
+    std::vector<double> grid(total);
+    size_t src = 0;
+    for (size_t i = 0; i < total; i++)
+    {
+      double ti = t.front() + i * dt;
+      while (src + 2 < n && t[src + 1] <= ti)
+        src++;
+      double span = t[src + 1] - t[src];
+      double frac = span > 0.0 ? (ti - t[src]) / span : 0.0;
+      frac = std::min(std::max(frac, 0.0), 1.0);
+      grid[i] = y[src] + (y[src + 1] - y[src]) * frac - mean;
+    }
+
+    size_t segment = segmentSeconds > 0.0 ? (size_t)(segmentSeconds / dt) : total;
+    segment = std::max<size_t>(4, std::min(segment, total));
+    size_t fftSize = nextPowerOfTwo(segment);
+    size_t hop = std::max<size_t>(1, segment / 2);
+
+    std::vector<double> window(segment);
+    double windowSum = 0.0;
+    for (size_t i = 0; i < segment; i++)
+    {
+      window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / (segment - 1));
+      windowSum += window[i];
+    }
+
+    std::vector<double> meanSquare(fftSize / 2 + 1, 0.0);
+    std::vector<std::complex<double>> buffer(fftSize);
+    size_t segments = 0;
+    for (size_t start = 0; start + segment <= total; start += hop)
+    {
+      std::fill(buffer.begin(), buffer.end(), std::complex<double>(0.0, 0.0));
+      for (size_t i = 0; i < segment; i++)
+        buffer[i] = grid[start + i] * window[i];
+      fft(&buffer);
+      for (size_t k = 0; k < meanSquare.size(); k++)
+        meanSquare[k] += std::norm(buffer[k]);
+      segments++;
+    }
+
+    // A sinusoid of amplitude A gives |X| = A * sum(w) / 2 at its bin
+    out.reserve(meanSquare.size());
+    for (size_t k = 1; k < meanSquare.size(); k++)
+    {
+      double amplitude = 2.0 * sqrt(meanSquare[k] / segments) / windowSum;
+      SpectrumPoint p;
+      p.frequency_hz = k / (fftSize * dt);
+      p.amplitude_m = amplitude;
+      p.power = amplitude * amplitude * n / 4.0;
+      out.push_back(p);
+    }
+    return out;
+  }
+
+  std::vector<size_t> findPeaks(const std::vector<SpectrumPoint> &spectrum, double minFraction, size_t maxPeaks)
+  {
+    std::vector<size_t> peaks;
+    double maxAmplitude = 0.0;
+    for (const SpectrumPoint &p : spectrum)
+      maxAmplitude = std::max(maxAmplitude, p.amplitude_m);
+
+    for (size_t i = 1; i + 1 < spectrum.size(); i++)
+    {
+      double a = spectrum[i].amplitude_m;
+      if (a >= minFraction * maxAmplitude && a > spectrum[i - 1].amplitude_m && a >= spectrum[i + 1].amplitude_m)
+        peaks.push_back(i);
+    }
+
+    std::sort(peaks.begin(), peaks.end(),
+              [&](size_t a, size_t b) { return spectrum[a].amplitude_m > spectrum[b].amplitude_m; });
+    if (peaks.size() > maxPeaks)
+      peaks.resize(maxPeaks);
+    return peaks;
+  }
+}
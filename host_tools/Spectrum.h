@@ -0,0 +1,48 @@
+// host_tools/Spectrum.h
+#pragma once
+
+#include <complex>
+#include <stddef.h>
+#include <vector>
+
+// Power spectra of a distance series. Amplitudes are in meters so the
+// numbers match plot_periodogram() in ESP32_to_Python_GUI/sd_plotter.py.
+struct SpectrumPoint
+{
+  double frequency_hz;
+  double power;       // scipy.signal.lombscargle convention (unnormalized)
+  double amplitude_m; // sqrt(4 * power / n)
+};
+
+namespace Spectrum
+{
+  // In-place radix-2 FFT, size must be a power of two. inverse has no 1/n.
+  void fft(std::vector<std::complex<double>> *data, bool inverse = false);
+
+  /**
+   * Lomb-Scargle periodogram on the grid k / (T * oversample), k >= 1, up
+   * to maxFrequency, where T is the time span. Uses Press & Rybicki's
+   * extirpolation onto a regular grid and one FFT, so it is
+   * O(n + M log M) for M frequencies instead of O(n * M).
+   */
+  std::vector<SpectrumPoint> lombScargleFast(const std::vector<double> &t, const std::vector<double> &y,
+                                             double oversample, double maxFrequency);
+
+  // Direct O(n * M) evaluation at the given frequencies, for checking the fast one
+  std::vector<SpectrumPoint> lombScargleDirect(const std::vector<double> &t, const std::vector<double> &y,
+                                               const std::vector<double> &frequencies);
+
+  /**
+   * Welch-averaged FFT amplitude spectrum. The series is resampled to a
+   * uniform grid at its median sample interval (linear interpolation, so
+   * gaps are bridged), split into Hann-windowed segments of segmentSeconds
+   * with 50% overlap (0 = one segment), and the segment spectra averaged.
+   * power is reported in the Lomb-Scargle convention for the same
+   * amplitude, so the two methods can be compared directly.
+   */
+  std::vector<SpectrumPoint> welch(const std::vector<double> &t, const std::vector<double> &y,
+                                   double segmentSeconds);
+
+  // Local maxima at least minFraction of the largest amplitude, largest first
+  std::vector<size_t> findPeaks(const std::vector<SpectrumPoint> &spectrum, double minFraction, size_t maxPeaks);
+}
@@ -0,0 +1,87 @@
+// host_tools/WaveFilter.cpp
+#include "WaveFilter.h"
+#include "OrderStatistics.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+  /**
+   * @brief numpy.percentile(values, 100 * q) in O(n) with nth_element
+   */
+  double percentile(std::vector<double> values, double q)
+  {
+    double pos = q * (values.size() - 1);
+    size_t lo = (size_t)floor(pos);
+    std::nth_element(values.begin(), values.begin() + lo, values.end());
+    double a = values[lo];
+    double frac = pos - lo;
+    if (frac == 0.0)
+      return a;
+    double b = *std::min_element(values.begin() + lo + 1, values.end());
+    return a + (b - a) * frac;
+  }
+}
+
+
+namespace WaveFilter
+{
+  OutlierStats detectOutliers(const std::vector<double> &values, size_t window, double iqrScale,
+                              std::vector<uint8_t> *keep)
+  {
+    OutlierStats stats;
+    size_t n = values.size();
+    keep->assign(n, 1);
+    if (n == 0)
+      return stats;
+
+    // First pass: global IQR bounds
+    double q1 = percentile(values, 0.25);
+    double q3 = percentile(values, 0.75);
+    double iqr = q3 - q1;
+    stats.globalLow = q1 - iqrScale * iqr;
+    stats.globalHigh = q3 + iqrScale * iqr;
+    for (size_t i = 0; i < n; i++)
+    {
+      if (values[i] < stats.globalLow || values[i] > stats.globalHigh)
+      {
+        (*keep)[i] = 0;
+        stats.globalOutliers++;
+      }
+    }
+
+    // Second pass: the tree holds the valid points of [i - half, i + half]
+    size_t half = window / 2;
+    OrderStatisticTree tree;
+    for (size_t j = 0; j <= half && j < n; j++)
+    {
+      if ((*keep)[j])
+        tree.insert(values[j], (uint32_t)j);
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+      if (tree.size() > 0)
+      {
+        double median = tree.quantile(0.5);
+        double localIqr = tree.quantile(0.75) - tree.quantile(0.25);
+        if (fabs(values[i] - median) > iqrScale * localIqr && (*keep)[i])
+        {
+          tree.erase(values[i], (uint32_t)i);
+          (*keep)[i] = 0;
+          stats.rollingOutliers++;
+        }
+      }
+
+      // Slide the window by one
+      if (i >= half && (*keep)[i - half])
+        tree.erase(values[i - half], (uint32_t)(i - half));
+      size_t incoming = i + half + 1;
+      if (incoming < n && (*keep)[incoming])
+        tree.insert(values[incoming], (uint32_t)incoming);
+    }
+
+    return stats;
+  }
+}
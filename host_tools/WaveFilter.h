@@ -0,0 +1,32 @@
+// host_tools/WaveFilter.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct OutlierStats
+{
+  double globalLow = 0.0;  // global IQR bounds
+  double globalHigh = 0.0;
+  size_t globalOutliers = 0;
+  size_t rollingOutliers = 0;
+};
+
+namespace WaveFilter
+{
+  /**
+   * Two-pass outlier detection, the same decisions as detect_outliers() in
+   * ESP32_to_Python_GUI/sd_plotter.py:
+   *  1. values outside [Q1 - k*IQR, Q3 + k*IQR] of the whole series
+   *  2. values further than k * local IQR from the median of the points in a
+   *     centered window of `window` samples that are still valid; points
+   *     rejected earlier in this pass are no longer part of later windows
+   * The window quantiles come from an order-statistics tree, so this is
+   * O(n log w) rather than a sort per point.
+   *
+   * keep[i] is set to 1 for values that pass both.
+   */
+  OutlierStats detectOutliers(const std::vector<double> &values, size_t window, double iqrScale,
+                              std::vector<uint8_t> *keep);
+}
@@ -0,0 +1,384 @@
+// host_tools/WaveSeries.cpp
+#include "WaveSeries.h"
+#include "CivilTime.h"
+#include "storage/BinaryLog.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  /**
+   * @brief Read-only memory map of a whole file
+   */
+  class MappedFile
+  {
+  public:
+    ~MappedFile()
+    {
+      if (m_data && m_size)
+        munmap((void *)m_data, m_size);
+    }
+
+    bool open(const char *path, std::string *error)
+    {
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0)
+      {
+        *error = std::string("Can't open ") + path;
+        return false;
+      }
+
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+      {
+        ::close(fd);
+        *error = std::string("Can't stat ") + path;
+        return false;
+      }
+
+      m_size = (size_t)st.st_size;
+      if (m_size > 0)
+      {
+        void *p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+          ::close(fd);
+          *error = std::string("Can't map ") + path;
+          return false;
+        }
+        madvise(p, m_size, MADV_SEQUENTIAL);
+        m_data = (const char *)p;
+      }
+      ::close(fd);
+      return true;
+    }
+
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+  private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+  };
+
+  inline bool isDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  inline unsigned twoDigits(const char *p)
+  {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+  }
+
+  /**
+   * @brief Parses "-12.345" style decimals
+   * @return Pointer past the number, nullptr if there are no digits
+   *
+   * The mantissa and power of ten are exact doubles for anything the logger
+   * writes, so the division gives the same value as strtod().
+   */
+  const char *parseDecimal(const char *p, const char *end, double *value)
+  {
+    static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+    bool negative = false;
+    if (p < end && *p == '-')
+    {
+      negative = true;
+      p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int decimals = 0;
+    while (p < end && isDigit(*p) && digits < 15)
+    {
+      mantissa = mantissa * 10 + (*p++ - '0');
+      digits++;
+    }
+    if (p < end && *p == '.')
+    {
+      p++;
+      while (p < end && isDigit(*p) && digits < 15 && decimals < 9)
+      {
+        mantissa = mantissa * 10 + (*p++ - '0');
+        digits++;
+        decimals++;
+      }
+    }
+    if (digits == 0 || (p < end && isDigit(*p)))
+      return nullptr;
+
+    *value = (negative ? -(double)mantissa : (double)mantissa) / POW10[decimals];
+    return p;
+  }
+
+  /**
+   * @brief Keeps one (distance, strength) pair of a measurement
+   */
+  class TargetPicker
+  {
+  public:
+    explicit TargetPicker(int target) : m_target(target) {}
+
+    void reset()
+    {
+      m_count = 0;
+      m_found = false;
+    }
+
+    void add(double distance, double strength)
+    {
+      m_count++;
+      bool take = (m_target == WaveSeriesFile::TARGET_STRONGEST) ? (!m_found || strength > m_strength)
+                                                                 : (m_count == m_target);
+      if (take)
+      {
+        m_distance = distance;
+        m_strength = strength;
+        m_found = true;
+      }
+    }
+
+    int count() const { return m_count; }
+    bool found() const { return m_found; }
+    double distance() const { return m_distance; }
+    double strength() const { return m_strength; }
+
+  private:
+    int m_target;
+    int m_count = 0;
+    bool m_found = false;
+    double m_distance = 0.0;
+    double m_strength = 0.0;
+  };
+
+  /**
+   * @brief Parses the values after the timestamp
+   * @return false if the line is malformed
+   */
+  bool parseValues(const char *p, const char *end, TargetPicker *picker)
+  {
+    picker->reset();
+    if (end - p == 8 && memcmp(p, "no_dists", 8) == 0)
+      return true;
+
+    double distance, strength;
+    p = parseDecimal(p, end, &distance);
+    if (!p)
+      return false;
+
+    // Older firmware: "4.058 m, 21.97"
+    if (end - p >= 4 && memcmp(p, " m, ", 4) == 0)
+    {
+      p = parseDecimal(p + 4, end, &strength);
+      if (!p || p != end)
+        return false;
+      picker->add(distance, strength);
+      return true;
+    }
+
+    // Current firmware: "d,s;d,s;"
+    while (true)
+    {
+      if (p >= end || *p != ',')
+        return false;
+      p = parseDecimal(p + 1, end, &strength);
+      if (!p || p >= end || *p != ';')
+        return false;
+      picker->add(distance, strength);
+      if (++p == end)
+        return true;
+      p = parseDecimal(p, end, &distance);
+      if (!p)
+        return false;
+    }
+  }
+
+  void appendText(const char *data, size_t size, TargetPicker *picker, WaveSeries *out, WaveParseStats *stats)
+  {
+    // "[YY/MM/DD HH:MM:SS.mmm] " is 24 characters; the day only changes
+    // around midnight, so it is converted once per date seen
+    constexpr size_t STAMP_LENGTH = 24;
+    char lastDate[8] = {0};
+    int64_t dayMs = 0;
+
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end)
+    {
+      const char *eol = (const char *)memchr(p, '\n', end - p);
+      const char *next = eol ? eol + 1 : end;
+      const char *lineEnd = eol ? eol : end;
+      if (lineEnd > p && lineEnd[-1] == '\r')
+        lineEnd--;
+      // Erased flash reads back as 0xFF; a line cut short by a power loss can
+      // end in such bytes after otherwise intact values
+      while (lineEnd > p && (unsigned char)lineEnd[-1] >= 0x80)
+        lineEnd--;
+
+      if (p == lineEnd || *p != '[')
+      {
+        stats->otherLines++;
+        p = next;
+        continue;
+      }
+      stats->lines++;
+
+      const char *s = p;
+      if ((size_t)(lineEnd - s) < STAMP_LENGTH ||
+          !isDigit(s[1]) || !isDigit(s[2]) || s[3] != '/' || !isDigit(s[4]) || !isDigit(s[5]) ||
+          s[6] != '/' || !isDigit(s[7]) || !isDigit(s[8]) || s[9] != ' ' ||
+          !isDigit(s[10]) || !isDigit(s[11]) || s[12] != ':' || !isDigit(s[13]) || !isDigit(s[14]) ||
+          s[15] != ':' || !isDigit(s[16]) || !isDigit(s[17]) || s[18] != '.' ||
+          !isDigit(s[19]) || !isDigit(s[20]) || !isDigit(s[21]) || s[22] != ']' || s[23] != ' ' ||
+          !parseValues(s + STAMP_LENGTH, lineEnd, picker))
+      {
+        stats->badLines++;
+        p = next;
+        continue;
+      }
+
+      if (memcmp(lastDate, s + 1, sizeof(lastDate)) != 0)
+      {
+        memcpy(lastDate, s + 1, sizeof(lastDate));
+        dayMs = CivilTime::daysFromCivil(2000 + twoDigits(s + 1), twoDigits(s + 4), twoDigits(s + 7)) * 86400000;
+      }
+      int64_t ms = dayMs + (twoDigits(s + 10) * 3600 + twoDigits(s + 13) * 60 + twoDigits(s + 16)) * 1000 +
+                   twoDigits(s + 19) * 10 + (s[21] - '0');
+
+      if (!picker->found())
+      {
+        stats->noDists += picker->count() == 0;
+        stats->badLines += picker->count() != 0; // asked for a target the line doesn't have
+        p = next;
+        continue;
+      }
+
+      out->time_s.push_back(ms / 1000.0);
+      out->distance_m.push_back(picker->distance());
+      out->strength_db.push_back(picker->strength());
+      stats->samples++;
+      p = next;
+    }
+  }
+
+  void appendBinary(const uint8_t *data, size_t size, TargetPicker *picker, WaveSeries *out, WaveParseStats *stats)
+  {
+    // Blocks follow the text header; scan for the magic so a torn write only
+    // costs the damaged block
+    size_t pos = 0;
+    while (pos + BINLOG_BLOCK_HEADER_SIZE <= size)
+    {
+      BinaryLogBlockInfo info;
+      if (!BinaryLog::readBlockHeader(data + pos, size - pos, &info))
+      {
+        pos++;
+        continue;
+      }
+
+      const uint8_t *payload = data + pos + BINLOG_BLOCK_HEADER_SIZE;
+      if (info.payloadSize > size - pos - BINLOG_BLOCK_HEADER_SIZE ||
+          RadarProtocol::crc16(payload, info.payloadSize) != info.payloadCrc)
+      {
+        stats->badBlocks++;
+        pos++;
+        continue;
+      }
+
+      int64_t t = CivilTime::epochMs(info.year, info.month, info.day, info.hour, info.minute,
+                                     info.second, info.millisecond);
+      size_t off = 0;
+      while (off < info.payloadSize)
+      {
+        BinaryLogRecord rec;
+        size_t used = BinaryLog::decodeRecord(payload + off, info.payloadSize - off, &rec);
+        if (used == 0)
+          break;
+        off += used;
+        t += rec.deltaMs;
+
+        if (rec.isText)
+        {
+          stats->otherLines++;
+          continue;
+        }
+
+        stats->lines++;
+        picker->reset();
+        for (int i = 0; i < rec.sample.count; i++)
+          picker->add(rec.sample.distances_mm[i] / 1000.0, rec.sample.strengths_cdb[i] / 100.0);
+        if (!picker->found())
+        {
+          stats->noDists += rec.sample.count == 0;
+          stats->badLines += rec.sample.count != 0;
+          continue;
+        }
+
+        out->time_s.push_back(t / 1000.0);
+        out->distance_m.push_back(picker->distance());
+        out->strength_db.push_back(picker->strength());
+        stats->samples++;
+      }
+
+      stats->blocks++;
+      pos += BINLOG_BLOCK_HEADER_SIZE + info.payloadSize;
+    }
+  }
+
+  bool endsWith(const char *s, const char *suffix)
+  {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+  }
+}
+
+
+namespace WaveSeriesFile
+{
+  bool append(const char *path, int target, WaveSeries *out, WaveParseStats *stats, std::string *error)
+  {
+    MappedFile file;
+    if (!file.open(path, error))
+      return false;
+
+    stats->bytes += file.size();
+    TargetPicker picker(target);
+    if (endsWith(path, ".bin"))
+      appendBinary((const uint8_t *)file.data(), file.size(), &picker, out, stats);
+    else
+      appendText(file.data(), file.size(), &picker, out, stats);
+    return true;
+  }
+
+  bool sortByTime(WaveSeries *series)
+  {
+    if (std::is_sorted(series->time_s.begin(), series->time_s.end()))
+      return false;
+
+    std::vector<size_t> order(series->size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return series->time_s[a] < series->time_s[b]; });
+
+    WaveSeries sorted;
+    sorted.time_s.reserve(order.size());
+    sorted.distance_m.reserve(order.size());
+    sorted.strength_db.reserve(order.size());
+    for (size_t i : order)
+    {
+      sorted.time_s.push_back(series->time_s[i]);
+      sorted.distance_m.push_back(series->distance_m[i]);
+      sorted.strength_db.push_back(series->strength_db[i]);
+    }
+    *series = std::move(sorted);
+    return true;
+  }
+}
@@ -0,0 +1,53 @@
+// host_tools/WaveSeries.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// One distance per measurement, read from logger data files.
+//
+// Text files (*_data.txt) may use the current line format
+//   "[YY/MM/DD HH:MM:SS.mmm] d,s;d,s;" or "[...] no_dists"
+// or the older single-target one
+//   "[YY/MM/DD HH:MM:SS.mmm] 4.058 m, 21.97"
+// Binary files (*.bin, RADAR_MODE_BINARY_LOG) are decoded with BinaryLog.
+// Lines that don't match (torn writes, GPS lines) are counted and skipped;
+// non-ASCII bytes at the end of a line are ignored, like sd_plotter.py does.
+struct WaveSeries
+{
+  std::vector<double> time_s;      // seconds since 1970-01-01, RTC wall clock
+  std::vector<double> distance_m;
+  std::vector<double> strength_db;
+
+  size_t size() const { return time_s.size(); }
+};
+
+struct WaveParseStats
+{
+  size_t bytes = 0;
+  size_t lines = 0;      // text lines after the header
+  size_t samples = 0;    // measurements with at least one distance
+  size_t noDists = 0;    // measurements without distances
+  size_t badLines = 0;   // timestamped lines that didn't parse
+  size_t otherLines = 0; // lines without a timestamp
+  size_t blocks = 0;     // binary blocks
+  size_t badBlocks = 0;
+};
+
+namespace WaveSeriesFile
+{
+  // Which target to keep when a measurement has several distances
+  static constexpr int TARGET_STRONGEST = 0;
+
+  /**
+   * Appends the measurements in a data file to out. target is 1-based (the
+   * order the STM32 reported them, nearest first) or TARGET_STRONGEST.
+   * Returns false and sets error if the file can't be read.
+   */
+  bool append(const char *path, int target, WaveSeries *out, WaveParseStats *stats, std::string *error);
+
+  // Sorts by time if the files weren't given in order. Returns true if it had to.
+  bool sortByTime(WaveSeries *series);
+}
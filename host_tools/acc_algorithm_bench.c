@@ -0,0 +1,1027 @@
+// host_tools/acc_algorithm_bench.c
+//
+// Micro-benchmarks of the STM32 signal processing in xm125/Src/algorithms,
+// compiled for the host so an algorithm change can be measured without
+// flashing. The runner works like Google Benchmark: the iteration count of
+// each benchmark grows until a run takes --min-time, then --repetitions runs
+// are timed and summarised. --json writes Google Benchmark's JSON format, so
+// two results can be compared with its tools/compare.py.
+//
+// Times are wall clock and process CPU time per iteration. On Linux the CPU
+// cycles per iteration are also read from the perf_event cycle counter when
+// the kernel allows it (perf_event_paranoid <= 2), otherwise they are left out.
+//
+// Host times only rank changes: the Cortex-M4 has no cache and a single
+// precision FPU, so measure on the target before relying on a ratio.
+
+#define _GNU_SOURCE
+
+#include <complex.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "acc_alg_basic_utils.h"
+#include "acc_algorithm.h"
+#include "acc_band_distance.h"
+#include "acc_order_statistics.h"
+#include "acc_processing_helpers.h"
+
+#define MAX_NAME_LENGTH 64
+#define MAX_AGGREGATE_NAME_LENGTH (MAX_NAME_LENGTH + 8) // run name + "_stddev"
+#define MAX_RESULTS 1024
+#define MAX_ITERATIONS 1000000000ULL
+
+typedef struct
+{
+  uint64_t iterations;
+  uint64_t real_ns;
+  uint64_t cpu_ns;
+  uint64_t cycles;
+  bool     has_cycles;
+  uint64_t start_real_ns;
+  uint64_t start_cpu_ns;
+  int      arg;
+} bench_state_t;
+
+typedef void (*bench_function_t)(bench_state_t *state);
+
+typedef struct
+{
+  const char       *name;
+  bench_function_t function;
+  int              args[4]; // 0 terminated, a benchmark without arguments runs once with 0
+} bench_t;
+
+typedef struct
+{
+  char       name[MAX_AGGREGATE_NAME_LENGTH];
+  char       run_name[MAX_NAME_LENGTH];
+  const char *aggregate; // NULL for a repetition
+  int        repetition;
+  uint64_t   iterations;
+  double     real_ns;
+  double     cpu_ns;
+  double     cycles;
+  bool       has_cycles;
+} bench_result_t;
+
+typedef struct
+{
+  const char *filter;
+  const char *json_path;
+  double     min_time_s;
+  int        repetitions;
+} options_t;
+
+static int            cycle_counter = -1;
+static volatile float sink_f32;
+static volatile int   sink_i32;
+static uint32_t       random_state = 1U;
+
+static bench_result_t results[MAX_RESULTS];
+static int            num_results;
+
+
+//-----------------------------
+// Timing
+//-----------------------------
+
+static uint64_t clock_ns(clockid_t clock)
+{
+  struct timespec ts;
+
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+static void cycle_counter_open(void)
+{
+#ifdef __linux__
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type           = PERF_TYPE_HARDWARE;
+  attr.size           = sizeof(attr);
+  attr.config         = PERF_COUNT_HW_CPU_CYCLES;
+  attr.disabled       = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+
+  cycle_counter = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+
+static void bench_start(bench_state_t *state)
+{
+#ifdef __linux__
+  if (cycle_counter >= 0)
+  {
+    ioctl(cycle_counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(cycle_counter, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+  state->start_cpu_ns  = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  state->start_real_ns = clock_ns(CLOCK_MONOTONIC);
+}
+
+
+static void bench_stop(bench_state_t *state)
+{
+  state->real_ns = clock_ns(CLOCK_MONOTONIC) - state->start_real_ns;
+  state->cpu_ns  = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - state->start_cpu_ns;
+  state->has_cycles = false;
+#ifdef __linux__
+  if (cycle_counter >= 0)
+  {
+    uint64_t count = 0;
+
+    ioctl(cycle_counter, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(cycle_counter, &count, sizeof(count)) == (ssize_t)sizeof(count))
+    {
+      state->cycles     = count;
+      state->has_cycles = true;
+    }
+  }
+#endif
+}
+
+
+//-----------------------------
+// Test data
+//-----------------------------
+
+static float random_f32(void)
+{
+  // xorshift32, the same data on every run and host
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return (float)(random_state >> 8) / 16777216.0f;
+}
+
+
+static float *alloc_noise_f32(int length)
+{
+  float *data = malloc((size_t)length * sizeof(*data));
+
+  for (int i = 0; i < length; i++)
+  {
+    data[i] = random_f32();
+  }
+
+  return data;
+}
+
+
+static float complex *alloc_noise_complex(int length)
+{
+  float complex *data = malloc((size_t)length * sizeof(*data));
+
+  for (int i = 0; i < length; i++)
+  {
+    data[i] = random_f32() - 0.5f + (random_f32() - 0.5f) * I;
+  }
+
+  return data;
+}
+
+
+// A spectrum-like sweep: noise floor with a few peaks
+static float *alloc_sweep_f32(int length)
+{
+  float *data = alloc_noise_f32(length);
+
+  for (int peak = 1; peak <= 4; peak++)
+  {
+    int center = peak * length / 5;
+
+    for (int i = -3; i <= 3; i++)
+    {
+      data[center + i] += 20.0f / (1.0f + (float)(i * i));
+    }
+  }
+
+  return data;
+}
+
+
+static uint16_t length_shift_of(int length)
+{
+  uint16_t shift = 0;
+
+  while ((1 << shift) < length)
+  {
+    shift++;
+  }
+
+  return shift;
+}
+
+
+//-----------------------------
+// Benchmarks
+//-----------------------------
+
+static void bench_rfft(bench_state_t *state)
+{
+  int           n      = state->arg;
+  float         *data  = alloc_noise_f32(n);
+  float complex *output = malloc(((size_t)n / 2 + 1) * sizeof(*output));
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_rfft(data, (uint16_t)n, length_shift_of(n), output);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(output);
+}
+
+
+static void bench_fft(bench_state_t *state)
+{
+  int           n      = state->arg;
+  float complex *data  = alloc_noise_complex(n);
+  float complex *output = malloc((size_t)n * sizeof(*output));
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_fft(data, (uint16_t)n, length_shift_of(n), output);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(output);
+}
+
+
+// Columns of a rows x 32 matrix, like the breathing and vibration time series
+static void bench_rfft_matrix_columns(bench_state_t *state)
+{
+  const int     cols   = 32;
+  int           rows   = state->arg;
+  float         *data  = alloc_noise_f32(rows * cols);
+  float complex *output = malloc(((size_t)rows / 2 + 1) * cols * sizeof(*output));
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_rfft_matrix(data, (uint16_t)rows, (uint16_t)cols, length_shift_of(rows), output, 0U);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(output);
+}
+
+
+// 512 samples in segments of arg, as in example_surface_velocity
+static void bench_welch(bench_state_t *state)
+{
+  const int     length     = 512;
+  int           segment    = state->arg;
+  float complex *data      = alloc_noise_complex(length);
+  float complex *buffer    = malloc((size_t)segment * sizeof(*buffer));
+  float complex *fft_out   = malloc((size_t)segment * sizeof(*fft_out));
+  float         *psd       = malloc((size_t)segment * sizeof(*psd));
+  float         *window    = malloc((size_t)segment * sizeof(*window));
+
+  acc_algorithm_hann((uint16_t)segment, window);
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_welch(data, (uint16_t)length, (uint16_t)segment, buffer, fft_out, psd, window, length_shift_of(segment), 100.0f);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(buffer);
+  free(fft_out);
+  free(psd);
+  free(window);
+}
+
+
+static void bench_cfar_per_index(bench_state_t *state)
+{
+  int   n     = state->arg;
+  float *data = alloc_sweep_f32(n);
+  float sum   = 0.0f;
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    for (int idx = 0; idx < n; idx++)
+    {
+      sum += acc_algorithm_calculate_cfar(data, (uint16_t)n, 16U, 4U, 0.5f, (uint16_t)idx);
+    }
+  }
+  bench_stop(state);
+
+  sink_f32 = sum;
+  free(data);
+}
+
+
+static void bench_cfar_sweep(bench_state_t *state)
+{
+  int   n          = state->arg;
+  float *data      = alloc_sweep_f32(n);
+  float *threshold = malloc((size_t)n * sizeof(*threshold));
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_calculate_cfar_sweep(data, (uint16_t)n, 16U, 4U, 0.5f, threshold);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(threshold);
+}
+
+
+static void bench_mirrored_cfar_per_index(bench_state_t *state)
+{
+  int   n     = state->arg;
+  float *data = alloc_sweep_f32(n);
+  float sum   = 0.0f;
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    for (int idx = 0; idx < n; idx++)
+    {
+      sum += acc_algorithm_calculate_mirrored_one_sided_cfar(data, (uint16_t)n, (uint16_t)(n / 2), 6U, 4U, 0.15f, (uint16_t)idx);
+    }
+  }
+  bench_stop(state);
+
+  sink_f32 = sum;
+  free(data);
+}
+
+
+static void bench_mirrored_cfar_sweep(bench_state_t *state)
+{
+  int   n          = state->arg;
+  float *data      = alloc_sweep_f32(n);
+  float *threshold = malloc((size_t)n * sizeof(*threshold));
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_calculate_mirrored_one_sided_cfar_sweep(data, (uint16_t)n, (uint16_t)(n / 2), 6U, 4U, 0.15f, threshold);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(threshold);
+}
+
+
+// Selection reorders its input, so every iteration includes copying it back
+static void bench_median_f32(bench_state_t *state)
+{
+  int   n        = state->arg;
+  float *data    = alloc_noise_f32(n);
+  float *scratch = malloc((size_t)n * sizeof(*scratch));
+  float sum      = 0.0f;
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    memcpy(scratch, data, (size_t)n * sizeof(*scratch));
+    sum += acc_algorithm_median_f32(scratch, (uint16_t)n);
+  }
+  bench_stop(state);
+
+  sink_f32 = sum;
+  free(data);
+  free(scratch);
+}
+
+
+static void bench_median_i16(bench_state_t *state)
+{
+  int     n        = state->arg;
+  int16_t *data    = malloc((size_t)n * sizeof(*data));
+  int16_t *scratch = malloc((size_t)n * sizeof(*scratch));
+  int     sum      = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    data[i] = (int16_t)(random_f32() * 4000.0f - 2000.0f);
+  }
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    memcpy(scratch, data, (size_t)n * sizeof(*scratch));
+    sum += acc_algorithm_median_i16(scratch, (uint16_t)n);
+  }
+  bench_stop(state);
+
+  sink_i32 = sum;
+  free(data);
+  free(scratch);
+}
+
+
+// One push and one median of a full window, the per-measurement cost of the jjh_v2 outlier filter
+static void bench_window_median(bench_state_t *state)
+{
+  int                           n       = state->arg;
+  float                         *ring   = malloc((size_t)n * sizeof(*ring));
+  float                         *sorted = malloc((size_t)n * sizeof(*sorted));
+  float                         *input  = alloc_noise_f32(1024);
+  float                         sum     = 0.0f;
+  acc_order_statistics_window_t window;
+
+  acc_order_statistics_window_init(&window, ring, sorted, (uint16_t)n);
+  for (int i = 0; i < n; i++)
+  {
+    acc_order_statistics_window_push(&window, input[i]);
+  }
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_order_statistics_window_push(&window, input[i & 1023U]);
+    sum += acc_order_statistics_window_median(&window);
+  }
+  bench_stop(state);
+
+  sink_f32 = sum;
+  free(ring);
+  free(sorted);
+  free(input);
+}
+
+
+static void bench_butter_design(bench_state_t *state)
+{
+  float b[5];
+  float a[4];
+  float sum = 0.0f;
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_butter_lowpass(1.0f, 20.0f, b, a);
+    sum += b[0];
+    acc_algorithm_butter_bandpass(0.2f, 2.0f, 20.0f, b, a);
+    sum += b[0];
+  }
+  bench_stop(state);
+
+  sink_f32 = sum;
+}
+
+
+// Filters a fresh copy every iteration, filtering the output again would decay into denormals
+static void bench_lfilter_bandpass(bench_state_t *state)
+{
+  int   n        = state->arg;
+  float *data    = alloc_noise_f32(n);
+  float *scratch = malloc((size_t)n * sizeof(*scratch));
+  float b[5];
+  float a[4];
+
+  acc_algorithm_butter_bandpass(0.2f, 2.0f, 20.0f, b, a);
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    memcpy(scratch, data, (size_t)n * sizeof(*scratch));
+    acc_algorithm_lfilter(b, a, scratch, (uint16_t)n);
+  }
+  bench_stop(state);
+
+  free(data);
+  free(scratch);
+}
+
+
+static void bench_find_peaks(bench_state_t *state)
+{
+  int      n              = state->arg;
+  float    *data          = alloc_sweep_f32(n);
+  float    *threshold     = malloc((size_t)n * sizeof(*threshold));
+  size_t   check_length   = acc_alg_basic_utils_calculate_length_of_bitarray_uint32((size_t)n);
+  uint32_t *check         = calloc(check_length, sizeof(*check));
+  uint16_t *peaks         = malloc((size_t)n / 2 * sizeof(*peaks));
+  uint16_t num_peaks      = 0;
+  int      sum            = 0;
+
+  acc_algorithm_calculate_cfar_sweep(data, (uint16_t)n, 16U, 4U, 0.5f, threshold);
+  for (int i = 0; i < n; i++)
+  {
+    if (data[i] > threshold[i])
+    {
+      acc_alg_basic_utils_set_bit_bitarray_uint32(check, (size_t)i);
+    }
+  }
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_find_peaks(data, (uint16_t)n, check, peaks, (uint16_t)(n / 2), &num_peaks);
+    sum += num_peaks;
+  }
+  bench_stop(state);
+
+  sink_i32 = sum;
+  free(data);
+  free(threshold);
+  free(check);
+  free(peaks);
+}
+
+
+// arg peaks in clusters of three
+static void bench_merge_peaks(bench_state_t *state)
+{
+  int      num_peaks         = state->arg;
+  int      n                 = num_peaks * 4;
+  float    *velocities       = malloc((size_t)n * sizeof(*velocities));
+  float    *energies         = alloc_noise_f32(n);
+  uint16_t *peaks            = malloc((size_t)num_peaks * sizeof(*peaks));
+  float    *merged_velocities = malloc((size_t)num_peaks * sizeof(*merged_velocities));
+  float    *merged_energies  = malloc((size_t)num_peaks * sizeof(*merged_energies));
+  uint16_t num_merged        = 0;
+  int      sum               = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    velocities[i] = 0.01f * (float)i;
+  }
+
+  for (int i = 0; i < num_peaks; i++)
+  {
+    peaks[i] = (uint16_t)((i / 3) * 12 + (i % 3));
+  }
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_algorithm_merge_peaks(0.05f, velocities, energies, peaks, (uint16_t)num_peaks, merged_velocities, merged_energies,
+                              (uint16_t)num_peaks, &num_merged);
+    sum += num_merged;
+  }
+  bench_stop(state);
+
+  sink_i32 = sum;
+  free(velocities);
+  free(energies);
+  free(peaks);
+  free(merged_velocities);
+  free(merged_energies);
+}
+
+
+// 0.5 to 10 m with a 0.5 m fine band at step 2 around an echo at 5.2 m,
+// arg is the coarse step, at 2 the whole range has the fine step length
+static void bench_band_distance(bench_state_t *state)
+{
+  acc_band_distance_band_t bands[ACC_BAND_DISTANCE_MAX_BANDS];
+  acc_band_distance_peak_t peaks[5];
+  uint8_t                  num_bands = acc_band_distance_layout(4.95f, 5.45f, 2U, ACC_CONFIG_PROFILE_2, 0.5f, 10.0f,
+                                                                (uint16_t)state->arg, ACC_CONFIG_PROFILE_5, bands);
+  uint16_t                 sweep_length = 0;
+  uint16_t                 max_points   = 0;
+  int                      sum          = 0;
+
+  for (uint8_t b = 0; b < num_bands; b++)
+  {
+    bands[b].data_offset = sweep_length;
+    sweep_length         = (uint16_t)(sweep_length + bands[b].num_points);
+    max_points           = (bands[b].num_points > max_points) ? bands[b].num_points : max_points;
+  }
+
+  acc_int16_complex_t *frame = malloc((size_t)sweep_length * sizeof(*frame));
+  float               *work  = malloc(ACC_BAND_DISTANCE_WORK_LENGTH((size_t)max_points) * sizeof(*work));
+
+  for (uint8_t b = 0; b < num_bands; b++)
+  {
+    float fwhm = acc_algorithm_get_fwhm(bands[b].profile);
+
+    for (uint16_t i = 0; i < bands[b].num_points; i++)
+    {
+      float distance = (float)(bands[b].start_point + i * bands[b].step_length) * ACC_APPROX_BASE_STEP_LENGTH_M;
+      float offset   = (distance - 5.2f) / fwhm;
+      float echo     = 2000.0f * expf(-2.77f * offset * offset);
+
+      frame[bands[b].data_offset + i].real = (int16_t)(echo + 40.0f * (random_f32() - 0.5f));
+      frame[bands[b].data_offset + i].imag = (int16_t)(40.0f * (random_f32() - 0.5f));
+    }
+  }
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    sum += acc_band_distance_process(frame, sweep_length, 1U, bands, num_bands, 0.5f, work, peaks, 5U);
+  }
+  bench_stop(state);
+
+  sink_i32 = sum;
+  free(frame);
+  free(work);
+}
+
+
+static void bench_exponential_average_iq(bench_state_t *state)
+{
+  int             n        = state->arg;
+  acc_vector_iq_t *current = acc_vector_iq_alloc((uint32_t)n);
+  acc_vector_iq_t *average = acc_vector_iq_alloc((uint32_t)n);
+  float complex   *noise   = alloc_noise_complex(n);
+
+  memcpy(current->data, noise, (size_t)n * sizeof(*noise));
+  memset(average->data, 0, (size_t)n * sizeof(*noise));
+
+  bench_start(state);
+  for (uint64_t i = 0; i < state->iterations; i++)
+  {
+    acc_vector_iq_update_exponential_average(current, average, 0.9f);
+  }
+  bench_stop(state);
+
+  acc_vector_iq_free(current);
+  acc_vector_iq_free(average);
+  free(noise);
+}
+
+
+static const bench_t benchmarks[] = {
+  {"rfft", bench_rfft, {64, 256, 1024, 4096}},
+  {"fft", bench_fft, {64, 256, 1024, 4096}},
+  {"rfft_matrix_columns", bench_rfft_matrix_columns, {64, 256}},
+  {"welch", bench_welch, {64, 128}},
+  {"cfar_per_index", bench_cfar_per_index, {256, 1024}},
+  {"cfar_sweep", bench_cfar_sweep, {256, 1024}},
+  {"mirrored_cfar_per_index", bench_mirrored_cfar_per_index, {64, 128}},
+  {"mirrored_cfar_sweep", bench_mirrored_cfar_sweep, {64, 128}},
+  {"median_f32", bench_median_f32, {31, 512}},
+  {"median_i16", bench_median_i16, {31, 512}},
+  {"window_median", bench_window_median, {13, 31}},
+  {"butter_design", bench_butter_design, {0}},
+  {"lfilter_bandpass", bench_lfilter_bandpass, {1024}},
+  {"find_peaks", bench_find_peaks, {256, 1024}},
+  {"merge_peaks", bench_merge_peaks, {24, 96}},
+  {"band_distance", bench_band_distance, {2, 8, 24}},
+  {"exponential_average_iq", bench_exponential_average_iq, {128}},
+};
+
+
+//-----------------------------
+// Runner
+//-----------------------------
+
+static bench_result_t *add_result(const char *name, const char *run_name, const char *aggregate)
+{
+  if (num_results >= MAX_RESULTS)
+  {
+    fprintf(stderr, "Too many results\n");
+    exit(EXIT_FAILURE);
+  }
+
+  bench_result_t *result = &results[num_results++];
+
+  memset(result, 0, sizeof(*result));
+  snprintf(result->name, sizeof(result->name), "%s", name);
+  snprintf(result->run_name, sizeof(result->run_name), "%s", run_name);
+  result->aggregate = aggregate;
+  return result;
+}
+
+
+static void print_result(const bench_result_t *result)
+{
+  char cycles[32] = "";
+
+  if (result->has_cycles)
+  {
+    snprintf(cycles, sizeof(cycles), "%14.0f", result->cycles);
+  }
+
+  printf("%-40s %14.1f %14.1f %14s %12llu\n", result->name, result->real_ns, result->cpu_ns, cycles,
+         (unsigned long long)result->iterations);
+}
+
+
+static int compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+
+static void add_aggregates(const char *run_name, const bench_result_t *reps, int count)
+{
+  static const char *names[] = {"mean", "median", "stddev"};
+  double            values[3][3]; // [aggregate][real, cpu, cycles]
+  double            samples[3][64];
+
+  for (int field = 0; field < 3; field++)
+  {
+    double sum = 0.0;
+
+    for (int r = 0; r < count; r++)
+    {
+      samples[field][r] = (field == 0) ? reps[r].real_ns : (field == 1) ? reps[r].cpu_ns : reps[r].cycles;
+      sum += samples[field][r];
+    }
+
+    double mean     = sum / count;
+    double variance = 0.0;
+
+    for (int r = 0; r < count; r++)
+    {
+      variance += (samples[field][r] - mean) * (samples[field][r] - mean);
+    }
+
+    qsort(samples[field], (size_t)count, sizeof(double), compare_double);
+    values[0][field] = mean;
+    values[1][field] = (count % 2) ? samples[field][count / 2] : 0.5 * (samples[field][count / 2 - 1] + samples[field][count / 2]);
+    values[2][field] = (count > 1) ? sqrt(variance / (count - 1)) : 0.0;
+  }
+
+  for (int aggregate = 0; aggregate < 3; aggregate++)
+  {
+    char name[MAX_AGGREGATE_NAME_LENGTH];
+
+    snprintf(name, sizeof(name), "%s_%s", run_name, names[aggregate]);
+
+    bench_result_t *result = add_result(name, run_name, names[aggregate]);
+    result->iterations     = reps[0].iterations;
+    result->real_ns        = values[aggregate][0];
+    result->cpu_ns         = values[aggregate][1];
+    result->cycles         = values[aggregate][2];
+    result->has_cycles     = reps[0].has_cycles;
+    print_result(result);
+  }
+}
+
+
+static void run_benchmark(const bench_t *bench, int arg, const options_t *options)
+{
+  char          run_name[MAX_NAME_LENGTH];
+  bench_state_t state;
+
+  if (arg != 0)
+  {
+    snprintf(run_name, sizeof(run_name), "%s/%d", bench->name, arg);
+  }
+  else
+  {
+    snprintf(run_name, sizeof(run_name), "%s", bench->name);
+  }
+
+  if (options->filter != NULL && strstr(run_name, options->filter) == NULL)
+  {
+    return;
+  }
+
+  // Grow the iteration count until a run takes min_time, aiming 40 % over it like Google Benchmark
+  uint64_t iterations = 1;
+  uint64_t min_ns     = (uint64_t)(options->min_time_s * 1e9);
+
+  while (true)
+  {
+    memset(&state, 0, sizeof(state));
+    state.iterations = iterations;
+    state.arg        = arg;
+    bench->function(&state);
+
+    if (state.real_ns >= min_ns || iterations >= MAX_ITERATIONS)
+    {
+      break;
+    }
+
+    double multiplier = (state.real_ns > 0) ? 1.4 * (double)min_ns / (double)state.real_ns : 10.0;
+
+    multiplier = (multiplier > 10.0) ? 10.0 : (multiplier < 1.1 ? 1.1 : multiplier);
+    iterations = (uint64_t)((double)iterations * multiplier) + 1;
+  }
+
+  bench_result_t reps[64];
+  int            repetitions = (options->repetitions > 64) ? 64 : options->repetitions;
+
+  for (int r = 0; r < repetitions; r++)
+  {
+    // The sizing run counts as the first repetition
+    if (r > 0)
+    {
+      memset(&state, 0, sizeof(state));
+      state.iterations = iterations;
+      state.arg        = arg;
+      bench->function(&state);
+    }
+
+    bench_result_t *result = add_result(run_name, run_name, NULL);
+    result->repetition = r;
+    result->iterations = state.iterations;
+    result->real_ns    = (double)state.real_ns / (double)state.iterations;
+    result->cpu_ns     = (double)state.cpu_ns / (double)state.iterations;
+    result->cycles     = (double)state.cycles / (double)state.iterations;
+    result->has_cycles = state.has_cycles;
+    reps[r]            = *result;
+    print_result(result);
+  }
+
+  if (repetitions > 1)
+  {
+    add_aggregates(run_name, reps, repetitions);
+  }
+}
+
+
+static bool write_json(const char *path, const char *executable, const options_t *options)
+{
+  FILE *out = fopen(path, "w");
+
+  if (out == NULL)
+  {
+    return false;
+  }
+
+  char      date[32];
+  char      host[64] = "";
+  time_t    now      = time(NULL);
+  struct tm local;
+
+  localtime_r(&now, &local);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", &local);
+  gethostname(host, sizeof(host) - 1);
+
+  fprintf(out, "{\n  \"context\": {\n");
+  fprintf(out, "    \"date\": \"%s\",\n", date);
+  fprintf(out, "    \"host_name\": \"%s\",\n", host);
+  fprintf(out, "    \"executable\": \"%s\",\n", executable);
+  fprintf(out, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+  fprintf(out, "    \"mhz_per_cpu\": 0,\n");
+  fprintf(out, "    \"cpu_scaling_enabled\": false,\n");
+  fprintf(out, "    \"caches\": [],\n");
+  fprintf(out, "    \"library_build_type\": \"release\",\n");
+  fprintf(out, "    \"min_time_s\": %g,\n", options->min_time_s);
+  fprintf(out, "    \"cycle_counter\": %s\n", (cycle_counter >= 0) ? "true" : "false");
+  fprintf(out, "  },\n  \"benchmarks\": [\n");
+
+  for (int i = 0; i < num_results; i++)
+  {
+    const bench_result_t *result = &results[i];
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": \"%s\",\n", result->name);
+    fprintf(out, "      \"run_name\": \"%s\",\n", result->run_name);
+    fprintf(out, "      \"run_type\": \"%s\",\n", (result->aggregate != NULL) ? "aggregate" : "iteration");
+    fprintf(out, "      \"repetitions\": %d,\n", options->repetitions);
+    if (result->aggregate != NULL)
+    {
+      fprintf(out, "      \"aggregate_name\": \"%s\",\n", result->aggregate);
+    }
+    else
+    {
+      fprintf(out, "      \"repetition_index\": %d,\n", result->repetition);
+    }
+    fprintf(out, "      \"threads\": 1,\n");
+    fprintf(out, "      \"iterations\": %llu,\n", (unsigned long long)result->iterations);
+    fprintf(out, "      \"real_time\": %.4f,\n", result->real_ns);
+    fprintf(out, "      \"cpu_time\": %.4f,\n", result->cpu_ns);
+    if (result->has_cycles)
+    {
+      fprintf(out, "      \"cycles\": %.1f,\n", result->cycles);
+    }
+    fprintf(out, "      \"time_unit\": \"ns\"\n");
+    fprintf(out, "    }%s\n", (i + 1 < num_results) ? "," : "");
+  }
+
+  fprintf(out, "  ]\n}\n");
+
+  return fclose(out) == 0;
+}
+
+
+static void usage(const char *argv0)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --filter TEXT      only run benchmarks whose name contains TEXT\n"
+          "  --min-time S       minimum time per repetition, default 0.2\n"
+          "  --repetitions N    timed runs per benchmark, default 3 (max 64)\n"
+          "  --json PATH        write the results in Google Benchmark JSON format\n"
+          "  --list             list the benchmarks\n",
+          argv0);
+}
+
+
+int main(int argc, char *argv[])
+{
+  options_t options = {NULL, NULL, 0.2, 3};
+  bool      list    = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool has_value = (i + 1 < argc);
+
+    if (strcmp(argv[i], "--filter") == 0 && has_value)
+    {
+      options.filter = argv[++i];
+    }
+    else if (strcmp(argv[i], "--min-time") == 0 && has_value)
+    {
+      options.min_time_s = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--repetitions") == 0 && has_value)
+    {
+      options.repetitions = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--json") == 0 && has_value)
+    {
+      options.json_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--list") == 0)
+    {
+      list = true;
+    }
+    else
+    {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (options.repetitions < 1 || options.min_time_s < 0.0)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  size_t num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+  if (list)
+  {
+    for (size_t b = 0; b < num_benchmarks; b++)
+    {
+      for (int a = 0; a == 0 || (a < 4 && benchmarks[b].args[a] != 0); a++)
+      {
+        if (benchmarks[b].args[a] != 0)
+        {
+          printf("%s/%d\n", benchmarks[b].name, benchmarks[b].args[a]);
+        }
+        else
+        {
+          printf("%s\n", benchmarks[b].name);
+        }
+      }
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  cycle_counter_open();
+  if (cycle_counter < 0)
+  {
+    fprintf(stderr, "CPU cycle counter not available, reporting times only\n");
+  }
+
+  printf("%-40s %14s %14s %14s %12s\n", "Benchmark", "Time [ns]", "CPU [ns]", "Cycles", "Iterations");
+  printf("------------------------------------------------------------------------------------------------------\n");
+
+  for (size_t b = 0; b < num_benchmarks; b++)
+  {
+    for (int a = 0; a == 0 || (a < 4 && benchmarks[b].args[a] != 0); a++)
+    {
+      run_benchmark(&benchmarks[b], benchmarks[b].args[a], &options);
+    }
+  }
+
+  if (options.json_path != NULL && !write_json(options.json_path, argv[0], &options))
+  {
+    fprintf(stderr, "Could not write %s\n", options.json_path);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
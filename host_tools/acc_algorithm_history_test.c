@@ -0,0 +1,359 @@
+// host_tools/acc_algorithm_history_test.c
+//
+// Tests of the ring histories in xm125/Src/algorithms/acc_algorithm.c,
+// compiled for the host. The history functions replace the roll_and_push
+// matrices in the presence and breathing code, so every result has to match
+// the rolled matrix bit for bit: the same pushes, the same IIR filter outputs
+// (apply_filter) and the same Welch PSDs, for every position of the ring head.
+
+#include <complex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_algorithm.h"
+
+#define MAX_ROWS 128
+#define MAX_COLS 8
+#define MAX_SEGMENT 32
+
+#define CHECK(condition)                                                     \
+  do                                                                         \
+  {                                                                          \
+    if (!(condition))                                                        \
+    {                                                                        \
+      fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                            \
+    }                                                                        \
+  } while (0)
+
+static const uint16_t row_counts[] = { 1, 2, 5, 16, 33 };
+static const uint16_t col_counts[] = { 1, 3, 8 };
+
+static int      failures;
+static uint32_t random_state = 1U;
+
+static uint32_t random_u32(void)
+{
+  random_state = random_state * 1664525U + 1013904223U;
+  return random_state >> 8;
+}
+
+// Uniform in [-1, 1), with all mantissa bits in use
+static float random_float(void)
+{
+  return (float)random_u32() / 8388608.0f - 1.0f;
+}
+
+static void random_row_f32(float *row, uint16_t cols)
+{
+  for (uint16_t c = 0; c < cols; c++)
+  {
+    row[c] = random_float();
+  }
+}
+
+static void random_row_f32_complex(float complex *row, uint16_t cols)
+{
+  for (uint16_t c = 0; c < cols; c++)
+  {
+    row[c] = random_float() + random_float() * I;
+  }
+}
+
+// Unrolled history against a matrix rolled with pos_shift false, and every row by age
+// against a matrix rolled with pos_shift true
+static void check_history_f32(const acc_algorithm_history_t *history, const float *oldest_first, const float *newest_first)
+{
+  float unrolled[MAX_ROWS * MAX_COLS];
+  size_t row_size = history->cols * sizeof(float);
+
+  acc_algorithm_history_unroll(history, unrolled);
+  CHECK(memcmp(unrolled, oldest_first, history->rows * row_size) == 0);
+
+  for (uint16_t age = 0; age < history->rows; age++)
+  {
+    CHECK(memcmp(acc_algorithm_history_recent(history, age), &newest_first[age * history->cols], row_size) == 0);
+    CHECK(acc_algorithm_history_row(history, history->rows - 1U - age) == acc_algorithm_history_recent(history, age));
+  }
+}
+
+static void test_push_row_f32(void)
+{
+  static float data[MAX_ROWS * MAX_COLS];
+  static float oldest_first[MAX_ROWS * MAX_COLS];
+  static float newest_first[MAX_ROWS * MAX_COLS];
+
+  for (size_t ri = 0; ri < sizeof(row_counts) / sizeof(row_counts[0]); ri++)
+  {
+    for (size_t ci = 0; ci < sizeof(col_counts) / sizeof(col_counts[0]); ci++)
+    {
+      uint16_t                rows = row_counts[ri];
+      uint16_t                cols = col_counts[ci];
+      acc_algorithm_history_t history;
+
+      acc_algorithm_history_init(&history, data, rows, cols, sizeof(float));
+      memset(oldest_first, 0, sizeof(oldest_first));
+      memset(newest_first, 0, sizeof(newest_first));
+      check_history_f32(&history, oldest_first, newest_first);
+
+      // Three times around the ring, so every head position is checked
+      for (int push = 0; push < 3 * rows + 1; push++)
+      {
+        float row[MAX_COLS];
+        random_row_f32(row, cols);
+
+        acc_algorithm_roll_and_push_matrix_f32(oldest_first, rows, cols, row, false);
+        acc_algorithm_roll_and_push_matrix_f32(newest_first, rows, cols, row, true);
+
+        // push_row and push followed by writing the row in place are the same
+        if (push % 2 == 0)
+        {
+          acc_algorithm_history_push_row(&history, row);
+        }
+        else
+        {
+          memcpy(acc_algorithm_history_push(&history), row, cols * sizeof(float));
+        }
+
+        check_history_f32(&history, oldest_first, newest_first);
+      }
+
+      acc_algorithm_history_reset(&history);
+      memset(oldest_first, 0, sizeof(oldest_first));
+      memset(newest_first, 0, sizeof(newest_first));
+      check_history_f32(&history, oldest_first, newest_first);
+    }
+  }
+}
+
+static void test_push_row_f32_complex(void)
+{
+  static float complex data[MAX_ROWS * MAX_COLS];
+  static float complex matrix[MAX_ROWS * MAX_COLS];
+  static float complex unrolled[MAX_ROWS * MAX_COLS];
+
+  for (size_t ri = 0; ri < sizeof(row_counts) / sizeof(row_counts[0]); ri++)
+  {
+    for (size_t ci = 0; ci < sizeof(col_counts) / sizeof(col_counts[0]); ci++)
+    {
+      uint16_t                rows = row_counts[ri];
+      uint16_t                cols = col_counts[ci];
+      acc_algorithm_history_t history;
+
+      acc_algorithm_history_init(&history, data, rows, cols, sizeof(float complex));
+      memset(matrix, 0, sizeof(matrix));
+
+      for (int push = 0; push < 3 * rows + 1; push++)
+      {
+        float complex row[MAX_COLS];
+        random_row_f32_complex(row, cols);
+
+        acc_algorithm_roll_and_push_matrix_f32_complex(matrix, rows, cols, row, false);
+        acc_algorithm_history_push_row(&history, row);
+
+        acc_algorithm_history_unroll(&history, unrolled);
+        CHECK(memcmp(unrolled, matrix, rows * cols * sizeof(float complex)) == 0);
+
+        // The view is the unrolled history without the copy
+        acc_algorithm_history_view_t view;
+        acc_algorithm_history_view(&history, &view);
+        CHECK(view.rows[0] + view.rows[1] == rows);
+        CHECK(memcmp(view.segment[0], matrix, view.rows[0] * cols * sizeof(float complex)) == 0);
+        CHECK(view.rows[1] == 0 ||
+              memcmp(view.segment[1], &matrix[view.rows[0] * cols], view.rows[1] * cols * sizeof(float complex)) == 0);
+      }
+    }
+  }
+}
+
+static void test_push_rows_i16_complex(void)
+{
+  static acc_int16_complex_t data[MAX_ROWS * MAX_COLS];
+  static acc_int16_complex_t matrix[MAX_ROWS * MAX_COLS];
+  static acc_int16_complex_t unrolled[MAX_ROWS * MAX_COLS];
+  static acc_int16_complex_t frame[(MAX_ROWS + 2) * MAX_COLS];
+
+  for (size_t ri = 0; ri < sizeof(row_counts) / sizeof(row_counts[0]); ri++)
+  {
+    for (size_t ci = 0; ci < sizeof(col_counts) / sizeof(col_counts[0]); ci++)
+    {
+      uint16_t                rows = row_counts[ri];
+      uint16_t                cols = col_counts[ci];
+      acc_algorithm_history_t history;
+
+      acc_algorithm_history_init(&history, data, rows, cols, sizeof(acc_int16_complex_t));
+      memset(matrix, 0, sizeof(matrix));
+
+      // Frames shorter than, as long as and longer than the history
+      for (uint16_t frame_rows = 1; frame_rows <= rows + 2U; frame_rows++)
+      {
+        for (int i = 0; i < frame_rows * cols; i++)
+        {
+          frame[i].real = (int16_t)random_u32();
+          frame[i].imag = (int16_t)random_u32();
+        }
+
+        acc_algorithm_roll_and_push_mult_matrix_i16_complex(matrix, rows, cols, frame, frame_rows, false);
+        acc_algorithm_history_push_rows(&history, frame, frame_rows);
+
+        acc_algorithm_history_unroll(&history, unrolled);
+        CHECK(memcmp(unrolled, matrix, rows * cols * sizeof(acc_int16_complex_t)) == 0);
+      }
+    }
+  }
+}
+
+// A running IIR filter, the way the presence and breathing processing uses it: the output is
+// pushed into the filtered history, which feeds the next output
+static void test_apply_filter_f32(void)
+{
+  static const float b[] = { 0.0675f, 0.1349f, 0.0675f, 0.0f, 0.0f };
+  static const float a[] = { 1.0f, -1.1430f, 0.4128f, 0.0f, 0.0f };
+
+  for (uint16_t taps = 1; taps <= 5; taps++)
+  {
+    for (size_t ci = 0; ci < sizeof(col_counts) / sizeof(col_counts[0]); ci++)
+    {
+      uint16_t                cols = col_counts[ci];
+      float                   data_buffer[5 * MAX_COLS];
+      float                   filt_buffer[5 * MAX_COLS];
+      float                   data_matrix[5 * MAX_COLS] = { 0 };
+      float                   filt_matrix[5 * MAX_COLS] = { 0 };
+      acc_algorithm_history_t data_history;
+      acc_algorithm_history_t filt_history;
+
+      acc_algorithm_history_init(&data_history, data_buffer, taps, cols, sizeof(float));
+      acc_algorithm_history_init(&filt_history, filt_buffer, taps, cols, sizeof(float));
+
+      for (int step = 0; step < 4 * taps + 3; step++)
+      {
+        float row[MAX_COLS];
+        float expected[MAX_COLS];
+        float output[MAX_COLS];
+
+        random_row_f32(row, cols);
+        acc_algorithm_roll_and_push_matrix_f32(data_matrix, taps, cols, row, true);
+        acc_algorithm_history_push_row(&data_history, row);
+
+        acc_algorithm_apply_filter_f32(a, filt_matrix, taps, cols, b, data_matrix, taps, cols, expected, cols);
+        acc_algorithm_apply_filter_history_f32(a, &filt_history, b, &data_history, output);
+        CHECK(memcmp(output, expected, cols * sizeof(float)) == 0);
+
+        acc_algorithm_roll_and_push_matrix_f32(filt_matrix, taps, cols, expected, true);
+        acc_algorithm_history_push_row(&filt_history, output);
+      }
+    }
+  }
+}
+
+static void test_apply_filter_f32_complex(void)
+{
+  static const float b[] = { 0.0036f, 0.0072f, 0.0036f };
+  static const float a[] = { 1.0f, -1.8227f, 0.8372f };
+
+  for (uint16_t taps = 1; taps <= 3; taps++)
+  {
+    for (size_t ci = 0; ci < sizeof(col_counts) / sizeof(col_counts[0]); ci++)
+    {
+      uint16_t                cols = col_counts[ci];
+      float complex           data_buffer[3 * MAX_COLS];
+      float complex           filt_buffer[3 * MAX_COLS];
+      float complex           data_matrix[3 * MAX_COLS] = { 0 };
+      float complex           filt_matrix[3 * MAX_COLS] = { 0 };
+      acc_algorithm_history_t data_history;
+      acc_algorithm_history_t filt_history;
+
+      acc_algorithm_history_init(&data_history, data_buffer, taps, cols, sizeof(float complex));
+      acc_algorithm_history_init(&filt_history, filt_buffer, taps, cols, sizeof(float complex));
+
+      for (int step = 0; step < 4 * taps + 3; step++)
+      {
+        float complex row[MAX_COLS];
+        float complex expected[MAX_COLS];
+        float complex output[MAX_COLS];
+
+        random_row_f32_complex(row, cols);
+        acc_algorithm_roll_and_push_matrix_f32_complex(data_matrix, taps, cols, row, true);
+        acc_algorithm_history_push_row(&data_history, row);
+
+        acc_algorithm_apply_filter_f32_complex(a, filt_matrix, taps, cols, b, data_matrix, taps, cols, expected, cols);
+        acc_algorithm_apply_filter_history_f32_complex(a, &filt_history, b, &data_history, output);
+        CHECK(memcmp(output, expected, cols * sizeof(float complex)) == 0);
+
+        acc_algorithm_roll_and_push_matrix_f32_complex(filt_matrix, taps, cols, expected, true);
+        acc_algorithm_history_push_row(&filt_history, output);
+      }
+    }
+  }
+}
+
+static void test_welch_history(void)
+{
+  static const uint16_t welch_rows[]   = { 32, 64, 100, 128 };
+  static const uint16_t length_shift[] = { 3, 4, 5 };
+
+  static float complex data[MAX_ROWS * MAX_COLS];
+  static float complex matrix[MAX_ROWS * MAX_COLS];
+  static float         expected[MAX_SEGMENT * MAX_COLS];
+  static float         psds[MAX_SEGMENT * MAX_COLS];
+
+  for (size_t ri = 0; ri < sizeof(welch_rows) / sizeof(welch_rows[0]); ri++)
+  {
+    for (size_t si = 0; si < sizeof(length_shift) / sizeof(length_shift[0]); si++)
+    {
+      uint16_t                rows           = welch_rows[ri];
+      uint16_t                cols           = 3;
+      uint16_t                segment_length = (uint16_t)(1U << length_shift[si]);
+      float                   window[MAX_SEGMENT];
+      float complex           data_buffer[MAX_SEGMENT];
+      float complex           fft_out[MAX_SEGMENT];
+      acc_algorithm_history_t history;
+
+      acc_algorithm_hann(segment_length, window);
+      acc_algorithm_history_init(&history, data, rows, cols, sizeof(float complex));
+      memset(matrix, 0, sizeof(matrix));
+
+      // Head positions 0 (a full turn) and a few inside the ring
+      for (int push = 0; push < rows + 7; push++)
+      {
+        float complex row[MAX_COLS];
+        random_row_f32_complex(row, cols);
+
+        acc_algorithm_roll_and_push_matrix_f32_complex(matrix, rows, cols, row, false);
+        acc_algorithm_history_push_row(&history, row);
+
+        if (push + 1 < rows && push % 5 != 0)
+        {
+          continue;
+        }
+
+        acc_algorithm_welch_matrix(matrix, rows, cols, segment_length, data_buffer, fft_out, expected, window,
+                                   length_shift[si], 10.0f);
+        acc_algorithm_welch_history(&history, segment_length, data_buffer, fft_out, psds, window, length_shift[si], 10.0f);
+        CHECK(memcmp(psds, expected, segment_length * cols * sizeof(float)) == 0);
+      }
+    }
+  }
+}
+
+int main(void)
+{
+  test_push_row_f32();
+  test_push_row_f32_complex();
+  test_push_rows_i16_complex();
+  test_apply_filter_f32();
+  test_apply_filter_f32_complex();
+  test_welch_history();
+
+  if (failures > 0)
+  {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  printf("All checks passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+// host_tools/acc_cfar_test.c
+//
+// Checks that acc_algorithm_calculate_cfar_sweep() and
+// acc_algorithm_calculate_mirrored_one_sided_cfar_sweep() in
+// xm125/Src/algorithms/acc_algorithm.c give the thresholds of the per-index
+// functions for every index, over window lengths, guard lengths, data lengths
+// and, for the mirrored CFAR, middle indexes.
+//
+// The sweeps slide their window sums, the per-index functions sum each window
+// again. On integer data every sum is exact, so the two have to match bit for
+// bit, and a window that is off by one bin shows up as a different threshold.
+// On noise the running sums round differently, so there the difference is held
+// to the rounding of one float sum over the whole sweep.
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_algorithm.h"
+
+#define MAX_LENGTH 300U
+#define MAX_WINDOW_LENGTH 12U
+#define MAX_HALF_GUARD_LENGTH 6U
+#define DENSE_LENGTH 64U // every data length up to here, then steps of LENGTH_STEP
+#define LENGTH_STEP 23U
+
+#define CHECK(condition)                                                     \
+  do                                                                         \
+  {                                                                          \
+    if (!(condition))                                                        \
+    {                                                                        \
+      fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                            \
+    }                                                                        \
+  } while (0)
+
+static int      failures;
+static uint32_t random_state = 1U;
+
+static uint32_t random_u32(void)
+{
+  random_state = random_state * 1664525U + 1013904223U;
+  return random_state >> 8;
+}
+
+// Integers in [-512, 511], so that every window sum is exact, or noise in [0, 100)
+static void fill(float *data, uint16_t length, int exact)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    data[i] = exact ? (float)((int32_t)(random_u32() & 1023U) - 512) : (float)random_u32() / 167772.16f;
+  }
+}
+
+static uint16_t next_length(uint16_t length)
+{
+  return (uint16_t)(length + ((length < DENSE_LENGTH) ? 1U : LENGTH_STEP));
+}
+
+static float max_abs(const float *data, uint16_t length)
+{
+  float max = 0.0f;
+
+  for (uint16_t i = 0; i < length; i++)
+  {
+    max = fmaxf(fabsf(data[i]), max);
+  }
+
+  return max;
+}
+
+// Bit for bit on exact data. Otherwise the same non-finite values and a difference below
+// the rounding of data_length additions at the data's scale, divided by divisor, plus the
+// rounding of the last operations on the threshold.
+static int thresholds_match(float sweep, float reference, int exact, uint16_t data_length, float scale, float divisor)
+{
+  if (exact || !isfinite(reference) || reference == FLT_MAX)
+  {
+    return memcmp(&sweep, &reference, sizeof(sweep)) == 0;
+  }
+
+  double bound = ((double)data_length * FLT_EPSILON * scale / divisor) + (4.0 * FLT_EPSILON * fabs(reference));
+
+  return fabs((double)sweep - (double)reference) <= bound;
+}
+
+static void test_cfar(int exact)
+{
+  static float data[MAX_LENGTH];
+  static float threshold[MAX_LENGTH];
+
+  const float sensitivity = 0.5f;
+
+  for (uint16_t data_length = 1; data_length <= MAX_LENGTH; data_length = next_length(data_length))
+  {
+    for (uint16_t window_length = 1; window_length <= MAX_WINDOW_LENGTH; window_length++)
+    {
+      for (uint16_t half_guard_length = 0; half_guard_length <= MAX_HALF_GUARD_LENGTH; half_guard_length++)
+      {
+        fill(data, data_length, exact);
+        acc_algorithm_calculate_cfar_sweep(data, data_length, window_length, half_guard_length, sensitivity, threshold);
+
+        float scale      = max_abs(data, data_length);
+        int   mismatches = 0;
+
+        for (uint16_t idx = 0; idx < data_length; idx++)
+        {
+          float reference =
+            acc_algorithm_calculate_cfar(data, data_length, window_length, half_guard_length, sensitivity, idx);
+
+          if (!thresholds_match(threshold[idx], reference, exact, data_length, scale, 1.0f))
+          {
+            if (mismatches == 0)
+            {
+              fprintf(stderr, "cfar%s length=%u window=%u guard=%u idx=%u: sweep %.9g, per index %.9g\n",
+                      exact ? " exact" : "", (unsigned)data_length, (unsigned)window_length,
+                      (unsigned)half_guard_length, (unsigned)idx, threshold[idx], reference);
+            }
+
+            mismatches++;
+          }
+        }
+
+        CHECK(mismatches == 0);
+      }
+    }
+  }
+}
+
+// The sweep needs both margins inside the data, and the callers take the middle as
+// rint(data_length / 2). One bin either side of it is checked too.
+static void test_mirrored_cfar(int exact)
+{
+  static float data[MAX_LENGTH];
+  static float threshold[MAX_LENGTH];
+
+  const float sensitivity = 0.15f;
+
+  for (uint16_t window_length = 1; window_length <= MAX_WINDOW_LENGTH; window_length++)
+  {
+    for (uint16_t half_guard_length = 0; half_guard_length <= MAX_HALF_GUARD_LENGTH; half_guard_length++)
+    {
+      uint16_t margin = window_length + half_guard_length;
+
+      for (uint16_t data_length = (uint16_t)(2U * margin + 3U); data_length <= MAX_LENGTH; data_length = next_length(data_length))
+      {
+        uint16_t middle = (uint16_t)rint((double)data_length / 2.0);
+
+        for (uint16_t middle_idx = middle - 1U; middle_idx <= middle + 1U; middle_idx++)
+        {
+          fill(data, data_length, exact);
+          acc_algorithm_calculate_mirrored_one_sided_cfar_sweep(data, data_length, middle_idx, window_length,
+                                                                half_guard_length, sensitivity, threshold);
+
+          float scale      = max_abs(data, data_length);
+          int   mismatches = 0;
+
+          for (uint16_t idx = 0; idx < data_length; idx++)
+          {
+            float reference = acc_algorithm_calculate_mirrored_one_sided_cfar(data, data_length, middle_idx, window_length,
+                                                                              half_guard_length, sensitivity, idx);
+
+            if (!thresholds_match(threshold[idx], reference, exact, data_length, scale,
+                                  (float)window_length * sensitivity))
+            {
+              if (mismatches == 0)
+              {
+                fprintf(stderr, "mirrored cfar%s length=%u middle=%u window=%u guard=%u idx=%u: sweep %.9g, per index %.9g\n",
+                        exact ? " exact" : "", (unsigned)data_length, (unsigned)middle_idx, (unsigned)window_length,
+                        (unsigned)half_guard_length, (unsigned)idx, threshold[idx], reference);
+              }
+
+              mismatches++;
+            }
+          }
+
+          CHECK(mismatches == 0);
+        }
+      }
+    }
+  }
+}
+
+int main(void)
+{
+  test_cfar(1);
+  test_cfar(0);
+  test_mirrored_cfar(1);
+  test_mirrored_cfar(0);
+
+  if (failures > 0)
+  {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  printf("All checks passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,373 @@
+// host_tools/acc_fft_test.c
+//
+// Tests of the STM32 FFT (xm125/Src/algorithms/acc_fft.c) and the
+// acc_algorithm_fft/rfft/_matrix wrappers around it, compiled for the host,
+// against a double precision DFT. Lengths 1 to 8192 cover the twiddle table
+// and the cosf/sinf fallback above ACC_FFT_TABLE_LENGTH_SHIFT, with zero
+// padded, truncated and strided input, in place transforms and both matrix
+// axes.
+//
+// The error is judged relative to the spectrum, in units of FLT_EPSILON *
+// log2(N), the growth of a float radix-2/4 FFT. Absolute errors scale with the
+// input, so a fixed absolute tolerance would only hold for one input level.
+
+#include <complex.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_algorithm.h"
+#include "acc_fft.h"
+
+#define MAX_LENGTH_SHIFT 13U
+#define MAX_LENGTH (1U << MAX_LENGTH_SHIFT)
+#define MAX_STRIDED_LENGTH_SHIFT 10U // strided and matrix cases, the DFT is O(N^2)
+#define MAX_COLS 10U
+// In FLT_EPSILON * log2(N). The worst case seen is about 0.3. The FFT that acc_fft replaced
+// reached 2 at N = 2048 and 15 at N = 8192 (rms), and would fail.
+#define ERROR_BOUND 1.0
+
+#define CHECK(condition)                                                     \
+  do                                                                         \
+  {                                                                          \
+    if (!(condition))                                                        \
+    {                                                                        \
+      fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                            \
+    }                                                                        \
+  } while (0)
+
+static int      failures;
+static uint32_t random_state = 1U;
+static double   worst_rms;
+static double   worst_peak;
+
+static double complex reference[MAX_LENGTH];
+static double complex twiddles[MAX_LENGTH];
+
+static uint32_t random_u32(void)
+{
+  random_state = random_state * 1664525U + 1013904223U;
+  return random_state >> 8;
+}
+
+// Uniform in [-1, 1), with all mantissa bits in use
+static float random_float(void)
+{
+  return (float)random_u32() / 8388608.0f - 1.0f;
+}
+
+// DFT of length n of the first length values at data[i * stride], zero padded or truncated to n
+static void dft_complex(const float complex *data, uint32_t length, uint32_t stride, uint32_t n)
+{
+  const double pi = 3.14159265358979323846;
+
+  for (uint32_t m = 0; m < n; m++)
+  {
+    twiddles[m] = cos(2.0 * pi * m / n) - sin(2.0 * pi * m / n) * I;
+  }
+
+  uint32_t count = (length < n) ? length : n;
+
+  for (uint32_t k = 0; k < n; k++)
+  {
+    double complex sum   = 0.0;
+    uint32_t       index = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+      sum   += (double complex)data[i * stride] * twiddles[index];
+      index += k;
+      if (index >= n)
+      {
+        index -= n;
+      }
+    }
+
+    reference[k] = sum;
+  }
+}
+
+static void dft_real(const float *data, uint32_t length, uint32_t stride, uint32_t n)
+{
+  static float complex complex_data[MAX_LENGTH + 8U];
+
+  for (uint32_t i = 0; i < length; i++)
+  {
+    complex_data[i] = data[i * stride];
+  }
+
+  dft_complex(complex_data, length, 1U, n);
+}
+
+// Normwise and largest error of count bins at output[k * stride] against the reference
+static void check_spectrum(const char *name, uint16_t length_shift, uint32_t length, const float complex *output, uint32_t stride,
+                           uint32_t count)
+{
+  double error_sum     = 0.0;
+  double reference_sum = 0.0;
+  double error_max     = 0.0;
+  double reference_max = 0.0;
+
+  for (uint32_t k = 0; k < count; k++)
+  {
+    double error     = cabs((double complex)output[k * stride] - reference[k]);
+    double magnitude = cabs(reference[k]);
+
+    error_sum     += error * error;
+    reference_sum += magnitude * magnitude;
+    error_max      = (error > error_max) ? error : error_max;
+    reference_max  = (magnitude > reference_max) ? magnitude : reference_max;
+  }
+
+  if (reference_sum == 0.0)
+  {
+    CHECK(error_max == 0.0);
+    return;
+  }
+
+  double unit = FLT_EPSILON * ((length_shift > 0U) ? length_shift : 1U);
+  double rms  = sqrt(error_sum / reference_sum) / unit;
+  double peak = (error_max / reference_max) / unit;
+
+  worst_rms  = (rms > worst_rms) ? rms : worst_rms;
+  worst_peak = (peak > worst_peak) ? peak : worst_peak;
+
+  if (rms > ERROR_BOUND || peak > ERROR_BOUND)
+  {
+    fprintf(stderr, "%s N=%u length=%u: error %.3g (rms) %.3g (peak) FLT_EPSILON * log2(N)\n", name, 1U << length_shift,
+            (unsigned)length, rms, peak);
+    failures++;
+  }
+}
+
+// Full length, zero padded and truncated input
+static uint32_t input_length(uint32_t n, int variant)
+{
+  switch (variant)
+  {
+    case 0:
+      return n;
+    case 1:
+      return (n * 3U / 4U) + 1U;
+    default:
+      return n + 5U;
+  }
+}
+
+static void test_complex(void)
+{
+  static float complex data[3U * (MAX_LENGTH + 8U)];
+  static float complex output[3U * MAX_LENGTH];
+
+  for (uint16_t length_shift = 0; length_shift <= MAX_LENGTH_SHIFT; length_shift++)
+  {
+    uint32_t       n = 1U << length_shift;
+    acc_fft_plan_t plan;
+
+    acc_fft_plan_init(&plan, length_shift);
+
+    for (uint32_t stride = 1; stride <= 3U; stride += 2U)
+    {
+      if (stride > 1U && length_shift > MAX_STRIDED_LENGTH_SHIFT)
+      {
+        continue;
+      }
+
+      for (int variant = 0; variant < 3; variant++)
+      {
+        uint32_t length = input_length(n, variant);
+
+        for (uint32_t i = 0; i < length * stride; i++)
+        {
+          data[i] = random_float() + random_float() * I;
+        }
+
+        acc_fft_complex(&plan, data, (uint16_t)length, (uint16_t)stride, output);
+        dft_complex(data, length, stride, n);
+        check_spectrum("acc_fft_complex", length_shift, length, output, stride, n);
+      }
+    }
+
+    // In place, with a DC offset like raw sweeps have
+    for (uint32_t i = 0; i < n; i++)
+    {
+      data[i] = (100.0f + random_float()) + random_float() * I;
+    }
+
+    dft_complex(data, n, 1U, n);
+    acc_fft_complex(&plan, data, (uint16_t)n, 1U, data);
+    check_spectrum("acc_fft_complex in place", length_shift, n, data, 1U, n);
+  }
+}
+
+static void test_real(void)
+{
+  static float         data[2U * (MAX_LENGTH + 8U)];
+  static float complex output[2U * (MAX_LENGTH / 2U + 1U)];
+
+  for (uint16_t length_shift = 1; length_shift <= MAX_LENGTH_SHIFT; length_shift++)
+  {
+    uint32_t       n = 1U << length_shift;
+    acc_fft_plan_t plan;
+
+    acc_fft_plan_init(&plan, length_shift);
+
+    for (uint32_t stride = 1; stride <= 2U; stride++)
+    {
+      if (stride > 1U && length_shift > MAX_STRIDED_LENGTH_SHIFT)
+      {
+        continue;
+      }
+
+      for (int variant = 0; variant < 3; variant++)
+      {
+        uint32_t length = input_length(n, variant);
+
+        for (uint32_t i = 0; i < length * stride; i++)
+        {
+          data[i] = (variant == 2) ? 100.0f + random_float() : random_float();
+        }
+
+        acc_fft_real(&plan, data, (uint16_t)length, (uint16_t)stride, output);
+        dft_real(data, length, stride, n);
+        check_spectrum("acc_fft_real", length_shift, length, output, stride, (n / 2U) + 1U);
+      }
+    }
+  }
+}
+
+// acc_fft_*_columns through acc_algorithm_fft_matrix/rfft_matrix with axis 0, and one
+// acc_fft_complex/acc_fft_real per row with axis 1
+static void test_matrix(void)
+{
+  static const uint16_t row_counts[] = { 1, 7, 64, 100 };
+  static const uint16_t col_counts[] = { 1, 3, MAX_COLS };
+
+  static float complex data[1024U * MAX_COLS];
+  static float         real_data[1024U * MAX_COLS];
+  static float complex output[1024U * MAX_COLS];
+  static float complex column[1024U];
+
+  for (size_t ri = 0; ri < sizeof(row_counts) / sizeof(row_counts[0]); ri++)
+  {
+    for (size_t ci = 0; ci < sizeof(col_counts) / sizeof(col_counts[0]); ci++)
+    {
+      uint16_t rows = row_counts[ri];
+      uint16_t cols = col_counts[ci];
+
+      for (uint32_t i = 0; i < (uint32_t)rows * cols; i++)
+      {
+        data[i]      = random_float() + random_float() * I;
+        real_data[i] = random_float();
+      }
+
+      // Axis 0, the smallest length that holds a column and, directly on acc_fft, a truncating one
+      uint16_t shift_0 = 0;
+      while ((1U << shift_0) < rows)
+      {
+        shift_0++;
+      }
+
+      for (uint16_t length_shift = (shift_0 > 0U) ? shift_0 - 1U : 0U; length_shift <= shift_0; length_shift++)
+      {
+        uint32_t       n = 1U << length_shift;
+        acc_fft_plan_t plan;
+
+        acc_fft_plan_init(&plan, length_shift);
+
+        if (length_shift == shift_0)
+        {
+          acc_algorithm_fft_matrix(data, rows, cols, length_shift, output, 0U);
+        }
+        else
+        {
+          acc_fft_complex_columns(&plan, data, rows, cols, output);
+        }
+
+        for (uint16_t c = 0; c < cols; c++)
+        {
+          dft_complex(&data[c], rows, cols, n);
+          check_spectrum("fft_matrix axis 0", length_shift, rows, &output[c], cols, n);
+        }
+
+        if (length_shift == 0U)
+        {
+          continue;
+        }
+
+        if (length_shift == shift_0)
+        {
+          acc_algorithm_rfft_matrix(real_data, rows, cols, length_shift, output, 0U);
+        }
+        else
+        {
+          acc_fft_real_columns(&plan, real_data, rows, cols, output);
+        }
+
+        for (uint16_t c = 0; c < cols; c++)
+        {
+          dft_real(&real_data[c], rows, cols, n);
+          check_spectrum("rfft_matrix axis 0", length_shift, rows, &output[c], cols, (n / 2U) + 1U);
+        }
+      }
+
+      // Axis 1, rows zero padded to the next length
+      uint16_t shift_1 = 1;
+      while ((1U << shift_1) < cols)
+      {
+        shift_1++;
+      }
+
+      uint32_t n = 1U << shift_1;
+
+      acc_algorithm_fft_matrix(data, rows, cols, shift_1, output, 1U);
+      for (uint16_t r = 0; r < rows; r++)
+      {
+        dft_complex(&data[r * cols], cols, 1U, n);
+        check_spectrum("fft_matrix axis 1", shift_1, cols, &output[r * n], 1U, n);
+      }
+
+      acc_algorithm_rfft_matrix(real_data, rows, cols, shift_1, output, 1U);
+      for (uint16_t r = 0; r < rows; r++)
+      {
+        dft_real(&real_data[r * cols], cols, 1U, n);
+        check_spectrum("rfft_matrix axis 1", shift_1, cols, &output[r * ((n / 2U) + 1U)], 1U, (n / 2U) + 1U);
+      }
+
+      // The vector wrappers, on the first column's length
+      acc_algorithm_fft(data, rows, shift_0, column);
+      dft_complex(data, rows, 1U, 1U << shift_0);
+      check_spectrum("acc_algorithm_fft", shift_0, rows, column, 1U, 1U << shift_0);
+
+      if (shift_0 > 0U)
+      {
+        acc_algorithm_rfft(real_data, rows, shift_0, column);
+        dft_real(real_data, rows, 1U, 1U << shift_0);
+        check_spectrum("acc_algorithm_rfft", shift_0, rows, column, 1U, (1U << shift_0) / 2U + 1U);
+      }
+    }
+  }
+}
+
+int main(void)
+{
+  test_complex();
+  test_real();
+  test_matrix();
+
+  printf("Largest error %.3f (rms) %.3f (peak) FLT_EPSILON * log2(N), bound %.1f\n", worst_rms, worst_peak, ERROR_BOUND);
+
+  if (failures > 0)
+  {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  printf("All checks passed\n");
+  return EXIT_SUCCESS;
+}
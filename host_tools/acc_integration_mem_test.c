@@ -0,0 +1,233 @@
+// host_tools/acc_integration_mem_test.c
+//
+// Tests of the STM32 memory pool in xm125/Src/integration/acc_integration_mem.c,
+// compiled for the host. The main case is the tracking window: every move
+// destroys and creates the detector, and may grow the sensor buffer, below
+// the sensor's memory. The pool has to reuse that memory, so the high water
+// mark must stop growing once every window shape has been seen.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "acc_integration.h"
+
+#define MOVES 10000
+#define HANDLE_BLOCKS 3
+#define SENSOR_BLOCKS 2
+#define BLOCK_OVERHEAD 16U // at most, header and alignment
+
+#define CHECK(condition)                                                     \
+  do                                                                         \
+  {                                                                          \
+    if (!(condition))                                                        \
+    {                                                                        \
+      fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+      failures++;                                                            \
+    }                                                                        \
+  } while (0)
+
+// Rough sizes of a distance detector for the tracking window and the wider search sweep
+static const size_t handle_sizes[2][HANDLE_BLOCKS] = { { 420, 1240, 96 }, { 610, 2050, 96 } };
+static const size_t buffer_sizes[2]                = { 3900, 6100 };
+static const size_t static_sizes[2]                = { 180, 260 };
+
+static int      failures;
+static uint32_t random_state = 1U;
+
+static uint32_t random_u32(void)
+{
+  random_state = random_state * 1664525U + 1013904223U;
+  return random_state >> 8;
+}
+
+static uint32_t mem_used(void)
+{
+  uint32_t used, high_water_mark, size;
+  acc_integration_mem_usage(&used, &high_water_mark, &size);
+  return used;
+}
+
+static uint32_t mem_high_water_mark(void)
+{
+  uint32_t used, high_water_mark, size;
+  acc_integration_mem_usage(&used, &high_water_mark, &size);
+  return high_water_mark;
+}
+
+static void create_handle(void *handle[HANDLE_BLOCKS], int shape)
+{
+  for (int i = 0; i < HANDLE_BLOCKS; i++)
+  {
+    handle[i] = acc_integration_mem_alloc(handle_sizes[shape][i]);
+    CHECK(handle[i] != NULL);
+  }
+}
+
+static void destroy_handle(void *handle[HANDLE_BLOCKS])
+{
+  // The SDK doesn't free in allocation order
+  for (int i = HANDLE_BLOCKS - 1; i >= 0; i--)
+  {
+    acc_integration_mem_free(handle[(i + 1) % HANDLE_BLOCKS]);
+  }
+}
+
+// Like move_detector_range() in jjh_v2.c, over a collection set up like acconeer_main_JJH_V2()
+static void test_tracking_moves(void)
+{
+  acc_integration_mem_mark_t mark = acc_integration_mem_mark();
+
+  void *config = acc_integration_mem_alloc(200);
+  void *handle[HANDLE_BLOCKS];
+  create_handle(handle, 0);
+  void   *buffer     = acc_integration_mem_alloc(buffer_sizes[0]);
+  size_t buffer_size = buffer_sizes[0];
+  void   *cal_static = acc_integration_mem_alloc(static_sizes[0]);
+  size_t static_size = static_sizes[0];
+  void   *sensor[SENSOR_BLOCKS];
+  sensor[0] = acc_integration_mem_alloc(310);
+  sensor[1] = acc_integration_mem_alloc(820);
+  CHECK(config != NULL && buffer != NULL && cal_static != NULL && sensor[0] != NULL && sensor[1] != NULL);
+
+  uint32_t settled_high_water_mark = 0U;
+
+  for (int move = 0; move < MOVES; move++)
+  {
+    // Both shapes first, then random moves between them
+    int shape = (move < 2) ? move : (int)(random_u32() % 2U);
+
+    destroy_handle(handle);
+    create_handle(handle, shape);
+
+    if (buffer_sizes[shape] > buffer_size)
+    {
+      acc_integration_mem_free(buffer);
+      buffer      = acc_integration_mem_alloc(buffer_sizes[shape]);
+      buffer_size = buffer_sizes[shape];
+      CHECK(buffer != NULL);
+    }
+
+    if (static_sizes[shape] > static_size)
+    {
+      acc_integration_mem_free(cal_static);
+      cal_static  = acc_integration_mem_alloc(static_sizes[shape]);
+      static_size = static_sizes[shape];
+      CHECK(cal_static != NULL);
+    }
+
+    if (move == 8)
+    {
+      settled_high_water_mark = mem_high_water_mark();
+    }
+  }
+
+  CHECK(mem_high_water_mark() == settled_high_water_mark);
+
+  // A freed block is reused by the next allocation it fits, so at most one block of every size
+  // used is in the pool at once. Only putting freed blocks back at the top needs more.
+  size_t bound = 200U + 310U + 820U + (5U + 2U * HANDLE_BLOCKS) * BLOCK_OVERHEAD;
+  for (int shape = 0; shape < 2; shape++)
+  {
+    for (int i = 0; i < HANDLE_BLOCKS; i++)
+    {
+      bound += handle_sizes[shape][i];
+    }
+    bound += buffer_sizes[shape] + static_sizes[shape];
+  }
+  CHECK(settled_high_water_mark <= bound);
+
+  // A reconfiguration gives everything back, also what was never freed
+  acc_integration_mem_release(mark);
+  CHECK(mem_used() == 0U);
+}
+
+static void test_free_blocks_merge(void)
+{
+  void *a = acc_integration_mem_alloc(100);
+  void *b = acc_integration_mem_alloc(100);
+  void *c = acc_integration_mem_alloc(100);
+  void *d = acc_integration_mem_alloc(100);
+
+  uint32_t high_water_mark = mem_high_water_mark();
+
+  acc_integration_mem_free(b);
+  acc_integration_mem_free(c);
+
+  // b and c with one of their headers
+  void *bc = acc_integration_mem_alloc(200);
+  CHECK(bc == b);
+  CHECK(mem_high_water_mark() == high_water_mark);
+
+  acc_integration_mem_free(a);
+  acc_integration_mem_free(bc);
+  acc_integration_mem_free(d);
+  CHECK(mem_used() == 0U);
+
+  // Free blocks at the end are given back
+  void *e = acc_integration_mem_alloc(400);
+  CHECK(e == a);
+  acc_integration_mem_free(e);
+}
+
+static void test_release_reused_block(void)
+{
+  void *old  = acc_integration_mem_alloc(64);
+  void *hole = acc_integration_mem_alloc(64);
+  void *top  = acc_integration_mem_alloc(64);
+  acc_integration_mem_free(hole);
+
+  uint32_t used = mem_used();
+
+  acc_integration_mem_mark_t mark = acc_integration_mem_mark();
+
+  // Allocated after the mark, but below older memory
+  void *reused = acc_integration_mem_alloc(64);
+  CHECK(reused == hole);
+  CHECK(acc_integration_mem_alloc(64) != NULL);
+
+  acc_integration_mem_release(mark);
+  CHECK(mem_used() == used);
+
+  // The same mark releases what was allocated after the previous release
+  CHECK(acc_integration_mem_alloc(32) != NULL);
+  acc_integration_mem_release(mark);
+  CHECK(mem_used() == used);
+
+  acc_integration_mem_free(old);
+  acc_integration_mem_free(top);
+  CHECK(mem_used() == 0U);
+}
+
+static void test_exhausted(void)
+{
+  uint32_t used, high_water_mark, size;
+  acc_integration_mem_usage(&used, &high_water_mark, &size);
+
+  CHECK(acc_integration_mem_alloc(size) == NULL);
+
+  void *all = acc_integration_mem_alloc(size - 8U);
+  CHECK(all != NULL);
+  CHECK(acc_integration_mem_alloc(1) == NULL);
+  acc_integration_mem_free(all);
+
+  CHECK(acc_integration_mem_calloc(SIZE_MAX / 2U, 4U) == NULL);
+}
+
+int main(void)
+{
+  test_tracking_moves();
+  test_free_blocks_merge();
+  test_release_reused_block();
+  test_exhausted();
+
+  if (failures > 0)
+  {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return EXIT_FAILURE;
+  }
+
+  printf("All checks passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+// host_tools/radar_log_decode.cpp
+//
+// Converts binary data files written with RADAR_MODE_BINARY_LOG (*_data.bin)
+// into CSV or a NumPy .npy array. See storage/BinaryLog.h for the format.
+//
+// CSV columns: epoch_ms,count,d1_m,s1_db,...,d5_m,s5_db (nan for missing
+// targets). Text lines logged in the data file (e.g. GPS fixes) are written as
+// "# " comment lines, so the CSV loads directly with
+// numpy.loadtxt(path, delimiter=",", skiprows=1).
+//
+// Times are the logger's RTC wall clock, converted to milliseconds since
+// 1970-01-01 as if the RTC was set to UTC.
+
+#include "CivilTime.h"
+#include "Npy.h"
+#include "storage/BinaryLog.h"
+#include "communication/RadarProtocol.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+  constexpr int NPY_COLUMNS = 2 + 2 * BINLOG_MAX_DISTANCES;
+
+  struct Options
+  {
+    const char *input = nullptr;
+    const char *csvPath = nullptr;
+    const char *npyPath = nullptr;
+    bool info = false;
+  };
+
+  struct Stats
+  {
+    size_t blocks = 0;
+    size_t samples = 0;
+    size_t textLines = 0;
+    size_t badBlocks = 0;
+    size_t skippedBytes = 0;
+  };
+
+  int64_t blockEpochMs(const BinaryLogBlockInfo &info)
+  {
+    return CivilTime::epochMs(info.year, info.month, info.day, info.hour, info.minute,
+                              info.second, info.millisecond);
+  }
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "Usage: %s [options] <file_data.bin>\n"
+            "  -o <file.csv>   write CSV (default: stdout)\n"
+            "  --npy <file>    write a float64 [N, %d] .npy array instead of CSV:\n"
+            "                  epoch_s, count, d1_m, s1_db, ..., d5_m, s5_db\n"
+            "  --info          print block summaries to stderr\n",
+            argv0, NPY_COLUMNS);
+  }
+
+  bool parseArgs(int argc, char **argv, Options *opt)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        opt->csvPath = argv[++i];
+      else if (strcmp(argv[i], "--npy") == 0 && i + 1 < argc)
+        opt->npyPath = argv[++i];
+      else if (strcmp(argv[i], "--info") == 0)
+        opt->info = true;
+      else if (argv[i][0] == '-')
+        return false;
+      else if (!opt->input)
+        opt->input = argv[i];
+      else
+        return false;
+    }
+    return opt->input != nullptr;
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  Options opt;
+  if (!parseArgs(argc, argv, &opt))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::ifstream in(opt.input, std::ios::binary);
+  if (!in)
+  {
+    fprintf(stderr, "Can't open %s\n", opt.input);
+    return 1;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  FILE *csv = nullptr;
+  if (!opt.npyPath)
+  {
+    csv = opt.csvPath ? fopen(opt.csvPath, "w") : stdout;
+    if (!csv)
+    {
+      fprintf(stderr, "Can't create %s\n", opt.csvPath);
+      return 1;
+    }
+    fprintf(csv, "epoch_ms,count");
+    for (int i = 1; i <= BINLOG_MAX_DISTANCES; i++)
+      fprintf(csv, ",d%d_m,s%d_db", i, i);
+    fprintf(csv, "\n");
+  }
+
+  std::vector<double> rows;
+  Stats stats;
+  size_t pos = 0;
+
+  // Blocks follow the text header; scan for the magic so a torn write from a
+  // power loss only costs the damaged block.
+  while (pos + BINLOG_BLOCK_HEADER_SIZE <= data.size())
+  {
+    BinaryLogBlockInfo info;
+    if (!BinaryLog::readBlockHeader(&data[pos], data.size() - pos, &info))
+    {
+      pos++;
+      stats.skippedBytes++;
+      continue;
+    }
+
+    const uint8_t *payload = &data[pos + BINLOG_BLOCK_HEADER_SIZE];
+    size_t available = data.size() - pos - BINLOG_BLOCK_HEADER_SIZE;
+    if (info.payloadSize > available ||
+        RadarProtocol::crc16(payload, info.payloadSize) != info.payloadCrc)
+    {
+      fprintf(stderr, "Bad block at offset %zu, resyncing\n", pos);
+      stats.badBlocks++;
+      pos++;
+      continue;
+    }
+
+    int64_t t = blockEpochMs(info);
+    if (opt.info)
+    {
+      char iso[40];
+      CivilTime::formatIso(t, iso, sizeof(iso));
+      fprintf(stderr, "block @%zu: %s, %u records, %u bytes, range %.2f-%.2f m, %.1f Hz, flags 0x%02X\n",
+              pos, iso, info.recordCount, info.payloadSize, info.start_m, info.end_m,
+              info.update_rate, info.mode_flags);
+    }
+
+    size_t off = 0;
+    uint16_t decoded = 0;
+    while (off < info.payloadSize)
+    {
+      BinaryLogRecord rec;
+      size_t used = BinaryLog::decodeRecord(payload + off, info.payloadSize - off, &rec);
+      if (used == 0)
+      {
+        fprintf(stderr, "Malformed record in block at offset %zu\n", pos);
+        break;
+      }
+      off += used;
+      decoded++;
+      t += rec.deltaMs;
+
+      if (rec.isText)
+      {
+        stats.textLines++;
+        if (csv)
+        {
+          char iso[40];
+          CivilTime::formatIso(t, iso, sizeof(iso));
+          fprintf(csv, "# %s %.*s\n", iso, rec.textLength, rec.text);
+        }
+        continue;
+      }
+
+      stats.samples++;
+      if (csv)
+      {
+        fprintf(csv, "%lld,%u", (long long)t, rec.sample.count);
+        for (int i = 0; i < BINLOG_MAX_DISTANCES; i++)
+        {
+          if (i < rec.sample.count)
+            fprintf(csv, ",%.3f,%.2f", rec.sample.distances_mm[i] / 1000.0,
+                    rec.sample.strengths_cdb[i] / 100.0);
+          else
+            fprintf(csv, ",nan,nan");
+        }
+        fprintf(csv, "\n");
+      }
+      else
+      {
+        rows.push_back(t / 1000.0);
+        rows.push_back(rec.sample.count);
+        for (int i = 0; i < BINLOG_MAX_DISTANCES; i++)
+        {
+          bool present = i < rec.sample.count;
+          rows.push_back(present ? rec.sample.distances_mm[i] / 1000.0 : NAN);
+          rows.push_back(present ? rec.sample.strengths_cdb[i] / 100.0 : NAN);
+        }
+      }
+    }
+
+    if (decoded != info.recordCount)
+    {
+      fprintf(stderr, "Block at offset %zu: header says %u records, decoded %u\n",
+              pos, info.recordCount, decoded);
+    }
+
+    stats.blocks++;
+    pos += BINLOG_BLOCK_HEADER_SIZE + info.payloadSize;
+  }
+
+  if (csv && csv != stdout)
+    fclose(csv);
+
+  if (opt.npyPath && !Npy::write(opt.npyPath, rows, NPY_COLUMNS))
+  {
+    fprintf(stderr, "Failed to write %s\n", opt.npyPath);
+    return 1;
+  }
+
+  fprintf(stderr, "%zu blocks, %zu samples, %zu text lines, %zu bad blocks, %zu bytes skipped\n",
+          stats.blocks, stats.samples, stats.textLines, stats.badBlocks, stats.skippedBytes);
+  return stats.badBlocks == 0 ? 0 : 1;
+}
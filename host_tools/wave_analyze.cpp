@@ -0,0 +1,420 @@
+// host_tools/wave_analyze.cpp
+//
+// Streaming wave/tide analysis of logger data files, the native replacement
+// for parse_wave_data() / detect_outliers() / plot_periodogram() in
+// ESP32_to_Python_GUI/sd_plotter.py. Files are memory-mapped and parsed with a
+// hand-written scanner, outliers are removed with a rolling median/IQR filter
+// in O(n log w), and the cleaned series can be written out along with a
+// Lomb-Scargle or Welch spectrum.
+//
+// Series columns: epoch_s, distance_m, strength_db
+// Spectrum columns: freq_hz, period_s, power, amplitude_m
+// Times are the logger's RTC wall clock as if it was set to UTC.
+
+#include "CivilTime.h"
+#include "Npy.h"
+#include "Spectrum.h"
+#include "WaveFilter.h"
+#include "WaveSeries.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+  constexpr int SERIES_COLUMNS = 3;
+  constexpr double DIRECT_WORK_WARNING = 1e10; // samples x frequencies
+
+  using Clock = std::chrono::steady_clock;
+
+  enum class Method
+  {
+    LombScargle,
+    LombScargleDirect,
+    Welch
+  };
+
+  struct Options
+  {
+    std::vector<const char *> inputs;
+    const char *seriesPath = nullptr;
+    const char *spectrumPath = nullptr;
+    Method method = Method::LombScargle;
+    int target = 1;
+    double start = 0.0;
+    double end = INFINITY;
+    double minStrength = -INFINITY;
+    size_t window = 13;
+    double iqrScale = 2.0;
+    double bin = 0.0;
+    double fmin = 1.0 / 30.0;
+    double fmax = 1.0;
+    double oversample = 4.0;
+    double segment = 0.0;
+  };
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "Usage: %s [options] <data file>...\n"
+            "  Data files are /DATA/*.txt or *.bin from the logger, in time order.\n"
+            "  -o <file>               cleaned series, .npy or CSV by extension:\n"
+            "                          epoch_s, distance_m, strength_db\n"
+            "  --spectrum <file.csv>   spectrum: freq_hz, period_s, power, amplitude_m\n"
+            "  --method <m>            ls (fast Lomb-Scargle, default), ls-direct, welch\n"
+            "  --target <n|strongest>  distance to use from multi-target lines (default 1)\n"
+            "  --start <s>, --end <s>  window in seconds after the first sample\n"
+            "  --min-strength <dB>     drop weaker measurements\n"
+            "  --window <n>            rolling outlier window in samples (default 13, 0 = off)\n"
+            "  --iqr <k>               outlier IQR multiplier (default 2.0)\n"
+            "  --bin <s>               average the cleaned series into s-second bins\n"
+            "  --fmin <Hz>, --fmax <Hz> spectrum range (default 0.0333 to 1.0)\n"
+            "  --oversample <x>        Lomb-Scargle frequency oversampling (default 4)\n"
+            "  --segment <s>           Welch segment length (default: whole series)\n",
+            argv0);
+  }
+
+  bool parseArgs(int argc, char **argv, Options *opt)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      bool hasValue = i + 1 < argc;
+      if (arg == "-o" && hasValue)
+        opt->seriesPath = argv[++i];
+      else if (arg == "--spectrum" && hasValue)
+        opt->spectrumPath = argv[++i];
+      else if (arg == "--method" && hasValue)
+      {
+        std::string m = argv[++i];
+        if (m == "ls")
+          opt->method = Method::LombScargle;
+        else if (m == "ls-direct")
+          opt->method = Method::LombScargleDirect;
+        else if (m == "welch")
+          opt->method = Method::Welch;
+        else
+          return false;
+      }
+      else if (arg == "--target" && hasValue)
+      {
+        std::string t = argv[++i];
+        opt->target = (t == "strongest") ? WaveSeriesFile::TARGET_STRONGEST : atoi(t.c_str());
+        if (t != "strongest" && opt->target < 1)
+          return false;
+      }
+      else if (arg == "--start" && hasValue)
+        opt->start = atof(argv[++i]);
+      else if (arg == "--end" && hasValue)
+        opt->end = atof(argv[++i]);
+      else if (arg == "--min-strength" && hasValue)
+        opt->minStrength = atof(argv[++i]);
+      else if (arg == "--window" && hasValue)
+        opt->window = strtoul(argv[++i], nullptr, 10);
+      else if (arg == "--iqr" && hasValue)
+        opt->iqrScale = atof(argv[++i]);
+      else if (arg == "--bin" && hasValue)
+        opt->bin = atof(argv[++i]);
+      else if (arg == "--fmin" && hasValue)
+        opt->fmin = atof(argv[++i]);
+      else if (arg == "--fmax" && hasValue)
+        opt->fmax = atof(argv[++i]);
+      else if (arg == "--oversample" && hasValue)
+        opt->oversample = atof(argv[++i]);
+      else if (arg == "--segment" && hasValue)
+        opt->segment = atof(argv[++i]);
+      else if (arg[0] == '-')
+        return false;
+      else
+        opt->inputs.push_back(argv[i]);
+    }
+    return !opt->inputs.empty() && opt->fmax > opt->fmin && opt->oversample > 0.0;
+  }
+
+  double secondsSince(Clock::time_point start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  bool endsWith(const char *s, const char *suffix)
+  {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+  }
+
+  /**
+   * @brief Keeps samples in the time window and above the strength threshold
+   */
+  WaveSeries selectSamples(const WaveSeries &in, const Options &opt, size_t *timeFiltered, size_t *weak)
+  {
+    WaveSeries out;
+    *timeFiltered = 0;
+    *weak = 0;
+    if (in.size() == 0)
+      return out;
+
+    double t0 = in.time_s.front();
+    for (size_t i = 0; i < in.size(); i++)
+    {
+      double seconds = in.time_s[i] - t0;
+      if (seconds < opt.start || seconds > opt.end)
+      {
+        (*timeFiltered)++;
+        continue;
+      }
+      if (in.strength_db[i] < opt.minStrength)
+      {
+        (*weak)++;
+        continue;
+      }
+      out.time_s.push_back(in.time_s[i]);
+      out.distance_m.push_back(in.distance_m[i]);
+      out.strength_db.push_back(in.strength_db[i]);
+    }
+    return out;
+  }
+
+  WaveSeries keepOnly(const WaveSeries &in, const std::vector<uint8_t> &keep)
+  {
+    WaveSeries out;
+    for (size_t i = 0; i < in.size(); i++)
+    {
+      if (!keep[i])
+        continue;
+      out.time_s.push_back(in.time_s[i]);
+      out.distance_m.push_back(in.distance_m[i]);
+      out.strength_db.push_back(in.strength_db[i]);
+    }
+    return out;
+  }
+
+  /**
+   * @brief Averages samples into fixed bins of binSeconds
+   *
+   * Each bin's time is the mean time of its samples, so sparse bins at the
+   * edges of a gap aren't shifted.
+   */
+  WaveSeries binAverage(const WaveSeries &in, double binSeconds)
+  {
+    WaveSeries out;
+    size_t i = 0;
+    while (i < in.size())
+    {
+      double bin = floor(in.time_s[i] / binSeconds);
+      double t = 0.0, d = 0.0, s = 0.0;
+      size_t count = 0;
+      for (; i < in.size() && floor(in.time_s[i] / binSeconds) == bin; i++, count++)
+      {
+        t += in.time_s[i];
+        d += in.distance_m[i];
+        s += in.strength_db[i];
+      }
+      out.time_s.push_back(t / count);
+      out.distance_m.push_back(d / count);
+      out.strength_db.push_back(s / count);
+    }
+    return out;
+  }
+
+  bool writeSeries(const char *path, const WaveSeries &series)
+  {
+    if (endsWith(path, ".npy"))
+    {
+      std::vector<double> values;
+      values.reserve(series.size() * SERIES_COLUMNS);
+      for (size_t i = 0; i < series.size(); i++)
+      {
+        values.push_back(series.time_s[i]);
+        values.push_back(series.distance_m[i]);
+        values.push_back(series.strength_db[i]);
+      }
+      return Npy::write(path, values, SERIES_COLUMNS);
+    }
+
+    FILE *f = fopen(path, "w");
+    if (!f)
+      return false;
+    fprintf(f, "epoch_s,distance_m,strength_db\n");
+    for (size_t i = 0; i < series.size(); i++)
+      fprintf(f, "%.3f,%.4f,%.2f\n", series.time_s[i], series.distance_m[i], series.strength_db[i]);
+    return fclose(f) == 0;
+  }
+
+  bool writeSpectrum(const char *path, const std::vector<SpectrumPoint> &spectrum)
+  {
+    FILE *f = fopen(path, "w");
+    if (!f)
+      return false;
+    fprintf(f, "freq_hz,period_s,power,amplitude_m\n");
+    for (const SpectrumPoint &p : spectrum)
+      fprintf(f, "%.6g,%.6g,%.6g,%.6g\n", p.frequency_hz, 1.0 / p.frequency_hz, p.power, p.amplitude_m);
+    return fclose(f) == 0;
+  }
+
+  std::vector<SpectrumPoint> computeSpectrum(const WaveSeries &series, const Options &opt)
+  {
+    std::vector<SpectrumPoint> spectrum;
+    if (opt.method == Method::Welch)
+    {
+      spectrum = Spectrum::welch(series.time_s, series.distance_m, opt.segment);
+    }
+    else if (opt.method == Method::LombScargle)
+    {
+      spectrum = Spectrum::lombScargleFast(series.time_s, series.distance_m, opt.oversample, opt.fmax);
+    }
+    else
+    {
+      double span = series.time_s.back() - series.time_s.front();
+      double df = 1.0 / (span * opt.oversample);
+      std::vector<double> frequencies;
+      for (size_t k = (size_t)ceil(opt.fmin / df); k * df <= opt.fmax; k++)
+      {
+        if (k > 0)
+          frequencies.push_back(k * df);
+      }
+      if ((double)series.size() * frequencies.size() > DIRECT_WORK_WARNING)
+        fprintf(stderr, "ls-direct: %zu samples x %zu frequencies, this will take a while\n",
+                series.size(), frequencies.size());
+      spectrum = Spectrum::lombScargleDirect(series.time_s, series.distance_m, frequencies);
+    }
+
+    // Keep [fmin, fmax]
+    std::vector<SpectrumPoint> inRange;
+    for (const SpectrumPoint &p : spectrum)
+    {
+      if (p.frequency_hz >= opt.fmin && p.frequency_hz <= opt.fmax)
+        inRange.push_back(p);
+    }
+    return inRange;
+  }
+
+  void formatPeriod(double seconds, char *out, size_t size)
+  {
+    if (seconds < 60.0)
+      snprintf(out, size, "%.1fs", seconds);
+    else if (seconds < 3600.0)
+      snprintf(out, size, "%.1fm", seconds / 60.0);
+    else
+      snprintf(out, size, "%.1fh", seconds / 3600.0);
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  Options opt;
+  if (!parseArgs(argc, argv, &opt))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  // Parse
+  Clock::time_point start = Clock::now();
+  WaveSeries raw;
+  WaveParseStats parse;
+  for (const char *path : opt.inputs)
+  {
+    std::string error;
+    if (!WaveSeriesFile::append(path, opt.target, &raw, &parse, &error))
+    {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+  }
+  if (WaveSeriesFile::sortByTime(&raw))
+    fprintf(stderr, "Input files were out of time order, samples sorted\n");
+  double parseS = secondsSince(start);
+
+  fprintf(stderr, "Parsed %zu files, %.1f MB in %.3f s (%.0f MB/s)\n", opt.inputs.size(),
+          parse.bytes / 1e6, parseS, parseS > 0.0 ? parse.bytes / 1e6 / parseS : 0.0);
+  fprintf(stderr, "  %zu samples, %zu no_dists, %zu bad lines, %zu other lines",
+          parse.samples, parse.noDists, parse.badLines, parse.otherLines);
+  if (parse.blocks || parse.badBlocks)
+    fprintf(stderr, ", %zu blocks, %zu bad blocks", parse.blocks, parse.badBlocks);
+  fprintf(stderr, "\n");
+
+  if (raw.size() == 0)
+  {
+    fprintf(stderr, "No samples found\n");
+    return 1;
+  }
+
+  char first[40], last[40];
+  CivilTime::formatIso((int64_t)llround(raw.time_s.front() * 1000.0), first, sizeof(first));
+  CivilTime::formatIso((int64_t)llround(raw.time_s.back() * 1000.0), last, sizeof(last));
+  fprintf(stderr, "  %s to %s (%.1f h)\n", first, last, (raw.time_s.back() - raw.time_s.front()) / 3600.0);
+
+  // Select and clean
+  size_t timeFiltered, weak;
+  WaveSeries series = selectSamples(raw, opt, &timeFiltered, &weak);
+  fprintf(stderr, "Selected %zu samples (%zu outside the time window, %zu below %.1f dB)\n",
+          series.size(), timeFiltered, weak, opt.minStrength);
+
+  if (opt.window > 0 && series.size() > 0)
+  {
+    start = Clock::now();
+    std::vector<uint8_t> keep;
+    OutlierStats outliers = WaveFilter::detectOutliers(series.distance_m, opt.window, opt.iqrScale, &keep);
+    double filterS = secondsSince(start);
+    series = keepOnly(series, keep);
+    fprintf(stderr, "Outliers: global IQR range %.3f to %.3f m, %zu global + %zu rolling removed (%.3f s)\n",
+            outliers.globalLow, outliers.globalHigh, outliers.globalOutliers, outliers.rollingOutliers, filterS);
+  }
+
+  if (opt.bin > 0.0)
+  {
+    series = binAverage(series, opt.bin);
+    fprintf(stderr, "Averaged into %zu bins of %.1f s\n", series.size(), opt.bin);
+  }
+
+  if (series.size() == 0)
+  {
+    fprintf(stderr, "No samples left\n");
+    return 1;
+  }
+
+  double sum = 0.0, minD = series.distance_m[0], maxD = series.distance_m[0];
+  for (double d : series.distance_m)
+  {
+    sum += d;
+    minD = std::min(minD, d);
+    maxD = std::max(maxD, d);
+  }
+  fprintf(stderr, "Distance: mean %.3f m, min %.3f m, max %.3f m\n", sum / series.size(), minD, maxD);
+
+  if (opt.seriesPath && !writeSeries(opt.seriesPath, series))
+  {
+    fprintf(stderr, "Failed to write %s\n", opt.seriesPath);
+    return 1;
+  }
+
+  if (!opt.spectrumPath)
+    return 0;
+
+  // Spectrum
+  start = Clock::now();
+  std::vector<SpectrumPoint> spectrum = computeSpectrum(series, opt);
+  double spectrumS = secondsSince(start);
+  fprintf(stderr, "Spectrum: %zu frequencies in %.3f s\n", spectrum.size(), spectrumS);
+
+  for (size_t peak : Spectrum::findPeaks(spectrum, 0.1, 5))
+  {
+    char period[16];
+    formatPeriod(1.0 / spectrum[peak].frequency_hz, period, sizeof(period));
+    fprintf(stderr, "  peak: period %s, freq %.3g Hz, amplitude %.3f m\n", period,
+            spectrum[peak].frequency_hz, spectrum[peak].amplitude_m);
+  }
+
+  if (!writeSpectrum(opt.spectrumPath, spectrum))
+  {
+    fprintf(stderr, "Failed to write %s\n", opt.spectrumPath);
+    return 1;
+  }
+  return 0;
+}
@@ -69,6 +69,132 @@ void acc_algorithm_roll_and_push_mult_matrix_i16_complex(acc_int16_complex_t *da
                                                          const acc_int16_complex_t *matrix, uint16_t matrix_rows, bool pos_shift);
 
 
+/**
+ * @brief History of the last rows pushed rows of cols elements
+ *
+ * Replaces the roll_and_push functions for long histories. The rows are kept
+ * in a ring, so a push writes one row and moves the head instead of moving
+ * every row. Row 0 is the oldest and row rows-1 the newest; physical row
+ * (head + row) % rows holds logical row 'row'.
+ *
+ * The buffer is owned by the caller, rows * cols elements of element_size bytes.
+ */
+typedef struct
+{
+	void     *data;
+	uint16_t rows;
+	uint16_t cols;
+	uint16_t element_size;
+	uint16_t head;
+} acc_algorithm_history_t;
+
+
+/**
+ * @brief The history in time order as at most two contiguous runs of rows
+ *
+ * Logical rows 0 .. rows[0]-1 start at segment[0], the remaining rows[1] at segment[1].
+ */
+typedef struct
+{
+	const void *segment[2];
+	uint16_t   rows[2];
+} acc_algorithm_history_view_t;
+
+
+/**
+ * @brief Initialize a history, filled with zeros
+ *
+ * @param[out] history The history
+ * @param[in] data Buffer of rows * cols elements
+ * @param[in] rows Number of rows, > 0
+ * @param[in] cols Number of elements in each row, > 0
+ * @param[in] element_size Size of an element in bytes
+ */
+void acc_algorithm_history_init(acc_algorithm_history_t *history, void *data, uint16_t rows, uint16_t cols, uint16_t element_size);
+
+
+/**
+ * @brief Fill the history with zeros
+ *
+ * @param[in, out] history The history
+ */
+void acc_algorithm_history_reset(acc_algorithm_history_t *history);
+
+
+/**
+ * @brief Drop the oldest row and return it as the newest row
+ *
+ * The caller writes the new row in place, cols elements.
+ *
+ * @param[in, out] history The history
+ * @return The newest row
+ */
+void *acc_algorithm_history_push(acc_algorithm_history_t *history);
+
+
+/**
+ * @brief Drop the oldest row and copy a new row last
+ *
+ * Same as acc_algorithm_roll_and_push_matrix_f32() with pos_shift false.
+ *
+ * @param[in, out] history The history
+ * @param[in] row The new row, cols elements
+ */
+void acc_algorithm_history_push_row(acc_algorithm_history_t *history, const void *row);
+
+
+/**
+ * @brief Drop the oldest rows and copy new rows last
+ *
+ * Same as acc_algorithm_roll_and_push_mult_matrix_i16_complex() with pos_shift false.
+ *
+ * @param[in, out] history The history
+ * @param[in] matrix The new rows, oldest first, num_rows * cols elements
+ * @param[in] num_rows Number of rows in matrix
+ */
+void acc_algorithm_history_push_rows(acc_algorithm_history_t *history, const void *matrix, uint16_t num_rows);
+
+
+/**
+ * @brief Get a row in time order
+ *
+ * @param[in] history The history
+ * @param[in] row Logical row, 0 is the oldest, < rows
+ * @return The row, cols elements
+ */
+void *acc_algorithm_history_row(const acc_algorithm_history_t *history, uint16_t row);
+
+
+/**
+ * @brief Get a row by age
+ *
+ * Row 'age' of a matrix rolled with pos_shift true.
+ *
+ * @param[in] history The history
+ * @param[in] age 0 is the newest row, < rows
+ * @return The row, cols elements
+ */
+void *acc_algorithm_history_recent(const acc_algorithm_history_t *history, uint16_t age);
+
+
+/**
+ * @brief Get the history in time order without copying
+ *
+ * @param[in] history The history
+ * @param[out] view The view
+ */
+void acc_algorithm_history_view(const acc_algorithm_history_t *history, acc_algorithm_history_view_t *view);
+
+
+/**
+ * @brief Copy the history to a matrix in time order
+ *
+ * @param[in] history The history
+ * @param[out] matrix Output matrix, rows * cols elements
+ */
+void acc_algorithm_history_unroll(const acc_algorithm_history_t *history, void *matrix);
+
+
 /**
  * @brief Unwraps a signal by changing elements which have an absolute difference from
  *        their predecessor of more than 2*pi to their period-complementary values.
@@ -79,6 +205,19 @@ void acc_algorithm_roll_and_push_mult_matrix_i16_complex(acc_int16_complex_t *da
 void acc_algorithm_unwrap(float *data, uint16_t data_length);
 
 
+/**
+ * @brief Unwrap one element against its predecessor
+ *
+ * Appending elements one by one gives the same series as acc_algorithm_unwrap(),
+ * without revisiting the elements already unwrapped.
+ *
+ * @param[in] previous The previous, unwrapped, element
+ * @param[in] element The new element
+ * @return The element moved by a multiple of 2*pi to within pi of previous
+ */
+float acc_algorithm_unwrap_element(float previous, float element);
+
+
 /**
  * @brief Find index of largest element in the array
  *
@@ -199,6 +338,38 @@ void acc_algorithm_apply_filter_f32_complex(const float *a, const float complex
                                             float complex *output, uint16_t output_length);
 
 
+/**
+ * @brief Apply filter coefficients to filtered data history and data history
+ *
+ * Same as acc_algorithm_apply_filter_f32() with row r of the matrices being
+ * the row of age r in the histories.
+ *
+ * @param[in] a Denominator of polynomial of the IIR filter, length == filt_history->rows
+ * @param[in] filt_history History of filtered data, float elements
+ * @param[in] b Numerator of polynomial of the IIR filter, length == history->rows
+ * @param[in] history History of data, float elements, same cols as filt_history
+ * @param[out] output Output filtered data array, length == cols
+ */
+void acc_algorithm_apply_filter_history_f32(const float *a, const acc_algorithm_history_t *filt_history, const float *b,
+                                            const acc_algorithm_history_t *history, float *output);
+
+
+/**
+ * @brief Apply filter coefficients to filtered data history and data history
+ *
+ * Same as acc_algorithm_apply_filter_f32_complex() with row r of the matrices
+ * being the row of age r in the histories.
+ *
+ * @param[in] a Denominator of polynomial of the IIR filter, length == filt_history->rows
+ * @param[in] filt_history History of filtered data, float complex elements
+ * @param[in] b Numerator of polynomial of the IIR filter, length == history->rows
+ * @param[in] history History of data, float complex elements, same cols as filt_history
+ * @param[out] output Output filtered data array, length == cols
+ */
+void acc_algorithm_apply_filter_history_f32_complex(const float *a, const acc_algorithm_history_t *filt_history, const float *b,
+                                                    const acc_algorithm_history_t *history, float complex *output);
+
+
 /**
  * @brief Calculate mean sweep of a frame from start_point to end_point
  *
@@ -467,6 +638,30 @@ void acc_algorithm_welch_matrix(const float complex *data,
                                 float               fs);
 
 
+/**
+ * @brief Estimate power spectral density (PSD) using Welch’s method along the rows of a history
+ *
+ * Same as acc_algorithm_welch_matrix() on the history in time order, read in place.
+ *
+ * @param[in] history History of float complex elements
+ * @param[in] segment_length Length of each segment
+ * @param[in] data_buffer Buffer used for calculations, length = segment_length
+ * @param[out] fft_out Array for fft output data, length = segment_length
+ * @param[out] psds Matrix for output data, size = (cols, segment_length)
+ * @param[in] window Desired window to use, length = segment_length
+ * @param[in] length_shift Integer that specifies the transform length N in accordance with N = 1 << length_shift and N >= segment_length
+ * @param[in] fs Sampling frequency
+ */
+void acc_algorithm_welch_history(const acc_algorithm_history_t *history,
+                                 uint16_t                      segment_length,
+                                 float complex                 *data_buffer,
+                                 float complex                 *fft_out,
+                                 float                         *psds,
+                                 const float                   *window,
+                                 uint16_t                      length_shift,
+                                 float                         fs);
+
+
 /**
  * @brief Estimate power spectral density using Welch’s method
  *
@@ -513,6 +708,29 @@ float acc_algorithm_calculate_cfar(const float *data,
                                    uint16_t    idx);
 
 
+/**
+ * @brief Calculate CFAR threshold for every index of the data
+ *
+ * Same thresholds as acc_algorithm_calculate_cfar() for idx in [0, data_length),
+ * in one pass with sliding window sums instead of summing both windows for
+ * every index. The running sums round differently, so the thresholds are equal
+ * bit for bit only when the window sums are exact, as for integer data.
+ *
+ * @param[in] data Array of data
+ * @param[in] data_length Length of the data array
+ * @param[in] window_length Number of frequency bins next to the CFAR guard from which the threshold level will be calculated
+ * @param[in] half_guard_length Number of frequency bins around the point of interest that is omitted when calculating the CFAR threshold
+ * @param[in] sensitivity Sensitivity of the CFAR threshold
+ * @param[out] threshold Threshold values, length = data_length
+ */
+void acc_algorithm_calculate_cfar_sweep(const float *data,
+                                        uint16_t    data_length,
+                                        uint16_t    window_length,
+                                        uint16_t    half_guard_length,
+                                        float       sensitivity,
+                                        float       *threshold);
+
+
 /**
  * @brief Calculate mirrored one sided CFAR threshold
  *
@@ -548,6 +766,32 @@ float acc_algorithm_calculate_mirrored_one_sided_cfar(const float *data,
                                                       uint16_t    idx);
 
 
+/**
+ * @brief Calculate mirrored one sided CFAR threshold for every index of the data
+ *
+ * Same thresholds as acc_algorithm_calculate_mirrored_one_sided_cfar() for idx in
+ * [0, data_length), with one pass for the minimum and sliding window sums, so
+ * linear in data_length instead of quadratic.
+ * The running sums round differently, so the thresholds are equal bit for bit
+ * only when the window sums are exact.
+ *
+ * @param[in] data Array of data
+ * @param[in] data_length Length of the data array
+ * @param[in] middle_idx Middle index
+ * @param[in] window_length Number of frequency bins next to the CFAR guard from which the threshold level will be calculated
+ * @param[in] half_guard_length Number of frequency bins around the point of interest that is omitted when calculating the CFAR threshold
+ * @param[in] sensitivity Sensitivity of the CFAR threshold
+ * @param[out] threshold Threshold values, length = data_length
+ */
+void acc_algorithm_calculate_mirrored_one_sided_cfar_sweep(const float *data,
+                                                           uint16_t    data_length,
+                                                           uint16_t    middle_idx,
+                                                           uint16_t    window_length,
+                                                           uint16_t    half_guard_length,
+                                                           float       sensitivity,
+                                                           float       *threshold);
+
+
 /**
  * @brief Find the index of the distance column containing the largest amplitude, disregarding amplitudes present in the slow zone
  *
@@ -674,9 +918,10 @@ void acc_algorithm_count_points_above_threshold(const float *matrix, uint16_t ro
 /**
  * @brief Calculate median of input data
  *
- * Median of data of even length is rounded down.
+ * Median of data of even length is rounded down. The median is found by
+ * selection rather than sorting, see acc_order_statistics_median_i16().
  *
- * @param[in] data Array of int16_t values
+ * @param[in, out] data Array of int16_t values, reordered
  * @param[in] length Length of data
  * @return The calculated median value
  */
@@ -686,7 +931,10 @@ int16_t acc_algorithm_median_i16(int16_t *data, uint16_t length);
 /**
  * @brief Calculate median of input data
  *
- * @param[in] data Array of float values
+ * The median is found by selection rather than sorting, see
+ * acc_order_statistics_median_f32().
+ *
+ * @param[in, out] data Array of float values, reordered
  * @param[in] length Length of data
  * @return The calculated median value
  */
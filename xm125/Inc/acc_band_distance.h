@@ -0,0 +1,120 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#ifndef ACC_BAND_DISTANCE_H_
+#define ACC_BAND_DISTANCE_H_
+
+#include <stdint.h>
+
+#include "acc_definitions_a121.h"
+#include "acc_definitions_common.h"
+
+
+/**
+ * Most bands a layout makes: coarse below, fine, coarse above
+ */
+#define ACC_BAND_DISTANCE_MAX_BANDS 3U
+
+/**
+ * Length of the work buffer needed for bands of at most max_num_points points
+ */
+#define ACC_BAND_DISTANCE_WORK_LENGTH(max_num_points) (2U * (max_num_points))
+
+
+/**
+ * @brief One band of a frame, measured as one subsweep
+ */
+typedef struct
+{
+	int32_t              start_point;
+	uint16_t             num_points;
+	uint16_t             step_length;
+	acc_config_profile_t profile;
+	uint16_t             data_offset; // of the subsweep in a sweep, from acc_processing_metadata_t
+} acc_band_distance_band_t;
+
+
+/**
+ * @brief A distance found in a frame
+ */
+typedef struct
+{
+	float   distance_m;
+	float   strength_db; // above the CFAR threshold
+	uint8_t band;
+} acc_band_distance_peak_t;
+
+
+/**
+ * @brief Lay out bands covering a range with a fine band inside it
+ *
+ * The fine band covers fine_start_m to fine_end_m. The rest of range_start_m
+ * to range_end_m is covered by coarse bands on the grid of the fine band's
+ * edges, so the point spacing only changes at the band edges. A part of the
+ * range shorter than one coarse step gets no band. Step lengths are lowered
+ * to a divisor or multiple of 24, which the sensor requires, and each band's
+ * profile is lowered if its start is too close for it, see
+ * acc_algorithm_select_profile().
+ *
+ * data_offset is not set, it comes from the processing metadata of the
+ * configuration made from the bands.
+ *
+ * @param[in] fine_start_m Start of the fine band
+ * @param[in] fine_end_m End of the fine band, > fine_start_m
+ * @param[in] fine_step_length Step length of the fine band, in base steps
+ * @param[in] fine_profile Profile of the fine band
+ * @param[in] range_start_m Start of the whole range
+ * @param[in] range_end_m End of the whole range
+ * @param[in] coarse_step_length Step length of the coarse bands, in base steps
+ * @param[in] coarse_profile Profile of the coarse bands
+ * @param[out] bands Bands in ascending distance, length >= ACC_BAND_DISTANCE_MAX_BANDS
+ * @return Number of bands, 0 if the fine band is empty
+ */
+uint8_t acc_band_distance_layout(float                    fine_start_m,
+                                 float                    fine_end_m,
+                                 uint16_t                 fine_step_length,
+                                 acc_config_profile_t     fine_profile,
+                                 float                    range_start_m,
+                                 float                    range_end_m,
+                                 uint16_t                 coarse_step_length,
+                                 acc_config_profile_t     coarse_profile,
+                                 acc_band_distance_band_t *bands);
+
+
+/**
+ * @brief Find the distances in a frame of bands
+ *
+ * Every band is processed on its own: the mean sweep amplitude in dB gets a
+ * CFAR threshold over a window and guard of one envelope FWHM each, one-sided
+ * at the band edges, and peaks above it are interpolated on the band's grid.
+ * A distance found in two bands within the larger FWHM of the two is kept
+ * from the band with the shorter step. The remaining distances are sorted by
+ * their strength above the threshold, which unlike the amplitude compares
+ * across profiles.
+ *
+ * @param[in] frame Frame data, sweeps_per_frame sweeps of sweep_data_length points
+ * @param[in] sweep_data_length Number of points in a sweep, all bands
+ * @param[in] sweeps_per_frame Number of sweeps in the frame
+ * @param[in] bands The bands of the frame
+ * @param[in] num_bands Number of bands
+ * @param[in] threshold_sensitivity Sensitivity in [0, 1], higher finds weaker distances
+ * @param[out] work Work buffer, length >= ACC_BAND_DISTANCE_WORK_LENGTH(largest num_points)
+ * @param[out] peaks Distances, strongest first
+ * @param[in] max_peaks Length of peaks
+ * @return Number of distances in peaks
+ */
+uint16_t acc_band_distance_process(const acc_int16_complex_t      *frame,
+                                   uint16_t                       sweep_data_length,
+                                   uint16_t                       sweeps_per_frame,
+                                   const acc_band_distance_band_t *bands,
+                                   uint8_t                        num_bands,
+                                   float                          threshold_sensitivity,
+                                   float                          *work,
+                                   acc_band_distance_peak_t       *peaks,
+                                   uint16_t                       max_peaks);
+
+
+#endif
@@ -0,0 +1,108 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#ifndef ACC_ENERGY_ESTIMATE_H_
+#define ACC_ENERGY_ESTIMATE_H_
+
+#include <stdint.h>
+
+#include "acc_definitions_a121.h"
+
+
+/**
+ * @brief Time and current model of one wakeup
+ *
+ * The sensor part, prepare to read, is active sensor and MCU. The MCU part,
+ * processing and sending, is the MCU alone. Both take an offset plus a time
+ * per measured point, times a scale calibrated from measured wakeups with
+ * @ref acc_energy_model_calibrate. Between wakeups only the sleep current flows.
+ */
+typedef struct
+{
+	float    sensor_offset_ms;
+	float    sensor_us_per_point;
+	float    sensor_scale;
+	float    mcu_offset_ms;
+	float    mcu_us_per_point;
+	float    mcu_scale;
+	float    sensor_ma;
+	float    mcu_ma;
+	float    sleep_ma;
+	uint32_t calibrations;
+} acc_energy_model_t;
+
+
+/**
+ * @brief Predicted time and energy of a configuration
+ */
+typedef struct
+{
+	float sensor_ms;      // per wakeup
+	float mcu_ms;         // per wakeup
+	float sleep_ms;       // per wakeup, 0 if the wakeup is longer than the period
+	float update_rate_hz; // lower than asked for if the wakeup is longer than the period
+	float average_ma;
+	float battery_life_days;
+} acc_energy_estimate_t;
+
+
+/**
+ * @brief Set up a model with uncalibrated defaults
+ *
+ * @param[out] model The model
+ * @param[in] sensor_ma Current while the sensor measures, MCU included
+ * @param[in] mcu_ma Current while the MCU runs alone
+ * @param[in] sleep_ma Current between wakeups
+ */
+void acc_energy_model_init(acc_energy_model_t *model, float sensor_ma, float mcu_ma, float sleep_ma);
+
+
+/**
+ * @brief Approximate number of points the distance detector measures over a range
+ *
+ * The detector lowers the profile close to the sensor and uses about four
+ * points per envelope FWHM, at most max_step_length base steps apart.
+ *
+ * @param[in] start_m Start of the range
+ * @param[in] end_m End of the range
+ * @param[in] max_step_length Longest step length, 0 for no limit
+ * @param[in] max_profile Highest profile
+ * @return Number of points
+ */
+uint32_t acc_energy_detector_points(float start_m, float end_m, uint16_t max_step_length, acc_config_profile_t max_profile);
+
+
+/**
+ * @brief Calibrate the model with a measured wakeup
+ *
+ * Moves the scales a part of the way to what makes the model match, so a
+ * single odd wakeup doesn't swing it.
+ *
+ * @param[in, out] model The model
+ * @param[in] points Points measured per wakeup
+ * @param[in] sensor_ms Measured sensor time per wakeup
+ * @param[in] mcu_ms Measured MCU time per wakeup
+ */
+void acc_energy_model_calibrate(acc_energy_model_t *model, uint32_t points, float sensor_ms, float mcu_ms);
+
+
+/**
+ * @brief Predict time and energy of a configuration
+ *
+ * @param[in] model The model
+ * @param[in] points Points measured per wakeup
+ * @param[in] update_rate_hz Wakeups per second
+ * @param[in] battery_mah Battery capacity
+ * @param[out] estimate The prediction
+ */
+void acc_energy_estimate(const acc_energy_model_t *model,
+                         uint32_t                 points,
+                         float                    update_rate_hz,
+                         float                    battery_mah,
+                         acc_energy_estimate_t    *estimate);
+
+
+#endif
@@ -0,0 +1,106 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#ifndef ACC_FFT_H_
+#define ACC_FFT_H_
+
+#include <complex.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Largest transform length, as a shift, served from the twiddle table in flash
+ *
+ * Longer transforms compute their twiddles with cosf/sinf.
+ */
+#define ACC_FFT_TABLE_LENGTH_SHIFT (12U)
+
+
+/**
+ * @brief Plan for transforms of one length
+ *
+ * Twiddles are read from a quarter-wave cosine table in flash, so a plan
+ * holds no buffers and is cheap to set up; keep one per transform length
+ * to avoid repeating the setup for every transform.
+ */
+typedef struct
+{
+	uint16_t length_shift;
+	bool     use_table;
+} acc_fft_plan_t;
+
+
+/**
+ * @brief Set up a plan
+ *
+ * @param[out] plan The plan
+ * @param[in] length_shift Transform length N = 1 << length_shift, for real input >= 1
+ */
+void acc_fft_plan_init(acc_fft_plan_t *plan, uint16_t length_shift);
+
+
+/**
+ * @brief Fast Fourier Transform of complex input
+ *
+ * Iterative radix-4 decimation in time, with a final radix-2 pass for odd length shifts.
+ * Safe to run in place when data == output and data_length >= N.
+ *
+ * @param[in] plan Plan for the length N
+ * @param[in] data Input, data_length elements at data[n * stride]
+ * @param[in] data_length Number of input elements, zero padded to N if shorter, truncated if longer
+ * @param[in] stride Distance between elements of data and of output
+ * @param[out] output N output elements at output[k * stride]
+ */
+void acc_fft_complex(const acc_fft_plan_t *plan, const float complex *data, uint16_t data_length, uint16_t stride,
+                     float complex *output);
+
+
+/**
+ * @brief Fast Fourier Transform of real input
+ *
+ * The N real values are transformed as N/2 complex values followed by a split
+ * into the spectrum of the real input, half the work of a complex transform.
+ *
+ * @param[in] plan Plan for the length N, N >= 2
+ * @param[in] data Input, data_length elements at data[n * stride]
+ * @param[in] data_length Number of input elements, zero padded to N if shorter, truncated if longer
+ * @param[in] stride Distance between elements of data and of output
+ * @param[out] output (N / 2) + 1 output elements at output[k * stride]
+ */
+void acc_fft_real(const acc_fft_plan_t *plan, const float *data, uint16_t data_length, uint16_t stride, float complex *output);
+
+
+/**
+ * @brief Fast Fourier Transform of the columns of a complex matrix
+ *
+ * All columns are transformed together with the column as the innermost loop,
+ * so the matrix is read row by row instead of with one strided pass per column.
+ *
+ * @param[in] plan Plan for the length N
+ * @param[in] data Input matrix of size (rows, cols)
+ * @param[in] rows Number of rows, zero padded to N if fewer, truncated if more
+ * @param[in] cols Number of columns
+ * @param[out] output Output matrix of size (N, cols)
+ */
+void acc_fft_complex_columns(const acc_fft_plan_t *plan, const float complex *data, uint16_t rows, uint16_t cols, float complex *output);
+
+
+/**
+ * @brief Fast Fourier Transform of the columns of a real matrix
+ *
+ * See acc_fft_complex_columns() and acc_fft_real().
+ *
+ * @param[in] plan Plan for the length N, N >= 2
+ * @param[in] data Input matrix of size (rows, cols)
+ * @param[in] rows Number of rows, zero padded to N if fewer, truncated if more
+ * @param[in] cols Number of columns
+ * @param[out] output Output matrix of size ((N / 2) + 1, cols)
+ */
+void acc_fft_real_columns(const acc_fft_plan_t *plan, const float *data, uint16_t rows, uint16_t cols, float complex *output);
+
+
+#endif
@@ -12,6 +12,12 @@
 typedef void (*acc_integration_uart_read_func_t)(uint8_t data, uint32_t status);
 
 
+/**
+ * @brief A point in the order of allocations, see @ref acc_integration_mem_mark
+ */
+typedef uint32_t acc_integration_mem_mark_t;
+
+
 /**
  * @brief Sleep for a specified number of microseconds
  *
@@ -84,6 +90,36 @@ void *acc_integration_mem_calloc(size_t nmemb, size_t size);
 void acc_integration_mem_free(void *ptr);
 
 
+/**
+ * @brief Mark the current point in the order of allocations
+ *
+ * @return A mark for @ref acc_integration_mem_release
+ */
+acc_integration_mem_mark_t acc_integration_mem_mark(void);
+
+
+/**
+ * @brief Free everything allocated after a mark
+ *
+ * Makes sure all memory of a configuration is reclaimed when an application
+ * reconfigures, also memory that was never freed. None of it may be used after.
+ * A mark can be released again, which frees what was allocated since it then.
+ *
+ * @param[in]  mark A mark from @ref acc_integration_mem_mark
+ */
+void acc_integration_mem_release(acc_integration_mem_mark_t mark);
+
+
+/**
+ * @brief Get the usage of the dynamic memory
+ *
+ * @param[out] used Bytes allocated now, including overhead
+ * @param[out] high_water_mark Most of the pool in use so far, free blocks between allocations included
+ * @param[out] size Bytes available in total
+ */
+void acc_integration_mem_usage(uint32_t *used, uint32_t *high_water_mark, uint32_t *size);
+
+
 /**
  * Enter a critical section
  */
@@ -0,0 +1,89 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#ifndef ACC_INTEGRATION_PROFILE_H_
+#define ACC_INTEGRATION_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Number of bins in the duration histogram of a zone
+ */
+#define ACC_INTEGRATION_PROFILE_BINS 8U
+
+/**
+ * Upper limit of a histogram bin in microseconds, 8 us for the first and four times
+ * the previous for the next. The last bin has no upper limit.
+ */
+#define ACC_INTEGRATION_PROFILE_BIN_LIMIT_US(bin) (8UL << (2U * (bin)))
+
+
+/**
+ * @brief Durations of a named part of a program
+ *
+ * Set up with @ref acc_integration_profile_zone_reset before it is used.
+ */
+typedef struct
+{
+	const char *name;
+	uint32_t   count;
+	uint32_t   min_cycles;
+	uint32_t   max_cycles;
+	uint64_t   total_cycles;
+	uint32_t   histogram[ACC_INTEGRATION_PROFILE_BINS];
+	uint32_t   start_cycles;
+	bool       running;
+} acc_integration_profile_zone_t;
+
+
+/**
+ * @brief Start the cycle counter
+ *
+ * The counter stops in STOP mode, so a zone should not contain a sleep.
+ */
+void acc_integration_profile_init(void);
+
+
+/**
+ * @brief Clear the durations of a zone
+ *
+ * @param[in] zone The zone
+ * @param[in] name Name of the zone, kept by pointer
+ */
+void acc_integration_profile_zone_reset(acc_integration_profile_zone_t *zone, const char *name);
+
+
+/**
+ * @brief Begin a duration of a zone
+ *
+ * @param[in] zone The zone
+ */
+void acc_integration_profile_begin(acc_integration_profile_zone_t *zone);
+
+
+/**
+ * @brief End a duration of a zone and add it to the zone
+ *
+ * Does nothing if the zone was not begun. A duration must be shorter than
+ * the cycle counter wraps, 2^32 cycles.
+ *
+ * @param[in] zone The zone
+ */
+void acc_integration_profile_end(acc_integration_profile_zone_t *zone);
+
+
+/**
+ * @brief Convert cycles to microseconds
+ *
+ * @param[in] cycles Cycles of the core clock
+ * @return Microseconds
+ */
+uint32_t acc_integration_profile_cycles_to_us(uint64_t cycles);
+
+
+#endif
@@ -0,0 +1,167 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#ifndef ACC_ORDER_STATISTICS_H_
+#define ACC_ORDER_STATISTICS_H_
+
+#include <stdint.h>
+
+
+/**
+ * @brief Sliding window over the last N pushed values with cheap order statistics
+ *
+ * Keeps the window both in arrival order (a ring) and in ascending order.
+ * Median and quantile queries are O(1). A push is O(N): it finds the outgoing
+ * and incoming positions by binary search, O(log N) compares, and then moves
+ * the values between them, up to N - 1 of them. That is a memmove of a few
+ * hundred bytes for the windows of per-frame filters, with no sorting per
+ * frame, but a window of thousands of values wants a tree or heaps instead.
+ * Values must not be NaN.
+ *
+ * The buffers are owned by the caller, both of capacity elements.
+ */
+typedef struct
+{
+	float    *ring;
+	float    *sorted;
+	uint16_t capacity;
+	uint16_t count;
+	uint16_t head;
+} acc_order_statistics_window_t;
+
+
+/**
+ * @brief Get the k-th smallest value of data, 0-based
+ *
+ * Introselect: quickselect with median-of-three pivots, falling back to
+ * heapsort of the remaining range if partitioning degenerates, so it is
+ * O(length) on average and O(length * log(length)) at worst.
+ *
+ * @param[in, out] data Array of values, reordered so that data[k] is the k-th smallest,
+ *                      data[0..k-1] <= data[k] <= data[k+1..length-1]
+ * @param[in] length Length of data, > 0
+ * @param[in] k Order statistic to select, < length
+ * @return The k-th smallest value
+ */
+float acc_order_statistics_select_f32(float *data, uint16_t length, uint16_t k);
+
+
+/**
+ * @brief Get the k-th smallest value of data, 0-based
+ *
+ * See acc_order_statistics_select_f32().
+ *
+ * @param[in, out] data Array of values, reordered
+ * @param[in] length Length of data, > 0
+ * @param[in] k Order statistic to select, < length
+ * @return The k-th smallest value
+ */
+int16_t acc_order_statistics_select_i16(int16_t *data, uint16_t length, uint16_t k);
+
+
+/**
+ * @brief Calculate median of data by selection
+ *
+ * The mean of the two middle values for even length.
+ *
+ * @param[in, out] data Array of values, reordered
+ * @param[in] length Length of data, > 0
+ * @return The median
+ */
+float acc_order_statistics_median_f32(float *data, uint16_t length);
+
+
+/**
+ * @brief Calculate median of data by selection
+ *
+ * The mean of the two middle values for even length, truncated toward zero.
+ *
+ * @param[in, out] data Array of values, reordered
+ * @param[in] length Length of data, > 0
+ * @return The median
+ */
+int16_t acc_order_statistics_median_i16(int16_t *data, uint16_t length);
+
+
+/**
+ * @brief Calculate a quantile of data by selection
+ *
+ * Linear interpolation between the two nearest order statistics, the same
+ * as numpy.quantile(data, q).
+ *
+ * @param[in, out] data Array of values, reordered
+ * @param[in] length Length of data, > 0
+ * @param[in] q Quantile in [0, 1]
+ * @return The quantile
+ */
+float acc_order_statistics_quantile_f32(float *data, uint16_t length, float q);
+
+
+/**
+ * @brief Initialize an empty sliding window
+ *
+ * @param[out] window The window
+ * @param[in] ring_buffer Buffer for values in arrival order, capacity elements
+ * @param[in] sorted_buffer Buffer for values in ascending order, capacity elements
+ * @param[in] capacity Window length N, > 0
+ */
+void acc_order_statistics_window_init(acc_order_statistics_window_t *window,
+                                      float                         *ring_buffer,
+                                      float                         *sorted_buffer,
+                                      uint16_t                      capacity);
+
+
+/**
+ * @brief Remove all values from the window
+ *
+ * @param[in, out] window The window
+ */
+void acc_order_statistics_window_reset(acc_order_statistics_window_t *window);
+
+
+/**
+ * @brief Push a value, dropping the oldest one if the window is full
+ *
+ * O(log N) compares and up to N - 1 moved values.
+ *
+ * @param[in, out] window The window
+ * @param[in] value The new value, not NaN
+ */
+void acc_order_statistics_window_push(acc_order_statistics_window_t *window, float value);
+
+
+/**
+ * @brief Get the k-th smallest value in the window, 0-based
+ *
+ * @param[in] window The window
+ * @param[in] k Order statistic, < window->count
+ * @return The k-th smallest value
+ */
+float acc_order_statistics_window_kth(const acc_order_statistics_window_t *window, uint16_t k);
+
+
+/**
+ * @brief Get the median of the values in the window
+ *
+ * @param[in] window The window, not empty
+ * @return The median, the mean of the two middle values for an even count
+ */
+float acc_order_statistics_window_median(const acc_order_statistics_window_t *window);
+
+
+/**
+ * @brief Get a quantile of the values in the window
+ *
+ * Same interpolation as acc_order_statistics_quantile_f32().
+ *
+ * @param[in] window The window, not empty
+ * @param[in] q Quantile in [0, 1]
+ * @return The quantile
+ */
+float acc_order_statistics_window_quantile(const acc_order_statistics_window_t *window, float q);
+
+
+#endif
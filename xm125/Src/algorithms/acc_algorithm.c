@@ -9,11 +9,14 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "acc_alg_basic_utils.h"
 #include "acc_algorithm.h"
 #include "acc_definitions_a121.h"
 #include "acc_definitions_common.h"
+#include "acc_fft.h"
+#include "acc_order_statistics.h"
 
 #define DOUBLE_BUFFERING_MEAN_ABS_DEV_OUTLIER_TH 5
 
@@ -46,9 +49,6 @@ static void sum_i16_complex(const acc_int16_complex_t *data, uint16_t num_steps,
 static void mean_i16_complex(const acc_int16_complex_t *data, uint16_t num_steps, float complex *out, uint16_t stride);
 
 
-static void rfft(const float *data, uint16_t data_length, uint16_t length_shift, float complex *output, uint16_t stride);
-
-
 static void fftshift(float *data, uint16_t data_length, uint16_t stride);
 
 
@@ -61,7 +61,8 @@ static void welch(const float complex *data,
                   const float         *window,
                   uint16_t            length_shift,
                   float               fs,
-                  uint16_t            stride);
+                  uint16_t            stride,
+                  uint16_t            first);
 
 
 static void filter_inplace_apply(uint16_t    sample_idx,
@@ -71,36 +72,6 @@ static void filter_inplace_apply(uint16_t    sample_idx,
                                  float       *data);
 
 
-static float complex get_data_padded_f32_to_f32_complex(const float *data, uint16_t data_length, uint16_t index, uint16_t stride);
-
-
-static float complex get_data_padded_f32_complex(const float complex *data, uint16_t data_length, uint16_t index, uint16_t stride);
-
-
-static void small_rfft(const float *data, uint16_t data_length, uint16_t length_shift, float complex *output, uint16_t stride);
-
-
-static void small_fft(const float complex *data, uint16_t data_length, uint16_t length_shift, float complex *output, uint16_t stride);
-
-
-static void small_fft_transformation(uint16_t length_shift, float complex *output, uint16_t stride);
-
-
-static void small_rfft_real_symmetry_conversion(float complex *output, uint16_t length_shift, uint16_t stride);
-
-
-static void sort_i16(int16_t *array, uint16_t array_length);
-
-
-static void swap_i16(int16_t *array, uint16_t idx_a, uint16_t idx_b);
-
-
-static void sort_f32(float *array, uint16_t array_length);
-
-
-static void swap_f32(float *array, uint16_t idx_a, uint16_t idx_b);
-
-
 /**
  * @brief Interpolate function for Double buffering
  *
@@ -169,6 +140,22 @@ static void merge_peak_cluster(uint16_t       start_idx,
 static float max_measurable_dist(acc_config_prf_t prf);
 
 
+/**
+ * @brief Sum of data[start .. start + length - 1]
+ */
+static float window_sum(const float *data, uint16_t start, uint16_t length);
+
+
+/**
+ * @brief Get a row of a history by its index in the buffer
+ *
+ * @param[in] history The history
+ * @param[in] physical Row in the buffer, < rows
+ * @return The row
+ */
+static void *history_physical_row(const acc_algorithm_history_t *history, uint16_t physical);
+
+
 /**
  * Get profile by value
  *
@@ -308,26 +295,128 @@ void acc_algorithm_roll_and_push_mult_matrix_i16_complex(acc_int16_complex_t *da
 }
 
 
+void acc_algorithm_history_init(acc_algorithm_history_t *history, void *data, uint16_t rows, uint16_t cols, uint16_t element_size)
+{
+	history->data         = data;
+	history->rows         = rows;
+	history->cols         = cols;
+	history->element_size = element_size;
+	acc_algorithm_history_reset(history);
+}
+
+
+void acc_algorithm_history_reset(acc_algorithm_history_t *history)
+{
+	memset(history->data, 0, (size_t)history->rows * history->cols * history->element_size);
+	history->head = 0U;
+}
+
+
+void *acc_algorithm_history_push(acc_algorithm_history_t *history)
+{
+	/* The oldest row is overwritten and becomes the newest */
+	void *row = history_physical_row(history, history->head);
+
+	history->head = (history->head + 1U == history->rows) ? 0U : history->head + 1U;
+
+	return row;
+}
+
+
+void acc_algorithm_history_push_row(acc_algorithm_history_t *history, const void *row)
+{
+	memcpy(acc_algorithm_history_push(history), row, (size_t)history->cols * history->element_size);
+}
+
+
+void acc_algorithm_history_push_rows(acc_algorithm_history_t *history, const void *matrix, uint16_t num_rows)
+{
+	size_t        row_size = (size_t)history->cols * history->element_size;
+	const uint8_t *src     = matrix;
+
+	/* Rows that would be pushed out again before returning are skipped */
+	if (num_rows > history->rows)
+	{
+		src      += (size_t)(num_rows - history->rows) * row_size;
+		num_rows  = history->rows;
+	}
+
+	for (uint16_t r = 0U; r < num_rows; r++)
+	{
+		memcpy(acc_algorithm_history_push(history), &src[r * row_size], row_size);
+	}
+}
+
+
+void *acc_algorithm_history_row(const acc_algorithm_history_t *history, uint16_t row)
+{
+	uint16_t physical = history->head + row;
+
+	if (physical >= history->rows)
+	{
+		physical -= history->rows;
+	}
+
+	return history_physical_row(history, physical);
+}
+
+
+void *acc_algorithm_history_recent(const acc_algorithm_history_t *history, uint16_t age)
+{
+	return acc_algorithm_history_row(history, history->rows - 1U - age);
+}
+
+
+void acc_algorithm_history_view(const acc_algorithm_history_t *history, acc_algorithm_history_view_t *view)
+{
+	view->segment[0] = history_physical_row(history, history->head);
+	view->rows[0]    = history->rows - history->head;
+	view->segment[1] = history->data;
+	view->rows[1]    = history->head;
+}
+
+
+void acc_algorithm_history_unroll(const acc_algorithm_history_t *history, void *matrix)
+{
+	acc_algorithm_history_view_t view;
+	size_t                       row_size = (size_t)history->cols * history->element_size;
+	uint8_t                      *dst     = matrix;
+
+	acc_algorithm_history_view(history, &view);
+
+	memcpy(dst, view.segment[0], view.rows[0] * row_size);
+	memcpy(&dst[view.rows[0] * row_size], view.segment[1], view.rows[1] * row_size);
+}
+
+
 void acc_algorithm_unwrap(float *data, uint16_t data_length)
 {
 	for (uint16_t i = 1U; i < data_length; i++)
 	{
-		float diff = data[i] - data[i - 1U];
+		data[i] = acc_algorithm_unwrap_element(data[i - 1U], data[i]);
+	}
+}
 
-		while ((diff > (float)M_PI) || (diff < -(float)M_PI))
-		{
-			if (diff > (float)M_PI)
-			{
-				data[i] -= 2.0f * (float)M_PI;
-			}
-			else
-			{
-				data[i] += 2.0f * (float)M_PI;
-			}
 
-			diff = data[i] - data[i - 1U];
+float acc_algorithm_unwrap_element(float previous, float element)
+{
+	float diff = element - previous;
+
+	while ((diff > (float)M_PI) || (diff < -(float)M_PI))
+	{
+		if (diff > (float)M_PI)
+		{
+			element -= 2.0f * (float)M_PI;
+		}
+		else
+		{
+			element += 2.0f * (float)M_PI;
 		}
+
+		diff = element - previous;
 	}
+
+	return element;
 }
 
 
@@ -545,6 +634,76 @@ void acc_algorithm_apply_filter_f32_complex(const float *a, const float complex
 }
 
 
+void acc_algorithm_apply_filter_history_f32(const float *a, const acc_algorithm_history_t *filt_history, const float *b,
+                                            const acc_algorithm_history_t *history, float *output)
+{
+	uint16_t cols = history->cols;
+
+	for (uint16_t i = 0U; i < cols; i++)
+	{
+		output[i] = 0.0f;
+	}
+
+	/* Row by row, so that each output gets the same sequence of operations as with a rolled matrix */
+	for (uint16_t r = 0U; r < filt_history->rows; r++)
+	{
+		const float *filt_data = acc_algorithm_history_recent(filt_history, r);
+
+		for (uint16_t i = 0U; i < cols; i++)
+		{
+			output[i] -= a[r] * filt_data[i];
+		}
+	}
+
+	for (uint16_t r = 0U; r < history->rows; r++)
+	{
+		const float *data = acc_algorithm_history_recent(history, r);
+
+		for (uint16_t i = 0U; i < cols; i++)
+		{
+			output[i] += b[r] * data[i];
+		}
+	}
+}
+
+
+void acc_algorithm_apply_filter_history_f32_complex(const float *a, const acc_algorithm_history_t *filt_history, const float *b,
+                                                    const acc_algorithm_history_t *history, float complex *output)
+{
+	uint16_t cols = history->cols;
+
+	/* Real and imaginary parts are accumulated separately, a float complex is laid out as float[2] */
+	float *parts = (float *)output;
+
+	for (uint16_t i = 0U; i < (2U * cols); i++)
+	{
+		parts[i] = 0.0f;
+	}
+
+	for (uint16_t r = 0U; r < filt_history->rows; r++)
+	{
+		const float complex *filt_data = acc_algorithm_history_recent(filt_history, r);
+
+		for (uint16_t i = 0U; i < cols; i++)
+		{
+			parts[2U * i]        -= a[r] * crealf(filt_data[i]);
+			parts[(2U * i) + 1U] -= a[r] * cimagf(filt_data[i]);
+		}
+	}
+
+	for (uint16_t r = 0U; r < history->rows; r++)
+	{
+		const float complex *data = acc_algorithm_history_recent(history, r);
+
+		for (uint16_t i = 0U; i < cols; i++)
+		{
+			parts[2U * i]        += b[r] * crealf(data[i]);
+			parts[(2U * i) + 1U] += b[r] * cimagf(data[i]);
+		}
+	}
+}
+
+
 void acc_algorithm_mean_sweep(const acc_int16_complex_t *frame, uint16_t num_points, uint16_t sweeps_per_frame, uint16_t start_point,
                               uint16_t end_point, float complex *sweep)
 {
@@ -614,28 +773,31 @@ void acc_algorithm_normalize_f32_complex(float complex *data, uint16_t data_leng
 
 void acc_algorithm_rfft(const float *data, uint16_t data_length, uint16_t length_shift, float complex *output)
 {
-	rfft(data, data_length, length_shift, output, 1U);
+	acc_fft_plan_t plan;
+
+	acc_fft_plan_init(&plan, length_shift);
+	acc_fft_real(&plan, data, data_length, 1U, output);
 }
 
 
 void acc_algorithm_rfft_matrix(const float *data, uint16_t rows, uint16_t cols, uint16_t length_shift, float complex *output, uint16_t axis)
 {
-	uint16_t full_cols = ((uint16_t)1U) << length_shift;
+	uint16_t       full_cols = ((uint16_t)1U) << length_shift;
+	acc_fft_plan_t plan;
+
+	acc_fft_plan_init(&plan, length_shift);
 
 	if (axis == 1U)
 	{
 		uint16_t output_cols = (full_cols / 2U) + 1U;
 		for (uint16_t i = 0U; i < rows; i++)
 		{
-			rfft(&data[i * cols], cols, length_shift, &output[i * output_cols], 1U);
+			acc_fft_real(&plan, &data[i * cols], cols, 1U, &output[i * output_cols]);
 		}
 	}
 	else if (axis == 0U)
 	{
-		for (uint16_t i = 0U; i < cols; i++)
-		{
-			rfft(&data[i], rows, length_shift, &output[i], cols);
-		}
+		acc_fft_real_columns(&plan, data, rows, cols, output);
 	}
 	else
 	{
@@ -646,28 +808,31 @@ void acc_algorithm_rfft_matrix(const float *data, uint16_t rows, uint16_t cols,
 
 void acc_algorithm_fft(const float complex *data, uint16_t data_length, uint16_t length_shift, float complex *output)
 {
-	small_fft(data, data_length, length_shift, output, 1U);
+	acc_fft_plan_t plan;
+
+	acc_fft_plan_init(&plan, length_shift);
+	acc_fft_complex(&plan, data, data_length, 1U, output);
 }
 
 
 void acc_algorithm_fft_matrix(const float complex *data, uint16_t rows, uint16_t cols, uint16_t length_shift, float complex *output, uint16_t axis)
 {
-	uint16_t full_cols = ((uint16_t)1U) << length_shift;
+	uint16_t       full_cols = ((uint16_t)1U) << length_shift;
+	acc_fft_plan_t plan;
+
+	acc_fft_plan_init(&plan, length_shift);
 
 	if (axis == 1U)
 	{
 		uint16_t output_cols = full_cols;
 		for (uint16_t i = 0U; i < rows; i++)
 		{
-			small_fft(&data[i * cols], cols, length_shift, &output[i * output_cols], 1U);
+			acc_fft_complex(&plan, &data[i * cols], cols, 1U, &output[i * output_cols]);
 		}
 	}
 	else if (axis == 0U)
 	{
-		for (uint16_t i = 0U; i < cols; i++)
-		{
-			small_fft(&data[i], rows, length_shift, &output[i], cols);
-		}
+		acc_fft_complex_columns(&plan, data, rows, cols, output);
 	}
 	else
 	{
@@ -911,7 +1076,26 @@ void acc_algorithm_welch_matrix(const float complex *data,
 	for (uint16_t i = 0U; i < cols; i++)
 	{
 		welch(&(data[i]), rows, segment_length, data_buffer, fft_out, &(psds[i]), window, length_shift, fs,
-		      cols);
+		      cols, 0U);
+	}
+}
+
+
+void acc_algorithm_welch_history(const acc_algorithm_history_t *history,
+                                 uint16_t                      segment_length,
+                                 float complex                 *data_buffer,
+                                 float complex                 *fft_out,
+                                 float                         *psds,
+                                 const float                   *window,
+                                 uint16_t                      length_shift,
+                                 float                         fs)
+{
+	const float complex *data = history->data;
+
+	for (uint16_t i = 0U; i < history->cols; i++)
+	{
+		welch(&(data[i]), history->rows, segment_length, data_buffer, fft_out, &(psds[i]), window, length_shift, fs,
+		      history->cols, history->head);
 	}
 }
 
@@ -926,7 +1110,7 @@ void acc_algorithm_welch(const float complex *data,
                          uint16_t            length_shift,
                          float               fs)
 {
-	welch(data, data_length, segment_length, data_buffer, fft_out, psd, window, length_shift, fs, 1U);
+	welch(data, data_length, segment_length, data_buffer, fft_out, psd, window, length_shift, fs, 1U, 0U);
 }
 
 
@@ -967,6 +1151,48 @@ float acc_algorithm_calculate_cfar(const float *data,
 }
 
 
+void acc_algorithm_calculate_cfar_sweep(const float *data,
+                                        uint16_t    data_length,
+                                        uint16_t    window_length,
+                                        uint16_t    half_guard_length,
+                                        float       sensitivity,
+                                        float       *threshold)
+{
+	const uint16_t start_idx    = window_length + half_guard_length;
+	const uint16_t end_idx      = (data_length > start_idx) ? (uint16_t)(data_length - start_idx) : 0U;
+	const float    sample_count = 2.0f * (float)window_length;
+
+	for (uint16_t idx = 0U; (idx < start_idx) && (idx < data_length); idx++)
+	{
+		threshold[idx] = FLT_MAX;
+	}
+
+	if (start_idx < end_idx)
+	{
+		/* Both windows slide one bin per index, so each step adds one sample to and drops one from each */
+		float close_sum = window_sum(data, 0U, window_length);
+		float far_sum   = window_sum(data, start_idx + half_guard_length + 1U, window_length);
+
+		for (uint16_t idx = start_idx; idx < end_idx; idx++)
+		{
+			if (idx > start_idx)
+			{
+				close_sum += data[idx - half_guard_length - 1U] - data[idx - start_idx - 1U];
+				far_sum   += data[idx + start_idx] - data[idx + half_guard_length];
+			}
+
+			threshold[idx] = (sample_count > 0.0f) ? ((close_sum + far_sum) / sample_count) : 0.0f;
+			threshold[idx] += sensitivity;
+		}
+	}
+
+	for (uint16_t idx = (end_idx > start_idx) ? end_idx : start_idx; idx < data_length; idx++)
+	{
+		threshold[idx] = FLT_MAX;
+	}
+}
+
+
 float acc_algorithm_calculate_mirrored_one_sided_cfar(const float *data,
                                                       uint16_t    data_length,
                                                       uint16_t    middle_idx,
@@ -1023,6 +1249,82 @@ float acc_algorithm_calculate_mirrored_one_sided_cfar(const float *data,
 }
 
 
+void acc_algorithm_calculate_mirrored_one_sided_cfar_sweep(const float *data,
+                                                           uint16_t    data_length,
+                                                           uint16_t    middle_idx,
+                                                           uint16_t    window_length,
+                                                           uint16_t    half_guard_length,
+                                                           float       sensitivity,
+                                                           float       *threshold)
+{
+	uint16_t margin                        = window_length + half_guard_length;
+	uint16_t half_sweep_len_without_margin = (uint16_t)rint(((double)data_length / 2.0) - (double)margin);
+	uint16_t tail_start                    = data_length - margin - 1U;
+
+	float min = INFINITY;
+
+	for (uint16_t i = 0U; i < data_length; i++)
+	{
+		min = fminf(data[i], min);
+	}
+
+	float head_sum    = window_sum(data, 0U, window_length);
+	float tail_sum    = window_sum(data, data_length - window_length, window_length);
+	float rising_sum  = 0.0f;
+	float falling_sum = 0.0f;
+
+	/* The windows of the two middle regions slide one bin per index */
+	for (uint16_t idx = 0U; idx < data_length; idx++)
+	{
+		float sum = 0.0f;
+
+		if (idx <= margin)
+		{
+			sum += head_sum;
+		}
+
+		if ((idx > margin) && (idx < middle_idx))
+		{
+			uint16_t start = idx - margin;
+
+			if (idx == (margin + 1U))
+			{
+				rising_sum = window_sum(data, start, window_length);
+			}
+			else
+			{
+				rising_sum += data[start + window_length - 1U] - data[start - 1U];
+			}
+
+			sum += rising_sum;
+		}
+
+		if ((idx >= middle_idx) && (idx < tail_start))
+		{
+			uint16_t start = data_length - half_sweep_len_without_margin + idx - middle_idx - (window_length - 1U);
+
+			if (idx == middle_idx)
+			{
+				falling_sum = window_sum(data, start, window_length);
+			}
+			else
+			{
+				falling_sum += data[start + window_length - 1U] - data[start - 1U];
+			}
+
+			sum += falling_sum;
+		}
+
+		if (idx >= tail_start)
+		{
+			sum += tail_sum;
+		}
+
+		threshold[idx] = ((sum / (float)window_length) + min) / sensitivity;
+	}
+}
+
+
 uint16_t acc_algorithm_get_distance_idx(const float *data, uint16_t cols, uint16_t rows, uint16_t middle_idx, uint16_t half_slow_zone)
 {
 	float max = -INFINITY;
@@ -1370,39 +1672,13 @@ void acc_algorithm_count_points_above_threshold(const float *matrix, uint16_t ro
 
 int16_t acc_algorithm_median_i16(int16_t *data, uint16_t length)
 {
-	sort_i16(data, length);
-
-	int16_t result;
-
-	if ((length % 2U) == 0U)
-	{
-		result = (data[(length / 2U) - 1U] + data[length / 2U]) / 2;
-	}
-	else
-	{
-		result = data[length / 2U];
-	}
-
-	return result;
+	return acc_order_statistics_median_i16(data, length);
 }
 
 
 float acc_algorithm_median_f32(float *data, uint16_t length)
 {
-	sort_f32(data, length);
-
-	float result;
-
-	if ((length % 2U) == 0U)
-	{
-		result = (data[(length / 2U) - 1U] + data[length / 2U]) / 2.0f;
-	}
-	else
-	{
-		result = data[length / 2U];
-	}
-
-	return result;
+	return acc_order_statistics_median_f32(data, length);
 }
 
 
@@ -1526,17 +1802,6 @@ static void mean_i16_complex(const acc_int16_complex_t *data, uint16_t num_steps
 }
 
 
-static void rfft(const float *data, uint16_t data_length, uint16_t length_shift, float complex *output, uint16_t stride)
-{
-	small_rfft(data, data_length, length_shift - 1U, output, stride);
-
-	small_rfft_real_symmetry_conversion(output, length_shift - 1U, stride);
-
-	output[(((uint16_t)1U) << (length_shift - 1U)) * stride] = cimagf(output[0]);
-	output[0]                                                = crealf(output[0]);
-}
-
-
 static void fftshift(float *data, uint16_t data_length, uint16_t stride)
 {
 	uint16_t half_data_length = (data_length + 1U) / 2U;
@@ -1564,28 +1829,38 @@ static void welch(const float complex *data,
                   const float         *window,
                   uint16_t            length_shift,
                   float               fs,
-                  uint16_t            stride)
+                  uint16_t            stride,
+                  uint16_t            first)
 {
-	uint16_t num_segments = data_length / segment_length;
-	float    scale        = 0.0f;
+	uint16_t       num_segments  = data_length / segment_length;
+	float          scale         = 0.0f;
+	uint16_t       segment_start = first;
+	acc_fft_plan_t plan;
+
+	acc_fft_plan_init(&plan, length_shift);
 
 	for (uint16_t i = 0U; i < num_segments; i++)
 	{
 		scale = 0.0f;
 		float complex mean = 0.0f;
+		uint16_t      idx  = segment_start;
 
 		for (uint16_t j = 0U; j < segment_length; j++)
 		{
-			mean += data[(i * segment_length * stride) + (j * stride)];
+			mean += data[idx * stride];
+			idx   = (idx + 1U == data_length) ? 0U : idx + 1U;
 		}
 
 		float complex adj_mean_real = crealf(mean) / (float)segment_length;
 		float complex adj_mean_imag = cimagf(mean) / (float)segment_length;
 		mean = adj_mean_real + (adj_mean_imag * I);
 
+		idx = segment_start;
+
 		for (uint16_t j = 0U; j < segment_length; j++)
 		{
-			data_buffer[j] = data[(i * segment_length * stride) + (j * stride)] - mean;
+			data_buffer[j] = data[idx * stride] - mean;
+			idx            = (idx + 1U == data_length) ? 0U : idx + 1U;
 
 			float complex adj_buf_real = crealf(data_buffer[j]) * window[j];
 			float complex adj_buf_imag = cimagf(data_buffer[j]) * window[j];
@@ -1594,7 +1869,9 @@ static void welch(const float complex *data,
 			scale += window[j] * window[j];
 		}
 
-		acc_algorithm_fft(data_buffer, segment_length, length_shift, fft_out);
+		segment_start = idx;
+
+		acc_fft_complex(&plan, data_buffer, segment_length, 1U, fft_out);
 
 		for (uint16_t j = 0U; j < segment_length; j++)
 		{
@@ -1635,241 +1912,6 @@ static void filter_inplace_apply(uint16_t    sample_idx,
 }
 
 
-static float complex get_data_padded_f32_to_f32_complex(const float *data, uint16_t data_length, uint16_t index, uint16_t stride)
-{
-	float    real = 0.0f;
-	float    imag = 0.0f;
-	uint16_t i    = index * 2U;
-
-	if (i < data_length)
-	{
-		real = data[i * stride];
-	}
-
-	i++;
-
-	if (i < data_length)
-	{
-		imag = data[i * stride];
-	}
-
-	return real + (imag * I);
-}
-
-
-static float complex get_data_padded_f32_complex(const float complex *data, uint16_t data_length, uint16_t index, uint16_t stride)
-{
-	float complex res = 0.0f + 0.0f * I;
-
-	if (index < data_length)
-	{
-		res = data[index * stride];
-	}
-
-	return res;
-}
-
-
-static void small_rfft(const float *data, uint16_t data_length, uint16_t length_shift, float complex *output, uint16_t stride)
-{
-	uint16_t full_data_length = ((uint16_t)1U) << length_shift;
-
-	if (length_shift == 0U)
-	{
-		// Trivial 1-element FFT
-		output[0] = get_data_padded_f32_to_f32_complex(data, data_length, 0U, stride);
-	}
-	else if (length_shift == 1U)
-	{
-		// 2-element FFT
-		output[0] = get_data_padded_f32_to_f32_complex(data, data_length, 0U, stride) + get_data_padded_f32_to_f32_complex(data,
-		                                                                                                                   data_length, 1U,
-		                                                                                                                   stride);
-		output[1U * stride] = get_data_padded_f32_to_f32_complex(data, data_length, 0U, stride) - get_data_padded_f32_to_f32_complex(data,
-		                                                                                                                             data_length, 1U,
-		                                                                                                                             stride);
-	}
-	else
-	{
-		// Perform element reordering
-		uint16_t reverse_i = 0U;
-		for (uint16_t i = 0U; i < full_data_length; i++)
-		{
-			if (i < reverse_i)
-			{
-				float complex tmp = get_data_padded_f32_to_f32_complex(data, data_length, i, stride);
-				output[i*stride]         = get_data_padded_f32_to_f32_complex(data, data_length, reverse_i, stride);
-				output[reverse_i*stride] = tmp;
-			}
-			else if (i == reverse_i)
-			{
-				output[i*stride] = get_data_padded_f32_to_f32_complex(data, data_length, i, stride);
-			}
-			else
-			{
-				// Do nothing
-			}
-
-			uint16_t bit = full_data_length >> 1U;
-			while ((bit & reverse_i) != 0U)
-			{
-				reverse_i &= ~bit;
-				bit      >>= 1U;
-			}
-			reverse_i |= bit;
-		}
-
-		small_fft_transformation(length_shift, output, stride);
-	}
-}
-
-
-static void small_fft(const float complex *data, uint16_t data_length, uint16_t length_shift, float complex *output, uint16_t stride)
-{
-	uint16_t full_data_length = ((uint16_t)1U) << length_shift;
-
-	if (length_shift == 0U)
-	{
-		// Trivial 1-element FFT
-		output[0] = get_data_padded_f32_complex(data, data_length, 0U, stride);
-	}
-	else if (length_shift == 1U)
-	{
-		// 2-element FFT
-		output[0] = get_data_padded_f32_complex(data, data_length, 0U, stride) + get_data_padded_f32_complex(data, data_length, 1U,
-		                                                                                                     stride);
-		output[1U * stride] = get_data_padded_f32_complex(data, data_length, 0U, stride) - get_data_padded_f32_complex(data, data_length, 1U,
-		                                                                                                               stride);
-	}
-	else
-	{
-		// Perform element reordering
-		uint16_t reverse_i = 0U;
-		for (uint16_t i = 0U; i < full_data_length; i++)
-		{
-			if (i < reverse_i)
-			{
-				float complex tmp = get_data_padded_f32_complex(data, data_length, i, stride);
-				output[i*stride]         = get_data_padded_f32_complex(data, data_length, reverse_i, stride);
-				output[reverse_i*stride] = tmp;
-			}
-			else if (i == reverse_i)
-			{
-				output[i*stride] = get_data_padded_f32_complex(data, data_length, i, stride);
-			}
-			else
-			{
-				// Do nothing
-			}
-
-			uint16_t bit = full_data_length >> 1U;
-			while ((bit & reverse_i) != 0U)
-			{
-				reverse_i &= ~bit;
-				bit      >>= 1U;
-			}
-			reverse_i |= bit;
-		}
-
-		small_fft_transformation(length_shift, output, stride);
-	}
-}
-
-
-static void small_fft_transformation(uint16_t length_shift, float complex *output, uint16_t stride)
-{
-	uint16_t full_data_length = ((uint16_t)1U) << length_shift;
-
-	// Perform 4-element base transformations
-	for (uint16_t i = 0U; i < full_data_length; i += 4U)
-	{
-		float complex s0 = output[i * stride] + output[(i + 1U) * stride];
-		float complex d0 = output[i * stride] - output[(i + 1U) * stride];
-		float complex s1 = output[(i + 2U) * stride] + output[(i + 3U) * stride];
-		float complex d1 = output[(i + 2U) * stride] - output[(i + 3U) * stride];
-
-		d1 = cimagf(d1) - (I * crealf(d1));          // d1 = -I*d1;
-
-		output[(i + 0U) * stride] = s0 + s1;
-		output[(i + 2U) * stride] = s0 - s1;
-		output[(i + 1U) * stride] = d0 + d1;
-		output[(i + 3U) * stride] = d0 - d1;
-	}
-
-	// Main part of the FFT computation
-	uint16_t      block_length = 4U;
-	float complex phase_incr   = -I;
-
-	while (block_length < full_data_length)
-	{
-		// Update the phase_incr unit vector to have half phase angle
-		phase_incr = (phase_incr + 1.0f) / cabsf(phase_incr + 1.0f);
-
-		float complex phase = 1.0f;
-		for (uint16_t m = 0U; m < block_length; m++)
-		{
-			for (uint16_t i = m; i < full_data_length; i += block_length << 1U)
-			{
-				float complex delta = output[(i + block_length) * stride] * phase;
-
-				output[(i + block_length) * stride] = output[i*stride] - delta;
-
-				output[i*stride] += delta;
-			}
-
-			// This phase increment is the leading error source for large transforms
-			phase = phase * phase_incr;
-		}
-
-		block_length <<= 1U;
-	}
-}
-
-
-static void small_rfft_real_symmetry_conversion(float complex *output, uint16_t length_shift, uint16_t stride)
-{
-	uint16_t full_data_length = ((uint16_t)1U) << length_shift;
-
-	output[0] = (1.0f + (1.0f * I)) * conjf(output[0]);
-
-	if (length_shift > 0U)
-	{
-		float complex phase_incr = I;
-		float complex z1_factor  = 0.5f * phase_incr;
-
-		for (uint16_t i = 1U; i < length_shift; i++)
-		{
-			phase_incr = (phase_incr + 1.0f) / cabsf(phase_incr + 1.0f);
-		}
-
-		uint16_t mid = full_data_length / 2U;
-		for (uint16_t i = 1U; i < mid; i++)
-		{
-			float complex t;
-			float complex z0 = output[i * stride];
-			float complex z1 = output[(full_data_length - i) * stride];
-
-			t  = z0 + conjf(z1);
-			z1 = conjf(z0) - z1;
-			z0 = t;
-
-			z0       *= 0.5f;
-			z1_factor = z1_factor * phase_incr;
-			z1        = z1 * z1_factor;
-
-			t  = z0 + conjf(z1);
-			z1 = conjf(z0) - z1;
-			z0 = t;
-
-			output[i * stride]                      = z0;
-			output[(full_data_length - i) * stride] = z1;
-		}
-
-		output[mid * stride] = conjf(output[mid * stride]);
-	}
-}
-
-
 static void double_buffering_median_filter(acc_int16_complex_t *frame,
                                            const uint16_t      num_points,
                                            const uint16_t      sweep,
@@ -2061,49 +2103,20 @@ static acc_config_profile_t get_profile(uint16_t value)
 }
 
 
-static void sort_i16(int16_t *array, uint16_t array_length)
+static void *history_physical_row(const acc_algorithm_history_t *history, uint16_t physical)
 {
-	for (uint16_t i = 0; i < (array_length - 1U); i++)
-	{
-		for (uint16_t j = 0; j < (array_length - i - 1U); j++)
-		{
-			if (array[j] > array[j + 1U])
-			{
-				swap_i16(array, j, j + 1U);
-			}
-		}
-	}
+	return &((uint8_t *)history->data)[(size_t)physical * history->cols * history->element_size];
 }
 
 
-static void swap_i16(int16_t *array, uint16_t idx_a, uint16_t idx_b)
+static float window_sum(const float *data, uint16_t start, uint16_t length)
 {
-	int16_t tmp = array[idx_a];
-
-	array[idx_a] = array[idx_b];
-	array[idx_b] = tmp;
-}
-
+	float sum = 0.0f;
 
-static void sort_f32(float *array, uint16_t array_length)
-{
-	for (uint16_t i = 0; i < (array_length - 1U); i++)
+	for (uint16_t k = 0U; k < length; k++)
 	{
-		for (uint16_t j = 0; j < (array_length - i - 1U); j++)
-		{
-			if (array[j] > array[j + 1U])
-			{
-				swap_f32(array, j, j + 1U);
-			}
-		}
+		sum += data[start + k];
 	}
-}
-
-
-static void swap_f32(float *array, uint16_t idx_a, uint16_t idx_b)
-{
-	float tmp = array[idx_a];
 
-	array[idx_a] = array[idx_b];
-	array[idx_b] = tmp;
+	return sum;
 }
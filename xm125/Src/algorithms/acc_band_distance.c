@@ -0,0 +1,314 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "acc_algorithm.h"
+#include "acc_band_distance.h"
+
+/**
+ * CFAR threshold above the surrounding mean at threshold sensitivity 0 and 1
+ */
+#define CFAR_OFFSET_MAX_DB 20.0f
+#define CFAR_OFFSET_MIN_DB 4.0f
+
+/**
+ * Added to the amplitude so an all zero point has a finite level
+ */
+#define AMPLITUDE_FLOOR 1.0f
+
+
+//-----------------------------
+// Private declarations
+//-----------------------------
+
+static int32_t meter_to_points(float length_m);
+
+
+static uint16_t valid_step_length(uint16_t step_length);
+
+
+static void set_band(acc_band_distance_band_t *band, int32_t start_point, int32_t num_points, uint16_t step_length,
+                     acc_config_profile_t profile);
+
+
+static void mean_amplitude_db(const acc_int16_complex_t *frame, uint16_t sweep_data_length, uint16_t sweeps_per_frame,
+                              const acc_band_distance_band_t *band, float *amplitude_db);
+
+
+static void cfar_threshold(const float *data, uint16_t data_length, uint16_t window_length, uint16_t half_guard_length, float offset,
+                           float *threshold);
+
+
+static uint16_t add_peak(acc_band_distance_peak_t       *peaks,
+                         uint16_t                       num_peaks,
+                         uint16_t                       max_peaks,
+                         const acc_band_distance_peak_t *peak,
+                         const acc_band_distance_band_t *bands);
+
+
+//-----------------------------
+// Public definitions
+//-----------------------------
+
+
+uint8_t acc_band_distance_layout(float                    fine_start_m,
+                                 float                    fine_end_m,
+                                 uint16_t                 fine_step_length,
+                                 acc_config_profile_t     fine_profile,
+                                 float                    range_start_m,
+                                 float                    range_end_m,
+                                 uint16_t                 coarse_step_length,
+                                 acc_config_profile_t     coarse_profile,
+                                 acc_band_distance_band_t *bands)
+{
+	const int32_t fine_start = meter_to_points(fine_start_m);
+	const int32_t fine_end   = meter_to_points(fine_end_m);
+
+	fine_step_length   = valid_step_length(fine_step_length);
+	coarse_step_length = valid_step_length(coarse_step_length);
+
+	if ((fine_end <= fine_start) || (fine_step_length == 0U) || (coarse_step_length == 0U))
+	{
+		return 0U;
+	}
+
+	const int32_t fine_num_points = ((fine_end - fine_start + (int32_t)fine_step_length - 1) / (int32_t)fine_step_length) + 1;
+	const int32_t fine_last       = fine_start + ((fine_num_points - 1) * (int32_t)fine_step_length);
+	const int32_t range_start     = meter_to_points(range_start_m);
+	const int32_t range_end       = meter_to_points(range_end_m);
+	const int32_t coarse_step     = (int32_t)coarse_step_length;
+	uint8_t       num_bands       = 0U;
+
+	if (range_start <= fine_start - coarse_step)
+	{
+		int32_t num_points = (fine_start - range_start) / coarse_step;
+
+		set_band(&bands[num_bands], fine_start - (num_points * coarse_step), num_points, coarse_step_length, coarse_profile);
+		num_bands++;
+	}
+
+	set_band(&bands[num_bands], fine_start, fine_num_points, fine_step_length, fine_profile);
+	num_bands++;
+
+	if (range_end >= fine_last + coarse_step)
+	{
+		int32_t num_points = (range_end - fine_last) / coarse_step;
+
+		set_band(&bands[num_bands], fine_last + coarse_step, num_points, coarse_step_length, coarse_profile);
+		num_bands++;
+	}
+
+	return num_bands;
+}
+
+
+uint16_t acc_band_distance_process(const acc_int16_complex_t      *frame,
+                                   uint16_t                       sweep_data_length,
+                                   uint16_t                       sweeps_per_frame,
+                                   const acc_band_distance_band_t *bands,
+                                   uint8_t                        num_bands,
+                                   float                          threshold_sensitivity,
+                                   float                          *work,
+                                   acc_band_distance_peak_t       *peaks,
+                                   uint16_t                       max_peaks)
+{
+	const float sensitivity = fminf(fmaxf(threshold_sensitivity, 0.0f), 1.0f);
+	const float offset      = CFAR_OFFSET_MAX_DB - (sensitivity * (CFAR_OFFSET_MAX_DB - CFAR_OFFSET_MIN_DB));
+	uint16_t    num_peaks   = 0U;
+
+	for (uint8_t b = 0U; b < num_bands; b++)
+	{
+		const acc_band_distance_band_t *band         = &bands[b];
+		const uint16_t                 num_points    = band->num_points;
+		const float                    step_m        = (float)band->step_length * ACC_APPROX_BASE_STEP_LENGTH_M;
+		const float                    start_m       = (float)band->start_point * ACC_APPROX_BASE_STEP_LENGTH_M;
+		float                          *amplitude_db = work;
+		float                          *threshold    = &work[num_points];
+
+		mean_amplitude_db(frame, sweep_data_length, sweeps_per_frame, band, amplitude_db);
+
+		uint16_t fwhm_points = (uint16_t)fmaxf(1.0f, roundf(acc_algorithm_get_fwhm(band->profile) / step_m));
+
+		cfar_threshold(amplitude_db, num_points, fwhm_points, fwhm_points, offset, threshold);
+
+		for (uint16_t i = 0U; i < num_points; i++)
+		{
+			bool first = (i == 0U);
+			bool last  = (i + 1U == num_points);
+
+			if ((amplitude_db[i] <= threshold[i]) || (!first && (amplitude_db[i] < amplitude_db[i - 1U])) ||
+			    (!last && (amplitude_db[i] <= amplitude_db[i + 1U])))
+			{
+				continue;
+			}
+
+			acc_band_distance_peak_t peak;
+
+			// The envelope is close to a Gaussian, so a parabola in dB fits it well
+			peak.distance_m = (first || last) ? (start_m + ((float)i * step_m)) :
+			                  acc_algorithm_interpolate_peaks_equidistant(amplitude_db, start_m, step_m, i);
+			peak.strength_db = amplitude_db[i] - threshold[i];
+			peak.band        = b;
+
+			num_peaks = add_peak(peaks, num_peaks, max_peaks, &peak, bands);
+		}
+	}
+
+	return num_peaks;
+}
+
+
+//-----------------------------
+// Private definitions
+//-----------------------------
+
+
+static int32_t meter_to_points(float length_m)
+{
+	return (int32_t)roundf(length_m / ACC_APPROX_BASE_STEP_LENGTH_M);
+}
+
+
+static uint16_t valid_step_length(uint16_t step_length)
+{
+	static const uint16_t divisors[] = {12U, 8U, 6U, 4U, 3U, 2U, 1U};
+
+	if (step_length >= 24U)
+	{
+		return (uint16_t)((step_length / 24U) * 24U);
+	}
+
+	for (uint16_t i = 0U; i < (sizeof(divisors) / sizeof(divisors[0])); i++)
+	{
+		if (divisors[i] <= step_length)
+		{
+			return divisors[i];
+		}
+	}
+
+	return 0U;
+}
+
+
+static void set_band(acc_band_distance_band_t *band, int32_t start_point, int32_t num_points, uint16_t step_length,
+                     acc_config_profile_t profile)
+{
+	acc_config_profile_t closest_profile = acc_algorithm_select_profile(start_point, ACC_APPROX_BASE_STEP_LENGTH_M);
+
+	band->start_point = start_point;
+	band->num_points  = (uint16_t)num_points;
+	band->step_length = step_length;
+	band->profile     = (closest_profile < profile) ? closest_profile : profile;
+	band->data_offset = 0U;
+}
+
+
+static void mean_amplitude_db(const acc_int16_complex_t *frame, uint16_t sweep_data_length, uint16_t sweeps_per_frame,
+                              const acc_band_distance_band_t *band, float *amplitude_db)
+{
+	for (uint16_t i = 0U; i < band->num_points; i++)
+	{
+		const acc_int16_complex_t *point = &frame[band->data_offset + i];
+		float                     real   = 0.0f;
+		float                     imag   = 0.0f;
+
+		for (uint16_t sweep = 0U; sweep < sweeps_per_frame; sweep++)
+		{
+			real += (float)point[sweep * sweep_data_length].real;
+			imag += (float)point[sweep * sweep_data_length].imag;
+		}
+
+		real /= (float)sweeps_per_frame;
+		imag /= (float)sweeps_per_frame;
+
+		amplitude_db[i] = 20.0f * log10f(sqrtf((real * real) + (imag * imag)) + AMPLITUDE_FLOOR);
+	}
+}
+
+
+static void cfar_threshold(const float *data, uint16_t data_length, uint16_t window_length, uint16_t half_guard_length, float offset,
+                           float *threshold)
+{
+	// Unlike acc_algorithm_calculate_cfar_sweep(), indexes near the edges use the window on one side,
+	// a narrow band would otherwise have no thresholds at all
+	for (uint16_t idx = 0U; idx < data_length; idx++)
+	{
+		float    sum   = 0.0f;
+		uint16_t count = 0U;
+
+		for (uint16_t k = half_guard_length + 1U; k <= half_guard_length + window_length; k++)
+		{
+			if (idx >= k)
+			{
+				sum += data[idx - k];
+				count++;
+			}
+
+			if (idx + k < data_length)
+			{
+				sum += data[idx + k];
+				count++;
+			}
+		}
+
+		threshold[idx] = (count > 0U) ? ((sum / (float)count) + offset) : FLT_MAX;
+	}
+}
+
+
+static uint16_t add_peak(acc_band_distance_peak_t       *peaks,
+                         uint16_t                       num_peaks,
+                         uint16_t                       max_peaks,
+                         const acc_band_distance_peak_t *peak,
+                         const acc_band_distance_band_t *bands)
+{
+	// Near a band edge the same reflection can be found in both bands
+	for (uint16_t i = 0U; i < num_peaks; i++)
+	{
+		const acc_band_distance_band_t *kept_band = &bands[peaks[i].band];
+		const acc_band_distance_band_t *new_band  = &bands[peak->band];
+
+		if ((peaks[i].band == peak->band) ||
+		    (fabsf(peaks[i].distance_m - peak->distance_m) >=
+		     fmaxf(acc_algorithm_get_fwhm(kept_band->profile), acc_algorithm_get_fwhm(new_band->profile))))
+		{
+			continue;
+		}
+
+		if (new_band->step_length >= kept_band->step_length)
+		{
+			return num_peaks;
+		}
+
+		memmove(&peaks[i], &peaks[i + 1U], (size_t)(num_peaks - i - 1U) * sizeof(*peaks));
+		num_peaks--;
+		break;
+	}
+
+	uint16_t pos = num_peaks;
+
+	while ((pos > 0U) && (peaks[pos - 1U].strength_db < peak->strength_db))
+	{
+		pos--;
+	}
+
+	if (pos >= max_peaks)
+	{
+		return num_peaks;
+	}
+
+	uint16_t moved = (num_peaks < max_peaks) ? (uint16_t)(num_peaks - pos) : (uint16_t)(max_peaks - pos - 1U);
+
+	memmove(&peaks[pos + 1U], &peaks[pos], (size_t)moved * sizeof(*peaks));
+	peaks[pos] = *peak;
+
+	return (num_peaks < max_peaks) ? (uint16_t)(num_peaks + 1U) : num_peaks;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdint.h>
+
+#include "acc_algorithm.h"
+#include "acc_energy_estimate.h"
+
+/**
+ * Uncalibrated wakeup times, a measure with prepare and read over SPI, and
+ * processing and sending of the result
+ */
+#define DEFAULT_SENSOR_OFFSET_MS    3.0f
+#define DEFAULT_SENSOR_US_PER_POINT 40.0f
+#define DEFAULT_MCU_OFFSET_MS       2.0f
+#define DEFAULT_MCU_US_PER_POINT    10.0f
+
+/**
+ * Points per envelope FWHM used by the distance detector
+ */
+#define POINTS_PER_FWHM 4.0f
+
+/**
+ * Part of the way a calibration moves a scale
+ */
+#define CALIBRATION_WEIGHT 0.25f
+
+#define HOURS_PER_DAY 24.0f
+
+
+//-----------------------------
+// Private declarations
+//-----------------------------
+
+static float calibrated_scale(float scale, float predicted_ms, float measured_ms, uint32_t calibrations);
+
+
+//-----------------------------
+// Public definitions
+//-----------------------------
+
+
+void acc_energy_model_init(acc_energy_model_t *model, float sensor_ma, float mcu_ma, float sleep_ma)
+{
+	model->sensor_offset_ms    = DEFAULT_SENSOR_OFFSET_MS;
+	model->sensor_us_per_point = DEFAULT_SENSOR_US_PER_POINT;
+	model->sensor_scale        = 1.0f;
+	model->mcu_offset_ms       = DEFAULT_MCU_OFFSET_MS;
+	model->mcu_us_per_point    = DEFAULT_MCU_US_PER_POINT;
+	model->mcu_scale           = 1.0f;
+	model->sensor_ma           = sensor_ma;
+	model->mcu_ma              = mcu_ma;
+	model->sleep_ma            = sleep_ma;
+	model->calibrations        = 0U;
+}
+
+
+uint32_t acc_energy_detector_points(float start_m, float end_m, uint16_t max_step_length, acc_config_profile_t max_profile)
+{
+	if (end_m <= start_m)
+	{
+		return 0U;
+	}
+
+	int32_t              start_point     = (int32_t)roundf(start_m / ACC_APPROX_BASE_STEP_LENGTH_M);
+	acc_config_profile_t closest_profile = acc_algorithm_select_profile(start_point, ACC_APPROX_BASE_STEP_LENGTH_M);
+	acc_config_profile_t profile         = (closest_profile < max_profile) ? closest_profile : max_profile;
+	float                step_length     = fmaxf(1.0f,
+	                                             floorf(acc_algorithm_get_fwhm(profile) / (POINTS_PER_FWHM * ACC_APPROX_BASE_STEP_LENGTH_M)));
+
+	if (max_step_length > 0U && step_length > (float)max_step_length)
+	{
+		step_length = (float)max_step_length;
+	}
+
+	return (uint32_t)ceilf((end_m - start_m) / (step_length * ACC_APPROX_BASE_STEP_LENGTH_M)) + 1U;
+}
+
+
+void acc_energy_model_calibrate(acc_energy_model_t *model, uint32_t points, float sensor_ms, float mcu_ms)
+{
+	float predicted_sensor_ms = model->sensor_offset_ms + ((model->sensor_us_per_point * (float)points) / 1000.0f);
+	float predicted_mcu_ms    = model->mcu_offset_ms + ((model->mcu_us_per_point * (float)points) / 1000.0f);
+
+	model->sensor_scale = calibrated_scale(model->sensor_scale, predicted_sensor_ms, sensor_ms, model->calibrations);
+	model->mcu_scale    = calibrated_scale(model->mcu_scale, predicted_mcu_ms, mcu_ms, model->calibrations);
+	model->calibrations++;
+}
+
+
+void acc_energy_estimate(const acc_energy_model_t *model,
+                         uint32_t                 points,
+                         float                    update_rate_hz,
+                         float                    battery_mah,
+                         acc_energy_estimate_t    *estimate)
+{
+	float sensor_ms = model->sensor_scale * (model->sensor_offset_ms + ((model->sensor_us_per_point * (float)points) / 1000.0f));
+	float mcu_ms    = model->mcu_scale * (model->mcu_offset_ms + ((model->mcu_us_per_point * (float)points) / 1000.0f));
+	float awake_ms  = sensor_ms + mcu_ms;
+	float period_ms = (update_rate_hz > 0.0f) ? (1000.0f / update_rate_hz) : awake_ms;
+
+	// A wakeup longer than the period delays the next one
+	period_ms = fmaxf(period_ms, awake_ms);
+
+	float charge = (model->sensor_ma * sensor_ms) + (model->mcu_ma * mcu_ms) + (model->sleep_ma * (period_ms - awake_ms));
+
+	estimate->sensor_ms         = sensor_ms;
+	estimate->mcu_ms            = mcu_ms;
+	estimate->sleep_ms          = period_ms - awake_ms;
+	estimate->update_rate_hz    = (period_ms > 0.0f) ? (1000.0f / period_ms) : 0.0f;
+	estimate->average_ma        = (period_ms > 0.0f) ? (charge / period_ms) : 0.0f;
+	estimate->battery_life_days = (estimate->average_ma > 0.0f) ? (battery_mah / estimate->average_ma / HOURS_PER_DAY) : 0.0f;
+}
+
+
+//-----------------------------
+// Private definitions
+//-----------------------------
+
+
+static float calibrated_scale(float scale, float predicted_ms, float measured_ms, uint32_t calibrations)
+{
+	if (predicted_ms <= 0.0f || measured_ms <= 0.0f)
+	{
+		return scale;
+	}
+
+	float measured_scale = measured_ms / predicted_ms;
+
+	// The defaults are only a guess, so the first measurement replaces them
+	return (calibrations == 0U) ? measured_scale : (scale + (CALIBRATION_WEIGHT * (measured_scale - scale)));
+}
@@ -0,0 +1,556 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "acc_order_statistics.h"
+
+/**
+ * Ranges this short are finished with insertion sort
+ */
+#define SELECT_INSERTION_SORT_LENGTH 8U
+
+
+//-----------------------------
+// Private declarations
+//-----------------------------
+
+static uint16_t select_depth_limit(uint16_t length);
+
+
+static void insertion_sort_f32(float *data, uint16_t left, uint16_t right);
+
+
+static void insertion_sort_i16(int16_t *data, uint16_t left, uint16_t right);
+
+
+static void heapsort_f32(float *data, uint16_t left, uint16_t right);
+
+
+static void heapsort_i16(int16_t *data, uint16_t left, uint16_t right);
+
+
+static void swap_f32(float *data, uint16_t idx_a, uint16_t idx_b);
+
+
+static void swap_i16(int16_t *data, uint16_t idx_a, uint16_t idx_b);
+
+
+/**
+ * @brief First index in the ascending array with a value >= value
+ */
+static uint16_t lower_bound_f32(const float *sorted, uint16_t count, float value);
+
+
+//-----------------------------
+// Public definitions
+//-----------------------------
+
+
+float acc_order_statistics_select_f32(float *data, uint16_t length, uint16_t k)
+{
+	uint16_t left  = 0U;
+	uint16_t right = length - 1U;
+	uint16_t depth = select_depth_limit(length);
+
+	while ((uint16_t)(right - left) >= SELECT_INSERTION_SORT_LENGTH)
+	{
+		if (depth == 0U)
+		{
+			heapsort_f32(data, left, right);
+			return data[k];
+		}
+
+		depth--;
+
+		/* Median of three to data[left + 1], with data[left] <= pivot <= data[right] as sentinels */
+		uint16_t mid = left + ((right - left) / 2U);
+		swap_f32(data, mid, left + 1U);
+		if (data[left] > data[right])
+		{
+			swap_f32(data, left, right);
+		}
+
+		if (data[left + 1U] > data[right])
+		{
+			swap_f32(data, left + 1U, right);
+		}
+
+		if (data[left] > data[left + 1U])
+		{
+			swap_f32(data, left, left + 1U);
+		}
+
+		float    pivot = data[left + 1U];
+		uint16_t i     = left + 1U;
+		uint16_t j     = right;
+
+		while (true)
+		{
+			do
+			{
+				i++;
+			} while (data[i] < pivot);
+
+			do
+			{
+				j--;
+			} while (data[j] > pivot);
+
+			if (j < i)
+			{
+				break;
+			}
+
+			swap_f32(data, i, j);
+		}
+
+		data[left + 1U] = data[j];
+		data[j]         = pivot;
+
+		if (j == k)
+		{
+			return pivot;
+		}
+		else if (j > k)
+		{
+			right = j - 1U;
+		}
+		else
+		{
+			left = i;
+		}
+	}
+
+	insertion_sort_f32(data, left, right);
+
+	return data[k];
+}
+
+
+int16_t acc_order_statistics_select_i16(int16_t *data, uint16_t length, uint16_t k)
+{
+	uint16_t left  = 0U;
+	uint16_t right = length - 1U;
+	uint16_t depth = select_depth_limit(length);
+
+	while ((uint16_t)(right - left) >= SELECT_INSERTION_SORT_LENGTH)
+	{
+		if (depth == 0U)
+		{
+			heapsort_i16(data, left, right);
+			return data[k];
+		}
+
+		depth--;
+
+		uint16_t mid = left + ((right - left) / 2U);
+		swap_i16(data, mid, left + 1U);
+		if (data[left] > data[right])
+		{
+			swap_i16(data, left, right);
+		}
+
+		if (data[left + 1U] > data[right])
+		{
+			swap_i16(data, left + 1U, right);
+		}
+
+		if (data[left] > data[left + 1U])
+		{
+			swap_i16(data, left, left + 1U);
+		}
+
+		int16_t  pivot = data[left + 1U];
+		uint16_t i     = left + 1U;
+		uint16_t j     = right;
+
+		while (true)
+		{
+			do
+			{
+				i++;
+			} while (data[i] < pivot);
+
+			do
+			{
+				j--;
+			} while (data[j] > pivot);
+
+			if (j < i)
+			{
+				break;
+			}
+
+			swap_i16(data, i, j);
+		}
+
+		data[left + 1U] = data[j];
+		data[j]         = pivot;
+
+		if (j == k)
+		{
+			return pivot;
+		}
+		else if (j > k)
+		{
+			right = j - 1U;
+		}
+		else
+		{
+			left = i;
+		}
+	}
+
+	insertion_sort_i16(data, left, right);
+
+	return data[k];
+}
+
+
+float acc_order_statistics_median_f32(float *data, uint16_t length)
+{
+	uint16_t upper  = length / 2U;
+	float    result = acc_order_statistics_select_f32(data, length, upper);
+
+	if ((length % 2U) == 0U)
+	{
+		/* Selection leaves the lower half in data[0..upper-1], its maximum is the lower middle */
+		float lower = data[0];
+
+		for (uint16_t i = 1U; i < upper; i++)
+		{
+			if (data[i] > lower)
+			{
+				lower = data[i];
+			}
+		}
+
+		result = (lower + result) / 2.0f;
+	}
+
+	return result;
+}
+
+
+int16_t acc_order_statistics_median_i16(int16_t *data, uint16_t length)
+{
+	uint16_t upper  = length / 2U;
+	int16_t  result = acc_order_statistics_select_i16(data, length, upper);
+
+	if ((length % 2U) == 0U)
+	{
+		int16_t lower = data[0];
+
+		for (uint16_t i = 1U; i < upper; i++)
+		{
+			if (data[i] > lower)
+			{
+				lower = data[i];
+			}
+		}
+
+		result = (lower + result) / 2;
+	}
+
+	return result;
+}
+
+
+float acc_order_statistics_quantile_f32(float *data, uint16_t length, float q)
+{
+	float    position = q * (float)(length - 1U);
+	uint16_t lo       = (uint16_t)position;
+
+	if (lo >= length - 1U)
+	{
+		lo = length - 1U;
+	}
+
+	float result   = acc_order_statistics_select_f32(data, length, lo);
+	float fraction = position - (float)lo;
+
+	if (fraction > 0.0f)
+	{
+		/* The next order statistic is the minimum of the upper part */
+		float next = data[lo + 1U];
+
+		for (uint16_t i = lo + 2U; i < length; i++)
+		{
+			if (data[i] < next)
+			{
+				next = data[i];
+			}
+		}
+
+		result += (next - result) * fraction;
+	}
+
+	return result;
+}
+
+
+void acc_order_statistics_window_init(acc_order_statistics_window_t *window,
+                                      float                         *ring_buffer,
+                                      float                         *sorted_buffer,
+                                      uint16_t                      capacity)
+{
+	window->ring     = ring_buffer;
+	window->sorted   = sorted_buffer;
+	window->capacity = capacity;
+	acc_order_statistics_window_reset(window);
+}
+
+
+void acc_order_statistics_window_reset(acc_order_statistics_window_t *window)
+{
+	window->count = 0U;
+	window->head  = 0U;
+}
+
+
+void acc_order_statistics_window_push(acc_order_statistics_window_t *window, float value)
+{
+	float    *sorted = window->sorted;
+	uint16_t count   = window->count;
+
+	if (count < window->capacity)
+	{
+		uint16_t tail = (uint16_t)((window->head + count) % window->capacity);
+		window->ring[tail] = value;
+
+		uint16_t pos = lower_bound_f32(sorted, count, value);
+		memmove(&sorted[pos + 1U], &sorted[pos], (size_t)(count - pos) * sizeof(*sorted));
+		sorted[pos] = value;
+		window->count++;
+	}
+	else
+	{
+		float oldest = window->ring[window->head];
+		window->ring[window->head] = value;
+		window->head               = (uint16_t)((window->head + 1U) % window->capacity);
+
+		/* Replace the oldest value and shift only the values between the two positions */
+		uint16_t out = lower_bound_f32(sorted, count, oldest);
+		uint16_t in  = lower_bound_f32(sorted, count, value);
+
+		if (in > out)
+		{
+			in--;
+			memmove(&sorted[out], &sorted[out + 1U], (size_t)(in - out) * sizeof(*sorted));
+		}
+		else if (in < out)
+		{
+			memmove(&sorted[in + 1U], &sorted[in], (size_t)(out - in) * sizeof(*sorted));
+		}
+
+		sorted[in] = value;
+	}
+}
+
+
+float acc_order_statistics_window_kth(const acc_order_statistics_window_t *window, uint16_t k)
+{
+	return window->sorted[k];
+}
+
+
+float acc_order_statistics_window_median(const acc_order_statistics_window_t *window)
+{
+	uint16_t count = window->count;
+	float    upper = window->sorted[count / 2U];
+
+	return ((count % 2U) == 0U) ? (window->sorted[(count / 2U) - 1U] + upper) / 2.0f : upper;
+}
+
+
+float acc_order_statistics_window_quantile(const acc_order_statistics_window_t *window, float q)
+{
+	float    position = q * (float)(window->count - 1U);
+	uint16_t lo       = (uint16_t)position;
+
+	if (lo >= window->count - 1U)
+	{
+		return window->sorted[window->count - 1U];
+	}
+
+	float fraction = position - (float)lo;
+
+	return window->sorted[lo] + ((window->sorted[lo + 1U] - window->sorted[lo]) * fraction);
+}
+
+
+//-----------------------------
+// Private definitions
+//-----------------------------
+
+
+static uint16_t select_depth_limit(uint16_t length)
+{
+	uint16_t log2 = 0U;
+
+	while (length > 1U)
+	{
+		length >>= 1U;
+		log2++;
+	}
+
+	return (uint16_t)(2U * log2);
+}
+
+
+static void insertion_sort_f32(float *data, uint16_t left, uint16_t right)
+{
+	for (uint16_t i = left + 1U; i <= right; i++)
+	{
+		float    value = data[i];
+		uint16_t j     = i;
+
+		while ((j > left) && (data[j - 1U] > value))
+		{
+			data[j] = data[j - 1U];
+			j--;
+		}
+
+		data[j] = value;
+	}
+}
+
+
+static void insertion_sort_i16(int16_t *data, uint16_t left, uint16_t right)
+{
+	for (uint16_t i = left + 1U; i <= right; i++)
+	{
+		int16_t  value = data[i];
+		uint16_t j     = i;
+
+		while ((j > left) && (data[j - 1U] > value))
+		{
+			data[j] = data[j - 1U];
+			j--;
+		}
+
+		data[j] = value;
+	}
+}
+
+
+static void heapsort_f32(float *data, uint16_t left, uint16_t right)
+{
+	float    *heap  = &data[left];
+	uint16_t length = right - left + 1U;
+
+	for (uint16_t end = length; end > 1U; end--)
+	{
+		/* Heapify on the first pass, afterwards only the new root needs sifting */
+		uint16_t start = (end == length) ? (uint16_t)(length / 2U) : 1U;
+
+		for (uint16_t s = start; s > 0U; s--)
+		{
+			uint16_t root = s - 1U;
+
+			while (((2U * root) + 1U) < end)
+			{
+				uint16_t child = (2U * root) + 1U;
+
+				if (((child + 1U) < end) && (heap[child] < heap[child + 1U]))
+				{
+					child++;
+				}
+
+				if (heap[root] >= heap[child])
+				{
+					break;
+				}
+
+				swap_f32(heap, root, child);
+				root = child;
+			}
+		}
+
+		swap_f32(heap, 0U, end - 1U);
+	}
+}
+
+
+static void heapsort_i16(int16_t *data, uint16_t left, uint16_t right)
+{
+	int16_t  *heap  = &data[left];
+	uint16_t length = right - left + 1U;
+
+	for (uint16_t end = length; end > 1U; end--)
+	{
+		uint16_t start = (end == length) ? (uint16_t)(length / 2U) : 1U;
+
+		for (uint16_t s = start; s > 0U; s--)
+		{
+			uint16_t root = s - 1U;
+
+			while (((2U * root) + 1U) < end)
+			{
+				uint16_t child = (2U * root) + 1U;
+
+				if (((child + 1U) < end) && (heap[child] < heap[child + 1U]))
+				{
+					child++;
+				}
+
+				if (heap[root] >= heap[child])
+				{
+					break;
+				}
+
+				swap_i16(heap, root, child);
+				root = child;
+			}
+		}
+
+		swap_i16(heap, 0U, end - 1U);
+	}
+}
+
+
+static void swap_f32(float *data, uint16_t idx_a, uint16_t idx_b)
+{
+	float tmp = data[idx_a];
+
+	data[idx_a] = data[idx_b];
+	data[idx_b] = tmp;
+}
+
+
+static void swap_i16(int16_t *data, uint16_t idx_a, uint16_t idx_b)
+{
+	int16_t tmp = data[idx_a];
+
+	data[idx_a] = data[idx_b];
+	data[idx_b] = tmp;
+}
+
+
+static uint16_t lower_bound_f32(const float *sorted, uint16_t count, float value)
+{
+	uint16_t lo = 0U;
+	uint16_t hi = count;
+
+	while (lo < hi)
+	{
+		uint16_t mid = lo + ((hi - lo) / 2U);
+
+		if (sorted[mid] < value)
+		{
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
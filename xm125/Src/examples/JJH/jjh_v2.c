@@ -4,6 +4,7 @@
 // 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
 // of this source code package.
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -11,13 +12,21 @@
 #include <stdarg.h>
 #include <string.h>
 
+#include "acc_algorithm.h"
+#include "acc_band_distance.h"
+#include "acc_config.h"
+#include "acc_config_subsweep.h"
 #include "acc_definitions_a121.h"
 #include "acc_definitions_common.h"
 #include "acc_detector_distance.h"
+#include "acc_energy_estimate.h"
 #include "acc_hal_definitions_a121.h"
 #include "acc_hal_integration_a121.h"
 #include "acc_integration.h"
 #include "acc_integration_log.h"
+#include "acc_integration_profile.h"
+#include "acc_order_statistics.h"
+#include "acc_processing.h"
 #include "acc_rss_a121.h"
 #include "acc_sensor.h"
 #include "acc_version.h"
@@ -90,17 +99,171 @@ typedef enum
 #define RADAR_CMD_STOP_CONFIRM 0x78
 #define RADAR_CMD_CONFIG_STRING 0x24
 #define RADAR_CMD_DEBUG_MSG 0x21
+#define RADAR_CMD_PROFILE_MSG 0x50 // text like RADAR_CMD_DEBUG_MSG, one zone of the profile per message
+#define RADAR_CMD_ENERGY_MSG 0x45  // text like RADAR_CMD_DEBUG_MSG, energy estimate of a new configuration
+#define RADAR_CMD_DATA_FRAME 0x44
+#define RADAR_CMD_AGGREGATE_FRAME 0x41
+#define RADAR_CMD_RATE_FRAME 0x52
+#define RADAR_CMD_TIMED_DATA_FRAME 0x64
+#define RADAR_CMD_CONFIG_DATA_FRAME 0x63
+#define RADAR_CMD_WINDOW_FRAME 0x57
+#define RADAR_CMD_FILTERED_DATA_FRAME 0x66
+
+// Binary frame layout (multi-byte fields are little-endian):
+// [HEADER1][HEADER2][CMD][VERSION][LENGTH][SEQ][PAYLOAD...][CRC16 LO][CRC16 HI]
+// CRC-16/CCITT-FALSE covers CMD through the end of the payload.
+// Distance payload: per target uint16 distance [mm] + int16 strength [0.01 dB]
+// Timed distance payload: uint32 measurement time [ms since boot], then the distance payload
+// Config distance payload: uint8 config index (1 = secondary), then the distance payload
+// Filtered distance payload: uint32 age of the measurement when sent [ms], then the distance payload
+#define RADAR_FRAME_VERSION 0x01
+#define RADAR_FRAME_PREFIX_SIZE 6
+#define RADAR_FRAME_CRC_SIZE 2
+#define RADAR_FRAME_DISTANCE_SIZE 4
+#define RADAR_FRAME_TIMESTAMP_SIZE 4
+#define RADAR_FRAME_AGE_SIZE 4
+#define RADAR_FRAME_CONFIG_INDEX_SIZE 1
+// Aggregate payload: uint16 median/min/max distance [mm], int16 mean strength [0.01 dB],
+// uint16 samples/outliers/empty measurements, uint32 period [ms]
+#define RADAR_FRAME_AGGREGATE_SIZE 18
+// Rate payload: uint32 measurement period [ms], uint16 distance spread [mm] that caused the change
+#define RADAR_FRAME_RATE_SIZE 6
+// Window payload: uint16 start/end of the measured range [mm], uint8 1 while searching
+#define RADAR_FRAME_WINDOW_SIZE 5
+#define RADAR_FRAME_MAX_PAYLOAD (RADAR_FRAME_TIMESTAMP_SIZE + MAX_DISTANCES * RADAR_FRAME_DISTANCE_SIZE)
+
+// Mode flags, last field of the config string
+#define RADAR_MODE_BINARY_FRAMES 0x01
+#define RADAR_MODE_ADAPTIVE_RATE 0x04 // announced with rate frames, so only used together with binary frames
+#define RADAR_MODE_RATE_WARMUP 0x08   // testing_update_rate with timed frames inside collection, needs binary frames
+#define RADAR_MODE_TRACKING 0x10      // range window follows the surface, announced with window frames
+#define RADAR_MODE_BANDS 0x20         // primary as a fine band and coarse bands in one frame
+#define RADAR_MODE_PROFILE 0x40       // profile messages every PROFILE_DUMP_INTERVAL wakeups and at a stop
+#define RADAR_MODE_HIBERNATE 0x80     // sensor hibernates between wakeups instead of losing its state
+
+// Optional features, left out unless defined in the build. The Release image only fits the flash
+// below the calibration cache without them, and the link fails when it doesn't. A mode flag of a
+// feature that is left out is cleared when the configuration is loaded.
+//   JJH_USE_BANDS            band mode, RADAR_MODE_BANDS
+//   JJH_USE_PROFILE          wakeup profile, RADAR_MODE_PROFILE
+//   JJH_USE_ENERGY_ESTIMATE  energy estimate messages, calibrated with the wakeup profile
+#if defined(JJH_USE_ENERGY_ESTIMATE) && !defined(JJH_USE_PROFILE)
+#error "JJH_USE_ENERGY_ESTIMATE needs JJH_USE_PROFILE"
+#endif
 
 // Constants
 #define SENSOR_ID (1U)
 #define SENSOR_TIMEOUT_MS (2000U)
 #define DEFAULT_UPDATE_RATE (3.0f)
-#define MAX_BUFFER_SIZE 64
+#define MAX_BUFFER_SIZE 96
 #define HAL_GETTICK_SCALAR 1.00f
 #define MAX_DISTANCES 5
 #define CONFIG_TIMEOUT_MS 1000
+#define CONFIG_FIELDS_LEGACY 10
+#define CONFIG_FIELDS_MODE 11
+#define CONFIG_FIELDS 13
+#define CONFIG_FIELDS_SECONDARY 18
+#define CONFIG_STRING_LENGTH 77
 #define DEBUG_MSG_MAX_LEN 256
 
+// Outlier filter on the strongest distance, the rolling pass of detect_outliers() in sd_plotter.py.
+// A push into the order statistics window is a binary search and a memmove of up to
+// filter_window - 1 floats, so O(filter_window), at most 120 bytes with FILTER_MAX_WINDOW.
+// Every measurement, empty or not, leaves the filter filter_window / 2 measurements late.
+#define FILTER_MAX_WINDOW 31
+#define FILTER_IQR_SCALE 2.0f
+#define FILTER_MIN_IQR_M 0.005f // so a window of near identical values doesn't reject every change
+#define AGGREGATE_MAX_SAMPLES 512
+
+// Adaptive update rate, from the spread of the strongest distance over the last RATE_WINDOW
+// measurements. The rate halves after every calm window down to RATE_MIN_HZ for tide tracking,
+// and goes straight back to the configured update rate when waves or wakes raise the spread.
+// The spread is the IQR scaled to a standard deviation, so a single bad measurement doesn't
+// start a burst.
+#define RATE_WINDOW 8
+#define RATE_MIN_SAMPLES 4
+#define RATE_MIN_HZ 0.2f
+#define RATE_CALM_SPREAD_M 0.004f
+#define RATE_ACTIVE_SPREAD_M 0.015f
+#define RATE_IQR_TO_STD 0.7413f // 1 / 1.349, the IQR of a normal distribution in standard deviations
+
+// Update rate characterisation (testing_update_rate with RADAR_MODE_RATE_WARMUP). Instead of a
+// separate test run followed by a reconfiguration and recalibration, the first measurements of
+// the collection are sent unfiltered as timed frames and the ESP32 works out the period and its
+// jitter from the timestamps. The first RATE_WARMUP_SKIP measurements are left out like in the test.
+#define RATE_WARMUP_SKIP 3
+#define RATE_WARMUP_MEASUREMENTS 32
+
+// Secondary configuration, e.g. a slow wide sweep next to a fast narrow primary so a surface that
+// left the primary range can be found again. It shares the sensor, its calibration and the sensor
+// buffer with the primary, is measured right after the primary every secondary_interval
+// measurements and is sent unfiltered in config frames, so it needs binary frames.
+#define SECONDARY_CONFIG_INDEX 1
+
+// Tracking window (RADAR_MODE_TRACKING). start_m..end_m only sets the width and the first position
+// of the measured range, which is moved to keep a smoothed surface estimate away from its edges.
+// After TRACKING_LOST_FRAMES measurements without a distance the secondary range is swept with
+// the secondary step length and profile until the surface is found again. Every move needs a new
+// detector handle and a full detector calibration, so the edge margin keeps moves rare.
+#define TRACKING_EDGE_FRACTION 0.25f // of the window width
+#define TRACKING_SMOOTHING 0.3f      // weight of a new distance in the surface estimate
+#define TRACKING_LOST_FRAMES 10
+
+// Band mode (RADAR_MODE_BANDS). The primary is measured with the Service API instead of the
+// detector: start_m..end_m, or the tracking window, as a fine band with the configured step
+// length and profile, and the rest of the secondary range as coarse bands with the secondary
+// ones, all subsweeps of one frame. Distances come from acc_band_distance_process(), with
+// strengths in dB above its threshold. signal_quality and reflector_shape are not used, BANDS_HWAAS
+// is the averaging of every band, and there is no detector calibration to
+// make, cache or update, and a tracking move only needs a new configuration. The secondary
+// range is covered by every frame, so a secondary configuration is not measured.
+#define BANDS_HWAAS 16U
+
+// Hibernation (RADAR_MODE_HIBERNATE). Between wakeups the sensor is disabled in hibernation, which
+// keeps its state, so a wakeup measures without a new sensor start-up. The bands measure a single
+// configuration and are only prepared again after a new configuration or a sensor calibration.
+// The detector prepares every frame anyway, as a detector result can take more than one
+// sensor configuration.
+
+// Profile of where a wakeup's time goes, counted with the DWT cycle counter from the start of a
+// collection. Zones inside do_*_get_next() also count the secondary, PROFILE_ZONE_AWAKE is the
+// whole wakeup up to the sleep, and the histogram bins are ACC_INTEGRATION_PROFILE_BIN_LIMIT_US().
+#define PROFILE_DUMP_INTERVAL 256
+#define PROFILE_MSG_MAX_LEN 128
+#ifdef JJH_USE_PROFILE
+#define PROFILE_BEGIN(zone) acc_integration_profile_begin(&profile_zones[zone])
+#define PROFILE_END(zone) acc_integration_profile_end(&profile_zones[zone])
+#else
+#define PROFILE_BEGIN(zone) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#endif
+
+// Energy estimate of the radar module, sent when a configuration is received and before the sensor
+// starts. The currents are rough figures for the XM125, replace them with ones measured on the board.
+// The times start as a guess and are calibrated every PROFILE_DUMP_INTERVAL wakeups and at a stop with
+// the profile of the wakeups since the previous calibration, leaving out wakeups that calibrated the
+// sensor or moved the range window, so an estimate is only as good as the collections run since the last reset.
+#define ENERGY_SENSOR_MA 35.0f   // sensor measuring, MCU included
+#define ENERGY_MCU_MA 8.0f       // MCU at 80 MHz, sensor disabled
+#define ENERGY_SLEEP_MA 0.015f   // STOP mode, sensor disabled
+#define ENERGY_BATTERY_MAH 3000.0f
+#define ENERGY_TARGET_DAYS 90.0f
+
+// Calibration cache in the CAL_CACHE flash region, see STM32L431CBYx_FLASH.ld.
+// Sensor and dynamic detector calibrations are valid within 15 degrees of the temperature they were
+// made at, so like example_detector_distance_calibration_caching.c one entry is kept per 16 degrees
+// over -40 to 85 degrees. The static detector calibration only depends on the configuration.
+#define CAL_CACHE_MAGIC 0x4843414AU // "JACH"
+#define CAL_CACHE_VERSION 1
+#define CAL_CACHE_MAX_TEMP_DIFF 16
+#define CAL_CACHE_MAX_ENTRIES ((125 / CAL_CACHE_MAX_TEMP_DIFF) + 1)
+#define CAL_CACHE_FLASH_ALIGN 8 // flash is programmed a double word at a time
+
+// Everything sent to the ESP32 is queued and sent by the USART1 TX DMA, so a frame doesn't hold
+// up the measurement loop for its time on the wire. A power of two, so the free running indexes
+// wrap with the uint16_t they are kept in.
+#define UART_TX_QUEUE_SIZE 1024U
+
 typedef struct
 {
   acc_sensor_t                      *sensor;
@@ -126,9 +289,154 @@ typedef struct
   bool testing_update_rate;
   float true_update_rate;
   int low_power_mode;
+  uint8_t mode_flags;
+  uint8_t filter_window;
+  uint16_t aggregate_s;
+  float secondary_start_m;
+  float secondary_end_m;
+  int secondary_max_step_length;
+  int secondary_max_profile;
+  uint16_t secondary_interval; // primary measurements per secondary measurement, 0 = off
 } config_settings_t;
 
+typedef struct
+{
+  uint8_t  num_distances;
+  float    distances[MAX_DISTANCES];
+  float    strengths[MAX_DISTANCES];
+  uint32_t tick; // HAL_GetTick() of the measurement
+} filter_sample_t;
+
+typedef struct
+{
+  acc_order_statistics_window_t window;
+  float                         ring[FILTER_MAX_WINDOW];
+  float                         sorted[FILTER_MAX_WINDOW];
+  filter_sample_t               delay[FILTER_MAX_WINDOW]; // measurements in push order, empty ones too
+  uint32_t                      pushed;
+  uint32_t                      popped;
+} outlier_filter_t;
+
+typedef struct
+{
+  float    distances[AGGREGATE_MAX_SAMPLES]; // reservoir sample of the period's inliers
+  uint16_t stored;
+  uint16_t samples;
+  uint16_t outliers;
+  uint16_t empty;
+  float    min;
+  float    max;
+  float    strength_sum;
+  uint32_t start_tick;
+  uint32_t random_state;
+} aggregate_t;
+
+typedef struct
+{
+  acc_order_statistics_window_t window;
+  float                         ring[RATE_WINDOW];
+  float                         sorted[RATE_WINDOW];
+  float                         max_rate; // configured update rate
+  float                         rate;
+  float                         spread;   // of the window that made the last change
+} rate_scheduler_t;
+
+typedef struct
+{
+  float    width;        // configured end_m - start_m, 0 if tracking is off
+  float    start_m;      // measured range, the search range while searching
+  float    end_m;
+  float    estimate;     // smoothed strongest distance
+  bool     have_estimate;
+  bool     searching;
+  uint16_t empty;        // measurements without a distance in a row
+} tracking_t;
+
+typedef struct
+{
+  acc_config_t              *config;
+  acc_processing_t          *processing;
+  acc_processing_metadata_t metadata;
+  acc_band_distance_band_t  bands[ACC_BAND_DISTANCE_MAX_BANDS];
+  uint8_t                   num_bands;
+  float                     *work;
+  bool                      prepared; // the sensor holds config, kept through hibernation
+} band_resources_t;
+
+typedef enum
+{
+  PROFILE_ZONE_PREPARE,
+  PROFILE_ZONE_MEASURE,
+  PROFILE_ZONE_WAIT,
+  PROFILE_ZONE_READ,
+  PROFILE_ZONE_PROCESS,
+  PROFILE_ZONE_SEND,
+  PROFILE_ZONE_UART_FLUSH,
+  PROFILE_ZONE_AWAKE,
+  PROFILE_ZONE_COUNT
+} profile_zone_id_t;
+
+// Profile of the wakeups since the energy model was last calibrated
+typedef struct
+{
+  uint64_t sensor_cycles;
+  uint64_t awake_cycles;
+  uint32_t wakeups;
+  uint64_t sensor_total; // zone totals at the end of the previous wakeup
+  uint64_t awake_total;
+  bool     skip;         // the wakeup calibrated or moved, so it isn't counted
+} energy_wakeups_t;
+
+typedef struct
+{
+  uint8_t           buffer[UART_TX_QUEUE_SIZE];
+  volatile uint16_t head;       // written by the main loop
+  volatile uint16_t tail;       // advanced when a transfer completes
+  volatile uint16_t in_flight;  // bytes from tail the DMA is sending, 0 when idle
+} uart_tx_queue_t;
+
+typedef struct
+{
+  int16_t                           temperature;
+  acc_cal_result_t                  sensor_cal_result;
+  acc_detector_cal_result_dynamic_t detector_cal_result_dynamic;
+} cal_cache_entry_t;
+
+// Flash layout: this struct, padded to CAL_CACHE_FLASH_ALIGN, then the static detector calibration
+typedef struct
+{
+  uint32_t          magic;
+  uint16_t          version;
+  uint16_t          count;
+  uint32_t          config_hash;  // detector settings, static calibration size and RSS version
+  uint32_t          static_size;
+  uint16_t          entries_crc;
+  uint16_t          static_crc;
+  uint16_t          in_use;       // entry restored at the next start
+  cal_cache_entry_t entries[CAL_CACHE_MAX_ENTRIES];
+} cal_cache_t;
+
+extern const uint8_t _cal_cache_start[];
+extern const uint8_t _cal_cache_size[];
+
 static bool change_config = true;
+static uint8_t frame_sequence = 0;
+static outlier_filter_t outlier_filter;
+static aggregate_t aggregate;
+static rate_scheduler_t rate_scheduler;
+static int16_t rate_warmup = RATE_WARMUP_MEASUREMENTS; // measurements stamped so far, negative while skipping
+static uint16_t secondary_count;
+static tracking_t tracking;
+static cal_cache_t cal_cache;
+static uart_tx_queue_t uart_tx_queue;
+static uint16_t profile_count;
+static energy_wakeups_t energy_wakeups;
+#ifdef JJH_USE_PROFILE
+static acc_integration_profile_zone_t profile_zones[PROFILE_ZONE_COUNT];
+#endif
+#ifdef JJH_USE_ENERGY_ESTIMATE
+static acc_energy_model_t energy_model;
+#endif
 uint32_t sleep_time_ms;
 
 static void cleanup(distance_detector_resources_t *resources);
@@ -140,6 +448,14 @@ static void set_config(acc_detector_distance_config_t *detector_config, distance
 static bool initialize_detector_resources(distance_detector_resources_t *resources);
 
 
+static bool initialize_secondary_detector(const config_settings_t       *config,
+                                          distance_detector_resources_t *secondary,
+                                          distance_detector_resources_t *primary);
+
+
+static void cleanup_secondary_detector(distance_detector_resources_t *secondary);
+
+
 static bool do_sensor_calibration(acc_sensor_t     *sensor,
                                   acc_cal_result_t *sensor_cal_result,
                                   void             *buffer,
@@ -152,6 +468,34 @@ static bool do_full_detector_calibration(distance_detector_resources_t *resource
 static bool do_detector_calibration_update(distance_detector_resources_t *resources,
                                            const acc_cal_result_t        *sensor_cal_result);
 
+static bool cal_cache_restore(const config_settings_t       *config,
+                              distance_detector_resources_t *resources,
+                              acc_cal_result_t              *sensor_cal_result);
+
+
+static bool cal_cache_lookup(int16_t                       temperature,
+                             distance_detector_resources_t *resources,
+                             acc_cal_result_t              *sensor_cal_result);
+
+
+static void cal_cache_store(const config_settings_t             *config,
+                            const distance_detector_resources_t *resources,
+                            const acc_cal_result_t              *sensor_cal_result,
+                            bool                                full_calibration);
+
+
+static uint32_t cal_cache_config_hash(const config_settings_t *config, uint32_t static_size);
+
+
+static uint32_t cal_cache_static_offset(void);
+
+
+static bool cal_cache_write(const uint8_t *detector_cal_result_static);
+
+
+static bool flash_program(uint32_t address, const uint8_t *data, uint32_t length);
+
+
 static bool do_detector_get_next(distance_detector_resources_t  *resources,
                                  const acc_cal_result_t         *sensor_cal_result,
                                  acc_detector_distance_result_t *result);
@@ -159,6 +503,135 @@ static bool do_detector_get_next(distance_detector_resources_t  *resources,
 static void print_distance_result(const acc_detector_distance_result_t *result);
 
 
+static void send_distance_frame(const acc_detector_distance_result_t *result, const uint32_t *timestamp_ms);
+
+
+static void send_config_frame(uint8_t config_index, const acc_detector_distance_result_t *result);
+
+
+static void send_filtered_frame(const acc_detector_distance_result_t *result, uint32_t age_ms);
+
+
+static uint8_t encode_distances(const acc_detector_distance_result_t *result, uint8_t *payload);
+
+
+static void send_distance_result(const config_settings_t *config, const acc_detector_distance_result_t *result);
+
+
+static void filter_and_send_result(const config_settings_t *config, const acc_detector_distance_result_t *result);
+
+
+static void send_filter_output(const config_settings_t *config, bool drain);
+
+
+static void flush_filtered_results(const config_settings_t *config);
+
+
+static void outlier_filter_init(outlier_filter_t *filter, uint8_t window_length);
+
+
+static void outlier_filter_push(outlier_filter_t *filter, const acc_detector_distance_result_t *result);
+
+
+static bool outlier_filter_pop(outlier_filter_t *filter, bool drain, filter_sample_t *ready, bool *outlier);
+
+
+static void aggregate_reset(aggregate_t *aggregate);
+
+
+static void aggregate_add(aggregate_t *aggregate, const acc_detector_distance_result_t *result, bool outlier);
+
+
+static void send_aggregate_frame(aggregate_t *aggregate, uint32_t period_ms);
+
+
+static void rate_scheduler_init(rate_scheduler_t *scheduler, float max_rate);
+
+
+static bool rate_scheduler_update(rate_scheduler_t *scheduler, const acc_detector_distance_result_t *result);
+
+
+static void set_update_rate(float update_rate);
+
+
+static void send_rate_frame(uint32_t period_ms, float spread_m);
+
+
+static void tracking_init(tracking_t *tracking, const config_settings_t *config, bool enabled);
+
+
+static bool tracking_update(tracking_t *tracking, const config_settings_t *config, const acc_detector_distance_result_t *result);
+
+
+static bool tracking_moved(const tracking_t *tracking, const config_settings_t *config);
+
+
+static bool move_detector_range(const config_settings_t       *config,
+                                const tracking_t              *tracking,
+                                distance_detector_resources_t *resources,
+                                const acc_cal_result_t        *sensor_cal_result);
+
+
+static void send_window_frame(const tracking_t *tracking);
+
+
+static bool create_bands(const config_settings_t       *config,
+                         const tracking_t              *tracking,
+                         band_resources_t              *bands,
+                         distance_detector_resources_t *resources);
+
+
+static void cleanup_bands(band_resources_t *bands);
+
+
+static bool sensor_power_down(acc_sensor_t *sensor, bool hibernate);
+
+
+static bool sensor_power_up(const acc_sensor_t *sensor, bool hibernate);
+
+
+static bool do_bands_get_next(band_resources_t                    *bands,
+                              const distance_detector_resources_t *resources,
+                              const acc_cal_result_t              *sensor_cal_result,
+                              float                               threshold_sensitivity,
+                              acc_detector_distance_result_t      *result);
+
+
+static void profile_reset(void);
+
+
+static void send_profile(void);
+
+
+#ifdef JJH_USE_ENERGY_ESTIMATE
+static uint32_t energy_points(const config_settings_t *config);
+#endif
+
+
+static void energy_wakeup_end(void);
+
+
+static void energy_calibrate(const config_settings_t *config);
+
+
+static void send_energy_estimate(const config_settings_t *config);
+
+
+static void send_text_message(uint8_t cmd, const char *text);
+
+
+static void send_frame(uint8_t cmd, const uint8_t *payload, uint8_t length);
+
+
+static uint16_t distance_to_mm(float distance_m);
+
+
+static int16_t strength_to_cdb(float strength_db);
+
+
+static uint16_t crc16_ccitt(const uint8_t *data, uint16_t length);
+
+
 static bool get_esp32_serial(char *result, uint16_t buf_size);
 
 
@@ -168,12 +641,18 @@ static void empty_uart_input_buffer(void);
 static bool load_config(config_settings_t *config);
 
 
+static float parse_decimal(const char *text);
+
+
 static bool wait_for_command(uint8_t send, uint8_t receive, int timeout_s);
 
 
 static void set_custom_config(config_settings_t *config, acc_detector_distance_config_t *detector_config);
 
 
+static void set_detector_config(const config_settings_t *config, acc_detector_distance_config_t *detector_config);
+
+
 HAL_StatusTypeDef send_esp32_serial(const uint8_t *message, uint16_t msg_length);
 
 
@@ -183,6 +662,21 @@ void send_esp32_serial_byte(uint8_t byte);
 static void debug_print(const char *format, ...);
 
 
+static void uart_tx_write(const uint8_t *data, uint16_t length);
+
+
+static void uart_tx_start(void);
+
+
+static void uart_tx_kick(void);
+
+
+static void uart_tx_wait(void);
+
+
+static void uart_tx_flush(void);
+
+
 int acconeer_main_JJH_V2(int argc, char *argv[]);
 
 
@@ -192,6 +686,8 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
   (void)argc;
   (void)argv;
   distance_detector_resources_t resources = { 0 };
+  distance_detector_resources_t secondary_resources = { 0 }; // shares sensor and buffer with resources
+  band_resources_t bands = { 0 };                            // shares sensor and buffer with resources
 
   config_settings_t current_config;
   uint32_t startTime = HAL_GetTick();
@@ -218,6 +714,16 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
+  // Everything allocated for a configuration is released when it changes
+  const acc_integration_mem_mark_t config_mem_mark = acc_integration_mem_mark();
+
+#ifdef JJH_USE_PROFILE
+  acc_integration_profile_init();
+#endif
+#ifdef JJH_USE_ENERGY_ESTIMATE
+  acc_energy_model_init(&energy_model, ENERGY_SENSOR_MA, ENERGY_MCU_MA, ENERGY_SLEEP_MA);
+#endif
+
   resources.config = acc_detector_distance_config_create();
   if (resources.config == NULL)
   {
@@ -231,6 +737,10 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
   acc_integration_set_periodic_wakeup(sleep_time_ms);
   current_config.update_rate = DEFAULT_UPDATE_RATE;
   current_config.testing_update_rate = false;
+  current_config.mode_flags = 0;
+  current_config.filter_window = 0;
+  current_config.aggregate_s = 0;
+  current_config.secondary_interval = 0;
   acc_cal_result_t sensor_cal_result;
 
   state = 1;
@@ -240,7 +750,10 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
     // ---------------- STATE 1: SET CONFIG ----------------
     if (state == 1){
       while (change_config){
+        cleanup_secondary_detector(&secondary_resources);
+        cleanup_bands(&bands);
         cleanup(&resources);
+        acc_integration_mem_release(config_mem_mark);
 
         resources.config = acc_detector_distance_config_create();
         if (resources.config == NULL)
@@ -257,6 +770,8 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
         }
       }
 
+      send_energy_estimate(&current_config);
+
       if (!initialize_detector_resources(&resources))
       {
         debug_print("Initializing detector resources failed\n");
@@ -281,23 +796,84 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
         return EXIT_FAILURE;
       }
 
-      if (!do_sensor_calibration(resources.sensor, &sensor_cal_result, resources.buffer, resources.buffer_size))
+      bool binary_frames = (current_config.mode_flags & RADAR_MODE_BINARY_FRAMES) != 0;
+      bool rate_warmup_mode = binary_frames && (current_config.mode_flags & RADAR_MODE_RATE_WARMUP);
+      bool band_mode = (current_config.mode_flags & RADAR_MODE_BANDS) &&
+                       current_config.secondary_end_m > current_config.secondary_start_m;
+      bool secondary_mode = binary_frames && current_config.secondary_interval > 0 && !band_mode;
+      bool tracking_mode = binary_frames && (current_config.mode_flags & RADAR_MODE_TRACKING) &&
+                           current_config.secondary_end_m > current_config.secondary_start_m;
+
+      tracking_init(&tracking, &current_config, tracking_mode);
+
+      // Before any calibration, the secondary may need a larger sensor buffer
+      if (secondary_mode && !initialize_secondary_detector(&current_config, &secondary_resources, &resources))
+      {
+        debug_print("Initializing secondary detector failed\n");
+        cleanup(&resources);
+        return EXIT_FAILURE;
+      }
+
+      // Also before any calibration, the bands may need a larger sensor buffer
+      if (band_mode && !create_bands(&current_config, &tracking, &bands, &resources))
       {
-        debug_print("Sensor calibration failed\n");
+        debug_print("Initializing bands failed\n");
         cleanup(&resources);
         return EXIT_FAILURE;
       }
 
-      if (!do_full_detector_calibration(&resources, &sensor_cal_result))
+      // A cached calibration for this configuration skips both calibrations and the settle delay.
+      // If the temperature has moved since, the first result asks for a calibration and the
+      // "calibration needed" handling below picks or makes one for the new temperature.
+      if (!band_mode && cal_cache_restore(&current_config, &resources, &sensor_cal_result))
+      {
+        debug_print("Using cached calibration for %d degrees Celsius\n", cal_cache.entries[cal_cache.in_use].temperature);
+      }
+      else
+      {
+        if (!do_sensor_calibration(resources.sensor, &sensor_cal_result, resources.buffer, resources.buffer_size))
+        {
+          debug_print("Sensor calibration failed\n");
+          cleanup(&resources);
+          return EXIT_FAILURE;
+        }
+
+        // The bands only need the sensor calibration
+        if (!band_mode)
+        {
+          if (!do_full_detector_calibration(&resources, &sensor_cal_result))
+          {
+            debug_print("Detector calibration failed\n");
+            cleanup(&resources);
+            return EXIT_FAILURE;
+          }
+
+          cal_cache_store(&current_config, &resources, &sensor_cal_result, true);
+        }
+
+        HAL_Delay(3000);
+      }
+
+      // The cache only holds the primary, the secondary always gets a full calibration
+      if (secondary_mode && !do_full_detector_calibration(&secondary_resources, &sensor_cal_result))
       {
-        debug_print("Detector calibration failed\n");
+        debug_print("Secondary detector calibration failed\n");
         cleanup(&resources);
         return EXIT_FAILURE;
       }
 
-      HAL_Delay(3000);
+      uint32_t mem_used;
+      uint32_t mem_high_water_mark;
+      uint32_t mem_size;
 
-      if (current_config.testing_update_rate){
+      acc_integration_mem_usage(&mem_used, &mem_high_water_mark, &mem_size);
+      debug_print("Memory: %u of %u bytes used, high water mark %u\n",
+                  (unsigned int)mem_used, (unsigned int)mem_size, (unsigned int)mem_high_water_mark);
+
+      profile_reset();
+      PROFILE_BEGIN(PROFILE_ZONE_AWAKE);
+
+      if (current_config.testing_update_rate && !rate_warmup_mode){
         update_counter = -3;
         startTime = HAL_GetTick();
         uint32_t sixTime = sleep_time_ms * 6;         // time period for six measurements to occur
@@ -306,6 +882,12 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
       }
       // start data collection
       else{
+        frame_sequence = 0;
+        outlier_filter_init(&outlier_filter, current_config.filter_window);
+        aggregate_reset(&aggregate);
+        rate_scheduler_init(&rate_scheduler, current_config.update_rate);
+        rate_warmup = current_config.testing_update_rate ? -RATE_WARMUP_SKIP : RATE_WARMUP_MEASUREMENTS;
+        secondary_count = 0;
         send_esp32_serial_byte(RADAR_CMD_START_DATA);
         state = 3;
       }
@@ -317,18 +899,31 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
       while (!change_config)
       {
         acc_detector_distance_result_t result = { 0 };
+        bool band_mode = bands.processing != NULL;
+        bool hibernate = (current_config.mode_flags & RADAR_MODE_HIBERNATE) != 0;
+        bool result_ok = band_mode ?
+                         do_bands_get_next(&bands, &resources, &sensor_cal_result, current_config.threshold_sensitivity, &result) :
+                         do_detector_get_next(&resources, &sensor_cal_result, &result);
 
-        if (!do_detector_get_next(&resources, &sensor_cal_result, &result))
+        if (!result_ok)
         {
           debug_print("Could not get next result\n");
           cleanup(&resources);
           return EXIT_FAILURE;
         }
 
-        /* If "calibration needed" is indicated, the sensor needs to be recalibrated and the detector calibration updated */
+        uint32_t measured_ms = HAL_GetTick();
+
+        // A calibration stays awake into the next measurement, a wakeup the energy model shouldn't see
         if (result.calibration_needed)
         {
-          debug_print("Sensor recalibration and detector calibration update needed ... \n");
+          energy_wakeups.skip = true;
+        }
+
+        /* If "calibration needed" is indicated, the sensor needs to be recalibrated and the detector calibration updated */
+        if (result.calibration_needed && band_mode)
+        {
+          debug_print("Sensor recalibration needed ... \n");
 
           if (!do_sensor_calibration(resources.sensor, &sensor_cal_result, resources.buffer, resources.buffer_size))
           {
@@ -337,24 +932,168 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
             return EXIT_FAILURE;
           }
 
-          /* Once the sensor is recalibrated, the detector calibration should be updated and measuring can continue. */
-          if (!do_detector_calibration_update(&resources, &sensor_cal_result))
+          // The calibration measured with its own configuration
+          bands.prepared = false;
+
+          debug_print("Sensor recalibration done!\n");
+        }
+        else if (result.calibration_needed)
+        {
+          // The cache is for the configured range, a moved window is calibrated like without it
+          bool moved = tracking_moved(&tracking, &current_config);
+          if (!moved && cal_cache_lookup(result.temperature, &resources, &sensor_cal_result))
+          {
+            debug_print("Using cached calibration for %d degrees Celsius\n", cal_cache.entries[cal_cache.in_use].temperature);
+          }
+          else
+          {
+            debug_print("Sensor recalibration and detector calibration update needed ... \n");
+
+            if (!do_sensor_calibration(resources.sensor, &sensor_cal_result, resources.buffer, resources.buffer_size))
+            {
+              debug_print("Sensor calibration failed\n");
+              cleanup(&resources);
+              return EXIT_FAILURE;
+            }
+
+            /* Once the sensor is recalibrated, the detector calibration should be updated and measuring can continue. */
+            if (!do_detector_calibration_update(&resources, &sensor_cal_result))
+            {
+              debug_print("Detector calibration update failed\n");
+              cleanup(&resources);
+              return EXIT_FAILURE;
+            }
+
+            if (!moved)
+            {
+              cal_cache_store(&current_config, &resources, &sensor_cal_result, false);
+            }
+
+            debug_print("Sensor recalibration and detector calibration update done!\n");
+          }
+
+          // Both detectors share the sensor calibration
+          if (secondary_resources.handle != NULL && !do_detector_calibration_update(&secondary_resources, &sensor_cal_result))
           {
-            debug_print("Detector calibration update failed\n");
+            debug_print("Secondary detector calibration update failed\n");
             cleanup(&resources);
             return EXIT_FAILURE;
           }
-
-          debug_print("Sensor recalibration and detector calibration update done!\n");
         }
         else
         {
-          acc_hal_integration_sensor_disable(SENSOR_ID);
-          print_distance_result(&result);
+          bool warming_up = (state == 3 && rate_warmup < RATE_WARMUP_MEASUREMENTS);
+
+          // The secondary is measured in the same wakeup, while the sensor is still enabled
+          acc_detector_distance_result_t secondary_result = { 0 };
+          bool secondary_due = false;
+          if (state == 3 && !warming_up && secondary_resources.handle != NULL &&
+              ++secondary_count >= current_config.secondary_interval)
+          {
+            secondary_count = 0;
+            secondary_due = true;
+            if (!do_detector_get_next(&secondary_resources, &sensor_cal_result, &secondary_result))
+            {
+              debug_print("Could not get next secondary result\n");
+              cleanup(&resources);
+              return EXIT_FAILURE;
+            }
+          }
+
+          // A move is calibrated straight away, so the next wakeup measures the new range
+          bool window_moved = false;
+          if (state == 3 && !warming_up && tracking.width > 0.0f && tracking_update(&tracking, &current_config, &result))
+          {
+            bool moved = band_mode ? create_bands(&current_config, &tracking, &bands, &resources) :
+                         move_detector_range(&current_config, &tracking, &resources, &sensor_cal_result);
+            if (!moved)
+            {
+              debug_print("Moving the range window failed\n");
+              cleanup(&resources);
+              return EXIT_FAILURE;
+            }
+            secondary_resources.buffer      = resources.buffer;
+            secondary_resources.buffer_size = resources.buffer_size;
+            window_moved = true;
+            energy_wakeups.skip = true;
+          }
+
+          if (!sensor_power_down(resources.sensor, hibernate))
+          {
+            cleanup(&resources);
+            return EXIT_FAILURE;
+          }
+
+          // Without hibernation the sensor forgets its configuration
+          bands.prepared = bands.prepared && hibernate;
+
+          PROFILE_BEGIN(PROFILE_ZONE_SEND);
+
+          // The update rate test and warm-up count every measurement, so they always get them unfiltered
+          if (warming_up && rate_warmup >= 0)
+          {
+            send_distance_frame(&result, &measured_ms);
+          }
+          else if (state == 3 && !warming_up && (current_config.filter_window > 0 || current_config.aggregate_s > 0))
+          {
+            filter_and_send_result(&current_config, &result);
+          }
+          else
+          {
+            send_distance_result(&current_config, &result);
+          }
+
+          // A temperature change shows up in the primary's next result as well, which recalibrates both
+          if (secondary_due && !secondary_result.calibration_needed)
+          {
+            send_config_frame(SECONDARY_CONFIG_INDEX, &secondary_result);
+          }
+
+          if (window_moved)
+          {
+            send_window_frame(&tracking);
+          }
+
+          // The warm-up needs a fixed period, so the adaptive rate starts after it. A new period
+          // starts at this measurement, and is announced before the ESP32 goes to sleep
+          bool adaptive_rate = (current_config.mode_flags & (RADAR_MODE_BINARY_FRAMES | RADAR_MODE_ADAPTIVE_RATE)) ==
+                               (RADAR_MODE_BINARY_FRAMES | RADAR_MODE_ADAPTIVE_RATE);
+          if (warming_up)
+          {
+            rate_warmup++;
+          }
+          else if (state == 3 && adaptive_rate && rate_scheduler_update(&rate_scheduler, &result))
+          {
+            set_update_rate(rate_scheduler.rate);
+            send_rate_frame((uint32_t)(1000.0f / rate_scheduler.rate + 0.5f), rate_scheduler.spread);
+          }
+
+          PROFILE_END(PROFILE_ZONE_SEND);
+
+          if (state == 3 && ++profile_count >= PROFILE_DUMP_INTERVAL)
+          {
+            profile_count = 0;
+            energy_calibrate(&current_config);
+            if (current_config.mode_flags & RADAR_MODE_PROFILE)
+            {
+              send_profile();
+            }
+          }
+
           send_esp32_serial_byte(RADAR_CMD_NOISE_ON);
+          PROFILE_BEGIN(PROFILE_ZONE_UART_FLUSH);
+          uart_tx_flush();
+          PROFILE_END(PROFILE_ZONE_UART_FLUSH);
+          PROFILE_END(PROFILE_ZONE_AWAKE);
+          energy_wakeup_end();
           acc_integration_sleep_until_periodic_wakeup();
+          PROFILE_BEGIN(PROFILE_ZONE_AWAKE);
           send_esp32_serial_byte(RADAR_CMD_NOISE_OFF);
-          acc_hal_integration_sensor_enable(SENSOR_ID);
+          if (!sensor_power_up(resources.sensor, hibernate))
+          {
+            cleanup(&resources);
+            return EXIT_FAILURE;
+          }
         }
 
         // Handle testing mode specific logic
@@ -379,9 +1118,31 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
 
         if (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_10) == GPIO_PIN_RESET)
         {
-          int timeout = (int)(3.0f / current_config.update_rate);
+          int timeout = (int)(3U * sleep_time_ms / 1000U);
+
+          // What is still in the outlier filter or the unfinished aggregate goes out before the
+          // stop request. The ESP32 has its UART removed while it holds the line low, so wait
+          // for it to let go first.
+          if (state == 3 && (current_config.filter_window > 0 || current_config.aggregate_s > 0))
+          {
+            uint32_t low_tick = HAL_GetTick();
+
+            while (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_10) == GPIO_PIN_RESET &&
+                   (HAL_GetTick() - low_tick) < (uint32_t)(4 + timeout) * 1000U)
+            {
+              HAL_Delay(10);
+            }
+
+            flush_filtered_results(&current_config);
+          }
+
           if (wait_for_command(RADAR_CMD_STOP_REQUEST, RADAR_CMD_STOP_CONFIRM, 4 + timeout))
           {
+            energy_calibrate(&current_config);
+            if (current_config.mode_flags & RADAR_MODE_PROFILE)
+            {
+              send_profile();
+            }
             change_config = true;
             state = 1;
           }
@@ -394,6 +1155,8 @@ int acconeer_main_JJH_V2(int argc, char *argv[])
     }
   }
 
+  cleanup_secondary_detector(&secondary_resources);
+  cleanup_bands(&bands);
   cleanup(&resources);
 
   debug_print("Done!\n");
@@ -456,8 +1219,8 @@ static bool load_config(config_settings_t *config){
   // request config from ESP32
   send_esp32_serial_byte(RADAR_CMD_REQUEST_CONFIG);
 
-  // should receive 40 + two header + $ (RADAR_CMD_CONFIG_STRING) + null terminator
-  while (!get_esp32_serial(_received_uart_data, 44)){
+  // should receive up to 73 + two header + $ (RADAR_CMD_CONFIG_STRING) + null terminator
+  while (!get_esp32_serial(_received_uart_data, CONFIG_STRING_LENGTH)){
     if ((HAL_GetTick() - startTime) > CONFIG_TIMEOUT_MS){
       startTime = HAL_GetTick();
       send_esp32_serial_byte(RADAR_CMD_REQUEST_CONFIG);
@@ -469,9 +1232,14 @@ static bool load_config(config_settings_t *config){
   send_esp32_serial((uint8_t*)_received_uart_data, strlen(_received_uart_data));
 
   // Check if received data fits format
-  // format: "O:$00.40,01.20,05.0,02,5,35.0,1,0.50,0,05.1\0"
-  //   start_m, end_m, update_rate, max_step_length, max_profile, signal_quality, reflector_shape, threshold_sensitivity, testing_update_rate, true_update_rate
-  //   float,   float, float,       int,             int,         float,          int,             float,                 int,                 float
+  // format: "O:$00.40,01.20,05.0,02,5,35.0,1,0.50,0,05.1,01,13,0010,00.20,06.00,08,5,0020\0"
+  //   start_m, end_m, update_rate, max_step_length, max_profile, signal_quality, reflector_shape, threshold_sensitivity, testing_update_rate, true_update_rate, mode_flags, filter_window, aggregate_s,
+  //   float,   float, float,       int,             int,         float,          int,             float,                 int,                 float,            hex,        int,           int,
+  //   secondary_start_m, secondary_end_m, secondary_max_step_length, secondary_max_profile, secondary_interval
+  //   float,             float,           int,                       int,                   int
+  // mode_flags is optional so older ESP32 firmware (10 fields) keeps getting the text protocol,
+  // filter_window and aggregate_s are only sent when one of them or the secondary is set,
+  // the secondary fields only when secondary_interval is set
 
   // Skip past the header "O:$" to get to the actual data
   char *data_start = strchr(_received_uart_data, RADAR_CMD_CONFIG_STRING);
@@ -486,25 +1254,52 @@ static bool load_config(config_settings_t *config){
   char *token;
   int field_count = 0;
 
+  config->mode_flags = 0;
+  config->filter_window = 0;
+  config->aggregate_s = 0;
+  config->secondary_interval = 0;
   token = strtok(data_start, ",");
-  while (token != NULL && field_count < 10) {
+  while (token != NULL && field_count < CONFIG_FIELDS_SECONDARY) {
     switch (field_count) {
-      case 0: config->start_m = atof(token); break;
-      case 1: config->end_m = atof(token); break;
-      case 2: config->update_rate = atof(token); break;
+      case 0: config->start_m = parse_decimal(token); break;
+      case 1: config->end_m = parse_decimal(token); break;
+      case 2: config->update_rate = parse_decimal(token); break;
       case 3: config->max_step_length = atoi(token); break;
       case 4: config->max_profile = atoi(token); break;
-      case 5: config->signal_quality = atof(token); break;
+      case 5: config->signal_quality = parse_decimal(token); break;
       case 6: config->reflector_shape = atoi(token); break;
-      case 7: config->threshold_sensitivity = atof(token); break;
+      case 7: config->threshold_sensitivity = parse_decimal(token); break;
       case 8: config->testing_update_rate = atoi(token); break;
-      case 9: config->true_update_rate = atof(token); break;
+      case 9: config->true_update_rate = parse_decimal(token); break;
+      case 10: config->mode_flags = (uint8_t)strtol(token, NULL, 16); break;
+      case 11: config->filter_window = (uint8_t)atoi(token); break;
+      case 12: config->aggregate_s = (uint16_t)atoi(token); break;
+      case 13: config->secondary_start_m = parse_decimal(token); break;
+      case 14: config->secondary_end_m = parse_decimal(token); break;
+      case 15: config->secondary_max_step_length = atoi(token); break;
+      case 16: config->secondary_max_profile = atoi(token); break;
+      case 17: config->secondary_interval = (uint16_t)atoi(token); break;
     }
     token = strtok(NULL, ",");
     field_count++;
   }
 
-  if (field_count == 10) {
+  uint8_t left_out = 0;
+#ifndef JJH_USE_BANDS
+  left_out |= RADAR_MODE_BANDS;
+#endif
+#ifndef JJH_USE_PROFILE
+  left_out |= RADAR_MODE_PROFILE;
+#endif
+  if (config->mode_flags & left_out) {
+    debug_print("Mode flags 0x%02x are not built in, ignored\n", (unsigned int)(config->mode_flags & left_out));
+    config->mode_flags &= (uint8_t)~left_out;
+  }
+
+  bool field_count_ok = (field_count == CONFIG_FIELDS_LEGACY || field_count == CONFIG_FIELDS_MODE ||
+                         field_count == CONFIG_FIELDS || field_count == CONFIG_FIELDS_SECONDARY);
+
+  if (field_count_ok && config->filter_window <= FILTER_MAX_WINDOW) {
     send_esp32_serial_byte(RADAR_CMD_CONFIG_GOOD);
     return true;
   }
@@ -515,6 +1310,36 @@ static bool load_config(config_settings_t *config){
 }
 
 
+// Config fields are plain decimals like "05.1". atof() would link strtod() with its hex, nan and
+// locale handling, about 5 KB of the flash left below the calibration cache.
+static float parse_decimal(const char *text) {
+  bool negative = (*text == '-');
+  float value = 0.0f;
+  float scale = 1.0f;
+  bool fraction = false;
+
+  if (*text == '-' || *text == '+') {
+    text++;
+  }
+
+  for (; *text != '\0'; text++) {
+    if (*text == '.' && !fraction) {
+      fraction = true;
+    } else if (*text >= '0' && *text <= '9') {
+      value = value * 10.0f + (float)(*text - '0');
+      if (fraction) {
+        scale *= 10.0f;
+      }
+    } else {
+      break;
+    }
+  }
+
+  value /= scale;
+  return negative ? -value : value;
+}
+
+
 static bool wait_for_command(uint8_t send, uint8_t receive, int timeout_s) {
   uint8_t _command_uart[4];  // Need 4 bytes: 2 header + 1 command + 1 null
   uint32_t start_time = HAL_GetTick() + 1001;
@@ -546,6 +1371,12 @@ static bool wait_for_command(uint8_t send, uint8_t receive, int timeout_s) {
 
 
 static void set_custom_config(config_settings_t *config, acc_detector_distance_config_t *detector_config){
+  set_detector_config(config, detector_config);
+  set_update_rate(config->update_rate);
+}
+
+
+static void set_detector_config(const config_settings_t *config, acc_detector_distance_config_t *detector_config){
   acc_detector_distance_config_start_set(detector_config, config->start_m);
   acc_detector_distance_config_end_set(detector_config, config->end_m);
   acc_detector_distance_config_max_step_length_set(detector_config, config->max_step_length);
@@ -553,10 +1384,6 @@ static void set_custom_config(config_settings_t *config, acc_detector_distance_c
   acc_detector_distance_config_reflector_shape_set(detector_config, config->reflector_shape);
   acc_detector_distance_config_threshold_sensitivity_set(detector_config, config->threshold_sensitivity);
   acc_detector_distance_config_signal_quality_set(detector_config, config->signal_quality);
-
-  sleep_time_ms = (uint32_t)(1000.0f * HAL_GETTICK_SCALAR / config->update_rate);
-  acc_integration_set_periodic_wakeup(sleep_time_ms);
-
   acc_detector_distance_config_peak_sorting_set(detector_config, ACC_DETECTOR_DISTANCE_PEAK_SORTING_STRONGEST);
   acc_detector_distance_config_threshold_method_set(detector_config, ACC_DETECTOR_DISTANCE_THRESHOLD_METHOD_CFAR);
   acc_detector_distance_config_close_range_leakage_cancellation_set(detector_config, false);
@@ -578,6 +1405,9 @@ static void cleanup(distance_detector_resources_t *resources)
   {
     acc_sensor_destroy(resources->sensor);
   }
+
+  // Configurations are cleaned up again when reloading fails
+  memset(resources, 0, sizeof(*resources));
 }
 
 
@@ -648,6 +1478,79 @@ static bool initialize_detector_resources(distance_detector_resources_t *resourc
 }
 
 
+static bool initialize_secondary_detector(const config_settings_t       *config,
+                                          distance_detector_resources_t *secondary,
+                                          distance_detector_resources_t *primary)
+{
+  secondary->config = acc_detector_distance_config_create();
+  if (secondary->config == NULL)
+  {
+    debug_print("acc_detector_distance_config_create() failed\n");
+    return false;
+  }
+
+  // Same detector settings as the primary, except for the range and how it is measured
+  set_detector_config(config, secondary->config);
+  acc_detector_distance_config_start_set(secondary->config, config->secondary_start_m);
+  acc_detector_distance_config_end_set(secondary->config, config->secondary_end_m);
+  acc_detector_distance_config_max_step_length_set(secondary->config, config->secondary_max_step_length);
+  acc_detector_distance_config_max_profile_set(secondary->config, config->secondary_max_profile);
+
+  secondary->handle = acc_detector_distance_create(secondary->config);
+  if (secondary->handle == NULL)
+  {
+    debug_print("acc_detector_distance_create() failed\n");
+    return false;
+  }
+
+  uint32_t buffer_size = 0;
+  if (!acc_detector_distance_get_sizes(secondary->handle, &buffer_size, &(secondary->detector_cal_result_static_size)))
+  {
+    debug_print("acc_detector_distance_get_sizes() failed\n");
+    return false;
+  }
+
+  // One sensor buffer, large enough for both detectors
+  if (buffer_size > primary->buffer_size)
+  {
+    acc_integration_mem_free(primary->buffer);
+    primary->buffer      = acc_integration_mem_alloc(buffer_size);
+    primary->buffer_size = buffer_size;
+    if (primary->buffer == NULL)
+    {
+      debug_print("sensor buffer allocation failed\n");
+      return false;
+    }
+  }
+
+  secondary->detector_cal_result_static = acc_integration_mem_alloc(secondary->detector_cal_result_static_size);
+  if (secondary->detector_cal_result_static == NULL)
+  {
+    debug_print("calibration buffer allocation failed\n");
+    return false;
+  }
+
+  secondary->sensor      = primary->sensor;
+  secondary->buffer      = primary->buffer;
+  secondary->buffer_size = primary->buffer_size;
+
+  acc_detector_distance_config_log(secondary->handle, secondary->config);
+
+  return true;
+}
+
+
+static void cleanup_secondary_detector(distance_detector_resources_t *secondary)
+{
+  // The sensor and the buffer belong to the primary
+  acc_detector_distance_config_destroy(secondary->config);
+  acc_detector_distance_destroy(secondary->handle);
+  acc_integration_mem_free(secondary->detector_cal_result_static);
+
+  memset(secondary, 0, sizeof(*secondary));
+}
+
+
 static bool do_sensor_calibration(acc_sensor_t     *sensor,
                                   acc_cal_result_t *sensor_cal_result,
                                   void             *buffer,
@@ -740,6 +1643,227 @@ static bool do_detector_calibration_update(distance_detector_resources_t *resour
 }
 
 
+static bool cal_cache_restore(const config_settings_t       *config,
+                              distance_detector_resources_t *resources,
+                              acc_cal_result_t              *sensor_cal_result)
+{
+  const cal_cache_t *stored        = (const cal_cache_t *)_cal_cache_start;
+  const uint8_t     *stored_static = _cal_cache_start + cal_cache_static_offset();
+  uint32_t          static_size    = resources->detector_cal_result_static_size;
+
+  // Nothing usable survives a failed restore, the next calibration starts the cache over
+  cal_cache.count = 0;
+
+  if (stored->magic != CAL_CACHE_MAGIC || stored->version != CAL_CACHE_VERSION ||
+      stored->config_hash != cal_cache_config_hash(config, static_size) || stored->static_size != static_size ||
+      stored->count == 0 || stored->count > CAL_CACHE_MAX_ENTRIES || stored->in_use >= stored->count ||
+      cal_cache_static_offset() + static_size > (uint32_t)(uintptr_t)_cal_cache_size)
+  {
+    return false;
+  }
+
+  if (crc16_ccitt((const uint8_t *)stored->entries, sizeof(stored->entries)) != stored->entries_crc ||
+      crc16_ccitt(stored_static, (uint16_t)static_size) != stored->static_crc)
+  {
+    debug_print("Calibration cache corrupt\n");
+    return false;
+  }
+
+  if (!acc_sensor_validate_calibration(&stored->entries[stored->in_use].sensor_cal_result))
+  {
+    debug_print("Cached sensor calibration invalid\n");
+    return false;
+  }
+
+  memcpy(&cal_cache, stored, sizeof(cal_cache));
+  memcpy(resources->detector_cal_result_static, stored_static, static_size);
+  *sensor_cal_result                     = cal_cache.entries[cal_cache.in_use].sensor_cal_result;
+  resources->detector_cal_result_dynamic = cal_cache.entries[cal_cache.in_use].detector_cal_result_dynamic;
+
+  return true;
+}
+
+
+static bool cal_cache_lookup(int16_t                       temperature,
+                             distance_detector_resources_t *resources,
+                             acc_cal_result_t              *sensor_cal_result)
+{
+  bool     found         = false;
+  uint16_t min_temp_diff = UINT16_MAX;
+
+  // With overlapping ranges the entry calibrated closest to the temperature wins
+  for (uint16_t index = 0; index < cal_cache.count; index++)
+  {
+    uint16_t temp_diff = (uint16_t)abs(cal_cache.entries[index].temperature - temperature);
+
+    if (temp_diff < CAL_CACHE_MAX_TEMP_DIFF && temp_diff < min_temp_diff)
+    {
+      min_temp_diff    = temp_diff;
+      cal_cache.in_use = index;
+      found            = true;
+    }
+  }
+
+  if (found)
+  {
+    *sensor_cal_result                     = cal_cache.entries[cal_cache.in_use].sensor_cal_result;
+    resources->detector_cal_result_dynamic = cal_cache.entries[cal_cache.in_use].detector_cal_result_dynamic;
+  }
+
+  return found;
+}
+
+
+static void cal_cache_store(const config_settings_t             *config,
+                            const distance_detector_resources_t *resources,
+                            const acc_cal_result_t              *sensor_cal_result,
+                            bool                                full_calibration)
+{
+  uint32_t       static_size = resources->detector_cal_result_static_size;
+  acc_cal_info_t cal_info;
+
+  if (cal_cache_static_offset() + static_size > (uint32_t)(uintptr_t)_cal_cache_size)
+  {
+    debug_print("Calibration too large to cache (%lu bytes)\n", (unsigned long)static_size);
+    return;
+  }
+
+  if (!acc_sensor_get_cal_info(sensor_cal_result, &cal_info))
+  {
+    return;
+  }
+
+  // A full calibration comes with a new static part, which invalidates every entry
+  if (full_calibration)
+  {
+    memset(&cal_cache, 0, sizeof(cal_cache));
+    cal_cache.magic       = CAL_CACHE_MAGIC;
+    cal_cache.version     = CAL_CACHE_VERSION;
+    cal_cache.config_hash = cal_cache_config_hash(config, static_size);
+    cal_cache.static_size = static_size;
+  }
+
+  uint16_t index = cal_cache.count;
+
+  if (index < CAL_CACHE_MAX_ENTRIES)
+  {
+    cal_cache.count++;
+  }
+  else
+  {
+    // Full, replace the entry calibrated furthest from this temperature
+    uint16_t max_temp_diff = 0;
+
+    for (uint16_t i = 0; i < cal_cache.count; i++)
+    {
+      uint16_t temp_diff = (uint16_t)abs(cal_cache.entries[i].temperature - cal_info.temperature);
+
+      if (temp_diff >= max_temp_diff)
+      {
+        max_temp_diff = temp_diff;
+        index         = i;
+      }
+    }
+  }
+
+  cal_cache.entries[index].temperature                 = cal_info.temperature;
+  cal_cache.entries[index].sensor_cal_result           = *sensor_cal_result;
+  cal_cache.entries[index].detector_cal_result_dynamic = resources->detector_cal_result_dynamic;
+  cal_cache.in_use                                     = index;
+  cal_cache.entries_crc = crc16_ccitt((const uint8_t *)cal_cache.entries, sizeof(cal_cache.entries));
+  cal_cache.static_crc  = crc16_ccitt(resources->detector_cal_result_static, (uint16_t)static_size);
+
+  if (!cal_cache_write(resources->detector_cal_result_static))
+  {
+    debug_print("Calibration cache write failed\n");
+  }
+}
+
+
+static uint32_t cal_cache_config_hash(const config_settings_t *config, uint32_t static_size)
+{
+  // FNV-1a over everything set_custom_config() hands to the detector
+  const void *fields[] = {
+    &config->start_m, &config->end_m, &config->max_step_length, &config->max_profile,
+    &config->signal_quality, &config->reflector_shape, &config->threshold_sensitivity, &static_size,
+  };
+  const size_t field_sizes[] = {
+    sizeof(config->start_m), sizeof(config->end_m), sizeof(config->max_step_length), sizeof(config->max_profile),
+    sizeof(config->signal_quality), sizeof(config->reflector_shape), sizeof(config->threshold_sensitivity), sizeof(static_size),
+  };
+  uint32_t hash = 2166136261U;
+
+  for (size_t field = 0; field < sizeof(fields) / sizeof(fields[0]); field++)
+  {
+    const uint8_t *bytes = fields[field];
+
+    for (size_t i = 0; i < field_sizes[field]; i++)
+    {
+      hash = (hash ^ bytes[i]) * 16777619U;
+    }
+  }
+
+  // Another RSS version may lay its calibration results out differently
+  for (const char *version = acc_version_get(); *version != '\0'; version++)
+  {
+    hash = (hash ^ (uint8_t)*version) * 16777619U;
+  }
+
+  return hash;
+}
+
+
+static uint32_t cal_cache_static_offset(void)
+{
+  return (sizeof(cal_cache_t) + CAL_CACHE_FLASH_ALIGN - 1) & ~(uint32_t)(CAL_CACHE_FLASH_ALIGN - 1);
+}
+
+
+static bool cal_cache_write(const uint8_t *detector_cal_result_static)
+{
+  uint32_t               start = (uint32_t)(uintptr_t)_cal_cache_start;
+  uint32_t               page_error;
+  FLASH_EraseInitTypeDef erase = {
+    .TypeErase = FLASH_TYPEERASE_PAGES,
+    .Banks     = FLASH_BANK_1,
+    .Page      = (start - FLASH_BASE) / FLASH_PAGE_SIZE,
+    .NbPages   = (uint32_t)(uintptr_t)_cal_cache_size / FLASH_PAGE_SIZE,
+  };
+
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+
+  // Static part first and the header with the magic last, so an interrupted write reads as no cache
+  bool status = HAL_FLASHEx_Erase(&erase, &page_error) == HAL_OK &&
+                flash_program(start + cal_cache_static_offset(), detector_cal_result_static, cal_cache.static_size) &&
+                flash_program(start, (const uint8_t *)&cal_cache, sizeof(cal_cache));
+
+  HAL_FLASH_Lock();
+
+  return status;
+}
+
+
+static bool flash_program(uint32_t address, const uint8_t *data, uint32_t length)
+{
+  for (uint32_t offset = 0; offset < length; offset += CAL_CACHE_FLASH_ALIGN)
+  {
+    uint64_t double_word = UINT64_MAX; // erased flash, for the bytes past the end
+    uint32_t chunk       = (length - offset < CAL_CACHE_FLASH_ALIGN) ? length - offset : CAL_CACHE_FLASH_ALIGN;
+
+    memcpy(&double_word, data + offset, chunk);
+
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + offset, double_word) != HAL_OK)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+
 static bool do_detector_get_next(distance_detector_resources_t  *resources,
                                  const acc_cal_result_t         *sensor_cal_result,
                                  acc_detector_distance_result_t *result)
@@ -748,31 +1872,40 @@ static bool do_detector_get_next(distance_detector_resources_t  *resources,
 
   do
   {
+    PROFILE_BEGIN(PROFILE_ZONE_PREPARE);
     if (!acc_detector_distance_prepare(resources->handle, resources->config, resources->sensor, sensor_cal_result, resources->buffer,
                                        resources->buffer_size))
     {
       debug_print("acc_detector_distance_prepare() failed\n");
       return false;
     }
+    PROFILE_END(PROFILE_ZONE_PREPARE);
 
+    PROFILE_BEGIN(PROFILE_ZONE_MEASURE);
     if (!acc_sensor_measure(resources->sensor))
     {
       debug_print("acc_sensor_measure() failed\n");
       return false;
     }
+    PROFILE_END(PROFILE_ZONE_MEASURE);
 
+    PROFILE_BEGIN(PROFILE_ZONE_WAIT);
     if (!acc_hal_integration_wait_for_sensor_interrupt(SENSOR_ID, SENSOR_TIMEOUT_MS))
     {
       debug_print("Sensor interrupt timeout\n");
       return false;
     }
+    PROFILE_END(PROFILE_ZONE_WAIT);
 
+    PROFILE_BEGIN(PROFILE_ZONE_READ);
     if (!acc_sensor_read(resources->sensor, resources->buffer, resources->buffer_size))
     {
       debug_print("acc_sensor_read() failed\n");
       return false;
     }
+    PROFILE_END(PROFILE_ZONE_READ);
 
+    PROFILE_BEGIN(PROFILE_ZONE_PROCESS);
     if (!acc_detector_distance_process(resources->handle, resources->buffer, resources->detector_cal_result_static,
                                        &resources->detector_cal_result_dynamic,
                                        &result_available, result))
@@ -780,6 +1913,7 @@ static bool do_detector_get_next(distance_detector_resources_t  *resources,
       debug_print("acc_detector_distance_process() failed\n");
       return false;
     }
+    PROFILE_END(PROFILE_ZONE_PROCESS);
   } while (!result_available);
 
   return true;
@@ -818,52 +1952,1149 @@ static void print_distance_result(const acc_detector_distance_result_t *result)
 }
 
 
-HAL_StatusTypeDef send_esp32_serial(const uint8_t *message, uint16_t msg_length) {
-    uint16_t total_length = msg_length + 3;  // Add 2 for header and 1 for null terminator
-    uint8_t *buffer = malloc(total_length);
+static void send_distance_frame(const acc_detector_distance_result_t *result, const uint32_t *timestamp_ms)
+{
+  uint8_t payload[RADAR_FRAME_MAX_PAYLOAD];
+  uint8_t offset = 0;
+
+  if (timestamp_ms != NULL)
+  {
+    payload[offset++] = (uint8_t)(*timestamp_ms & 0xFF);
+    payload[offset++] = (uint8_t)((*timestamp_ms >> 8) & 0xFF);
+    payload[offset++] = (uint8_t)((*timestamp_ms >> 16) & 0xFF);
+    payload[offset++] = (uint8_t)(*timestamp_ms >> 24);
+  }
+
+  offset += encode_distances(result, &payload[offset]);
+
+  send_frame((timestamp_ms != NULL) ? RADAR_CMD_TIMED_DATA_FRAME : RADAR_CMD_DATA_FRAME, payload, offset);
+}
 
-    if (buffer == NULL) {
-        return HAL_ERROR;
-    }
 
-    // Build message: header + message + null terminator
-    buffer[0] = RADAR_HEADER_BYTE1;
-    buffer[1] = RADAR_HEADER_BYTE2;
-    memcpy(buffer + 2, message, msg_length);
-    buffer[total_length - 1] = 0x00;
+static void send_config_frame(uint8_t config_index, const acc_detector_distance_result_t *result)
+{
+  uint8_t payload[RADAR_FRAME_MAX_PAYLOAD];
+  uint8_t offset = 0;
 
-    HAL_StatusTypeDef status = HAL_UART_Transmit(&DEBUG_UART_HANDLE, buffer, total_length, 100);
+  payload[offset++] = config_index;
+  offset += encode_distances(result, &payload[offset]);
 
-    free(buffer);
-    return status;
+  send_frame(RADAR_CMD_CONFIG_DATA_FRAME, payload, offset);
 }
 
-void send_esp32_serial_byte(uint8_t byte) {
-    send_esp32_serial(&byte, 1);
+
+static void send_filtered_frame(const acc_detector_distance_result_t *result, uint32_t age_ms)
+{
+  uint8_t payload[RADAR_FRAME_MAX_PAYLOAD];
+  uint8_t offset = 0;
+
+  payload[offset++] = (uint8_t)(age_ms & 0xFF);
+  payload[offset++] = (uint8_t)((age_ms >> 8) & 0xFF);
+  payload[offset++] = (uint8_t)((age_ms >> 16) & 0xFF);
+  payload[offset++] = (uint8_t)(age_ms >> 24);
+
+  offset += encode_distances(result, &payload[offset]);
+
+  send_frame(RADAR_CMD_FILTERED_DATA_FRAME, payload, offset);
 }
 
-static void debug_print(const char *format, ...) {
-    char msg_buffer[DEBUG_MSG_MAX_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg_buffer, sizeof(msg_buffer), format, args);
-    va_end(args);
 
-    // Calculate total message length including headers and null terminator
-    size_t msg_len = strlen(msg_buffer);
-    uint8_t *send_buffer = malloc(msg_len + 4); // Headers (2) + CMD (1) + Message + Null terminator
+static uint8_t encode_distances(const acc_detector_distance_result_t *result, uint8_t *payload)
+{
+  uint8_t num_dists = ((result->num_distances) <= MAX_DISTANCES) ? result->num_distances : MAX_DISTANCES;
+  uint8_t offset = 0;
+
+  // Fixed point: distance in mm, strength in hundredths, rounded and clamped
+  for (uint8_t i = 0; i < num_dists; i++)
+  {
+    uint16_t distance       = distance_to_mm(result->distances[i]);
+    int16_t  strength_fixed = strength_to_cdb(result->strengths[i]);
+
+    payload[offset++] = (uint8_t)(distance & 0xFF);
+    payload[offset++] = (uint8_t)(distance >> 8);
+    payload[offset++] = (uint8_t)((uint16_t)strength_fixed & 0xFF);
+    payload[offset++] = (uint8_t)((uint16_t)strength_fixed >> 8);
+  }
+
+  return offset;
+}
+
+
+static void send_distance_result(const config_settings_t *config, const acc_detector_distance_result_t *result)
+{
+  if (config->mode_flags & RADAR_MODE_BINARY_FRAMES)
+  {
+    send_distance_frame(result, NULL);
+  }
+  else
+  {
+    print_distance_result(result);
+  }
+}
+
+
+static void filter_and_send_result(const config_settings_t *config, const acc_detector_distance_result_t *result)
+{
+  if (config->filter_window > 0)
+  {
+    outlier_filter_push(&outlier_filter, result);
+    send_filter_output(config, false);
+  }
+  else
+  {
+    aggregate_add(&aggregate, result, false);
+  }
+
+  if (config->aggregate_s == 0)
+  {
+    return;
+  }
+
+  uint32_t elapsed_ms = HAL_GetTick() - aggregate.start_tick;
+  if (elapsed_ms >= (uint32_t)config->aggregate_s * 1000U)
+  {
+    send_aggregate_frame(&aggregate, elapsed_ms);
+    aggregate_reset(&aggregate);
+  }
+}
+
 
-    if (send_buffer != NULL) {
-        // Build the header
-        send_buffer[0] = RADAR_HEADER_BYTE1;
-        send_buffer[1] = RADAR_HEADER_BYTE2;
-        send_buffer[2] = RADAR_CMD_DEBUG_MSG;
+static void send_filter_output(const config_settings_t *config, bool drain)
+{
+  filter_sample_t sample;
+  bool            outlier;
+
+  while (outlier_filter_pop(&outlier_filter, drain, &sample, &outlier))
+  {
+    acc_detector_distance_result_t ready = { 0 };
 
-        // Copy the actual message, including the null terminator
-        strcpy((char *)&send_buffer[3], msg_buffer);
+    ready.num_distances = sample.num_distances;
+    memcpy(ready.distances, sample.distances, sample.num_distances * sizeof(float));
+    memcpy(ready.strengths, sample.strengths, sample.num_distances * sizeof(float));
 
-        // Send the complete buffer
-        HAL_UART_Transmit(&DEBUG_UART_HANDLE, send_buffer, msg_len + 4, 100);
-        free(send_buffer);
+    if (config->aggregate_s > 0)
+    {
+      aggregate_add(&aggregate, &ready, outlier);
     }
+    else if (!outlier)
+    {
+      // Half a window late, the ESP32 back-dates the measurement by its age
+      send_filtered_frame(&ready, HAL_GetTick() - sample.tick);
+    }
+  }
+}
+
+
+static void flush_filtered_results(const config_settings_t *config)
+{
+  if (config->filter_window > 0)
+  {
+    send_filter_output(config, true);
+  }
+
+  if (config->aggregate_s > 0 && (aggregate.samples > 0U || aggregate.outliers > 0U || aggregate.empty > 0U))
+  {
+    send_aggregate_frame(&aggregate, HAL_GetTick() - aggregate.start_tick);
+    aggregate_reset(&aggregate);
+  }
+}
+
+
+static void outlier_filter_init(outlier_filter_t *filter, uint8_t window_length)
+{
+  uint16_t capacity = (window_length < 3U) ? 3U : (window_length > FILTER_MAX_WINDOW) ? FILTER_MAX_WINDOW : window_length;
+
+  acc_order_statistics_window_init(&filter->window, filter->ring, filter->sorted, capacity);
+  filter->pushed = 0;
+  filter->popped = 0;
+}
+
+
+static void outlier_filter_push(outlier_filter_t *filter, const acc_detector_distance_result_t *result)
+{
+  filter_sample_t *incoming = &filter->delay[filter->pushed % filter->window.capacity];
+
+  incoming->num_distances = (result->num_distances <= MAX_DISTANCES) ? result->num_distances : MAX_DISTANCES;
+  incoming->tick          = HAL_GetTick();
+  memcpy(incoming->distances, result->distances, incoming->num_distances * sizeof(float));
+  memcpy(incoming->strengths, result->strengths, incoming->num_distances * sizeof(float));
+  filter->pushed++;
+
+  // Peaks are sorted strongest first, the filter follows the strongest one. Empty
+  // measurements only take their place in the delay line, not in the statistics
+  if (incoming->num_distances > 0)
+  {
+    acc_order_statistics_window_push(&filter->window, result->distances[0]);
+  }
+}
+
+
+static bool outlier_filter_pop(outlier_filter_t *filter, bool drain, filter_sample_t *ready, bool *outlier)
+{
+  acc_order_statistics_window_t *window = &filter->window;
+  uint32_t                      waiting = filter->pushed - filter->popped;
+
+  if (waiting == 0U || (!drain && waiting <= window->capacity / 2U))
+  {
+    return false;
+  }
+
+  // The window is centered on the measurement from half a window ago. A
+  // trailing window lags a moving surface and rejects good values after
+  // every crest and trough. A drain judges the last half window against
+  // the window as it is.
+  *ready   = filter->delay[filter->popped % window->capacity];
+  *outlier = false;
+  filter->popped++;
+
+  if (ready->num_distances == 0)
+  {
+    return true;
+  }
+
+  float median = acc_order_statistics_window_median(window);
+  float iqr    = acc_order_statistics_window_quantile(window, 0.75f) - acc_order_statistics_window_quantile(window, 0.25f);
+
+  if (iqr < FILTER_MIN_IQR_M)
+  {
+    iqr = FILTER_MIN_IQR_M;
+  }
+
+  *outlier = fabsf(ready->distances[0] - median) > FILTER_IQR_SCALE * iqr;
+  return true;
+}
+
+
+static void aggregate_reset(aggregate_t *aggregate)
+{
+  aggregate->stored       = 0;
+  aggregate->samples      = 0;
+  aggregate->outliers     = 0;
+  aggregate->empty        = 0;
+  aggregate->min          = 0.0f;
+  aggregate->max          = 0.0f;
+  aggregate->strength_sum = 0.0f;
+  aggregate->start_tick   = HAL_GetTick();
+
+  if (aggregate->random_state == 0U)
+  {
+    aggregate->random_state = 0x2545F491U;
+  }
+}
+
+
+static void aggregate_add(aggregate_t *aggregate, const acc_detector_distance_result_t *result, bool outlier)
+{
+  if (result->num_distances == 0)
+  {
+    aggregate->empty++;
+    return;
+  }
+
+  if (outlier)
+  {
+    aggregate->outliers++;
+    return;
+  }
+
+  float distance = result->distances[0];
+
+  if (aggregate->samples == 0U || distance < aggregate->min)
+  {
+    aggregate->min = distance;
+  }
+
+  if (aggregate->samples == 0U || distance > aggregate->max)
+  {
+    aggregate->max = distance;
+  }
+
+  aggregate->strength_sum += result->strengths[0];
+  aggregate->samples++;
+
+  // Reservoir sampling keeps a uniform sample of the whole period for the median
+  if (aggregate->stored < AGGREGATE_MAX_SAMPLES)
+  {
+    aggregate->distances[aggregate->stored++] = distance;
+  }
+  else
+  {
+    uint32_t x = aggregate->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    aggregate->random_state = x;
+
+    uint32_t slot = x % aggregate->samples;
+    if (slot < AGGREGATE_MAX_SAMPLES)
+    {
+      aggregate->distances[slot] = distance;
+    }
+  }
+}
+
+
+static void send_aggregate_frame(aggregate_t *aggregate, uint32_t period_ms)
+{
+  uint8_t  payload[RADAR_FRAME_AGGREGATE_SIZE];
+  uint16_t median   = 0;
+  int16_t  strength = 0;
+
+  if (aggregate->samples > 0U)
+  {
+    median   = distance_to_mm(acc_order_statistics_median_f32(aggregate->distances, aggregate->stored));
+    strength = strength_to_cdb(aggregate->strength_sum / (float)aggregate->samples);
+  }
+
+  uint16_t fields[] = {
+    median,
+    distance_to_mm(aggregate->min),
+    distance_to_mm(aggregate->max),
+    (uint16_t)strength,
+    aggregate->samples,
+    aggregate->outliers,
+    aggregate->empty,
+    (uint16_t)(period_ms & 0xFFFF),
+    (uint16_t)(period_ms >> 16),
+  };
+
+  for (uint8_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+  {
+    payload[2 * i]      = (uint8_t)(fields[i] & 0xFF);
+    payload[2 * i + 1U] = (uint8_t)(fields[i] >> 8);
+  }
+
+  send_frame(RADAR_CMD_AGGREGATE_FRAME, payload, RADAR_FRAME_AGGREGATE_SIZE);
+}
+
+
+static void rate_scheduler_init(rate_scheduler_t *scheduler, float max_rate)
+{
+  acc_order_statistics_window_init(&scheduler->window, scheduler->ring, scheduler->sorted, RATE_WINDOW);
+  scheduler->max_rate = max_rate;
+  scheduler->rate     = max_rate;
+  scheduler->spread   = 0.0f;
+}
+
+
+static bool rate_scheduler_update(rate_scheduler_t *scheduler, const acc_detector_distance_result_t *result)
+{
+  acc_order_statistics_window_t *window = &scheduler->window;
+
+  if (result->num_distances == 0)
+  {
+    return false;
+  }
+
+  acc_order_statistics_window_push(window, result->distances[0]);
+
+  if (window->count < RATE_MIN_SAMPLES)
+  {
+    return false;
+  }
+
+  float spread   = (acc_order_statistics_window_quantile(window, 0.75f) - acc_order_statistics_window_quantile(window, 0.25f)) * RATE_IQR_TO_STD;
+  float min_rate = (scheduler->max_rate < RATE_MIN_HZ) ? scheduler->max_rate : RATE_MIN_HZ;
+  float rate     = scheduler->rate;
+
+  if (spread > RATE_ACTIVE_SPREAD_M)
+  {
+    rate = scheduler->max_rate;
+  }
+  else if (window->count == RATE_WINDOW && spread < RATE_CALM_SPREAD_M)
+  {
+    rate = (rate / 2.0f < min_rate) ? min_rate : rate / 2.0f;
+  }
+
+  if (rate == scheduler->rate)
+  {
+    return false;
+  }
+
+  // Every rate is judged on a window of its own measurements
+  acc_order_statistics_window_reset(window);
+  scheduler->rate   = rate;
+  scheduler->spread = spread;
+  return true;
+}
+
+
+static void set_update_rate(float update_rate)
+{
+  sleep_time_ms = (uint32_t)(1000.0f * HAL_GETTICK_SCALAR / update_rate);
+  acc_integration_set_periodic_wakeup(sleep_time_ms);
+}
+
+
+static void send_rate_frame(uint32_t period_ms, float spread_m)
+{
+  uint8_t  payload[RADAR_FRAME_RATE_SIZE];
+  uint16_t spread = distance_to_mm(spread_m);
+
+  payload[0] = (uint8_t)(period_ms & 0xFF);
+  payload[1] = (uint8_t)((period_ms >> 8) & 0xFF);
+  payload[2] = (uint8_t)((period_ms >> 16) & 0xFF);
+  payload[3] = (uint8_t)(period_ms >> 24);
+  payload[4] = (uint8_t)(spread & 0xFF);
+  payload[5] = (uint8_t)(spread >> 8);
+
+  send_frame(RADAR_CMD_RATE_FRAME, payload, RADAR_FRAME_RATE_SIZE);
+}
+
+
+static void tracking_init(tracking_t *tracking, const config_settings_t *config, bool enabled)
+{
+  tracking->width         = enabled ? config->end_m - config->start_m : 0.0f;
+  tracking->start_m       = config->start_m;
+  tracking->end_m         = config->end_m;
+  tracking->estimate      = 0.0f;
+  tracking->have_estimate = false;
+  tracking->searching     = false;
+  tracking->empty         = 0U;
+}
+
+
+static bool tracking_update(tracking_t *tracking, const config_settings_t *config, const acc_detector_distance_result_t *result)
+{
+  if (result->num_distances == 0)
+  {
+    if (tracking->searching || ++tracking->empty < TRACKING_LOST_FRAMES)
+    {
+      return false;
+    }
+
+    tracking->searching     = true;
+    tracking->have_estimate = false;
+    tracking->start_m       = config->secondary_start_m;
+    tracking->end_m         = config->secondary_end_m;
+    return true;
+  }
+
+  float distance = result->distances[0];
+  tracking->empty = 0U;
+
+  if (tracking->have_estimate)
+  {
+    tracking->estimate += TRACKING_SMOOTHING * (distance - tracking->estimate);
+  }
+  else
+  {
+    tracking->estimate      = distance;
+    tracking->have_estimate = true;
+  }
+
+  float margin = tracking->width * TRACKING_EDGE_FRACTION;
+  if (!tracking->searching && tracking->estimate >= tracking->start_m + margin && tracking->estimate <= tracking->end_m - margin)
+  {
+    return false;
+  }
+
+  // Centre the window on the estimate, inside the search range
+  float start_m = tracking->estimate - tracking->width / 2.0f;
+  if (start_m + tracking->width > config->secondary_end_m)
+  {
+    start_m = config->secondary_end_m - tracking->width;
+  }
+  if (start_m < config->secondary_start_m)
+  {
+    start_m = config->secondary_start_m;
+  }
+
+  tracking->searching = false;
+  tracking->start_m   = start_m;
+  tracking->end_m     = start_m + tracking->width;
+  return true;
+}
+
+
+static bool tracking_moved(const tracking_t *tracking, const config_settings_t *config)
+{
+  return tracking->start_m != config->start_m || tracking->end_m != config->end_m;
+}
+
+
+static bool move_detector_range(const config_settings_t       *config,
+                                const tracking_t              *tracking,
+                                distance_detector_resources_t *resources,
+                                const acc_cal_result_t        *sensor_cal_result)
+{
+  // The search sweep is measured like the secondary, the window like the configured range
+  acc_detector_distance_config_start_set(resources->config, tracking->start_m);
+  acc_detector_distance_config_end_set(resources->config, tracking->end_m);
+  acc_detector_distance_config_max_step_length_set(resources->config,
+                                                   tracking->searching ? config->secondary_max_step_length : config->max_step_length);
+  acc_detector_distance_config_max_profile_set(resources->config,
+                                               tracking->searching ? config->secondary_max_profile : config->max_profile);
+
+  acc_detector_distance_destroy(resources->handle);
+  resources->handle = acc_detector_distance_create(resources->config);
+  if (resources->handle == NULL)
+  {
+    debug_print("acc_detector_distance_create() failed\n");
+    return false;
+  }
+
+  uint32_t buffer_size = 0;
+  uint32_t static_size = 0;
+  if (!acc_detector_distance_get_sizes(resources->handle, &buffer_size, &static_size))
+  {
+    debug_print("acc_detector_distance_get_sizes() failed\n");
+    return false;
+  }
+
+  if (buffer_size > resources->buffer_size)
+  {
+    acc_integration_mem_free(resources->buffer);
+    resources->buffer      = acc_integration_mem_alloc(buffer_size);
+    resources->buffer_size = buffer_size;
+    if (resources->buffer == NULL)
+    {
+      debug_print("sensor buffer allocation failed\n");
+      return false;
+    }
+  }
+
+  if (static_size > resources->detector_cal_result_static_size)
+  {
+    acc_integration_mem_free(resources->detector_cal_result_static);
+    resources->detector_cal_result_static = acc_integration_mem_alloc(static_size);
+    if (resources->detector_cal_result_static == NULL)
+    {
+      debug_print("calibration buffer allocation failed\n");
+      return false;
+    }
+  }
+  resources->detector_cal_result_static_size = static_size;
+
+  return do_full_detector_calibration(resources, sensor_cal_result);
+}
+
+
+static void send_window_frame(const tracking_t *tracking)
+{
+  uint8_t  payload[RADAR_FRAME_WINDOW_SIZE];
+  uint16_t start = distance_to_mm(tracking->start_m);
+  uint16_t end   = distance_to_mm(tracking->end_m);
+
+  payload[0] = (uint8_t)(start & 0xFF);
+  payload[1] = (uint8_t)(start >> 8);
+  payload[2] = (uint8_t)(end & 0xFF);
+  payload[3] = (uint8_t)(end >> 8);
+  payload[4] = tracking->searching ? 1U : 0U;
+
+  send_frame(RADAR_CMD_WINDOW_FRAME, payload, RADAR_FRAME_WINDOW_SIZE);
+}
+
+
+static bool create_bands(const config_settings_t       *config,
+                         const tracking_t              *tracking,
+                         band_resources_t              *bands,
+                         distance_detector_resources_t *resources)
+{
+#ifdef JJH_USE_BANDS
+  cleanup_bands(bands);
+
+  // The search sweep is measured like the secondary, the window like the configured range
+  bands->num_bands = acc_band_distance_layout(tracking->start_m,
+                                              tracking->end_m,
+                                              (uint16_t)(tracking->searching ? config->secondary_max_step_length : config->max_step_length),
+                                              (acc_config_profile_t)(tracking->searching ? config->secondary_max_profile : config->max_profile),
+                                              config->secondary_start_m,
+                                              config->secondary_end_m,
+                                              (uint16_t)config->secondary_max_step_length,
+                                              (acc_config_profile_t)config->secondary_max_profile,
+                                              bands->bands);
+  if (bands->num_bands == 0U)
+  {
+    debug_print("No fine band in %.2f-%.2f m\n", tracking->start_m, tracking->end_m);
+    return false;
+  }
+
+  bands->config = acc_config_create();
+  if (bands->config == NULL)
+  {
+    debug_print("acc_config_create() failed\n");
+    return false;
+  }
+
+  uint16_t max_points = 0U;
+
+  acc_config_num_subsweeps_set(bands->config, bands->num_bands);
+  acc_config_sweeps_per_frame_set(bands->config, 1U);
+
+  for (uint8_t i = 0U; i < bands->num_bands; i++)
+  {
+    const acc_band_distance_band_t *band = &bands->bands[i];
+    int32_t last_point = band->start_point + (int32_t)(band->num_points - 1U) * (int32_t)band->step_length;
+
+    acc_config_subsweep_start_point_set(bands->config, band->start_point, i);
+    acc_config_subsweep_num_points_set(bands->config, band->num_points, i);
+    acc_config_subsweep_step_length_set(bands->config, band->step_length, i);
+    acc_config_subsweep_profile_set(bands->config, band->profile, i);
+    acc_config_subsweep_hwaas_set(bands->config, BANDS_HWAAS, i);
+    acc_config_subsweep_prf_set(bands->config, acc_algorithm_select_prf((int16_t)last_point, band->profile, ACC_APPROX_BASE_STEP_LENGTH_M), i);
+
+    if (band->num_points > max_points)
+    {
+      max_points = band->num_points;
+    }
+  }
+
+  bands->processing = acc_processing_create(bands->config, &bands->metadata);
+  if (bands->processing == NULL)
+  {
+    debug_print("acc_processing_create() failed\n");
+    return false;
+  }
+
+  for (uint8_t i = 0U; i < bands->num_bands; i++)
+  {
+    bands->bands[i].data_offset = bands->metadata.subsweep_data_offset[i];
+  }
+
+  uint32_t buffer_size = 0;
+  if (!acc_rss_get_buffer_size(bands->config, &buffer_size))
+  {
+    debug_print("acc_rss_get_buffer_size() failed\n");
+    return false;
+  }
+
+  // One sensor buffer, large enough for the detector and the bands
+  if (buffer_size > resources->buffer_size)
+  {
+    acc_integration_mem_free(resources->buffer);
+    resources->buffer      = acc_integration_mem_alloc(buffer_size);
+    resources->buffer_size = buffer_size;
+    if (resources->buffer == NULL)
+    {
+      debug_print("sensor buffer allocation failed\n");
+      return false;
+    }
+  }
+
+  bands->work = acc_integration_mem_alloc(ACC_BAND_DISTANCE_WORK_LENGTH(max_points) * sizeof(float));
+  if (bands->work == NULL)
+  {
+    debug_print("band work buffer allocation failed\n");
+    return false;
+  }
+
+  acc_config_log(bands->config);
+
+  return true;
+#else
+  (void)config;
+  (void)tracking;
+  (void)bands;
+  (void)resources;
+  return false;
+#endif
+}
+
+
+static void cleanup_bands(band_resources_t *bands)
+{
+#ifdef JJH_USE_BANDS
+  // The sensor and the buffer belong to the primary
+  acc_processing_destroy(bands->processing);
+  acc_config_destroy(bands->config);
+  acc_integration_mem_free(bands->work);
+
+  memset(bands, 0, sizeof(*bands));
+#else
+  (void)bands;
+#endif
+}
+
+
+static bool sensor_power_down(acc_sensor_t *sensor, bool hibernate)
+{
+  if (hibernate && !acc_sensor_hibernate_on(sensor))
+  {
+    debug_print("acc_sensor_hibernate_on() failed\n");
+    return false;
+  }
+
+  acc_hal_integration_sensor_disable(SENSOR_ID);
+
+  return true;
+}
+
+
+static bool sensor_power_up(const acc_sensor_t *sensor, bool hibernate)
+{
+  acc_hal_integration_sensor_enable(SENSOR_ID);
+
+  if (hibernate && !acc_sensor_hibernate_off(sensor))
+  {
+    debug_print("acc_sensor_hibernate_off() failed\n");
+    return false;
+  }
+
+  return true;
+}
+
+
+static bool do_bands_get_next(band_resources_t                    *bands,
+                              const distance_detector_resources_t *resources,
+                              const acc_cal_result_t              *sensor_cal_result,
+                              float                               threshold_sensitivity,
+                              acc_detector_distance_result_t      *result)
+{
+#ifdef JJH_USE_BANDS
+  if (!bands->prepared)
+  {
+    PROFILE_BEGIN(PROFILE_ZONE_PREPARE);
+    if (!acc_sensor_prepare(resources->sensor, bands->config, sensor_cal_result, resources->buffer, resources->buffer_size))
+    {
+      debug_print("acc_sensor_prepare() failed\n");
+      return false;
+    }
+    PROFILE_END(PROFILE_ZONE_PREPARE);
+
+    bands->prepared = true;
+  }
+
+  PROFILE_BEGIN(PROFILE_ZONE_MEASURE);
+  if (!acc_sensor_measure(resources->sensor))
+  {
+    debug_print("acc_sensor_measure() failed\n");
+    return false;
+  }
+  PROFILE_END(PROFILE_ZONE_MEASURE);
+
+  PROFILE_BEGIN(PROFILE_ZONE_WAIT);
+  if (!acc_hal_integration_wait_for_sensor_interrupt(SENSOR_ID, SENSOR_TIMEOUT_MS))
+  {
+    debug_print("Sensor interrupt timeout\n");
+    return false;
+  }
+  PROFILE_END(PROFILE_ZONE_WAIT);
+
+  PROFILE_BEGIN(PROFILE_ZONE_READ);
+  if (!acc_sensor_read(resources->sensor, resources->buffer, resources->buffer_size))
+  {
+    debug_print("acc_sensor_read() failed\n");
+    return false;
+  }
+  PROFILE_END(PROFILE_ZONE_READ);
+
+  PROFILE_BEGIN(PROFILE_ZONE_PROCESS);
+
+  acc_processing_result_t processing_result;
+  acc_processing_execute(bands->processing, resources->buffer, &processing_result);
+
+  // Strengths are dB above the CFAR threshold, not the detector's calibrated strength
+  acc_band_distance_peak_t peaks[MAX_DISTANCES];
+  uint16_t num_peaks = acc_band_distance_process(processing_result.frame, bands->metadata.sweep_data_length,
+                                                 acc_config_sweeps_per_frame_get(bands->config), bands->bands, bands->num_bands,
+                                                 threshold_sensitivity, bands->work, peaks, MAX_DISTANCES);
+
+  for (uint16_t i = 0; i < num_peaks; i++)
+  {
+    result->distances[i] = peaks[i].distance_m;
+    result->strengths[i] = peaks[i].strength_db;
+  }
+
+  result->num_distances      = (uint8_t)num_peaks;
+  result->calibration_needed = processing_result.calibration_needed;
+  result->temperature        = processing_result.temperature;
+
+  PROFILE_END(PROFILE_ZONE_PROCESS);
+
+  return true;
+#else
+  (void)bands;
+  (void)resources;
+  (void)sensor_cal_result;
+  (void)threshold_sensitivity;
+  (void)result;
+  return false;
+#endif
+}
+
+
+static void profile_reset(void)
+{
+#ifdef JJH_USE_PROFILE
+  static const char *const names[PROFILE_ZONE_COUNT] = {
+    "prepare", "measure", "wait", "read", "process", "send", "uart_flush", "awake"
+  };
+
+  for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++)
+  {
+    acc_integration_profile_zone_reset(&profile_zones[i], names[i]);
+  }
+#endif
+
+  profile_count = 0;
+  memset(&energy_wakeups, 0, sizeof(energy_wakeups));
+}
+
+
+static void send_profile(void)
+{
+#ifdef JJH_USE_PROFILE
+  // e.g. "process n=256 min=1520 mean=1604 max=2311 us hist=0,0,0,0,0,256,0,0"
+  for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++)
+  {
+    const acc_integration_profile_zone_t *zone = &profile_zones[i];
+    char msg[PROFILE_MSG_MAX_LEN];
+
+    if (zone->count == 0)
+    {
+      continue;
+    }
+
+    int length = snprintf(msg, sizeof(msg), "%s n=%lu min=%lu mean=%lu max=%lu us hist=", zone->name,
+                          (unsigned long)zone->count,
+                          (unsigned long)acc_integration_profile_cycles_to_us(zone->min_cycles),
+                          (unsigned long)acc_integration_profile_cycles_to_us(zone->total_cycles / zone->count),
+                          (unsigned long)acc_integration_profile_cycles_to_us(zone->max_cycles));
+
+    for (uint8_t bin = 0; bin < ACC_INTEGRATION_PROFILE_BINS && length > 0 && length < (int)sizeof(msg); bin++)
+    {
+      length += snprintf(&msg[length], sizeof(msg) - (size_t)length, bin == 0 ? "%lu" : ",%lu",
+                         (unsigned long)zone->histogram[bin]);
+    }
+
+    send_text_message(RADAR_CMD_PROFILE_MSG, msg);
+  }
+#endif
+}
+
+
+#ifdef JJH_USE_ENERGY_ESTIMATE
+static uint32_t energy_points(const config_settings_t *config)
+{
+  // Measured per wakeup, with the modes decided like when a collection starts
+  bool binary_frames = (config->mode_flags & RADAR_MODE_BINARY_FRAMES) != 0;
+  bool band_mode = (config->mode_flags & RADAR_MODE_BANDS) && config->secondary_end_m > config->secondary_start_m;
+  bool secondary_mode = binary_frames && config->secondary_interval > 0 && !band_mode;
+
+#ifdef JJH_USE_BANDS
+  if (band_mode)
+  {
+    acc_band_distance_band_t bands[ACC_BAND_DISTANCE_MAX_BANDS];
+    uint8_t num_bands = acc_band_distance_layout(config->start_m, config->end_m, (uint16_t)config->max_step_length,
+                                                 (acc_config_profile_t)config->max_profile, config->secondary_start_m,
+                                                 config->secondary_end_m, (uint16_t)config->secondary_max_step_length,
+                                                 (acc_config_profile_t)config->secondary_max_profile, bands);
+    uint32_t points = 0;
+
+    for (uint8_t i = 0; i < num_bands; i++)
+    {
+      points += bands[i].num_points;
+    }
+
+    return points;
+  }
+#endif
+
+  uint32_t points = acc_energy_detector_points(config->start_m, config->end_m, (uint16_t)config->max_step_length,
+                                               (acc_config_profile_t)config->max_profile);
+
+  if (secondary_mode)
+  {
+    points += acc_energy_detector_points(config->secondary_start_m, config->secondary_end_m,
+                                         (uint16_t)config->secondary_max_step_length,
+                                         (acc_config_profile_t)config->secondary_max_profile) / config->secondary_interval;
+  }
+
+  return points;
+}
+#endif
+
+
+static void energy_wakeup_end(void)
+{
+#ifdef JJH_USE_ENERGY_ESTIMATE
+  // Per wakeup, the zones up to the read are the sensor's and the rest of the wakeup the MCU's
+  uint64_t sensor_total = 0;
+  for (uint8_t i = PROFILE_ZONE_PREPARE; i <= PROFILE_ZONE_READ; i++)
+  {
+    sensor_total += profile_zones[i].total_cycles;
+  }
+
+  uint64_t awake_total = profile_zones[PROFILE_ZONE_AWAKE].total_cycles;
+
+  if (!energy_wakeups.skip)
+  {
+    energy_wakeups.sensor_cycles += sensor_total - energy_wakeups.sensor_total;
+    energy_wakeups.awake_cycles += awake_total - energy_wakeups.awake_total;
+    energy_wakeups.wakeups++;
+  }
+
+  energy_wakeups.sensor_total = sensor_total;
+  energy_wakeups.awake_total = awake_total;
+  energy_wakeups.skip = false;
+#endif
+}
+
+
+static void energy_calibrate(const config_settings_t *config)
+{
+#ifdef JJH_USE_ENERGY_ESTIMATE
+  if (energy_wakeups.wakeups == 0)
+  {
+    return;
+  }
+
+  float sensor_ms = (float)acc_integration_profile_cycles_to_us(energy_wakeups.sensor_cycles / energy_wakeups.wakeups) / 1000.0f;
+  float awake_ms = (float)acc_integration_profile_cycles_to_us(energy_wakeups.awake_cycles / energy_wakeups.wakeups) / 1000.0f;
+
+  acc_energy_model_calibrate(&energy_model, energy_points(config), sensor_ms, fmaxf(awake_ms - sensor_ms, 0.0f));
+
+  // The next calibration only gets the wakeups after this one
+  energy_wakeups.sensor_cycles = 0;
+  energy_wakeups.awake_cycles = 0;
+  energy_wakeups.wakeups = 0;
+#else
+  (void)config;
+#endif
+}
+
+
+static void send_energy_estimate(const config_settings_t *config)
+{
+#ifdef JJH_USE_ENERGY_ESTIMATE
+  acc_energy_estimate_t estimate;
+  char msg[DEBUG_MSG_MAX_LEN];
+  uint32_t points = energy_points(config);
+
+  acc_energy_estimate(&energy_model, points, config->update_rate, ENERGY_BATTERY_MAH, &estimate);
+
+  snprintf(msg, sizeof(msg),
+           "%lu points, awake %.1f ms (sensor %.1f, mcu %.1f) at %.2f Hz, %.3f mA, %.0f days on %.0f mAh, %s %.0f day target%s",
+           (unsigned long)points, estimate.sensor_ms + estimate.mcu_ms, estimate.sensor_ms, estimate.mcu_ms,
+           estimate.update_rate_hz, estimate.average_ma, estimate.battery_life_days, ENERGY_BATTERY_MAH,
+           (estimate.battery_life_days >= ENERGY_TARGET_DAYS) ? "meets" : "misses", ENERGY_TARGET_DAYS,
+           (energy_model.calibrations == 0) ? ", uncalibrated" : "");
+
+  send_text_message(RADAR_CMD_ENERGY_MSG, msg);
+#else
+  (void)config;
+#endif
+}
+
+
+static void send_text_message(uint8_t cmd, const char *text)
+{
+  const uint8_t header[] = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2, cmd};
+
+  // Headers (2) + CMD (1) + Message + Null terminator
+  uart_tx_write(header, sizeof(header));
+  uart_tx_write((const uint8_t *)text, (uint16_t)(strlen(text) + 1));
+}
+
+
+static void send_frame(uint8_t cmd, const uint8_t *payload, uint8_t length)
+{
+  uint8_t frame[RADAR_FRAME_PREFIX_SIZE + RADAR_FRAME_MAX_PAYLOAD + RADAR_FRAME_CRC_SIZE];
+  uint16_t offset = RADAR_FRAME_PREFIX_SIZE;
+
+  frame[0] = RADAR_HEADER_BYTE1;
+  frame[1] = RADAR_HEADER_BYTE2;
+  frame[2] = cmd;
+  frame[3] = RADAR_FRAME_VERSION;
+  frame[4] = length;
+  frame[5] = frame_sequence++;
+
+  memcpy(&frame[offset], payload, length);
+  offset += length;
+
+  uint16_t crc = crc16_ccitt(&frame[2], offset - 2);
+  frame[offset++] = (uint8_t)(crc & 0xFF);
+  frame[offset++] = (uint8_t)(crc >> 8);
+
+  uart_tx_write(frame, offset);
+}
+
+
+static uint16_t distance_to_mm(float distance_m)
+{
+  float distance_mm = distance_m * 1000.0f + 0.5f;
+
+  return (distance_mm <= 0.0f) ? 0U : (distance_mm >= 65535.0f) ? 0xFFFFU : (uint16_t)distance_mm;
+}
+
+
+static int16_t strength_to_cdb(float strength_db)
+{
+  float strength = strength_db * 100.0f;
+
+  if (strength >= 32767.0f)
+  {
+    return INT16_MAX;
+  }
+  else if (strength <= -32768.0f)
+  {
+    return INT16_MIN;
+  }
+
+  return (int16_t)(strength + ((strength >= 0.0f) ? 0.5f : -0.5f));
+}
+
+
+static uint16_t crc16_ccitt(const uint8_t *data, uint16_t length)
+{
+  // CRC-16/CCITT-FALSE, must match RadarProtocol::crc16() on the ESP32
+  uint16_t crc = 0xFFFF;
+
+  for (uint16_t i = 0; i < length; i++)
+  {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+
+HAL_StatusTypeDef send_esp32_serial(const uint8_t *message, uint16_t msg_length) {
+    static const uint8_t header[] = {RADAR_HEADER_BYTE1, RADAR_HEADER_BYTE2};
+    static const uint8_t terminator = 0x00;
+
+    // Message: header + message + null terminator
+    uart_tx_write(header, sizeof(header));
+    uart_tx_write(message, msg_length);
+    uart_tx_write(&terminator, 1);
+
+    return HAL_OK;
+}
+
+void send_esp32_serial_byte(uint8_t byte) {
+    send_esp32_serial(&byte, 1);
+}
+
+static void debug_print(const char *format, ...) {
+    char msg_buffer[DEBUG_MSG_MAX_LEN];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(msg_buffer, sizeof(msg_buffer), format, args);
+    va_end(args);
+
+    send_text_message(RADAR_CMD_DEBUG_MSG, msg_buffer);
+}
+
+
+static void uart_tx_write(const uint8_t *data, uint16_t length)
+{
+  while (length > 0)
+  {
+    uint16_t used = (uint16_t)(uart_tx_queue.head - uart_tx_queue.tail);
+
+    if (used == UART_TX_QUEUE_SIZE)
+    {
+      // Full, only a completed transfer makes room
+      uart_tx_kick();
+      uart_tx_wait();
+      continue;
+    }
+
+    uint16_t index = uart_tx_queue.head & (UART_TX_QUEUE_SIZE - 1U);
+    uint16_t chunk = UART_TX_QUEUE_SIZE - used;
+
+    if (chunk > UART_TX_QUEUE_SIZE - index)
+    {
+      chunk = UART_TX_QUEUE_SIZE - index;
+    }
+
+    if (chunk > length)
+    {
+      chunk = length;
+    }
+
+    memcpy(&uart_tx_queue.buffer[index], data, chunk);
+    uart_tx_queue.head += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+
+  uart_tx_kick();
+}
+
+
+static void uart_tx_start(void)
+{
+  // Called with interrupts disabled or from the transfer complete interrupt
+  uint16_t used = (uint16_t)(uart_tx_queue.head - uart_tx_queue.tail);
+
+  if (uart_tx_queue.in_flight != 0 || used == 0)
+  {
+    return;
+  }
+
+  uint16_t index = uart_tx_queue.tail & (UART_TX_QUEUE_SIZE - 1U);
+  uint16_t chunk = UART_TX_QUEUE_SIZE - index;
+
+  // A DMA transfer is contiguous, the part after the wrap is sent by the next one
+  if (chunk > used)
+  {
+    chunk = used;
+  }
+
+  if (HAL_UART_Transmit_DMA(&DEBUG_UART_HANDLE, &uart_tx_queue.buffer[index], chunk) == HAL_OK)
+  {
+    uart_tx_queue.in_flight = chunk;
+  }
+}
+
+
+static void uart_tx_kick(void)
+{
+  __disable_irq();
+  uart_tx_start();
+  __enable_irq();
+}
+
+
+static void uart_tx_wait(void)
+{
+  // Sleep mode keeps the DMA running, a pending interrupt ends __WFI() even with interrupts disabled,
+  // so a transfer completing between the check and __WFI() can't be missed
+  __disable_irq();
+  if (uart_tx_queue.in_flight != 0)
+  {
+    __WFI();
+  }
+  __enable_irq();
+}
+
+
+static void uart_tx_flush(void)
+{
+  // STOP mode deinitializes the UART, see acc_integration_prepare_stop_1(), so everything queued must
+  // be on the wire before acc_integration_sleep_until_periodic_wakeup()
+  while (uart_tx_queue.head != uart_tx_queue.tail)
+  {
+    uart_tx_kick();
+    uart_tx_wait();
+  }
+}
+
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if (huart != &DEBUG_UART_HANDLE)
+  {
+    return;
+  }
+
+  uart_tx_queue.tail += uart_tx_queue.in_flight;
+  uart_tx_queue.in_flight = 0;
+  uart_tx_start();
+}
+
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  // Only a failed transfer ends a transmit, its chunk is still queued and sent again by the next kick
+  if (huart == &DEBUG_UART_HANDLE && huart->gState == HAL_UART_STATE_READY)
+  {
+    uart_tx_queue.in_flight = 0;
+  }
 }
@@ -169,8 +169,8 @@ const acc_hal_a121_t *acc_hal_rss_integration_get_implementation(void)
 	{
 		.max_spi_transfer_size = STM32_MAX_TRANSFER_SIZE,
 
-		.mem_alloc = malloc,
-		.mem_free  = free,
+		.mem_alloc = acc_integration_mem_alloc,
+		.mem_free  = acc_integration_mem_free,
 
 		.transfer = NULL,
 		.log      = acc_integration_log,
@@ -0,0 +1,256 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "acc_integration.h"
+
+
+/**
+ * @brief Size of the pool dynamic memory is allocated from
+ *
+ * All of acc_integration_mem_alloc() comes from a static pool instead of the
+ * newlib heap. Use the high water mark from acc_integration_mem_usage() to size
+ * it for an application.
+ */
+#ifndef ACC_INTEGRATION_MEM_POOL_SIZE
+#define ACC_INTEGRATION_MEM_POOL_SIZE (36U * 1024U)
+#endif
+
+
+/**
+ * @brief Alignment of every allocation, enough for any type
+ */
+#define MEM_ALIGNMENT 8U
+
+#define MEM_BLOCK_FREE 1U
+
+
+/**
+ * @brief Header in front of every block in the pool
+ *
+ * The blocks lie back to back from the start of the pool up to mem_top, the
+ * next one starts the size of this one later.
+ */
+typedef struct
+{
+	uint32_t size_and_free; // size with header, MEM_BLOCK_FREE set when free
+	uint32_t mark;          // mem_marks when allocated, see acc_integration_mem_release()
+} mem_block_t;
+
+
+/**
+ * @brief Smallest free block split off when a larger one is reused
+ */
+#define MEM_MIN_BLOCK_SIZE (sizeof(mem_block_t) + MEM_ALIGNMENT)
+
+
+/**
+ * @brief The pool of dynamic memory, uint64_t for its alignment
+ */
+static uint64_t mem_pool[ACC_INTEGRATION_MEM_POOL_SIZE / sizeof(uint64_t)];
+
+
+/**
+ * @brief End of the blocks, the pool above it has never been used or was given back
+ */
+static uint32_t mem_top = 0;
+
+
+/**
+ * @brief Number of marks taken
+ */
+static uint32_t mem_marks = 0;
+
+
+/**
+ * @brief Highest mem_top so far
+ */
+static uint32_t mem_high_water_mark = 0;
+
+
+static mem_block_t *mem_block(uint32_t offset)
+{
+	return (mem_block_t *)((uint8_t *)mem_pool + offset);
+}
+
+
+static uint32_t mem_block_size(const mem_block_t *block)
+{
+	return block->size_and_free & ~MEM_BLOCK_FREE;
+}
+
+
+static bool mem_block_is_free(const mem_block_t *block)
+{
+	return (block->size_and_free & MEM_BLOCK_FREE) != 0U;
+}
+
+
+static void mem_merge(void)
+{
+	// Neighbouring free blocks become one, and free blocks at the end go back above mem_top
+	uint32_t free_offset = mem_top; // first of the free blocks just walked, mem_top if none
+	uint32_t offset      = 0U;
+
+	while (offset < mem_top)
+	{
+		mem_block_t *block = mem_block(offset);
+		uint32_t    size   = mem_block_size(block);
+
+		if (!mem_block_is_free(block))
+		{
+			free_offset = mem_top;
+		}
+		else if (free_offset == mem_top)
+		{
+			free_offset = offset;
+		}
+		else
+		{
+			mem_block(free_offset)->size_and_free += size;
+		}
+
+		offset += size;
+	}
+
+	mem_top = free_offset;
+}
+
+
+void *acc_integration_mem_alloc(size_t size)
+{
+	if (size > sizeof(mem_pool) - sizeof(mem_block_t))
+	{
+		return NULL;
+	}
+
+	uint32_t    block_size = (uint32_t)((size + sizeof(mem_block_t) + MEM_ALIGNMENT - 1U) & ~(MEM_ALIGNMENT - 1U));
+	mem_block_t *block     = NULL;
+
+	// First fit among the free blocks. The tracking window recreates a detector below the
+	// sensor's memory, and the SDK only allocates a few dozen blocks, so the walk is short.
+	for (uint32_t offset = 0U; offset < mem_top; offset += mem_block_size(mem_block(offset)))
+	{
+		mem_block_t *candidate     = mem_block(offset);
+		uint32_t    candidate_size = mem_block_size(candidate);
+
+		if (mem_block_is_free(candidate) && candidate_size >= block_size)
+		{
+			if (candidate_size - block_size >= MEM_MIN_BLOCK_SIZE)
+			{
+				mem_block(offset + block_size)->size_and_free = (candidate_size - block_size) | MEM_BLOCK_FREE;
+			}
+			else
+			{
+				block_size = candidate_size;
+			}
+
+			block = candidate;
+			break;
+		}
+	}
+
+	if (block == NULL)
+	{
+		if (block_size > sizeof(mem_pool) - mem_top)
+		{
+			return NULL;
+		}
+
+		block    = mem_block(mem_top);
+		mem_top += block_size;
+
+		if (mem_top > mem_high_water_mark)
+		{
+			mem_high_water_mark = mem_top;
+		}
+	}
+
+	block->size_and_free = block_size;
+	block->mark          = mem_marks;
+
+	return block + 1;
+}
+
+
+void *acc_integration_mem_calloc(size_t nmemb, size_t size)
+{
+	if (nmemb != 0U && size > SIZE_MAX / nmemb)
+	{
+		return NULL;
+	}
+
+	void *ptr = acc_integration_mem_alloc(nmemb * size);
+
+	if (ptr != NULL)
+	{
+		memset(ptr, 0, nmemb * size);
+	}
+
+	return ptr;
+}
+
+
+void acc_integration_mem_free(void *ptr)
+{
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	mem_block_t *block = (mem_block_t *)ptr - 1;
+
+	block->size_and_free |= MEM_BLOCK_FREE;
+
+	mem_merge();
+}
+
+
+acc_integration_mem_mark_t acc_integration_mem_mark(void)
+{
+	// Blocks remember the number of marks when they were allocated, so a release also finds
+	// the ones that reused a free block below older memory
+	mem_marks++;
+
+	return mem_marks;
+}
+
+
+void acc_integration_mem_release(acc_integration_mem_mark_t mark)
+{
+	for (uint32_t offset = 0U; offset < mem_top; offset += mem_block_size(mem_block(offset)))
+	{
+		mem_block_t *block = mem_block(offset);
+
+		if (!mem_block_is_free(block) && block->mark >= mark)
+		{
+			block->size_and_free |= MEM_BLOCK_FREE;
+		}
+	}
+
+	mem_merge();
+}
+
+
+void acc_integration_mem_usage(uint32_t *used, uint32_t *high_water_mark, uint32_t *size)
+{
+	*used = 0U;
+
+	for (uint32_t offset = 0U; offset < mem_top; offset += mem_block_size(mem_block(offset)))
+	{
+		if (!mem_block_is_free(mem_block(offset)))
+		{
+			*used += mem_block_size(mem_block(offset));
+		}
+	}
+
+	*high_water_mark = mem_high_water_mark;
+	*size            = sizeof(mem_pool);
+}
@@ -0,0 +1,90 @@
+// Copyright (c) Acconeer AB, 2024
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "main.h"
+
+#include "acc_integration_profile.h"
+
+
+/**
+ * @brief Core clock cycles per microsecond, set by acc_integration_profile_init()
+ */
+static uint32_t cycles_per_us = 1U;
+
+
+void acc_integration_profile_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT       = 0U;
+	DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+	cycles_per_us = SystemCoreClock / 1000000U;
+	if (cycles_per_us == 0U)
+	{
+		cycles_per_us = 1U;
+	}
+}
+
+
+void acc_integration_profile_zone_reset(acc_integration_profile_zone_t *zone, const char *name)
+{
+	memset(zone, 0, sizeof(*zone));
+
+	zone->name       = name;
+	zone->min_cycles = UINT32_MAX;
+}
+
+
+void acc_integration_profile_begin(acc_integration_profile_zone_t *zone)
+{
+	zone->start_cycles = DWT->CYCCNT;
+	zone->running      = true;
+}
+
+
+void acc_integration_profile_end(acc_integration_profile_zone_t *zone)
+{
+	uint32_t cycles = DWT->CYCCNT - zone->start_cycles;
+
+	if (!zone->running)
+	{
+		return;
+	}
+
+	zone->running = false;
+	zone->count++;
+	zone->total_cycles += cycles;
+
+	if (cycles < zone->min_cycles)
+	{
+		zone->min_cycles = cycles;
+	}
+
+	if (cycles > zone->max_cycles)
+	{
+		zone->max_cycles = cycles;
+	}
+
+	uint32_t duration_us = cycles / cycles_per_us;
+	uint32_t bin         = 0U;
+
+	while (bin < ACC_INTEGRATION_PROFILE_BINS - 1U && duration_us >= ACC_INTEGRATION_PROFILE_BIN_LIMIT_US(bin))
+	{
+		bin++;
+	}
+
+	zone->histogram[bin]++;
+}
+
+
+uint32_t acc_integration_profile_cycles_to_us(uint64_t cycles)
+{
+	return (uint32_t)(cycles / cycles_per_us);
+}
@@ -627,21 +627,3 @@ uint32_t acc_integration_get_time(void)
 {
 	return HAL_GetTick();
 }
-
-
-void *acc_integration_mem_alloc(size_t size)
-{
-	return malloc(size);
-}
-
-
-void *acc_integration_mem_calloc(size_t nmemb, size_t size)
-{
-	return calloc(nmemb, size);
-}
-
-
-void acc_integration_mem_free(void *ptr)
-{
-	free(ptr);
-}
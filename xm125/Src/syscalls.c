@@ -77,6 +77,12 @@ int _read(int file, char *ptr, int len)
 int _write(int file, char *ptr, int len)
 {
 	(void)file;
+
+	// An application may be sending on the same UART with DMA, a blocking transmit fails until it's done
+	while (DEBUG_UART_HANDLE.gState == HAL_UART_STATE_BUSY_TX)
+	{
+	}
+
 	HAL_UART_Transmit(&DEBUG_UART_HANDLE, (uint8_t *)ptr, len, 0xFFFF);
 	return len;
 }
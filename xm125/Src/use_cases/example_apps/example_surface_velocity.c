@@ -131,18 +131,20 @@ typedef struct
 	uint16_t middle_index;
 
 	int32_t       *double_buffer_filter_buffer;
-	float complex *frame;
 	float complex *time_series;
 	float complex *time_series_buffer;
 	float complex *fft_out;
 	float         *psds;
 	float         *lp_psds;
 	float         *psd;
+	float         *cfar_threshold;
 	float         *window;
 	uint32_t      *threshold_check;
 	float         *bin_rad_vs;
 	float         *bin_vertical_vs;
 
+	acc_algorithm_history_t time_series_history;
+
 	uint16_t update_index;
 	uint16_t wait_n;
 	float    lp_velocity;
@@ -319,14 +321,15 @@ int acconeer_main(int argc, char *argv[])
 
 static void update_threshold(acc_surface_velocity_handle_t *handle)
 {
+	acc_algorithm_calculate_mirrored_one_sided_cfar_sweep(handle->psd, handle->segment_length, handle->middle_index,
+	                                                      handle->surface_velocity_config.cfar_win,
+	                                                      handle->surface_velocity_config.cfar_guard,
+	                                                      handle->surface_velocity_config.threshold_sensitivity,
+	                                                      handle->cfar_threshold);
+
 	for (uint16_t i = 0U; i < handle->segment_length; i++)
 	{
-		float threshold = acc_algorithm_calculate_mirrored_one_sided_cfar(handle->psd, handle->segment_length, handle->middle_index,
-		                                                                  handle->surface_velocity_config.cfar_win,
-		                                                                  handle->surface_velocity_config.cfar_guard,
-		                                                                  handle->surface_velocity_config.threshold_sensitivity, i);
-
-		if (handle->psd[i] > threshold)
+		if (handle->psd[i] > handle->cfar_threshold[i])
 		{
 			acc_alg_basic_utils_set_bit_bitarray_uint32(handle->threshold_check, i);
 		}
@@ -400,11 +403,6 @@ static void cleanup(acc_surface_velocity_handle_t *handle, acc_surface_velocity_
 		acc_integration_mem_free(handle->double_buffer_filter_buffer);
 	}
 
-	if (handle->frame != NULL)
-	{
-		acc_integration_mem_free(handle->frame);
-	}
-
 	if (handle->time_series != NULL)
 	{
 		acc_integration_mem_free(handle->time_series);
@@ -445,6 +443,11 @@ static void cleanup(acc_surface_velocity_handle_t *handle, acc_surface_velocity_
 		acc_integration_mem_free(handle->psd);
 	}
 
+	if (handle->cfar_threshold != NULL)
+	{
+		acc_integration_mem_free(handle->cfar_threshold);
+	}
+
 	if (handle->window != NULL)
 	{
 		acc_integration_mem_free(handle->window);
@@ -727,13 +730,13 @@ static bool init_handle(acc_surface_velocity_handle_t *handle, acc_surface_veloc
 		acc_integration_mem_alloc(handle->surface_velocity_config.time_series_length * handle->num_distances * sizeof(*handle->time_series));
 	handle->time_series_buffer = acc_integration_mem_alloc(
 		handle->segment_length * sizeof(*handle->time_series_buffer));
-	handle->frame           = acc_integration_mem_alloc(handle->num_distances * handle->sweeps_per_frame * sizeof(*handle->frame));
 	handle->bin_rad_vs      = acc_integration_mem_alloc(handle->segment_length * sizeof(*handle->bin_rad_vs));
 	handle->bin_vertical_vs = acc_integration_mem_alloc(handle->segment_length * sizeof(*handle->bin_vertical_vs));
 	handle->lp_psds         = acc_integration_mem_alloc(handle->segment_length * handle->num_distances * sizeof(*handle->lp_psds));
 	handle->fft_out         = acc_integration_mem_alloc(handle->padded_segment_length * sizeof(*handle->fft_out));
 	handle->psds            = acc_integration_mem_alloc(handle->segment_length * handle->num_distances * sizeof(*handle->psds));
 	handle->psd             = acc_integration_mem_alloc(handle->segment_length * sizeof(*handle->psd));
+	handle->cfar_threshold  = acc_integration_mem_alloc(handle->segment_length * sizeof(*handle->cfar_threshold));
 	handle->window          = acc_integration_mem_alloc(handle->segment_length * sizeof(*handle->window));
 
 	size_t threshold_check_length =
@@ -751,9 +754,10 @@ static bool init_handle(acc_surface_velocity_handle_t *handle, acc_surface_veloc
 	handle->num_peaks           = 0U;
 
 	bool alloc_success =
-		handle->double_buffer_filter_buffer && handle->time_series != NULL && handle->time_series_buffer != NULL && handle->frame != NULL &&
+		handle->double_buffer_filter_buffer && handle->time_series != NULL && handle->time_series_buffer != NULL &&
 		handle->bin_rad_vs != NULL && handle->bin_vertical_vs != NULL && handle->lp_psds != NULL &&
-		handle->fft_out != NULL && handle->psds != NULL && handle->window != NULL && handle->threshold_check != NULL &&
+		handle->fft_out != NULL && handle->psds != NULL && handle->psd != NULL && handle->cfar_threshold != NULL &&
+		handle->window != NULL && handle->threshold_check != NULL &&
 		handle->merged_velocities != NULL && handle->merged_energies != NULL && handle->peak_indexes != NULL;
 
 	if (!alloc_success)
@@ -762,8 +766,8 @@ static bool init_handle(acc_surface_velocity_handle_t *handle, acc_surface_veloc
 		return false;
 	}
 
-	memset(handle->time_series, 0,
-	       handle->surface_velocity_config.time_series_length * handle->num_distances * sizeof(*handle->time_series));
+	acc_algorithm_history_init(&handle->time_series_history, handle->time_series, handle->surface_velocity_config.time_series_length,
+	                           handle->num_distances, sizeof(*handle->time_series));
 	memset(handle->lp_psds, 0,
 	       handle->segment_length * handle->num_distances * sizeof(*handle->lp_psds));
 	memset(handle->psds, 0,
@@ -828,22 +832,18 @@ static uint16_t calc_power_spectral_density(acc_surface_velocity_handle_t *handl
 {
 	for (uint16_t i = 0U; i < handle->sweeps_per_frame; i++)
 	{
+		float complex *sweep = acc_algorithm_history_push(&handle->time_series_history);
+
 		for (uint16_t j = 0U; j < handle->num_distances; j++)
 		{
 			uint16_t index = i * handle->num_distances + j;
 
-			handle->frame[j] = ((float)handle->proc_result.frame[index].real) + ((float)handle->proc_result.frame[index].imag) * I;
+			sweep[j] = ((float)handle->proc_result.frame[index].real) + ((float)handle->proc_result.frame[index].imag) * I;
 		}
-
-		acc_algorithm_roll_and_push_matrix_f32_complex(handle->time_series, handle->surface_velocity_config.time_series_length,
-		                                               handle->num_distances,
-		                                               handle->frame,
-		                                               false);
 	}
 
-	acc_algorithm_welch_matrix(handle->time_series, handle->surface_velocity_config.time_series_length, handle->num_distances,
-	                           handle->segment_length, handle->time_series_buffer, handle->fft_out, handle->psds, handle->window,
-	                           handle->padded_segment_length_shift, handle->sweep_rate);
+	acc_algorithm_welch_history(&handle->time_series_history, handle->segment_length, handle->time_series_buffer, handle->fft_out,
+	                            handle->psds, handle->window, handle->padded_segment_length_shift, handle->sweep_rate);
 
 	acc_algorithm_fftshift_matrix(handle->psds, handle->segment_length, handle->num_distances);
 
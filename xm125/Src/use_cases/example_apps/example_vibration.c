@@ -153,6 +153,8 @@ typedef struct
 
 	float *time_series;
 	float *frequencies;
+
+	acc_algorithm_history_t time_series_history;
 	float *lp_displacements;
 
 	int32_t *double_buffer_filter_buffer;
@@ -197,7 +199,7 @@ static void process(acc_vibration_app_t *app, acc_vibration_config_t *config, ac
 static void update_vibration_result(acc_vibration_app_t *app, acc_vibration_config_t *config, acc_vibration_result_t *result);
 
 
-static void roll_and_update_time_series(acc_vibration_app_t *app, acc_vibration_config_t *config);
+static void roll_and_update_time_series(acc_vibration_app_t *app, uint16_t num_elements, bool unwrap_first);
 
 
 static void calculate_threshold(acc_vibration_app_t *app, acc_vibration_config_t *config);
@@ -472,6 +474,8 @@ static bool init_app_resources(acc_vibration_app_t *app, acc_vibration_config_t
 		return false;
 	}
 
+	acc_algorithm_history_init(&app->time_series_history, app->time_series, config->time_series_length, 1U, sizeof(*app->time_series));
+
 	app->frequencies = acc_integration_mem_calloc(app->rfft_output_length, sizeof(*app->frequencies));
 	if (app->frequencies == NULL)
 	{
@@ -642,17 +646,11 @@ static void process(acc_vibration_app_t *app, acc_vibration_config_t *config, ac
 	{
 		acc_algorithm_double_buffering_frame_filter(app->proc_result.frame, sweeps_per_frame, num_points,
 		                                            app->double_buffer_filter_buffer);
-		roll_and_update_time_series(app, config);
+		roll_and_update_time_series(app, sweeps_per_frame, true);
 	}
 	else
 	{
-		for (uint16_t i = 0; i < app->frame_length; i++)
-		{
-			acc_int16_complex_t point = app->proc_result.frame[i];
-			app->time_series[i] = cargf(point.real + (point.imag * I));
-		}
-
-		acc_algorithm_unwrap(app->time_series, app->frame_length);
+		roll_and_update_time_series(app, app->frame_length, false);
 	}
 
 	/*
@@ -729,33 +727,39 @@ static void update_vibration_result(acc_vibration_app_t *app, acc_vibration_conf
 }
 
 
-static void roll_and_update_time_series(acc_vibration_app_t *app, acc_vibration_config_t *config)
+static void roll_and_update_time_series(acc_vibration_app_t *app, uint16_t num_elements, bool unwrap_first)
 {
-	const uint16_t sweeps_per_frame = acc_config_sweeps_per_frame_get(config->sensor_config);
+	/*
+	 * The elements already in the history are unwrapped, so only the new
+	 * ones need to be unwrapped, each against the one pushed before it.
+	 */
+	float *previous = acc_algorithm_history_recent(&app->time_series_history, 0U);
 
-	for (uint16_t i = 0; i < sweeps_per_frame; i++)
+	for (uint16_t i = 0; i < num_elements; i++)
 	{
 		acc_int16_complex_t point       = app->proc_result.frame[i];
 		float               new_element = cargf(point.real + (point.imag * I));
+		float               *element    = acc_algorithm_history_push(&app->time_series_history);
 
-		acc_algorithm_roll_and_push(app->time_series, config->time_series_length, new_element);
-	}
+		if ((i > 0U) || unwrap_first)
+		{
+			new_element = acc_algorithm_unwrap_element(*previous, new_element);
+		}
 
-	acc_algorithm_unwrap(app->time_series, config->time_series_length);
+		*element = new_element;
+		previous = element;
+	}
 }
 
 
 static void calculate_threshold(acc_vibration_app_t *app, acc_vibration_config_t *config)
 {
-	for (uint16_t i = 0; i < app->data_length; i++)
-	{
-		app->threshold[i] = acc_algorithm_calculate_cfar(app->lp_displacements,
-		                                                 app->data_length,
-		                                                 CFAR_WINDOW_LENGTH,
-		                                                 CFAR_HALF_GUARD_LENGTH,
-		                                                 config->threshold_sensitivity,
-		                                                 i);
-	}
+	acc_algorithm_calculate_cfar_sweep(app->lp_displacements,
+	                                   app->data_length,
+	                                   CFAR_WINDOW_LENGTH,
+	                                   CFAR_HALF_GUARD_LENGTH,
+	                                   config->threshold_sensitivity,
+	                                   app->threshold);
 
 	/*
 	 * Extend the CFAR threshold using extrapolation.
@@ -817,18 +821,34 @@ static void calculate_threshold(acc_vibration_app_t *app, acc_vibration_config_t
 
 static float *get_zero_mean_time_series(acc_vibration_app_t *app, acc_vibration_config_t *config)
 {
-	float mean = 0.0f;
+	acc_algorithm_history_view_t view;
+	float                        mean = 0.0f;
 
-	for (uint16_t i = 0; i < config->time_series_length; i++)
+	acc_algorithm_history_view(&app->time_series_history, &view);
+
+	for (uint16_t s = 0; s < 2U; s++)
 	{
-		mean += app->time_series[i];
+		const float *segment = view.segment[s];
+
+		for (uint16_t i = 0; i < view.rows[s]; i++)
+		{
+			mean += segment[i];
+		}
 	}
 
 	mean /= (float)config->time_series_length;
 
-	for (uint16_t i = 0; i < config->time_series_length; i++)
+	/* Unrolled to time order on the way */
+	float *zero_mean = app->zero_mean_time_series;
+
+	for (uint16_t s = 0; s < 2U; s++)
 	{
-		app->zero_mean_time_series[i] = app->time_series[i] - mean;
+		const float *segment = view.segment[s];
+
+		for (uint16_t i = 0; i < view.rows[s]; i++)
+		{
+			*zero_mean++ = segment[i] - mean;
+		}
 	}
 
 	return app->zero_mean_time_series;
@@ -68,6 +68,13 @@ struct ref_app_breathing_handle
 	float         *filt_angle_buffer;
 	float         *breathing_motion_buffer;
 	float         *hamming_window;
+
+	acc_algorithm_history_t sparse_iq_history;
+	acc_algorithm_history_t filt_sparse_iq_history;
+	acc_algorithm_history_t angle_history;
+	acc_algorithm_history_t filt_angle_history;
+	acc_algorithm_history_t breathing_motion_history;
+
 	float         *windowed_breathing_motion_buffer;
 	float complex *rfft_output;
 	uint16_t      rfft_output_length;
@@ -500,15 +507,19 @@ static bool reinit_breathing(ref_app_breathing_handle_t *handle, uint16_t start_
 	handle->count       = 0U;
 	handle->initialized = false;
 
-	memset(handle->sparse_iq_buffer, 0, B_STATIC_LENGTH * handle->num_points_to_analyze * sizeof(*handle->sparse_iq_buffer));
-	memset(handle->filt_sparse_iq_buffer, 0, A_STATIC_LENGTH * handle->num_points_to_analyze * sizeof(*handle->filt_sparse_iq_buffer));
+	acc_algorithm_history_init(&handle->sparse_iq_history, handle->sparse_iq_buffer, B_STATIC_LENGTH, handle->num_points_to_analyze,
+	                           sizeof(*handle->sparse_iq_buffer));
+	acc_algorithm_history_init(&handle->filt_sparse_iq_history, handle->filt_sparse_iq_buffer, A_STATIC_LENGTH,
+	                           handle->num_points_to_analyze, sizeof(*handle->filt_sparse_iq_buffer));
 	memset(handle->prev_angle, 0, handle->num_points_to_analyze * sizeof(*handle->prev_angle));
 	memset(handle->lp_filt_ampl, 0, handle->num_points_to_analyze * sizeof(*handle->lp_filt_ampl));
 	memset(handle->unwrapped_angle, 0, handle->num_points_to_analyze * sizeof(*handle->unwrapped_angle));
-	memset(handle->angle_buffer, 0, B_ANGLE_LENGTH * handle->num_points_to_analyze * sizeof(*handle->angle_buffer));
-	memset(handle->filt_angle_buffer, 0, A_ANGLE_LENGTH * handle->num_points_to_analyze * sizeof(*handle->filt_angle_buffer));
-	memset(handle->breathing_motion_buffer, 0,
-	       handle->time_series_length * handle->num_points_to_analyze * sizeof(*handle->breathing_motion_buffer));
+	acc_algorithm_history_init(&handle->angle_history, handle->angle_buffer, B_ANGLE_LENGTH, handle->num_points_to_analyze,
+	                           sizeof(*handle->angle_buffer));
+	acc_algorithm_history_init(&handle->filt_angle_history, handle->filt_angle_buffer, A_ANGLE_LENGTH, handle->num_points_to_analyze,
+	                           sizeof(*handle->filt_angle_buffer));
+	acc_algorithm_history_init(&handle->breathing_motion_history, handle->breathing_motion_buffer, handle->time_series_length,
+	                           handle->num_points_to_analyze, sizeof(*handle->breathing_motion_buffer));
 
 	return true;
 }
@@ -586,16 +597,12 @@ static bool process_breathing(ref_app_breathing_handle_t *handle, acc_int16_comp
 	acc_algorithm_mean_sweep(frame, handle->num_points, handle->sweeps_per_frame, handle->start_point, handle->end_point,
 	                         handle->mean_sweep);
 
-	acc_algorithm_roll_and_push_matrix_f32_complex(handle->sparse_iq_buffer, B_STATIC_LENGTH, handle->num_points_to_analyze,
-	                                               handle->mean_sweep,
-	                                               true);
+	acc_algorithm_history_push_row(&handle->sparse_iq_history, handle->mean_sweep);
 
-	acc_algorithm_apply_filter_f32_complex(handle->a_static, handle->filt_sparse_iq_buffer, A_STATIC_LENGTH, handle->num_points_to_analyze,
-	                                       handle->b_static, handle->sparse_iq_buffer, B_STATIC_LENGTH, handle->num_points_to_analyze,
-	                                       handle->filt_sparse_iq, handle->num_points_to_analyze);
+	acc_algorithm_apply_filter_history_f32_complex(handle->a_static, &handle->filt_sparse_iq_history, handle->b_static,
+	                                               &handle->sparse_iq_history, handle->filt_sparse_iq);
 
-	acc_algorithm_roll_and_push_matrix_f32_complex(handle->filt_sparse_iq_buffer, A_STATIC_LENGTH, handle->num_points_to_analyze,
-	                                               handle->filt_sparse_iq, true);
+	acc_algorithm_history_push_row(&handle->filt_sparse_iq_history, handle->filt_sparse_iq);
 
 	for (uint16_t i = 0U; i < handle->num_points_to_analyze; i++)
 	{
@@ -637,18 +644,14 @@ static bool process_breathing(ref_app_breathing_handle_t *handle, acc_int16_comp
 		handle->unwrapped_angle[i] += angle_diff;
 	}
 
-	acc_algorithm_roll_and_push_matrix_f32(handle->angle_buffer, B_ANGLE_LENGTH, handle->num_points_to_analyze, handle->unwrapped_angle,
-	                                       true);
+	acc_algorithm_history_push_row(&handle->angle_history, handle->unwrapped_angle);
 
-	acc_algorithm_apply_filter_f32(handle->a_angle, handle->filt_angle_buffer, A_ANGLE_LENGTH, handle->num_points_to_analyze, handle->b_angle,
-	                               handle->angle_buffer, B_ANGLE_LENGTH, handle->num_points_to_analyze, handle->angle,
-	                               handle->num_points_to_analyze);
+	acc_algorithm_apply_filter_history_f32(handle->a_angle, &handle->filt_angle_history, handle->b_angle, &handle->angle_history,
+	                                       handle->angle);
 
-	acc_algorithm_roll_and_push_matrix_f32(handle->filt_angle_buffer, A_ANGLE_LENGTH, handle->num_points_to_analyze, handle->angle, true);
+	acc_algorithm_history_push_row(&handle->filt_angle_history, handle->angle);
 
-	acc_algorithm_roll_and_push_matrix_f32(handle->breathing_motion_buffer, handle->time_series_length, handle->num_points_to_analyze,
-	                                       handle->angle,
-	                                       false);
+	acc_algorithm_history_push_row(&handle->breathing_motion_history, handle->angle);
 
 	if (handle->init_count > handle->time_series_length)
 	{
@@ -669,12 +672,12 @@ static bool process_breathing(ref_app_breathing_handle_t *handle, acc_int16_comp
 
 			for (uint16_t r = 0U; r < handle->time_series_length; r++)
 			{
+				const float *breathing_motion = acc_algorithm_history_row(&handle->breathing_motion_history, r);
+
 				for (uint16_t c = 0U; c < handle->num_points_to_analyze; c++)
 				{
 					handle->windowed_breathing_motion_buffer[r * handle->num_points_to_analyze +
-					                                         c] =
-						handle->breathing_motion_buffer[r * handle->num_points_to_analyze + c] *
-						handle->hamming_window[r];
+					                                         c] = breathing_motion[c] * handle->hamming_window[r];
 					lp_filt_ampl_sum += handle->lp_filt_ampl[c];
 				}
 			}
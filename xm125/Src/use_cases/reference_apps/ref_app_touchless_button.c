@@ -125,6 +125,7 @@ typedef struct
 	uint16_t                      cal_interval_frames;
 	uint16_t                      cal_sweeps;
 	acc_int16_complex_t           *dynamic_background;
+	acc_algorithm_history_t       dynamic_background_history;
 	uint16_t                      rows_in_dynamic_background;
 	acc_int16_complex_t           *dynamic_background_guard;
 	bool                          update_background;
@@ -630,6 +631,8 @@ static bool init_handle(acc_touchless_button_handle_t *handle)
 
 	if (status)
 	{
+		acc_algorithm_history_init(&handle->dynamic_background_history, handle->dynamic_background, handle->cal_sweeps,
+		                           handle->proc_metadata.sweep_data_length, sizeof(*handle->dynamic_background));
 		reset_background(handle);
 
 		handle->run_close = handle->config.measurement_type == ACC_TOUCHLESS_BUTTON_CLOSE_RANGE ||
@@ -670,7 +673,7 @@ static void reset_background(acc_touchless_button_handle_t *handle)
 	uint16_t spf        = acc_config_sweeps_per_frame_get(handle->config.sensor_config);
 	uint16_t num_points = handle->proc_metadata.sweep_data_length;
 
-	memset(handle->dynamic_background, 0, handle->cal_sweeps * num_points * sizeof(*handle->dynamic_background));
+	acc_algorithm_history_reset(&handle->dynamic_background_history);
 	handle->rows_in_dynamic_background = 0U;
 	memset(handle->dynamic_background_guard, 0, spf * num_points * sizeof(*handle->dynamic_background_guard));
 	handle->update_background = false;
@@ -783,10 +786,12 @@ static void calc_variance(acc_touchless_button_handle_t *handle)
 		float phase_sq_term = 0.0f;
 		for (uint16_t r = 0U; r < handle->cal_sweeps; r++)
 		{
-			float         ac      = handle->dynamic_background[r * sweep_data_length + c].real * crealf(handle->arg_norm[c]);
-			float         bd      = handle->dynamic_background[r * sweep_data_length + c].imag * cimagf(handle->arg_norm[c]);
-			float         ad      = handle->dynamic_background[r * sweep_data_length + c].real * cimagf(handle->arg_norm[c]);
-			float         bc      = handle->dynamic_background[r * sweep_data_length + c].imag * crealf(handle->arg_norm[c]);
+			const acc_int16_complex_t *background = acc_algorithm_history_row(&handle->dynamic_background_history, r);
+
+			float         ac      = background[c].real * crealf(handle->arg_norm[c]);
+			float         bd      = background[c].imag * cimagf(handle->arg_norm[c]);
+			float         ad      = background[c].real * cimagf(handle->arg_norm[c]);
+			float         bc      = background[c].imag * crealf(handle->arg_norm[c]);
 			float complex element = (ac - bd) + I * (ad + bc);
 
 			float    delta = cabsf(element) - abs_mean;
@@ -845,9 +850,7 @@ static void update_background(acc_touchless_button_handle_t *handle)
 {
 	uint16_t spf = acc_config_sweeps_per_frame_get(handle->config.sensor_config);
 
-	acc_algorithm_roll_and_push_mult_matrix_i16_complex(handle->dynamic_background, handle->cal_sweeps, handle->proc_metadata.sweep_data_length,
-	                                                    handle->dynamic_background_guard, acc_config_sweeps_per_frame_get(
-								    handle->config.sensor_config), false);
+	acc_algorithm_history_push_rows(&handle->dynamic_background_history, handle->dynamic_background_guard, spf);
 
 	handle->rows_in_dynamic_background += spf;
 	handle->rows_in_dynamic_background  = handle->rows_in_dynamic_background >